@@ -0,0 +1,1228 @@
+/**
+ * hthbench - loopback benchmark of serialtextsrc, hthstreamsink and hthstreamsrc
+ *
+ * Runs the real elements in one process, fully offline. For each stream
+ * videotestsrc, audiotestsrc and a serialtextsrc fed by a pty go into
+ * hthstreamsink, which sends to an hthstreamsrc on 127.0.0.1 whose pads
+ * end in fakesinks:
+ *
+ *     videotestsrc ---.
+ *     audiotestsrc ---+--> hthstreamsink --udp--> hthstreamsrc --> fakesink x3
+ *     serialtextsrc --'
+ *
+ * Every combination of --resolutions, --framerates, --bitrates and
+ * --streams is run for --duration seconds after --warmup seconds, and the
+ * results are written as one JSON document:
+ *
+ * - frames, datagrams and bytes sent and received, throughput
+ * - glass-to-glass latency percentiles of the video frames (matched by
+ *   PTS, Matroska keeps them to the millisecond) and of the serial
+ *   messages (they carry their send time, as with serialloadgen)
+ * - CPU of each thread, grouped by thread name, so the streaming threads
+ *   named by the elements show up one by one
+ * - RSS sampled during the run and the drops reported by the elements
+ *
+ * The sources are deterministic (ball pattern, sine wave, fixed serial
+ * rate), so two builds run with the same options can be compared field by
+ * field. --label tags the document with the build under test.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <termios.h>
+
+#include <gst/gst.h>
+
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+#define YELLOW  "\033[1m\033[33m"   /** Warnings */
+#define WHITE   "\033[1m\033[37m"   /** Normal text */
+
+#define DEFAULT_RESOLUTIONS     "640x480" /**< Comma separated WIDTHxHEIGHT list */
+#define DEFAULT_FRAMERATES      "30" /**< Comma separated frames per second list */
+#define DEFAULT_BITRATES        "1024" /**< Comma separated theoraenc kbit/s list */
+#define DEFAULT_STREAMS         "1" /**< Comma separated sender/receiver pairs list */
+#define DEFAULT_DURATION        10 /**< Seconds measured per run */
+#define DEFAULT_WARMUP          2 /**< Seconds ignored at the start of each run */
+#define DEFAULT_PORT            5000 /**< Port of the first stream, the next ones follow */
+#define DEFAULT_SERIAL_RATE     50 /**< Serial messages per second and stream */
+#define MAX_STREAMS             16
+#define MAX_SWEEP_VALUES        16 /**< Values per swept parameter */
+#define MAX_THREADS             512 /**< Threads followed per run */
+#define SENT_FRAMES             512 /**< Send times kept per stream to match the received frames */
+#define SAMPLE_INTERVAL_MS      250 /**< Period of the RSS samples */
+#define SERIAL_MESSAGE_SIZE     64
+#define SERIAL_SETTINGS         "115200,8n1" /**< Speed and framing of the device property, a pty ignores them */
+
+#define EXIT_USAGE_FAILURE      -1 /**< Wrong command line */
+#define EXIT_FILE_FAILURE       -2 /**< Output could not be opened */
+#define EXIT_RUN_FAILURE        -3 /**< At least one run failed, its error is in the JSON */
+
+//==============================================================================
+
+/**
+ * @struct SentFrame
+ *
+ * @brief Send time of one video frame
+ *
+ */
+typedef struct {
+    GstClockTime pts; /**< PTS leaving videotestsrc */
+    gint64 sentUs; /**< Monotonic time it left videotestsrc */
+} SentFrame;
+
+/**
+ * @struct BenchStream
+ *
+ * @brief One sender/receiver pair and its counters
+ *
+ */
+typedef struct {
+    int ptyFd; /**< Master side of the serial pty */
+    GstElement *sink; /**< hthstreamsink */
+    GstElement *src; /**< hthstreamsrc */
+    GstStructure *sinkStats; /**< Stats of hthstreamsink when the measure started */
+    GstStructure *srcStats; /**< Stats of hthstreamsrc when the measure started */
+    GstStructure *sinkEndStats; /**< Stats of hthstreamsink when the measure stopped */
+    GstStructure *srcEndStats; /**< Stats of hthstreamsrc when the measure stopped */
+
+    GMutex lock; /**< Protects everything below, the probes run on several threads */
+    SentFrame sent[SENT_FRAMES]; /**< Ring of the last frames sent */
+    guint sentCount; /**< Frames written to the ring */
+    guint64 framesSent; /**< Video frames out of videotestsrc while measuring */
+    guint64 framesReceived; /**< Video frames out of hthstreamsrc while measuring */
+    guint64 framesUnmatched; /**< Received frames whose PTS was not in the ring */
+    guint64 audioReceived; /**< Audio buffers out of hthstreamsrc while measuring */
+    guint64 textReceived; /**< Serial messages out of hthstreamsrc while measuring */
+    GArray *videoLatency; /**< Glass-to-glass latencies in ns */
+    GArray *textLatency; /**< Serial to text pad latencies in ns */
+} BenchStream;
+
+/**
+ * @struct ThreadTicks
+ *
+ * @brief CPU time of the threads sharing a name
+ *
+ */
+typedef struct {
+    char name[32]; /**< Thread name, as in /proc/self/task/<tid>/comm */
+    unsigned long long ticks; /**< User and system clock ticks */
+} ThreadTicks;
+
+/**
+ * @struct BenchRun
+ *
+ * @brief One combination of the sweep
+ *
+ */
+typedef struct {
+    int width;
+    int height;
+    int framerate;
+    int bitrate; /**< theoraenc kbit/s */
+    unsigned int streamCount;
+    unsigned int duration; /**< Seconds measured */
+    unsigned int warmup; /**< Seconds before the measure */
+    unsigned int port; /**< Port of the first stream */
+    unsigned int serialRate; /**< Serial messages per second and stream */
+
+    BenchStream streams[MAX_STREAMS];
+    GstElement *pipeline;
+    GMainLoop *loop;
+    gint measuring; /**< Atomic, the probes count only while set */
+    gint serialRunning; /**< Atomic, stops the serial writer */
+    GThread *serialThread;
+    gint64 startUs; /**< Monotonic time the measure started */
+    gint64 stopUs; /**< Monotonic time the measure stopped */
+    ThreadTicks ticks[MAX_THREADS]; /**< CPU time of the threads when the measure started */
+    unsigned int ticksCount;
+    ThreadTicks endTicks[MAX_THREADS]; /**< CPU time of the threads when the measure stopped */
+    unsigned int endTicksCount;
+    long rssKb; /**< RSS when the measure stopped */
+    long rssPeakKb; /**< Highest RSS sampled while measuring */
+    char *error; /**< First error of the pipeline, NULL for none */
+} BenchRun;
+
+//==============================================================================
+
+/**
+ * @brief Parse a comma separated list of positive integers
+ *
+ * @param text The list
+ * @param values Parsed values
+ * @return unsigned int Number of values, 0 if the list is wrong
+ */
+static unsigned int parseList(const char *text, int values[MAX_SWEEP_VALUES]);
+
+/**
+ * @brief Parse a comma separated list of WIDTHxHEIGHT
+ *
+ * @param text The list
+ * @param widths Parsed widths
+ * @param heights Parsed heights
+ * @return unsigned int Number of resolutions, 0 if the list is wrong
+ */
+static unsigned int parseResolutions(const char *text, int widths[MAX_SWEEP_VALUES], int heights[MAX_SWEEP_VALUES]);
+
+/**
+ * @brief Create a raw, non blocking pty pair for serialtextsrc
+ *
+ * @param slaveName Name of the slave, to free
+ * @return int Master file descriptor, -1 on failure
+ */
+static int openPty(char **slaveName);
+
+/**
+ * @brief Build the pipeline of a run and install the probes
+ *
+ * @param run The run
+ * @return gboolean FALSE if an element is missing
+ */
+static gboolean buildPipeline(BenchRun *run);
+
+/**
+ * @brief Play the pipeline for the warmup and the measure
+ *
+ * @param run The run, its counters filled
+ */
+static void runPipeline(BenchRun *run);
+
+/**
+ * @brief Free the pipeline, the ptys and the counters of a run
+ *
+ * @param run The run
+ */
+static void clearRun(BenchRun *run);
+
+/**
+ * @brief Keep the send time of a video frame
+ *
+ * @param pad Src pad of videotestsrc
+ * @param info Probe info with the frame
+ * @param user_data The BenchRun
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_videoSentProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Match a received video frame with its send time
+ *
+ * @param pad Sink pad of the video fakesink
+ * @param info Probe info with the frame
+ * @param user_data The BenchRun
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_videoReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count a received audio buffer
+ *
+ * @param pad Sink pad of the audio fakesink
+ * @param info Probe info with the buffer
+ * @param user_data The BenchRun
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_audioReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Read the send times of the serial messages of a received text buffer
+ *
+ * @param pad Sink pad of the text fakesink
+ * @param info Probe info with the text
+ * @param user_data The BenchRun
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_textReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Find the stream of a probed pad from the name of its element
+ *
+ * @param run The run
+ * @param pad The pad
+ * @return BenchStream* The stream
+ */
+static BenchStream *findStream(BenchRun *run, GstPad *pad);
+
+/**
+ * @brief Write the sequenced serial messages of every stream
+ *
+ * @param data The BenchRun
+ * @return gpointer NULL
+ */
+static gpointer serialWriter(gpointer data);
+
+/**
+ * @brief Stop the run on the first error of the pipeline
+ *
+ * @param bus Bus of the pipeline
+ * @param message The message
+ * @param user_data The BenchRun
+ * @return gboolean Always TRUE
+ */
+static gboolean cb_busMessage(GstBus *bus, GstMessage *message, gpointer user_data);
+
+/**
+ * @brief End of the warmup, snapshot of the element stats and thread times
+ *
+ * @param user_data The BenchRun
+ * @return gboolean G_SOURCE_REMOVE
+ */
+static gboolean cb_startMeasure(gpointer user_data);
+
+/**
+ * @brief Sample the RSS while measuring
+ *
+ * @param user_data The BenchRun
+ * @return gboolean G_SOURCE_CONTINUE
+ */
+static gboolean cb_sampleRss(gpointer user_data);
+
+/**
+ * @brief End of the measure, snapshot of the thread times and RSS
+ *
+ * @param user_data The BenchRun
+ * @return gboolean G_SOURCE_REMOVE
+ */
+static gboolean cb_stopMeasure(gpointer user_data);
+
+/**
+ * @brief Read the CPU time of the threads of the process, grouped by name
+ *
+ * @param ticks Output, one entry per name
+ * @return unsigned int Number of entries
+ */
+static unsigned int readThreadTicks(ThreadTicks ticks[MAX_THREADS]);
+
+/**
+ * @brief Read a kB field of /proc/self/status
+ *
+ * @param field Field name with its colon, e.g. "VmRSS:"
+ * @return long Value in kB, 0 if missing
+ */
+static long readStatusKb(const char *field);
+
+/**
+ * @brief Difference of a uint64 field between two stats structures
+ *
+ * @param start Stats when the measure started, may be NULL
+ * @param end Stats when the measure stopped, may be NULL
+ * @param field Field name
+ * @return guint64 end - start, 0 if the field is missing
+ */
+static guint64 statsDelta(const GstStructure *start, const GstStructure *end, const char *field);
+
+/**
+ * @brief qsort comparison of two latencies
+ *
+ * @param a First gint64
+ * @param b Second gint64
+ * @return int Negative, 0 or positive
+ */
+static int compareLatency(const void *a, const void *b);
+
+/**
+ * @brief Write the percentiles of a latency array as a JSON object
+ *
+ * @param output JSON output
+ * @param name Key of the object
+ * @param samples Latencies in ns, sorted in place
+ */
+static void writeLatency(FILE *output, const char *name, GArray *samples);
+
+/**
+ * @brief Write the results of a run as a JSON object
+ *
+ * @param output JSON output
+ * @param run The run
+ */
+static void writeRun(FILE *output, BenchRun *run);
+
+/**
+ * @brief Write a string as a JSON string
+ *
+ * @param output JSON output
+ * @param text The string
+ */
+static void writeJsonString(FILE *output, const char *text);
+
+/**
+ * @brief Print the command line help
+ *
+ * @param program argv[0]
+ */
+static void printUsage(const char *program);
+
+//==============================================================================
+
+static unsigned int parseList(const char *text, int values[MAX_SWEEP_VALUES]) {
+
+    unsigned int count = 0;
+    char *end;
+    long value;
+
+    while (*text != '\0' && count < MAX_SWEEP_VALUES) {
+        value = strtol(text, &end, 10);
+        if (end == text || value <= 0 || (*end != ',' && *end != '\0'))
+            return 0;
+        values[count++] = (int)value;
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return *text == '\0' ? count : 0;
+}
+
+//==============================================================================
+
+static unsigned int parseResolutions(const char *text, int widths[MAX_SWEEP_VALUES], int heights[MAX_SWEEP_VALUES]) {
+
+    unsigned int count = 0;
+    int consumed;
+
+    while (*text != '\0' && count < MAX_SWEEP_VALUES) {
+        if (sscanf(text, "%dx%d%n", &widths[count], &heights[count], &consumed) != 2
+            || widths[count] <= 0 || heights[count] <= 0 || (text[consumed] != ',' && text[consumed] != '\0'))
+            return 0;
+        count++;
+        text += consumed;
+        if (*text == ',')
+            text++;
+    }
+
+    return *text == '\0' ? count : 0;
+}
+
+//==============================================================================
+
+static int openPty(char **slaveName) {
+
+    struct termios settings;
+    const char *name;
+    int fd;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0 || (name = ptsname(fd)) == NULL) {
+        fprintf(stderr, RED "Could not create the pty pair: %s \n" RESET, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    /** No echo nor line processing, the bytes reach serialtextsrc unchanged */
+    if (tcgetattr(fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        tcsetattr(fd, TCSANOW, &settings);
+    }
+
+    *slaveName = g_strdup(name);
+
+    return fd;
+}
+
+//==============================================================================
+
+static gboolean buildPipeline(BenchRun *run) {
+
+    GString *description = g_string_new(NULL);
+    GstElement *element;
+    GstPad *pad;
+    GstCaps *caps;
+    GstBus *bus;
+    GError *error = NULL;
+    BenchStream *stream;
+    char *slaveName;
+    char name[32];
+    unsigned int i;
+
+    for (i = 0; i < run->streamCount; i++) {
+
+        stream = &run->streams[i];
+        stream->ptyFd = openPty(&slaveName);
+        if (stream->ptyFd < 0) {
+            run->error = g_strdup("Could not create the serial pty");
+            g_string_free(description, TRUE);
+            return FALSE;
+        }
+
+        /** Same stream id header as a multi sender deployment, it also gives the datagram loss */
+        g_string_append_printf(description,
+                               "videotestsrc name=vsrc%u is-live=true pattern=ball "
+                               "! video/x-raw,width=%d,height=%d,framerate=%d/1 ! s%u.video_sink "
+                               "audiotestsrc is-live=true wave=sine ! s%u.audio_sink "
+                               "serialtextsrc device=%s," SERIAL_SETTINGS " ! s%u.text_sink "
+                               "hthstreamsink name=s%u host=127.0.0.1 port=%u stream-id=%u "
+                               "hthstreamsrc name=r%u port=%u stream-id-header=true "
+                               "r%u.video_src ! fakesink name=vout%u sync=false "
+                               "r%u.audio_src ! fakesink name=aout%u sync=false "
+                               "r%u.text_src ! fakesink name=tout%u sync=false ",
+                               i, run->width, run->height, run->framerate, i,
+                               i,
+                               slaveName, i,
+                               i, run->port + i, i + 1,
+                               i, run->port + i,
+                               i, i, i, i, i, i);
+        g_free(slaveName);
+    }
+
+    run->pipeline = gst_parse_launch(description->str, &error);
+    g_string_free(description, TRUE);
+    if (run->pipeline == NULL || error != NULL) {
+        run->error = g_strdup(error != NULL ? error->message : "Could not build the pipeline");
+        g_clear_error(&error);
+        return FALSE;
+    }
+
+    for (i = 0; i < run->streamCount; i++) {
+
+        stream = &run->streams[i];
+
+        g_snprintf(name, sizeof(name), "s%u", i);
+        stream->sink = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+        g_snprintf(name, sizeof(name), "r%u", i);
+        stream->src = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+
+        /** hthstreamsink scales to 640x480 and lets theoraenc pick its bitrate */
+        caps = gst_caps_new_simple("video/x-raw", "width", G_TYPE_INT, run->width, "height", G_TYPE_INT, run->height, NULL);
+        gst_child_proxy_set(GST_CHILD_PROXY(stream->sink), "filter-cap::caps", caps, "video-enc::bitrate", run->bitrate, NULL);
+        gst_caps_unref(caps);
+
+        g_snprintf(name, sizeof(name), "vsrc%u", i);
+        element = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+        pad = gst_element_get_static_pad(element, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_videoSentProbe, run, NULL);
+        gst_object_unref(pad);
+        gst_object_unref(element);
+
+        g_snprintf(name, sizeof(name), "vout%u", i);
+        element = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+        pad = gst_element_get_static_pad(element, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_videoReceivedProbe, run, NULL);
+        gst_object_unref(pad);
+        gst_object_unref(element);
+
+        g_snprintf(name, sizeof(name), "aout%u", i);
+        element = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+        pad = gst_element_get_static_pad(element, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_audioReceivedProbe, run, NULL);
+        gst_object_unref(pad);
+        gst_object_unref(element);
+
+        g_snprintf(name, sizeof(name), "tout%u", i);
+        element = gst_bin_get_by_name(GST_BIN(run->pipeline), name);
+        pad = gst_element_get_static_pad(element, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_textReceivedProbe, run, NULL);
+        gst_object_unref(pad);
+        gst_object_unref(element);
+    }
+
+    bus = gst_element_get_bus(run->pipeline);
+    gst_bus_add_watch(bus, cb_busMessage, run);
+    gst_object_unref(bus);
+
+    return TRUE;
+}
+
+//==============================================================================
+
+static void runPipeline(BenchRun *run) {
+
+    guint sampleSource;
+
+    run->loop = g_main_loop_new(NULL, FALSE);
+
+    g_atomic_int_set(&run->serialRunning, 1);
+    run->serialThread = g_thread_new("hthbench-serial", serialWriter, run);
+
+    if (gst_element_set_state(run->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        run->error = g_strdup("The pipeline could not go to PLAYING");
+    } else {
+        g_timeout_add_seconds(run->warmup, cb_startMeasure, run);
+        g_timeout_add_seconds(run->warmup + run->duration, cb_stopMeasure, run);
+        sampleSource = g_timeout_add(SAMPLE_INTERVAL_MS, cb_sampleRss, run);
+        g_main_loop_run(run->loop);
+        g_source_remove(sampleSource);
+    }
+
+    gst_element_set_state(run->pipeline, GST_STATE_NULL);
+
+    g_atomic_int_set(&run->serialRunning, 0);
+    g_thread_join(run->serialThread);
+    run->serialThread = NULL;
+}
+
+//==============================================================================
+
+static void clearRun(BenchRun *run) {
+
+    BenchStream *stream;
+    GstBus *bus;
+    unsigned int i;
+
+    for (i = 0; i < run->streamCount; i++) {
+        stream = &run->streams[i];
+        if (stream->sink != NULL)
+            gst_object_unref(stream->sink);
+        if (stream->src != NULL)
+            gst_object_unref(stream->src);
+        if (stream->sinkStats != NULL)
+            gst_structure_free(stream->sinkStats);
+        if (stream->srcStats != NULL)
+            gst_structure_free(stream->srcStats);
+        if (stream->sinkEndStats != NULL)
+            gst_structure_free(stream->sinkEndStats);
+        if (stream->srcEndStats != NULL)
+            gst_structure_free(stream->srcEndStats);
+        if (stream->ptyFd >= 0)
+            close(stream->ptyFd);
+        g_array_free(stream->videoLatency, TRUE);
+        g_array_free(stream->textLatency, TRUE);
+        g_mutex_clear(&stream->lock);
+    }
+
+    if (run->pipeline != NULL) {
+        bus = gst_element_get_bus(run->pipeline);
+        gst_bus_remove_watch(bus);
+        gst_object_unref(bus);
+        gst_object_unref(run->pipeline);
+    }
+    if (run->loop != NULL)
+        g_main_loop_unref(run->loop);
+
+    g_free(run->error);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_videoSentProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream = findStream(run, pad);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    SentFrame *frame;
+
+    g_mutex_lock(&stream->lock);
+    frame = &stream->sent[stream->sentCount++ % SENT_FRAMES];
+    frame->pts = GST_BUFFER_PTS(buffer);
+    frame->sentUs = g_get_monotonic_time();
+    if (g_atomic_int_get(&run->measuring))
+        stream->framesSent++;
+    g_mutex_unlock(&stream->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static BenchStream *findStream(BenchRun *run, GstPad *pad) {
+
+    GstObject *parent = gst_pad_get_parent(pad);
+    const char *name = GST_OBJECT_NAME(parent);
+    unsigned int index;
+
+    /** vsrc<N>, vout<N>, aout<N> and tout<N> */
+    index = (unsigned int) strtoul(name + 4, NULL, 10);
+    gst_object_unref(parent);
+
+    return &run->streams[index < run->streamCount ? index : 0];
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_videoReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream = findStream(run, pad);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gint64 nowUs = g_get_monotonic_time();
+    gint64 latency;
+    SentFrame *frame;
+    guint i, count;
+
+    if (!g_atomic_int_get(&run->measuring) || !GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_PAD_PROBE_OK;
+
+    g_mutex_lock(&stream->lock);
+
+    stream->framesReceived++;
+
+    /** Newest first, Matroska rounds the timestamps to the millisecond */
+    count = MIN(stream->sentCount, SENT_FRAMES);
+    for (i = 1; i <= count; i++) {
+        frame = &stream->sent[(stream->sentCount - i) % SENT_FRAMES];
+        if (ABS(GST_CLOCK_DIFF(frame->pts, GST_BUFFER_PTS(buffer))) <= (GstClockTimeDiff) GST_MSECOND) {
+            latency = (nowUs - frame->sentUs) * 1000;
+            g_array_append_val(stream->videoLatency, latency);
+            break;
+        }
+    }
+    if (i > count)
+        stream->framesUnmatched++;
+
+    g_mutex_unlock(&stream->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_audioReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream = findStream(run, pad);
+
+    if (!g_atomic_int_get(&run->measuring))
+        return GST_PAD_PROBE_OK;
+
+    g_mutex_lock(&stream->lock);
+    stream->audioReceived++;
+    g_mutex_unlock(&stream->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_textReceivedProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream = findStream(run, pad);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gint64 nowUs = g_get_monotonic_time();
+    unsigned long long sequence;
+    long long sentUs;
+    gint64 latency;
+    GstMapInfo map;
+    char *text, *message;
+
+    if (!g_atomic_int_get(&run->measuring) || !gst_buffer_map(buffer, &map, GST_MAP_READ))
+        return GST_PAD_PROBE_OK;
+
+    /** A buffer may hold several messages, or none with frame telemetry records */
+    text = g_strndup((const char*) map.data, map.size);
+    gst_buffer_unmap(buffer, &map);
+
+    g_mutex_lock(&stream->lock);
+    for (message = strstr(text, "HTH "); message != NULL; message = strstr(message + 4, "HTH ")) {
+        if (sscanf(message, "HTH %llu %lld", &sequence, &sentUs) != 2)
+            continue;
+        stream->textReceived++;
+        latency = (nowUs - sentUs) * 1000;
+        g_array_append_val(stream->textLatency, latency);
+    }
+    g_mutex_unlock(&stream->lock);
+
+    g_free(text);
+
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static gpointer serialWriter(gpointer data) {
+
+    BenchRun *run = (BenchRun*) data;
+    gint64 periodUs = G_USEC_PER_SEC / run->serialRate;
+    gint64 deadlineUs = g_get_monotonic_time();
+    unsigned long long sequence = 0;
+    char message[SERIAL_MESSAGE_SIZE];
+    unsigned int i;
+    int length;
+
+    while (g_atomic_int_get(&run->serialRunning)) {
+
+        /** Same format as serialloadgen, the send time is CLOCK_MONOTONIC in us */
+        length = g_snprintf(message, sizeof(message), "HTH %llu %" G_GINT64_FORMAT " hthbench\n",
+                            sequence++, g_get_monotonic_time());
+        for (i = 0; i < run->streamCount; i++) {
+            if (write(run->streams[i].ptyFd, message, length) < 0 && errno != EAGAIN && errno != EIO)
+                break;
+        }
+
+        deadlineUs += periodUs;
+        if (deadlineUs > g_get_monotonic_time())
+            g_usleep(deadlineUs - g_get_monotonic_time());
+    }
+
+    return NULL;
+}
+
+//==============================================================================
+
+static gboolean cb_busMessage(GstBus *bus, GstMessage *message, gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    GError *error;
+    gchar *debug;
+
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_ERROR)
+        return TRUE;
+
+    gst_message_parse_error(message, &error, &debug);
+    fprintf(stderr, RED "Error from %s: %s \n" RESET, GST_OBJECT_NAME(GST_MESSAGE_SRC(message)), error->message);
+    if (run->error == NULL)
+        run->error = g_strdup_printf("%s: %s", GST_OBJECT_NAME(GST_MESSAGE_SRC(message)), error->message);
+    g_error_free(error);
+    g_free(debug);
+
+    g_atomic_int_set(&run->measuring, 0);
+    g_main_loop_quit(run->loop);
+
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean cb_startMeasure(gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream;
+    unsigned int i;
+
+    for (i = 0; i < run->streamCount; i++) {
+        stream = &run->streams[i];
+        g_object_get(stream->sink, "stats", &stream->sinkStats, NULL);
+        g_object_get(stream->src, "stats", &stream->srcStats, NULL);
+    }
+
+    run->ticksCount = readThreadTicks(run->ticks);
+    run->rssPeakKb = readStatusKb("VmRSS:");
+    run->startUs = g_get_monotonic_time();
+    g_atomic_int_set(&run->measuring, 1);
+
+    fprintf(stderr, WHITE "Measuring for %u s \n" RESET, run->duration);
+
+    return G_SOURCE_REMOVE;
+}
+
+//==============================================================================
+
+static gboolean cb_sampleRss(gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    long rssKb;
+
+    if (g_atomic_int_get(&run->measuring)) {
+        rssKb = readStatusKb("VmRSS:");
+        if (rssKb > run->rssPeakKb)
+            run->rssPeakKb = rssKb;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+//==============================================================================
+
+static gboolean cb_stopMeasure(gpointer user_data) {
+
+    BenchRun *run = (BenchRun*) user_data;
+    BenchStream *stream;
+    unsigned int i;
+
+    g_atomic_int_set(&run->measuring, 0);
+    run->stopUs = g_get_monotonic_time();
+    for (i = 0; i < run->streamCount; i++) {
+        stream = &run->streams[i];
+        g_object_get(stream->sink, "stats", &stream->sinkEndStats, NULL);
+        g_object_get(stream->src, "stats", &stream->srcEndStats, NULL);
+    }
+    run->endTicksCount = readThreadTicks(run->endTicks);
+    run->rssKb = readStatusKb("VmRSS:");
+    if (run->rssKb > run->rssPeakKb)
+        run->rssPeakKb = run->rssKb;
+
+    g_main_loop_quit(run->loop);
+
+    return G_SOURCE_REMOVE;
+}
+
+//==============================================================================
+
+static unsigned int readThreadTicks(ThreadTicks ticks[MAX_THREADS]) {
+
+    char path[64], line[512], name[32];
+    unsigned long long userTicks, systemTicks;
+    unsigned int count = 0, i;
+    struct dirent *entry;
+    char *nameStart, *nameEnd;
+    FILE *statFile;
+    DIR *tasks;
+
+    tasks = opendir("/proc/self/task");
+    if (tasks == NULL)
+        return 0;
+
+    while ((entry = readdir(tasks)) != NULL) {
+
+        if (entry->d_name[0] == '.')
+            continue;
+
+        g_snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        statFile = fopen(path, "r");
+        if (statFile == NULL)
+            continue;
+        if (fgets(line, sizeof(line), statFile) == NULL) {
+            fclose(statFile);
+            continue;
+        }
+        fclose(statFile);
+
+        /** The name may hold spaces and parentheses, it ends at the last one */
+        nameStart = strchr(line, '(');
+        nameEnd = strrchr(line, ')');
+        if (nameStart == NULL || nameEnd == NULL || nameEnd < nameStart)
+            continue;
+        g_strlcpy(name, nameStart + 1, MIN(sizeof(name), (size_t)(nameEnd - nameStart)));
+
+        /** utime and stime are the 14th and 15th fields */
+        if (sscanf(nameEnd + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &userTicks, &systemTicks) != 2)
+            continue;
+
+        for (i = 0; i < count && strcmp(ticks[i].name, name) != 0; i++)
+            ;
+        if (i == count) {
+            if (count == MAX_THREADS)
+                continue;
+            g_strlcpy(ticks[count].name, name, sizeof(ticks[count].name));
+            ticks[count++].ticks = 0;
+        }
+        ticks[i].ticks += userTicks + systemTicks;
+    }
+
+    closedir(tasks);
+
+    return count;
+}
+
+//==============================================================================
+
+static long readStatusKb(const char *field) {
+
+    char line[256];
+    long value = 0;
+    FILE *status;
+
+    status = fopen("/proc/self/status", "r");
+    if (status == NULL)
+        return 0;
+
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (strncmp(line, field, strlen(field)) == 0) {
+            value = strtol(line + strlen(field), NULL, 10);
+            break;
+        }
+    }
+
+    fclose(status);
+
+    return value;
+}
+
+//==============================================================================
+
+static guint64 statsDelta(const GstStructure *start, const GstStructure *end, const char *field) {
+
+    guint64 startValue = 0, endValue = 0;
+
+    if (end == NULL || !gst_structure_get_uint64(end, field, &endValue))
+        return 0;
+    if (start != NULL)
+        gst_structure_get_uint64(start, field, &startValue);
+
+    return endValue > startValue ? endValue - startValue : 0;
+}
+
+//==============================================================================
+
+static int compareLatency(const void *a, const void *b) {
+
+    gint64 first = *(const gint64*) a, second = *(const gint64*) b;
+
+    return first < second ? -1 : first > second;
+}
+
+//==============================================================================
+
+static void writeLatency(FILE *output, const char *name, GArray *samples) {
+
+    gint64 *values = (gint64*) samples->data;
+    guint count = samples->len;
+
+    if (count == 0) {
+        fprintf(output, "\"%s\": {\"samples\": 0}", name);
+        return;
+    }
+
+    qsort(values, count, sizeof(gint64), compareLatency);
+
+    fprintf(output, "\"%s\": {\"samples\": %u, \"p50\": %" G_GINT64_FORMAT ", \"p95\": %" G_GINT64_FORMAT
+            ", \"p99\": %" G_GINT64_FORMAT ", \"max\": %" G_GINT64_FORMAT "}",
+            name, count, values[count * 50 / 100], values[count * 95 / 100], values[count * 99 / 100], values[count - 1]);
+}
+
+//==============================================================================
+
+static void writeRun(FILE *output, BenchRun *run) {
+
+    GArray *videoLatency = g_array_new(FALSE, FALSE, sizeof(gint64));
+    GArray *textLatency = g_array_new(FALSE, FALSE, sizeof(gint64));
+    guint64 framesSent = 0, framesReceived = 0, framesUnmatched = 0, audioReceived = 0, textReceived = 0;
+    guint64 bytesSent = 0, bytesReceived = 0, datagramsSent = 0, datagramsReceived = 0;
+    guint64 datagramsLost = 0, rateDrops = 0, lateDrops = 0, memoryDrops = 0, demuxErrors = 0;
+    GstStructure *sinkStats, *srcStats;
+    unsigned long long startTicks;
+    double seconds, ticksPerSecond = sysconf(_SC_CLK_TCK);
+    BenchStream *stream;
+    unsigned int i, j;
+
+    seconds = run->stopUs > run->startUs ? (run->stopUs - run->startUs) / (double) G_USEC_PER_SEC : 0.0;
+
+    for (i = 0; i < run->streamCount; i++) {
+
+        stream = &run->streams[i];
+        sinkStats = stream->sinkEndStats;
+        srcStats = stream->srcEndStats;
+
+        framesSent += stream->framesSent;
+        framesReceived += stream->framesReceived;
+        framesUnmatched += stream->framesUnmatched;
+        audioReceived += stream->audioReceived;
+        textReceived += stream->textReceived;
+        g_array_append_vals(videoLatency, stream->videoLatency->data, stream->videoLatency->len);
+        g_array_append_vals(textLatency, stream->textLatency->data, stream->textLatency->len);
+
+        /** Missing when the run failed before the end of the measure, the deltas are then 0 */
+        bytesSent += statsDelta(stream->sinkStats, sinkStats, "bytes-sent");
+        datagramsSent += statsDelta(stream->sinkStats, sinkStats, "datagrams-sent");
+        rateDrops += statsDelta(stream->sinkStats, sinkStats, "videorate-drops");
+        lateDrops += statsDelta(stream->sinkStats, sinkStats, "video-late-drops");
+        memoryDrops += statsDelta(stream->sinkStats, sinkStats, "video-memory-drops")
+            + statsDelta(stream->srcStats, srcStats, "video-memory-drops");
+        bytesReceived += statsDelta(stream->srcStats, srcStats, "bytes-received");
+        datagramsReceived += statsDelta(stream->srcStats, srcStats, "datagrams-received");
+        datagramsLost += statsDelta(stream->srcStats, srcStats, "datagrams-lost");
+        demuxErrors += statsDelta(stream->srcStats, srcStats, "demux-errors");
+    }
+
+    fprintf(output, "    {\"width\": %d, \"height\": %d, \"framerate\": %d, \"bitrate\": %d, \"streams\": %u,\n",
+            run->width, run->height, run->framerate, run->bitrate, run->streamCount);
+    fprintf(output, "     \"error\": ");
+    if (run->error != NULL)
+        writeJsonString(output, run->error);
+    else
+        fprintf(output, "null");
+    fprintf(output, ",\n     \"measured_s\": %.3f,\n", seconds);
+
+    fprintf(output, "     \"video_frames_sent\": %" G_GUINT64_FORMAT ", \"video_frames_received\": %" G_GUINT64_FORMAT
+            ", \"video_frames_unmatched\": %" G_GUINT64_FORMAT ", \"video_fps\": %.2f, \"video_drop_rate\": %.4f,\n",
+            framesSent, framesReceived, framesUnmatched, seconds > 0 ? framesReceived / seconds / run->streamCount : 0.0,
+            framesSent > 0 && framesSent > framesReceived ? (double)(framesSent - framesReceived) / framesSent : 0.0);
+    fprintf(output, "     \"audio_buffers_received\": %" G_GUINT64_FORMAT ", \"text_messages_received\": %" G_GUINT64_FORMAT ",\n",
+            audioReceived, textReceived);
+    fprintf(output, "     \"datagrams_sent\": %" G_GUINT64_FORMAT ", \"bytes_sent\": %" G_GUINT64_FORMAT
+            ", \"datagrams_received\": %" G_GUINT64_FORMAT ", \"bytes_received\": %" G_GUINT64_FORMAT
+            ", \"send_kbps\": %.1f, \"receive_kbps\": %.1f,\n",
+            datagramsSent, bytesSent, datagramsReceived, bytesReceived,
+            seconds > 0 ? bytesSent * 8 / seconds / 1000 : 0.0, seconds > 0 ? bytesReceived * 8 / seconds / 1000 : 0.0);
+    fprintf(output, "     \"datagrams_lost\": %" G_GUINT64_FORMAT ", \"videorate_drops\": %" G_GUINT64_FORMAT
+            ", \"video_late_drops\": %" G_GUINT64_FORMAT ", \"memory_drops\": %" G_GUINT64_FORMAT
+            ", \"demux_errors\": %" G_GUINT64_FORMAT ",\n",
+            datagramsLost, rateDrops, lateDrops, memoryDrops, demuxErrors);
+
+    fprintf(output, "     ");
+    writeLatency(output, "video_latency_ns", videoLatency);
+    fprintf(output, ",\n     ");
+    writeLatency(output, "text_latency_ns", textLatency);
+    fprintf(output, ",\n     \"rss_kb\": %ld, \"rss_peak_kb\": %ld,\n", run->rssKb, run->rssPeakKb);
+
+    fprintf(output, "     \"threads\": [");
+    for (i = 0; i < run->endTicksCount; i++) {
+        startTicks = 0;
+        for (j = 0; j < run->ticksCount; j++) {
+            if (strcmp(run->ticks[j].name, run->endTicks[i].name) == 0)
+                startTicks = run->ticks[j].ticks;
+        }
+        fprintf(output, "%s\n       {\"name\": ", i == 0 ? "" : ",");
+        writeJsonString(output, run->endTicks[i].name);
+        fprintf(output, ", \"cpu_percent\": %.1f}",
+                seconds > 0 && run->endTicks[i].ticks > startTicks
+                    ? (run->endTicks[i].ticks - startTicks) / ticksPerSecond / seconds * 100 : 0.0);
+    }
+    fprintf(output, "]}");
+
+    g_array_free(videoLatency, TRUE);
+    g_array_free(textLatency, TRUE);
+}
+
+//==============================================================================
+
+static void writeJsonString(FILE *output, const char *text) {
+
+    fputc('"', output);
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\')
+            fprintf(output, "\\%c", *text);
+        else if ((unsigned char) *text < 0x20)
+            fprintf(output, "\\u%04x", (unsigned char) *text);
+        else
+            fputc(*text, output);
+    }
+    fputc('"', output);
+}
+
+//==============================================================================
+
+static void printUsage(const char *program) {
+
+    printf("Usage: %s [OPTION]...\n"
+           "Loopback benchmark of serialtextsrc, hthstreamsink and hthstreamsrc, results as JSON.\n"
+           "\n"
+           "  -r, --resolutions=LIST  WIDTHxHEIGHT list (default %s)\n"
+           "  -f, --framerates=LIST   frames per second list (default %s)\n"
+           "  -b, --bitrates=LIST     theoraenc kbit/s list (default %s)\n"
+           "  -s, --streams=LIST      sender/receiver pairs list, up to %d (default %s)\n"
+           "  -d, --duration=SECONDS  measure of each run (default %d)\n"
+           "  -w, --warmup=SECONDS    ignored start of each run (default %d)\n"
+           "  -p, --port=PORT         port of the first stream (default %d)\n"
+           "  -t, --serial-rate=HZ    serial messages per second and stream (default %d)\n"
+           "  -o, --output=FILE       write the JSON to FILE instead of stdout\n"
+           "  -l, --label=TEXT        build under test, copied to the JSON\n"
+           "  -h, --help              show this help\n",
+           program, DEFAULT_RESOLUTIONS, DEFAULT_FRAMERATES, DEFAULT_BITRATES, MAX_STREAMS, DEFAULT_STREAMS,
+           DEFAULT_DURATION, DEFAULT_WARMUP, DEFAULT_PORT, DEFAULT_SERIAL_RATE);
+}
+
+//==============================================================================
+
+int main(int argc, char *argv[]) {
+
+    static const struct option options[] = {
+        { "resolutions", required_argument, NULL, 'r' },
+        { "framerates", required_argument, NULL, 'f' },
+        { "bitrates", required_argument, NULL, 'b' },
+        { "streams", required_argument, NULL, 's' },
+        { "duration", required_argument, NULL, 'd' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "port", required_argument, NULL, 'p' },
+        { "serial-rate", required_argument, NULL, 't' },
+        { "output", required_argument, NULL, 'o' },
+        { "label", required_argument, NULL, 'l' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    const char *resolutions = DEFAULT_RESOLUTIONS, *framerates = DEFAULT_FRAMERATES, *bitrates = DEFAULT_BITRATES;
+    const char *streams = DEFAULT_STREAMS, *outputPath = NULL, *label = "";
+    unsigned int duration = DEFAULT_DURATION, warmup = DEFAULT_WARMUP, port = DEFAULT_PORT, serialRate = DEFAULT_SERIAL_RATE;
+    int widths[MAX_SWEEP_VALUES], heights[MAX_SWEEP_VALUES], rates[MAX_SWEEP_VALUES], bits[MAX_SWEEP_VALUES];
+    int counts[MAX_SWEEP_VALUES];
+    unsigned int resolutionCount, rateCount, bitCount, streamCount, r, f, b, s, i, runs = 0;
+    int option, ret = EXIT_SUCCESS;
+    gchar *version;
+    BenchRun *run;
+    FILE *output;
+
+    gst_init(&argc, &argv);
+
+    while ((option = getopt_long(argc, argv, "r:f:b:s:d:w:p:t:o:l:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'r': resolutions = optarg; break;
+            case 'f': framerates = optarg; break;
+            case 'b': bitrates = optarg; break;
+            case 's': streams = optarg; break;
+            case 'd': duration = strtoul(optarg, NULL, 10); break;
+            case 'w': warmup = strtoul(optarg, NULL, 10); break;
+            case 'p': port = strtoul(optarg, NULL, 10); break;
+            case 't': serialRate = strtoul(optarg, NULL, 10); break;
+            case 'o': outputPath = optarg; break;
+            case 'l': label = optarg; break;
+            case 'h': printUsage(argv[0]); return EXIT_SUCCESS;
+            default: printUsage(argv[0]); return EXIT_USAGE_FAILURE;
+        }
+    }
+
+    resolutionCount = parseResolutions(resolutions, widths, heights);
+    rateCount = parseList(framerates, rates);
+    bitCount = parseList(bitrates, bits);
+    streamCount = parseList(streams, counts);
+    for (i = 0; i < streamCount; i++) {
+        if (counts[i] > MAX_STREAMS)
+            streamCount = 0;
+    }
+
+    if (resolutionCount == 0 || rateCount == 0 || bitCount == 0 || streamCount == 0 || duration == 0
+        || serialRate == 0 || serialRate > G_USEC_PER_SEC || port == 0 || port + MAX_STREAMS > 65535) {
+        printUsage(argv[0]);
+        return EXIT_USAGE_FAILURE;
+    }
+
+    output = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+    if (output == NULL) {
+        fprintf(stderr, RED "Could not open %s: %s \n" RESET, outputPath, strerror(errno));
+        return EXIT_FILE_FAILURE;
+    }
+
+    fprintf(output, "{\"benchmark\": \"hthbench\", \"format\": 1, \"label\": ");
+    writeJsonString(output, label);
+    fprintf(output, ",\n \"gstreamer\": ");
+    version = gst_version_string();
+    writeJsonString(output, version);
+    g_free(version);
+    fprintf(output, ", \"cpus\": %ld, \"warmup_s\": %u, \"duration_s\": %u, \"serial_rate\": %u,\n \"runs\": [\n",
+            sysconf(_SC_NPROCESSORS_ONLN), warmup, duration, serialRate);
+
+    /** Same order on every build, so two documents can be diffed run by run */
+    for (r = 0; r < resolutionCount; r++)
+    for (f = 0; f < rateCount; f++)
+    for (b = 0; b < bitCount; b++)
+    for (s = 0; s < streamCount; s++) {
+
+        run = g_new0(BenchRun, 1);
+        run->width = widths[r];
+        run->height = heights[r];
+        run->framerate = rates[f];
+        run->bitrate = bits[b];
+        run->streamCount = counts[s];
+        run->duration = duration;
+        run->warmup = warmup;
+        run->port = port;
+        run->serialRate = serialRate;
+        for (i = 0; i < run->streamCount; i++) {
+            run->streams[i].ptyFd = -1;
+            g_mutex_init(&run->streams[i].lock);
+            run->streams[i].videoLatency = g_array_new(FALSE, FALSE, sizeof(gint64));
+            run->streams[i].textLatency = g_array_new(FALSE, FALSE, sizeof(gint64));
+        }
+
+        fprintf(stderr, GREEN "Run %u: %dx%d at %d fps, %d kbit/s, %u streams \n" RESET,
+                runs + 1, run->width, run->height, run->framerate, run->bitrate, run->streamCount);
+
+        if (buildPipeline(run))
+            runPipeline(run);
+        if (run->error != NULL) {
+            fprintf(stderr, RED "Run %u failed: %s \n" RESET, runs + 1, run->error);
+            ret = EXIT_RUN_FAILURE;
+        }
+
+        fprintf(output, runs == 0 ? "" : ",\n");
+        writeRun(output, run);
+        fflush(output);
+
+        clearRun(run);
+        g_free(run);
+        runs++;
+    }
+
+    fprintf(output, "\n ]}\n");
+    if (output != stdout)
+        fclose(output);
+
+    return ret;
+}
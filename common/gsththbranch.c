@@ -0,0 +1,366 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** branch header */
+#include "gsththbranch.h" /**< For the branch bookkeeping declarations */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+#define RESET   "\033[0m"
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+
+//==============================================================================
+
+/**
+ * @brief First buffer of a rebuilt branch, ends the restore
+ *
+ * @param pad Last pad of the branch
+ * @param info Probe info
+ * @param user_data The branch
+ * @return GstPadProbeReturn GST_PAD_PROBE_REMOVE
+ */
+static GstPadProbeReturn cb_branchRestoredProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Read the failed flag of a branch
+ *
+ * @param branch The branch
+ * @return gboolean TRUE between the error and the rebuild
+ */
+static gboolean branchIsFailed (GstHthBranch *branch);
+
+/**
+ * @brief Mask the flow errors returned by a failed branch
+ *
+ * @param branch The branch
+ * @param ret Flow return of the branch
+ * @return GstFlowReturn GST_FLOW_OK if the branch is failed and ret is an error
+ */
+static GstFlowReturn branchFlowReturn (GstHthBranch *branch, GstFlowReturn ret);
+
+/**
+ * @brief Chain functions of the isolated ghost pads
+ */
+static GstFlowReturn cb_ghostChain (GstPad *pad, GstObject *parent, GstBuffer *buffer);
+static GstFlowReturn cb_ghostChainList (GstPad *pad, GstObject *parent, GstBufferList *list);
+
+/**
+ * @brief Pad functions of the entry pairs, they forward everything to the other pad
+ */
+static GstFlowReturn cb_entryChain (GstPad *pad, GstObject *parent, GstBuffer *buffer);
+static GstFlowReturn cb_entryChainList (GstPad *pad, GstObject *parent, GstBufferList *list);
+static gboolean cb_entryEvent (GstPad *pad, GstObject *parent, GstEvent *event);
+static gboolean cb_entryQuery (GstPad *pad, GstObject *parent, GstQuery *query);
+
+//==============================================================================
+
+void gst_hth_branch_init (GstHthBranch *branch, GstElement *owner, const gchar *name){
+    
+    branch->owner = owner;
+    branch->name = name;
+    branch->failed = FALSE;
+    branch->restoring = FALSE;
+    branch->failureTime = 0;
+    branch->pendingRebuilds = 0;
+    branch->restarts = 0;
+    branch->lastRestoreTime = GST_CLOCK_TIME_NONE;
+    branch->maxRestoreTime = GST_CLOCK_TIME_NONE;
+}
+
+//==============================================================================
+
+GstHthBranchAction gst_hth_branch_fail (GstHthBranch *branch){
+    
+    GstHthBranchAction action;
+    
+    GST_OBJECT_LOCK (branch->owner);
+    
+    /** Errors of the other elements of a branch being rebuilt are ignored */
+    if (branch->failed) {
+        GST_OBJECT_UNLOCK (branch->owner);
+        return GST_HTH_BRANCH_PENDING;
+    }
+    
+    /** The time-to-restore counts from the first error */
+    if (!branch->restoring)
+        branch->failureTime = g_get_monotonic_time ();
+    
+    branch->failed = TRUE;
+    branch->restoring = FALSE;
+    action = branch->pendingRebuilds < HTH_BRANCH_MAX_REBUILDS ? GST_HTH_BRANCH_REBUILD : GST_HTH_BRANCH_GIVE_UP;
+    branch->pendingRebuilds++;
+    
+    GST_OBJECT_UNLOCK (branch->owner);
+    
+    return action;
+}
+
+//==============================================================================
+
+void gst_hth_branch_rebuilt (GstHthBranch *branch, GstPad *pad){
+    
+    GST_OBJECT_LOCK (branch->owner);
+    branch->failed = FALSE;
+    branch->restoring = TRUE;
+    GST_OBJECT_UNLOCK (branch->owner);
+    
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                       cb_branchRestoredProbe, branch, NULL);
+}
+
+//==============================================================================
+
+void gst_hth_branch_isolate_ghost_pad (GstHthBranch *branch, GstPad *ghostPad){
+    
+    gst_pad_set_element_private (ghostPad, branch);
+    gst_pad_set_chain_function (ghostPad, cb_ghostChain);
+    gst_pad_set_chain_list_function (ghostPad, cb_ghostChainList);
+}
+
+//==============================================================================
+
+GstPad *gst_hth_branch_entry_new (GstHthBranch *branch, const gchar *name, GstPad **srcPad){
+    
+    gchar *sinkName = g_strdup_printf ("%s_entry_sink", name);
+    gchar *srcName = g_strdup_printf ("%s_entry_src", name);
+    GstPad *sinkPad;
+    
+    sinkPad = gst_object_ref_sink (gst_pad_new (sinkName, GST_PAD_SINK));
+    *srcPad = gst_object_ref_sink (gst_pad_new (srcName, GST_PAD_SRC));
+    g_free (sinkName);
+    g_free (srcName);
+    
+    /** Each pad forwards to the other one */
+    gst_pad_set_element_private (sinkPad, *srcPad);
+    gst_pad_set_element_private (*srcPad, sinkPad);
+    g_object_set_data (G_OBJECT (sinkPad), "hth-branch", branch);
+    
+    gst_pad_set_chain_function (sinkPad, cb_entryChain);
+    gst_pad_set_chain_list_function (sinkPad, cb_entryChainList);
+    gst_pad_set_event_function (sinkPad, cb_entryEvent);
+    gst_pad_set_query_function (sinkPad, cb_entryQuery);
+    gst_pad_set_event_function (*srcPad, cb_entryEvent);
+    gst_pad_set_query_function (*srcPad, cb_entryQuery);
+    GST_PAD_SET_PROXY_CAPS (sinkPad);
+    GST_PAD_SET_PROXY_ALLOCATION (sinkPad);
+    
+    gst_pad_set_active (sinkPad, TRUE);
+    gst_pad_set_active (*srcPad, TRUE);
+    
+    return sinkPad;
+}
+
+//==============================================================================
+
+void gst_hth_branch_append_stats (GstHthBranch *branch, GstStructure *stats){
+    
+    gchar *restartsField = g_strdup_printf ("%s-restarts", branch->name);
+    gchar *lastField = g_strdup_printf ("%s-last-restore-time", branch->name);
+    gchar *maxField = g_strdup_printf ("%s-max-restore-time", branch->name);
+    
+    GST_OBJECT_LOCK (branch->owner);
+    gst_structure_set (stats,
+                       restartsField, G_TYPE_UINT, branch->restarts,
+                       lastField, G_TYPE_UINT64, branch->lastRestoreTime,
+                       maxField, G_TYPE_UINT64, branch->maxRestoreTime,
+                       NULL);
+    GST_OBJECT_UNLOCK (branch->owner);
+    
+    g_free (restartsField);
+    g_free (lastField);
+    g_free (maxField);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_branchRestoredProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthBranch *branch = (GstHthBranch*) user_data;
+    GstClockTime restoreTime;
+    GstStructure *restored;
+    guint restarts;
+    
+    GST_OBJECT_LOCK (branch->owner);
+    
+    /** The branch failed again before any data flowed */
+    if (!branch->restoring) {
+        GST_OBJECT_UNLOCK (branch->owner);
+        return GST_PAD_PROBE_REMOVE;
+    }
+    
+    restoreTime = (g_get_monotonic_time () - branch->failureTime) * GST_USECOND;
+    branch->restoring = FALSE;
+    branch->pendingRebuilds = 0;
+    branch->restarts++;
+    branch->lastRestoreTime = restoreTime;
+    if (!GST_CLOCK_TIME_IS_VALID (branch->maxRestoreTime) || restoreTime > branch->maxRestoreTime)
+        branch->maxRestoreTime = restoreTime;
+    restarts = branch->restarts;
+    
+    GST_OBJECT_UNLOCK (branch->owner);
+    
+    printf (GREEN "%s branch restored in %" GST_TIME_FORMAT " \n" RESET, branch->name, GST_TIME_ARGS (restoreTime));
+    
+    restored = gst_structure_new ("hth-branch-restored",
+                                  "branch", G_TYPE_STRING, branch->name,
+                                  "restore-time", G_TYPE_UINT64, restoreTime,
+                                  "restarts", G_TYPE_UINT, restarts,
+                                  NULL);
+    gst_element_post_message (branch->owner, gst_message_new_element (GST_OBJECT (branch->owner), restored));
+    
+    return GST_PAD_PROBE_REMOVE;
+}
+
+//==============================================================================
+
+static gboolean branchIsFailed (GstHthBranch *branch){
+    
+    gboolean failed;
+    
+    GST_OBJECT_LOCK (branch->owner);
+    failed = branch->failed;
+    GST_OBJECT_UNLOCK (branch->owner);
+    
+    return failed;
+}
+
+//==============================================================================
+
+static GstFlowReturn branchFlowReturn (GstHthBranch *branch, GstFlowReturn ret){
+    
+    /**
+     * The element posted its error before returning, so the branch is
+     * already failed. FLUSHING is also masked because the failed elements
+     * are being shut down, the real flushes reach a branch that is not failed.
+     */
+    if (ret < GST_FLOW_OK && ret != GST_FLOW_EOS && branchIsFailed (branch))
+        return GST_FLOW_OK;
+    
+    return ret;
+}
+
+//==============================================================================
+
+static GstFlowReturn cb_ghostChain (GstPad *pad, GstObject *parent, GstBuffer *buffer){
+    
+    GstHthBranch *branch = (GstHthBranch*) gst_pad_get_element_private (pad);
+    
+    if (branchIsFailed (branch)) {
+        gst_buffer_unref (buffer);
+        return GST_FLOW_OK;
+    }
+    
+    return branchFlowReturn (branch, gst_proxy_pad_chain_default (pad, parent, buffer));
+}
+
+//==============================================================================
+
+static GstFlowReturn cb_ghostChainList (GstPad *pad, GstObject *parent, GstBufferList *list){
+    
+    GstHthBranch *branch = (GstHthBranch*) gst_pad_get_element_private (pad);
+    
+    if (branchIsFailed (branch)) {
+        gst_buffer_list_unref (list);
+        return GST_FLOW_OK;
+    }
+    
+    return branchFlowReturn (branch, gst_proxy_pad_chain_list_default (pad, parent, list));
+}
+
+//==============================================================================
+
+static GstFlowReturn cb_entryChain (GstPad *pad, GstObject *parent, GstBuffer *buffer){
+    
+    GstHthBranch *branch = (GstHthBranch*) g_object_get_data (G_OBJECT (pad), "hth-branch");
+    GstPad *srcPad = (GstPad*) gst_pad_get_element_private (pad);
+    
+    if (branchIsFailed (branch)) {
+        gst_buffer_unref (buffer);
+        return GST_FLOW_OK;
+    }
+    
+    return branchFlowReturn (branch, gst_pad_push (srcPad, buffer));
+}
+
+//==============================================================================
+
+static GstFlowReturn cb_entryChainList (GstPad *pad, GstObject *parent, GstBufferList *list){
+    
+    GstHthBranch *branch = (GstHthBranch*) g_object_get_data (G_OBJECT (pad), "hth-branch");
+    GstPad *srcPad = (GstPad*) gst_pad_get_element_private (pad);
+    
+    if (branchIsFailed (branch)) {
+        gst_buffer_list_unref (list);
+        return GST_FLOW_OK;
+    }
+    
+    return branchFlowReturn (branch, gst_pad_push_list (srcPad, list));
+}
+
+//==============================================================================
+
+static gboolean cb_entryEvent (GstPad *pad, GstObject *parent, GstEvent *event){
+    
+    GstPad *otherPad = (GstPad*) gst_pad_get_element_private (pad);
+    
+    /** The sticky events stay on the src pad and reach the rebuilt branch */
+    return gst_pad_push_event (otherPad, event);
+}
+
+//==============================================================================
+
+static gboolean cb_entryQuery (GstPad *pad, GstObject *parent, GstQuery *query){
+    
+    GstPad *otherPad = (GstPad*) gst_pad_get_element_private (pad);
+    
+    return gst_pad_peer_query (otherPad, query);
+}
@@ -0,0 +1,167 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHBRANCH_H__
+#define __GST_HTHBRANCH_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Consecutive rebuilds of a branch without a buffer flowing before giving up
+ */
+#define HTH_BRANCH_MAX_REBUILDS 3
+
+/**
+ * @enum GstHthBranchAction
+ *
+ * @brief What the owner does after an error of a branch element
+ *
+ */
+typedef enum {
+    GST_HTH_BRANCH_REBUILD, /**< Schedule the rebuild of the branch */
+    GST_HTH_BRANCH_PENDING, /**< A rebuild is already scheduled, ignore the error */
+    GST_HTH_BRANCH_GIVE_UP  /**< The rebuilds don't help, forward the error */
+} GstHthBranchAction;
+
+/**
+ * @struct GstHthBranch
+ *
+ * @brief Restart bookkeeping of one internal branch (video, audio or text)
+ *
+ * When an element of a branch posts an error the bin tears down and
+ * rebuilds only that branch. The time from the error to the first buffer
+ * leaving the rebuilt branch is its time-to-restore.
+ *
+ * The counters are protected by the object lock of the owner.
+ *
+ */
+
+typedef struct _GstHthBranch GstHthBranch;
+
+struct _GstHthBranch {
+    
+    GstElement *owner; /**< Bin that owns the branch, posts the messages */
+    const gchar *name; /**< Branch name, prefix of the stats fields */
+    
+    gboolean failed; /**< Between the error and the rebuild, data is dropped */
+    gboolean restoring; /**< Rebuilt, waiting for the first buffer */
+    gint64 failureTime; /**< Monotonic time of the error, in us */
+    guint pendingRebuilds; /**< Rebuilds since the last buffer flowed */
+    
+    guint restarts; /**< Rebuilds that restored the data flow */
+    GstClockTime lastRestoreTime; /**< Time-to-restore of the last restart */
+    GstClockTime maxRestoreTime; /**< Longest time-to-restore */
+};
+
+/**
+ * @brief Initialize the bookkeeping of a branch
+ *
+ * @param branch The branch
+ * @param owner Bin that owns the branch
+ * @param name Branch name, a static string
+ */
+void gst_hth_branch_init (GstHthBranch *branch, GstElement *owner, const gchar *name);
+
+/**
+ * @brief Mark the branch as failed after an error of one of its elements
+ *
+ * @param branch The branch
+ * @return GstHthBranchAction GST_HTH_BRANCH_GIVE_UP after HTH_BRANCH_MAX_REBUILDS
+ * rebuilds in a row without data flowing
+ */
+GstHthBranchAction gst_hth_branch_fail (GstHthBranch *branch);
+
+/**
+ * @brief The branch was rebuilt, the restore ends with the first buffer on pad
+ *
+ * @param branch The branch
+ * @param pad Last pad of the rebuilt branch
+ */
+void gst_hth_branch_rebuilt (GstHthBranch *branch, GstPad *pad);
+
+/**
+ * @brief Isolate the upstream elements from the failures of the branch
+ *
+ * Replaces the chain functions of a ghost sink pad that feeds the branch.
+ * While the branch is failed the buffers are dropped, and the flow errors
+ * of a failed branch are returned as GST_FLOW_OK so the upstream elements
+ * keep streaming. The sticky events still go through and reach the new
+ * branch.
+ *
+ * @param branch The branch
+ * @param ghostPad Ghost sink pad of the owner
+ */
+void gst_hth_branch_isolate_ghost_pad (GstHthBranch *branch, GstPad *ghostPad);
+
+/**
+ * @brief Create a pair of pads that isolates a branch fed by an internal element
+ *
+ * Same as gst_hth_branch_isolate_ghost_pad() for a branch that starts at a
+ * src pad of an internal element (e.g. a demuxer pad). The returned sink
+ * pad is linked to that src pad and srcPad to the first element of the
+ * branch. Both pads have no parent and are activated in push mode.
+ *
+ * @param branch The branch
+ * @param name Name prefix of the pads
+ * @param srcPad Returns the src pad of the pair
+ * @return GstPad* The sink pad of the pair
+ */
+GstPad *gst_hth_branch_entry_new (GstHthBranch *branch, const gchar *name, GstPad **srcPad);
+
+/**
+ * @brief Add the restart counters of the branch to a stats structure
+ *
+ * Adds <name>-restarts, <name>-last-restore-time and <name>-max-restore-time.
+ *
+ * @param branch The branch
+ * @param stats Structure to fill
+ */
+void gst_hth_branch_append_stats (GstHthBranch *branch, GstStructure *stats);
+
+G_END_DECLS
+
+#endif /* __GST_HTHBRANCH_H__ */
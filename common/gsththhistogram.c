@@ -0,0 +1,184 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** histogram header */
+#include "gsththhistogram.h" /**< For the histogram declarations */
+
+/** string header file */
+#include <string.h> /**< For memset() */
+
+#define SUB_BUCKETS (1 << HTH_HISTOGRAM_SUB_BITS) /**< Buckets per power of two */
+
+//==============================================================================
+
+/**
+ * @brief Bucket of a value
+ *
+ * @param value The value
+ * @return guint Bucket index
+ */
+static guint getBucket (guint64 value);
+
+/**
+ * @brief Lowest value of a bucket
+ *
+ * @param bucket Bucket index
+ * @return guint64 Value
+ */
+static guint64 getBucketValue (guint bucket);
+
+/**
+ * @brief Add one field to a stats structure
+ *
+ * @param stats Structure to fill
+ * @param prefix Prefix of the field
+ * @param suffix Suffix of the field
+ * @param value Field value
+ * @return void
+ */
+static void appendField (GstStructure *stats, const gchar *prefix, const gchar *suffix, guint64 value);
+
+//==============================================================================
+
+void gst_hth_histogram_reset (GstHthHistogram *histogram){
+    
+    memset (histogram->counts, 0, sizeof (histogram->counts));
+    histogram->samples = 0;
+    histogram->min = G_MAXUINT64;
+    histogram->max = 0;
+    histogram->sum = 0.0;
+}
+
+//==============================================================================
+
+void gst_hth_histogram_record (GstHthHistogram *histogram, guint64 value){
+    
+    histogram->counts[getBucket (value)]++;
+    histogram->samples++;
+    histogram->min = MIN (histogram->min, value);
+    histogram->max = MAX (histogram->max, value);
+    histogram->sum += value;
+}
+
+//==============================================================================
+
+guint64 gst_hth_histogram_get_percentile (const GstHthHistogram *histogram, gdouble percentile){
+    
+    guint64 rank;
+    guint64 counted = 0;
+    guint bucket;
+    
+    if (histogram->samples == 0)
+        return 0;
+    
+    rank = (guint64) ((histogram->samples - 1) * percentile / 100.0) + 1;
+    for (bucket = 0; bucket < HTH_HISTOGRAM_BUCKETS; bucket++) {
+        counted += histogram->counts[bucket];
+        if (counted >= rank)
+            break;
+    }
+    
+    /** Never below the lowest value seen, nor above the highest */
+    return CLAMP (getBucketValue (MIN (bucket, HTH_HISTOGRAM_BUCKETS - 1)), histogram->min, histogram->max);
+}
+
+//==============================================================================
+
+void gst_hth_histogram_append_stats (const GstHthHistogram *histogram, GstStructure *stats, const gchar *prefix){
+    
+    appendField (stats, prefix, "p50", gst_hth_histogram_get_percentile (histogram, 50.0));
+    appendField (stats, prefix, "p95", gst_hth_histogram_get_percentile (histogram, 95.0));
+    appendField (stats, prefix, "p99", gst_hth_histogram_get_percentile (histogram, 99.0));
+    appendField (stats, prefix, "p999", gst_hth_histogram_get_percentile (histogram, 99.9));
+    appendField (stats, prefix, "min", histogram->samples > 0 ? histogram->min : 0);
+    appendField (stats, prefix, "max", histogram->max);
+    appendField (stats, prefix, "mean", histogram->samples > 0 ? (guint64) (histogram->sum / histogram->samples) : 0);
+}
+
+//==============================================================================
+
+static guint getBucket (guint64 value){
+    
+    guint shift;
+    
+    if (value < 2 * SUB_BUCKETS)
+        return (guint) value;
+    
+    /** The top HTH_HISTOGRAM_SUB_BITS + 1 bits of the value */
+    shift = g_bit_storage (value) - 1 - HTH_HISTOGRAM_SUB_BITS;
+    
+    return shift * SUB_BUCKETS + (guint) (value >> shift);
+}
+
+//==============================================================================
+
+static guint64 getBucketValue (guint bucket){
+    
+    guint shift;
+    
+    if (bucket < 2 * SUB_BUCKETS)
+        return bucket;
+    
+    shift = bucket / SUB_BUCKETS - 1;
+    
+    return ((guint64) (bucket % SUB_BUCKETS + SUB_BUCKETS)) << shift;
+}
+
+//==============================================================================
+
+static void appendField (GstStructure *stats, const gchar *prefix, const gchar *suffix, guint64 value){
+    
+    gchar *field;
+    
+    field = g_strdup_printf ("%s-%s", prefix, suffix);
+    gst_structure_set (stats, field, G_TYPE_UINT64, value, NULL);
+    g_free (field);
+}
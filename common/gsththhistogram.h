@@ -0,0 +1,116 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHHISTOGRAM_H__
+#define __GST_HTHHISTOGRAM_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Bits of the sub-buckets, 16 buckets per power of two
+ *
+ * The values are exact below 32, then rounded down by less than 1/16,
+ * like an HDR histogram with 1 significant digit.
+ */
+#define HTH_HISTOGRAM_SUB_BITS 4
+
+/**
+ * @brief Buckets covering the whole 64 bits range
+ */
+#define HTH_HISTOGRAM_BUCKETS ((64 - HTH_HISTOGRAM_SUB_BITS + 1) << HTH_HISTOGRAM_SUB_BITS)
+
+/**
+ * @struct GstHthHistogram
+ * @brief Log-linear histogram of unsigned values
+ *
+ * Fixed size, recording a value only increments counters, so it can be
+ * used from a streaming thread for every buffer. Not locked.
+ */
+typedef struct {
+    guint64 counts[HTH_HISTOGRAM_BUCKETS]; /**< Values of each bucket */
+    guint64 samples; /**< Values of all the buckets */
+    guint64 min; /**< Lowest value, G_MAXUINT64 without samples */
+    guint64 max; /**< Highest value */
+    gdouble sum; /**< Sum of the values, for the mean */
+} GstHthHistogram;
+
+/**
+ * @brief Forget all the values
+ * @param histogram The histogram
+ */
+void gst_hth_histogram_reset (GstHthHistogram *histogram);
+
+/**
+ * @brief Count a value
+ * @param histogram The histogram
+ * @param value The value
+ */
+void gst_hth_histogram_record (GstHthHistogram *histogram, guint64 value);
+
+/**
+ * @brief Value below which a percentage of the values fall
+ * @param histogram The histogram
+ * @param percentile Percentage, 0 to 100
+ * @return guint64 Lowest value of the bucket, 0 without samples
+ */
+guint64 gst_hth_histogram_get_percentile (const GstHthHistogram *histogram, gdouble percentile);
+
+/**
+ * @brief Add the summary of the histogram to a stats structure
+ *
+ * Adds <prefix>-p50, <prefix>-p95, <prefix>-p99, <prefix>-p999, <prefix>-min,
+ * <prefix>-max and <prefix>-mean.
+ *
+ * @param histogram The histogram
+ * @param stats Structure to fill
+ * @param prefix Prefix of the fields
+ */
+void gst_hth_histogram_append_stats (const GstHthHistogram *histogram, GstStructure *stats, const gchar *prefix);
+
+G_END_DECLS
+
+#endif /* __GST_HTHHISTOGRAM_H__ */
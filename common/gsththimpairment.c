@@ -0,0 +1,183 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** impairment header */
+#include "gsththimpairment.h" /**< For the impairment declarations */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/**
+ * @brief Colors for printed messages
+ *
+ */
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state, playing state or close state*/
+
+//==============================================================================
+
+/**
+ * @brief Set the properties of a description on the element
+ *
+ * @param impairment hthimpair element
+ * @param description Properties separated by spaces or commas
+ * @return gboolean FALSE on an unknown property or a token without value
+ */
+static gboolean setDescription(GstElement *impairment, const gchar *description);
+
+/**
+ * @brief Copy one field of the hthimpair stats with the impair- prefix
+ *
+ * @param field Field quark
+ * @param value Field value
+ * @param user_data Structure to fill
+ * @return gboolean TRUE to go on
+ */
+static gboolean cb_appendField(GQuark field, const GValue *value, gpointer user_data);
+
+//==============================================================================
+
+GstElement *gst_hth_impairment_insert (GstBin *bin, GstElement *upstream, GstElement *downstream, const gchar *description){
+    
+    GstElement *impairment;
+    
+    impairment = gst_element_factory_make(HTH_IMPAIRMENT_FACTORY, "impairment");
+    if (impairment == NULL) {
+        printf(RED "hthimpair is not installed, no impairment \n" RESET);
+        return NULL;
+    }
+    
+    if (!setDescription(impairment, description)) {
+        gst_object_unref(impairment);
+        return NULL;
+    }
+    
+    gst_element_unlink(upstream, downstream);
+    gst_bin_add(bin, impairment);
+    if (!gst_element_link_many(upstream, impairment, downstream, NULL)) {
+        printf(RED "Impairment fail linking pads, removed \n" RESET);
+        gst_hth_impairment_remove(bin, impairment, upstream, downstream);
+        return NULL;
+    }
+    
+    printf(GREEN "Impairment %s \n" RESET, description);
+    
+    return impairment;
+}
+
+//==============================================================================
+
+void gst_hth_impairment_remove (GstBin *bin, GstElement *impairment, GstElement *upstream, GstElement *downstream){
+    
+    /** Removing the element unlinks it from both sides */
+    gst_element_set_state(impairment, GST_STATE_NULL);
+    gst_bin_remove(bin, impairment);
+    
+    if (!gst_element_link(upstream, downstream))
+        printf(RED "Elements fail linking pads again after the impairment \n" RESET);
+}
+
+//==============================================================================
+
+void gst_hth_impairment_append_stats (GstElement *impairment, GstStructure *stats){
+    
+    GstStructure *impairmentStats = NULL;
+    
+    g_object_get(impairment, "stats", &impairmentStats, NULL);
+    if (impairmentStats == NULL)
+        return;
+    
+    gst_structure_foreach(impairmentStats, cb_appendField, stats);
+    gst_structure_free(impairmentStats);
+}
+
+//==============================================================================
+
+static gboolean setDescription(GstElement *impairment, const gchar *description){
+    
+    gchar **tokens;
+    gchar **pair;
+    gboolean valid = TRUE;
+    guint i;
+    
+    tokens = g_strsplit_set(description, " ,", -1);
+    for (i = 0; tokens[i] != NULL && valid; i++) {
+        
+        if (*tokens[i] == '\0')
+            continue;
+        
+        pair = g_strsplit(tokens[i], "=", 2);
+        if (pair[1] == NULL || g_object_class_find_property(G_OBJECT_GET_CLASS(impairment), pair[0]) == NULL) {
+            printf(RED "Invalid impairment %s \n" RESET, tokens[i]);
+            valid = FALSE;
+        } else {
+            gst_util_set_object_arg(G_OBJECT(impairment), pair[0], pair[1]);
+        }
+        g_strfreev(pair);
+    }
+    g_strfreev(tokens);
+    
+    return valid;
+}
+
+//==============================================================================
+
+static gboolean cb_appendField(GQuark field, const GValue *value, gpointer user_data){
+    
+    gchar *name;
+    
+    name = g_strdup_printf("impair-%s", g_quark_to_string(field));
+    gst_structure_set_value((GstStructure*) user_data, name, value);
+    g_free(name);
+    
+    return TRUE;
+}
@@ -0,0 +1,92 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHIMPAIRMENT_H__
+#define __GST_HTHIMPAIRMENT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Factory of the impairment element, from the impair plugin
+ */
+#define HTH_IMPAIRMENT_FACTORY "hthimpair"
+
+/**
+ * @brief Put an hthimpair element between two linked elements of a bin
+ *
+ * The description holds properties of hthimpair separated by spaces or
+ * commas, e.g. "loss=1 delay=40 jitter=10 seed=7". Called in the NULL
+ * state, the element follows the state of the bin.
+ *
+ * @param bin Bin of the two elements
+ * @param upstream Element linked to downstream
+ * @param downstream Element linked from upstream
+ * @param description Properties of hthimpair
+ * @return GstElement* The element, owned by the bin, NULL if hthimpair is not installed or the
+ * description is invalid, the two elements are linked again then
+ */
+GstElement *gst_hth_impairment_insert (GstBin *bin, GstElement *upstream, GstElement *downstream, const gchar *description);
+
+/**
+ * @brief Take an hthimpair element out and link the two elements again
+ * @param bin Bin of the elements
+ * @param impairment Element returned by gst_hth_impairment_insert()
+ * @param upstream Element linked to the impairment
+ * @param downstream Element linked from the impairment
+ */
+void gst_hth_impairment_remove (GstBin *bin, GstElement *impairment, GstElement *upstream, GstElement *downstream);
+
+/**
+ * @brief Add the stats of hthimpair to a stats structure, prefixed with impair-
+ * @param impairment The element
+ * @param stats Structure to fill
+ */
+void gst_hth_impairment_append_stats (GstElement *impairment, GstStructure *stats);
+
+G_END_DECLS
+
+#endif /* __GST_HTHIMPAIRMENT_H__ */
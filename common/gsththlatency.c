@@ -0,0 +1,407 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** c libraries */
+#include <string.h> /**< For strcmp */
+
+/** latency tracer header */
+#include "gsththlatency.h" /**< For the latency tracer declarations */
+
+/** histogram header */
+#include "gsththhistogram.h" /**< For the residency histograms */
+
+//==============================================================================
+
+/**
+ * @struct HthLatencyEntry
+ * @brief A buffer that entered a stage
+ */
+typedef struct {
+    GstClockTime pts; /**< PTS of the buffer, GST_CLOCK_TIME_NONE once matched */
+    GstClockTime time; /**< Monotonic time it entered */
+} HthLatencyEntry;
+
+/**
+ * @struct HthLatencyStage
+ * @brief Probes and histograms of one stage
+ */
+typedef struct {
+    
+    GstHthLatency *latency; /**< Tracer of the stage */
+    GMutex lock; /**< Protects the ring and the histograms, taken after the lock of the tracer */
+    gchar *name; /**< Prefix of the stats fields */
+    GstPad *entry; /**< Entry pad, NULL once detached */
+    GstPad *exit; /**< Exit pad, NULL once detached */
+    gulong entryProbe; /**< Probe id on the entry pad */
+    gulong exitProbe; /**< Probe id on the exit pad */
+    gboolean matchLast; /**< Measure from the last buffer entered */
+    
+    HthLatencyEntry pending[HTH_LATENCY_PENDING]; /**< Ring of the buffers inside the stage */
+    guint next; /**< Next slot of the ring */
+    GstClockTime lastEntry; /**< Monotonic time of the last buffer entered */
+    
+    GstHthHistogram total; /**< Residency in ns since the stage was added, for the stats */
+    GstHthHistogram window; /**< Residency in ns since the previous message */
+    GstClockTime nextCheck; /**< Monotonic time this stage looks again if a message is due */
+    
+} HthLatencyStage;
+
+struct _GstHthLatency {
+    
+    GstElement *owner; /**< Element posting the messages */
+    GMutex lock; /**< Protects the stages list and the message timing */
+    GList *stages; /**< HthLatencyStage of every stage ever added */
+    GstClockTime interval; /**< Period of the messages, 0 for none */
+    GstClockTime lastPost; /**< Monotonic time of the previous message */
+};
+
+//==============================================================================
+
+/**
+ * @brief Add the summary of a residency histogram to a structure
+ *
+ * @param stats Structure to fill
+ * @param name Stage name
+ * @param histogram The histogram
+ */
+static void appendHistogram (GstStructure *stats, const gchar *name, const GstHthHistogram *histogram);
+
+/**
+ * @brief Post the message of the windows if the interval elapsed
+ *
+ * Takes the lock of the tracer, then the lock of each stage.
+ *
+ * @param latency The tracer
+ * @param now Monotonic time of the caller
+ */
+static void postWindows (GstHthLatency *latency, GstClockTime now);
+
+/**
+ * @brief Remove the probes of a stage, called with the lock of the tracer
+ *
+ * @param stage The stage
+ */
+static void detachStage (HthLatencyStage *stage);
+
+/**
+ * @brief Remember the time a buffer entered a stage
+ *
+ * @param pad Entry pad
+ * @param info Probe info with the buffer
+ * @param user_data The HthLatencyStage
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_entryProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count the residency of a buffer leaving a stage
+ *
+ * Also posts the periodic message once the interval elapsed.
+ *
+ * @param pad Exit pad
+ * @param info Probe info with the buffer
+ * @param user_data The HthLatencyStage
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_exitProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+//==============================================================================
+
+GstHthLatency *gst_hth_latency_new (GstElement *owner){
+    
+    GstHthLatency *latency = g_new0 (GstHthLatency, 1);
+    
+    latency->owner = owner;
+    latency->lastPost = GST_CLOCK_TIME_NONE;
+    g_mutex_init (&latency->lock);
+    
+    return latency;
+}
+
+//==============================================================================
+
+void gst_hth_latency_free (GstHthLatency *latency){
+    
+    GList *item;
+    HthLatencyStage *stage;
+    
+    for (item = latency->stages; item != NULL; item = item->next) {
+        stage = (HthLatencyStage*) item->data;
+        detachStage (stage);
+        g_mutex_clear (&stage->lock);
+        g_free (stage->name);
+        g_free (stage);
+    }
+    
+    g_list_free (latency->stages);
+    g_mutex_clear (&latency->lock);
+    g_free (latency);
+}
+
+//==============================================================================
+
+void gst_hth_latency_set_interval (GstHthLatency *latency, GstClockTime interval){
+    
+    g_mutex_lock (&latency->lock);
+    latency->interval = GST_CLOCK_TIME_IS_VALID (interval) ? interval : 0;
+    g_mutex_unlock (&latency->lock);
+}
+
+//==============================================================================
+
+void gst_hth_latency_add_stage (GstHthLatency *latency, const gchar *name, GstPad *entry, GstPad *exit,
+                                gboolean matchLast){
+    
+    HthLatencyStage *stage = NULL;
+    GList *item;
+    guint i;
+    
+    if (entry == NULL || exit == NULL)
+        return;
+    
+    g_mutex_lock (&latency->lock);
+    
+    for (item = latency->stages; item != NULL && stage == NULL; item = item->next) {
+        if (strcmp (((HthLatencyStage*) item->data)->name, name) == 0)
+            stage = (HthLatencyStage*) item->data;
+    }
+    
+    if (stage == NULL) {
+        stage = g_new0 (HthLatencyStage, 1);
+        stage->latency = latency;
+        stage->name = g_strdup (name);
+        g_mutex_init (&stage->lock);
+        gst_hth_histogram_reset (&stage->total);
+        gst_hth_histogram_reset (&stage->window);
+        latency->stages = g_list_append (latency->stages, stage);
+    }
+    
+    detachStage (stage);
+    
+    g_mutex_lock (&stage->lock);
+    stage->matchLast = matchLast;
+    stage->lastEntry = GST_CLOCK_TIME_NONE;
+    for (i = 0; i < HTH_LATENCY_PENDING; i++)
+        stage->pending[i].pts = GST_CLOCK_TIME_NONE;
+    g_mutex_unlock (&stage->lock);
+    
+    stage->entry = gst_object_ref (entry);
+    stage->exit = gst_object_ref (exit);
+    stage->entryProbe = gst_pad_add_probe (entry, GST_PAD_PROBE_TYPE_BUFFER, cb_entryProbe, stage, NULL);
+    stage->exitProbe = gst_pad_add_probe (exit, GST_PAD_PROBE_TYPE_BUFFER, cb_exitProbe, stage, NULL);
+    
+    g_mutex_unlock (&latency->lock);
+}
+
+//==============================================================================
+
+void gst_hth_latency_detach_stages (GstHthLatency *latency, const gchar *prefix){
+    
+    GList *item;
+    HthLatencyStage *stage;
+    
+    g_mutex_lock (&latency->lock);
+    for (item = latency->stages; item != NULL; item = item->next) {
+        stage = (HthLatencyStage*) item->data;
+        if (prefix == NULL || g_str_has_prefix (stage->name, prefix))
+            detachStage (stage);
+    }
+    g_mutex_unlock (&latency->lock);
+}
+
+//==============================================================================
+
+void gst_hth_latency_append_stats (GstHthLatency *latency, GstStructure *stats){
+    
+    GList *item;
+    HthLatencyStage *stage;
+    
+    g_mutex_lock (&latency->lock);
+    for (item = latency->stages; item != NULL; item = item->next) {
+        stage = (HthLatencyStage*) item->data;
+        g_mutex_lock (&stage->lock);
+        appendHistogram (stats, stage->name, &stage->total);
+        g_mutex_unlock (&stage->lock);
+    }
+    g_mutex_unlock (&latency->lock);
+}
+
+//==============================================================================
+
+static void appendHistogram (GstStructure *stats, const gchar *name, const GstHthHistogram *histogram){
+    
+    gchar *field;
+    
+    field = g_strdup_printf ("%s-latency", name);
+    gst_hth_histogram_append_stats (histogram, stats, field);
+    g_free (field);
+    
+    field = g_strdup_printf ("%s-latency-buffers", name);
+    gst_structure_set (stats, field, G_TYPE_UINT64, histogram->samples, NULL);
+    g_free (field);
+}
+
+//==============================================================================
+
+static void postWindows (GstHthLatency *latency, GstClockTime now){
+    
+    GstStructure *message = NULL;
+    HthLatencyStage *stage;
+    GList *item;
+    
+    g_mutex_lock (&latency->lock);
+    
+    if (!GST_CLOCK_TIME_IS_VALID (latency->lastPost))
+        latency->lastPost = now;
+    
+    if (latency->interval > 0 && now - latency->lastPost >= latency->interval) {
+        latency->lastPost = now;
+        message = gst_structure_new_empty (HTH_LATENCY_MESSAGE);
+        for (item = latency->stages; item != NULL; item = item->next) {
+            stage = (HthLatencyStage*) item->data;
+            g_mutex_lock (&stage->lock);
+            appendHistogram (message, stage->name, &stage->window);
+            gst_hth_histogram_reset (&stage->window);
+            g_mutex_unlock (&stage->lock);
+        }
+    }
+    
+    g_mutex_unlock (&latency->lock);
+    
+    if (message != NULL)
+        gst_element_post_message (latency->owner, gst_message_new_element (GST_OBJECT (latency->owner), message));
+}
+
+//==============================================================================
+
+static void detachStage (HthLatencyStage *stage){
+    
+    if (stage->entry == NULL)
+        return;
+    
+    gst_pad_remove_probe (stage->entry, stage->entryProbe);
+    gst_pad_remove_probe (stage->exit, stage->exitProbe);
+    gst_object_unref (stage->entry);
+    gst_object_unref (stage->exit);
+    stage->entry = NULL;
+    stage->exit = NULL;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_entryProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthLatencyStage *stage = (HthLatencyStage*) user_data;
+    GstClockTime pts = GST_BUFFER_PTS (GST_PAD_PROBE_INFO_BUFFER (info));
+    GstClockTime now = gst_util_get_timestamp ();
+    
+    g_mutex_lock (&stage->lock);
+    
+    stage->lastEntry = now;
+    
+    /** The oldest buffer is overwritten, it was dropped inside the stage or lost its PTS */
+    if (GST_CLOCK_TIME_IS_VALID (pts) && !stage->matchLast) {
+        stage->pending[stage->next].pts = pts;
+        stage->pending[stage->next].time = now;
+        stage->next = (stage->next + 1) % HTH_LATENCY_PENDING;
+    }
+    
+    g_mutex_unlock (&stage->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_exitProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthLatencyStage *stage = (HthLatencyStage*) user_data;
+    GstClockTime pts = GST_BUFFER_PTS (GST_PAD_PROBE_INFO_BUFFER (info));
+    GstClockTime now = gst_util_get_timestamp ();
+    GstClockTime entered = GST_CLOCK_TIME_NONE;
+    gboolean check = FALSE;
+    HthLatencyEntry *entry;
+    guint i;
+    
+    g_mutex_lock (&stage->lock);
+    
+    if (stage->matchLast) {
+        entered = stage->lastEntry;
+    } else if (GST_CLOCK_TIME_IS_VALID (pts)) {
+        /** Newest first, the buffer most likely entered recently */
+        for (i = 1; i <= HTH_LATENCY_PENDING; i++) {
+            entry = &stage->pending[(stage->next + HTH_LATENCY_PENDING - i) % HTH_LATENCY_PENDING];
+            if (entry->pts == pts) {
+                entered = entry->time;
+                entry->pts = GST_CLOCK_TIME_NONE;
+                break;
+            }
+        }
+    }
+    
+    if (GST_CLOCK_TIME_IS_VALID (entered) && now >= entered) {
+        gst_hth_histogram_record (&stage->total, now - entered);
+        gst_hth_histogram_record (&stage->window, now - entered);
+    }
+    
+    /** The lock of the tracer is taken a few times per second, not for every buffer */
+    if (now >= stage->nextCheck) {
+        stage->nextCheck = now + HTH_LATENCY_CHECK_PERIOD;
+        check = TRUE;
+    }
+    
+    g_mutex_unlock (&stage->lock);
+    
+    if (check)
+        postWindows (stage->latency, now);
+    
+    return GST_PAD_PROBE_OK;
+}
@@ -0,0 +1,143 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHLATENCY_H__
+#define __GST_HTHLATENCY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Buffers of a stage waiting for their exit, older ones are forgotten
+ */
+#define HTH_LATENCY_PENDING 64
+
+/**
+ * @brief Period at which a stage looks if the periodic message is due
+ */
+#define HTH_LATENCY_CHECK_PERIOD (100 * GST_MSECOND)
+
+/**
+ * @brief Name of the periodic element message
+ */
+#define HTH_LATENCY_MESSAGE "hth-latency"
+
+/**
+ * @struct GstHthLatency
+ * @brief Residency time of the buffers in the stages of a bin
+ *
+ * A stage is the path between two pads, usually the sink and src pads of
+ * one element. A buffer is matched by its PTS when it leaves the stage,
+ * the buffers whose PTS the stage changes are not counted. Without stages
+ * no probe is installed and the tracer costs nothing.
+ */
+typedef struct _GstHthLatency GstHthLatency;
+
+/**
+ * @brief Create a tracer without stages
+ * @param owner Element posting the periodic messages, not referenced
+ * @return GstHthLatency* The tracer
+ */
+GstHthLatency *gst_hth_latency_new (GstElement *owner);
+
+/**
+ * @brief Free a tracer, its stages must be detached
+ * @param latency The tracer
+ */
+void gst_hth_latency_free (GstHthLatency *latency);
+
+/**
+ * @brief Period of the HTH_LATENCY_MESSAGE element messages
+ *
+ * The message carries the percentiles of the buffers that left each stage
+ * since the previous one. It is posted from the streaming thread of the
+ * first buffer leaving a stage after the period.
+ *
+ * @param latency The tracer
+ * @param interval Period, 0 or GST_CLOCK_TIME_NONE posts nothing
+ */
+void gst_hth_latency_set_interval (GstHthLatency *latency, GstClockTime interval);
+
+/**
+ * @brief Measure the buffers between two pads
+ *
+ * A stage with the name of a detached one gets its histograms back.
+ *
+ * @param latency The tracer
+ * @param name Stage name, prefix of the stats fields
+ * @param entry Pad where the buffers enter the stage
+ * @param exit Pad where the buffers leave the stage
+ * @param matchLast Measure from the last buffer entered instead of matching the
+ * PTS, for the demuxers whose input has no frame timestamps
+ */
+void gst_hth_latency_add_stage (GstHthLatency *latency, const gchar *name, GstPad *entry, GstPad *exit,
+                                gboolean matchLast);
+
+/**
+ * @brief Remove the probes of some stages, their histograms are kept
+ *
+ * Called before the elements of the stages are removed from the bin.
+ *
+ * @param latency The tracer
+ * @param prefix Detach the stages whose name starts with it, NULL for all
+ */
+void gst_hth_latency_detach_stages (GstHthLatency *latency, const gchar *prefix);
+
+/**
+ * @brief Add the residency percentiles of every stage to a stats structure
+ *
+ * Adds <stage>-latency-p50, -p95, -p99, -p999, -min, -max and -mean in ns
+ * (see GstHthHistogram) and <stage>-latency-buffers, since the stage was
+ * first added.
+ *
+ * @param latency The tracer
+ * @param stats Structure to fill
+ */
+void gst_hth_latency_append_stats (GstHthLatency *latency, GstStructure *stats);
+
+G_END_DECLS
+
+#endif /* __GST_HTHLATENCY_H__ */
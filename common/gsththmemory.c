@@ -0,0 +1,418 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** memory budget header */
+#include "gsththmemory.h" /**< For the memory budget declarations */
+
+
+#define QUEUE_SIZE_PROPERTY "max-size-bytes" /**< queue2 property derived from the budget */
+
+//==============================================================================
+
+struct _GstHthMemory {
+    
+    gint refCount; /**< Owner and watched queues, atomic */
+    GMutex lock; /**< Protects the counters and the queues list */
+    guint64 limit; /**< Bytes, 0 for no limit */
+    guint64 used[GST_HTH_MEMORY_PRIORITIES]; /**< Bytes inside the watched queues, by priority */
+    guint64 reserved; /**< Bytes held outside the queues */
+    guint64 peak; /**< Highest used plus reserved */
+    guint64 drops[GST_HTH_MEMORY_PRIORITIES]; /**< Buffers dropped by priority */
+    GList *queues; /**< HthMemoryQueue of the watched queues */
+};
+
+/**
+ * @struct HthMemoryQueue
+ * @brief Probe data of one watched queue
+ */
+typedef struct {
+    GstHthMemory *memory; /**< Budget, one reference */
+    GstHthMemoryPriority priority; /**< Drop order */
+    gint refCount; /**< One per probe, atomic */
+    GWeakRef queue; /**< The queue, for its size limit */
+    guint defaultSize; /**< max-size-bytes of the queue before the budget set it, 0 without the property */
+    guint64 bytes; /**< Bytes between the sink and the src pad of the queue */
+    gboolean waitKeyframe; /**< A video buffer was dropped, the deltas are dropped too */
+} HthMemoryQueue;
+
+//==============================================================================
+
+/**
+ * @brief Drop level of one priority
+ *
+ * The level is taken from the budget left by the reserved bytes.
+ *
+ * @param memory The budget, locked
+ * @param priority Drop order
+ * @return guint64 Bytes all the queues may hold before the buffers of the priority are dropped
+ */
+static guint64 getDropLevel (GstHthMemory *memory, GstHthMemoryPriority priority);
+
+/**
+ * @brief Bytes inside all the watched queues
+ *
+ * @param memory The budget, locked
+ * @return guint64 Sum of the priorities
+ */
+static guint64 getUsed (GstHthMemory *memory);
+
+/**
+ * @brief Set max-size-bytes of the watched queues from the budget
+ *
+ * A queue gets the drop level of its priority, or its own value back without limit.
+ *
+ * @param memory The budget
+ * @return void
+ */
+static void applyQueueSizes (GstHthMemory *memory);
+
+/**
+ * @brief Count or drop a buffer entering a queue, forget the bytes of a flush
+ *
+ * @param pad Sink pad of the queue
+ * @param info Probe info with the buffer or the flush event
+ * @param user_data The HthMemoryQueue
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP over the budget
+ */
+static GstPadProbeReturn cb_queueInProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Uncount a buffer leaving a queue
+ *
+ * @param pad Src pad of the queue
+ * @param info Probe info with the buffer
+ * @param user_data The HthMemoryQueue
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_queueOutProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Release the probe data of a queue, freed with the last probe
+ *
+ * @param data The HthMemoryQueue
+ */
+static void freeMemoryQueue (gpointer data);
+
+//==============================================================================
+
+GstHthMemory *gst_hth_memory_new (void){
+    
+    GstHthMemory *memory = g_new0 (GstHthMemory, 1);
+    
+    memory->refCount = 1;
+    g_mutex_init (&memory->lock);
+    
+    return memory;
+}
+
+//==============================================================================
+
+void gst_hth_memory_unref (GstHthMemory *memory){
+    
+    if (!g_atomic_int_dec_and_test (&memory->refCount))
+        return;
+    
+    g_mutex_clear (&memory->lock);
+    g_free (memory);
+}
+
+//==============================================================================
+
+void gst_hth_memory_set_limit (GstHthMemory *memory, guint64 limit){
+    
+    g_mutex_lock (&memory->lock);
+    memory->limit = limit;
+    g_mutex_unlock (&memory->lock);
+    
+    applyQueueSizes (memory);
+}
+
+//==============================================================================
+
+guint64 gst_hth_memory_get_limit (GstHthMemory *memory){
+    
+    guint64 limit;
+    
+    g_mutex_lock (&memory->lock);
+    limit = memory->limit;
+    g_mutex_unlock (&memory->lock);
+    
+    return limit;
+}
+
+//==============================================================================
+
+void gst_hth_memory_set_reserved (GstHthMemory *memory, guint64 bytes){
+    
+    g_mutex_lock (&memory->lock);
+    memory->reserved = bytes;
+    memory->peak = MAX (memory->peak, getUsed (memory) + memory->reserved);
+    g_mutex_unlock (&memory->lock);
+    
+    applyQueueSizes (memory);
+}
+
+//==============================================================================
+
+void gst_hth_memory_watch_queue (GstHthMemory *memory, GstElement *queue, GstHthMemoryPriority priority){
+    
+    HthMemoryQueue *watched;
+    GstPad *sinkPad;
+    GstPad *srcPad;
+    
+    if (queue == NULL)
+        return;
+    
+    watched = g_new0 (HthMemoryQueue, 1);
+    watched->memory = memory;
+    watched->priority = priority;
+    watched->refCount = 2;
+    g_weak_ref_init (&watched->queue, queue);
+    g_atomic_int_inc (&memory->refCount);
+    
+    /** identity in queueless mode has no size limit */
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (queue), QUEUE_SIZE_PROPERTY) != NULL)
+        g_object_get (queue, QUEUE_SIZE_PROPERTY, &watched->defaultSize, NULL);
+    
+    g_mutex_lock (&memory->lock);
+    memory->queues = g_list_prepend (memory->queues, watched);
+    g_mutex_unlock (&memory->lock);
+    
+    sinkPad = gst_element_get_static_pad (queue, "sink");
+    gst_pad_add_probe (sinkPad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+                       cb_queueInProbe, watched, freeMemoryQueue);
+    gst_object_unref (sinkPad);
+    
+    srcPad = gst_element_get_static_pad (queue, "src");
+    gst_pad_add_probe (srcPad, GST_PAD_PROBE_TYPE_BUFFER, cb_queueOutProbe, watched, freeMemoryQueue);
+    gst_object_unref (srcPad);
+    
+    applyQueueSizes (memory);
+}
+
+//==============================================================================
+
+void gst_hth_memory_append_stats (GstHthMemory *memory, GstStructure *stats){
+    
+    g_mutex_lock (&memory->lock);
+    gst_structure_set (stats,
+                       "memory-used", G_TYPE_UINT64, getUsed (memory) + memory->reserved,
+                       "memory-reserved", G_TYPE_UINT64, memory->reserved,
+                       "memory-peak", G_TYPE_UINT64, memory->peak,
+                       "max-memory", G_TYPE_UINT64, memory->limit,
+                       "video-memory-used", G_TYPE_UINT64, memory->used[GST_HTH_MEMORY_VIDEO],
+                       "audio-memory-used", G_TYPE_UINT64, memory->used[GST_HTH_MEMORY_AUDIO],
+                       "text-memory-used", G_TYPE_UINT64, memory->used[GST_HTH_MEMORY_TEXT],
+                       "video-memory-drops", G_TYPE_UINT64, memory->drops[GST_HTH_MEMORY_VIDEO],
+                       "audio-memory-drops", G_TYPE_UINT64, memory->drops[GST_HTH_MEMORY_AUDIO],
+                       "text-memory-drops", G_TYPE_UINT64, memory->drops[GST_HTH_MEMORY_TEXT],
+                       NULL);
+    g_mutex_unlock (&memory->lock);
+}
+
+//==============================================================================
+
+static guint64 getDropLevel (GstHthMemory *memory, GstHthMemoryPriority priority){
+    
+    guint64 available = memory->limit - MIN (memory->limit, memory->reserved);
+    
+    switch (priority) {
+        case GST_HTH_MEMORY_AUDIO:
+            return available / 100 * HTH_MEMORY_AUDIO_LEVEL;
+        case GST_HTH_MEMORY_TEXT:
+            return available / 100 * HTH_MEMORY_TEXT_LEVEL;
+        default:
+            return available / 100 * HTH_MEMORY_VIDEO_LEVEL;
+    }
+}
+
+//==============================================================================
+
+static guint64 getUsed (GstHthMemory *memory){
+    
+    guint64 used = 0;
+    guint i;
+    
+    for (i = 0; i < GST_HTH_MEMORY_PRIORITIES; i++)
+        used += memory->used[i];
+    
+    return used;
+}
+
+//==============================================================================
+
+static void applyQueueSizes (GstHthMemory *memory){
+    
+    HthMemoryQueue *watched;
+    GstElement *queue;
+    GList *queues = NULL;
+    GList *sizes = NULL;
+    GList *item;
+    GList *size;
+    guint64 bytes;
+    
+    /** Collected under the lock, set outside of it: queue2 takes its own lock */
+    g_mutex_lock (&memory->lock);
+    for (item = memory->queues; item != NULL; item = item->next) {
+        watched = (HthMemoryQueue*) item->data;
+        if (watched->defaultSize == 0)
+            continue;
+        queue = g_weak_ref_get (&watched->queue);
+        if (queue == NULL)
+            continue;
+        bytes = memory->limit > 0 ? getDropLevel (memory, watched->priority) : watched->defaultSize;
+        queues = g_list_prepend (queues, queue);
+        sizes = g_list_prepend (sizes, GUINT_TO_POINTER ((guint) CLAMP (bytes, 1, G_MAXUINT)));
+    }
+    g_mutex_unlock (&memory->lock);
+    
+    for (item = queues, size = sizes; item != NULL; item = item->next, size = size->next) {
+        g_object_set (item->data, QUEUE_SIZE_PROPERTY, GPOINTER_TO_UINT (size->data), NULL);
+        gst_object_unref (item->data);
+    }
+    
+    g_list_free (queues);
+    g_list_free (sizes);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_queueInProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthMemoryQueue *watched = (HthMemoryQueue*) user_data;
+    GstHthMemory *memory = watched->memory;
+    GstBuffer *buffer;
+    gsize size;
+    gboolean keyframe;
+    gboolean drop;
+    
+    /** The queue discarded what it held */
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+        if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP) {
+            g_mutex_lock (&memory->lock);
+            memory->used[watched->priority] -= MIN (memory->used[watched->priority], watched->bytes);
+            watched->bytes = 0;
+            g_mutex_unlock (&memory->lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+    
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    size = gst_buffer_get_size (buffer);
+    keyframe = !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    
+    g_mutex_lock (&memory->lock);
+    
+    /** One budget for all the kinds, the video stops first so the audio and the text still fit */
+    drop = memory->limit > 0 && getUsed (memory) + size > getDropLevel (memory, watched->priority);
+    
+    /** Only the probe thread of the queue touches waitKeyframe */
+    if (watched->priority == GST_HTH_MEMORY_VIDEO) {
+        if (drop)
+            watched->waitKeyframe = TRUE;
+        else if (watched->waitKeyframe && keyframe)
+            watched->waitKeyframe = FALSE;
+        drop = watched->waitKeyframe;
+    }
+    
+    if (drop) {
+        memory->drops[watched->priority]++;
+        g_mutex_unlock (&memory->lock);
+        return GST_PAD_PROBE_DROP;
+    }
+    
+    watched->bytes += size;
+    memory->used[watched->priority] += size;
+    memory->peak = MAX (memory->peak, getUsed (memory) + memory->reserved);
+    
+    g_mutex_unlock (&memory->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_queueOutProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthMemoryQueue *watched = (HthMemoryQueue*) user_data;
+    GstHthMemory *memory = watched->memory;
+    gsize size = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+    
+    /** A flush may have already forgotten the buffer */
+    g_mutex_lock (&memory->lock);
+    size = MIN (size, watched->bytes);
+    watched->bytes -= size;
+    memory->used[watched->priority] -= MIN (memory->used[watched->priority], size);
+    g_mutex_unlock (&memory->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static void freeMemoryQueue (gpointer data){
+    
+    HthMemoryQueue *watched = (HthMemoryQueue*) data;
+    GstHthMemory *memory = watched->memory;
+    
+    if (!g_atomic_int_dec_and_test (&watched->refCount))
+        return;
+    
+    /** The queue is gone with what it held */
+    g_mutex_lock (&memory->lock);
+    memory->queues = g_list_remove (memory->queues, watched);
+    memory->used[watched->priority] -= MIN (memory->used[watched->priority], watched->bytes);
+    g_mutex_unlock (&memory->lock);
+    
+    g_weak_ref_clear (&watched->queue);
+    gst_hth_memory_unref (memory);
+    g_free (watched);
+}
@@ -0,0 +1,156 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHMEMORY_H__
+#define __GST_HTHMEMORY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @enum GstHthMemoryPriority
+ *
+ * @brief Kind of a watched queue, in drop order
+ *
+ */
+typedef enum {
+    GST_HTH_MEMORY_VIDEO, /**< Dropped first, once HTH_MEMORY_VIDEO_LEVEL percent of the budget is used */
+    GST_HTH_MEMORY_AUDIO, /**< Dropped once HTH_MEMORY_AUDIO_LEVEL percent of the budget is used */
+    GST_HTH_MEMORY_TEXT,  /**< Dropped last, only when the whole budget is used */
+    GST_HTH_MEMORY_PRIORITIES
+} GstHthMemoryPriority;
+
+/**
+ * @brief Percent of the budget used by all the queues above which the video buffers are dropped
+ */
+#define HTH_MEMORY_VIDEO_LEVEL 80
+
+/**
+ * @brief Percent of the budget used by all the queues above which the audio buffers are dropped
+ */
+#define HTH_MEMORY_AUDIO_LEVEL 95
+
+/**
+ * @brief Percent of the budget used by all the queues above which the text buffers are dropped
+ */
+#define HTH_MEMORY_TEXT_LEVEL 100
+
+/**
+ * @struct GstHthMemory
+ * @brief Memory budget shared by the internal queues of one bin
+ *
+ * Each watched queue counts the bytes between its sink and its src pad,
+ * and all the queues take from the same budget. A buffer that would take
+ * the total over the drop level of its priority is dropped before it
+ * enters the queue: as the budget fills the video goes first, then the
+ * audio, and the text only when nothing is left. The max-size-bytes of
+ * the queues follows the drop levels, so queue2 never holds more than
+ * the budget allows.
+ */
+typedef struct _GstHthMemory GstHthMemory;/**
+ * @brief Create a budget without limit
+ * @return GstHthMemory* The budget, one reference
+ */
+GstHthMemory *gst_hth_memory_new (void);
+
+/**
+ * @brief Drop a reference of the budget
+ * @param memory The budget
+ */
+void gst_hth_memory_unref (GstHthMemory *memory);
+
+/**
+ * @brief Change the budget, the buffers already queued are kept
+ * @param memory The budget
+ * @param limit Bytes, 0 for no limit
+ */
+void gst_hth_memory_set_limit (GstHthMemory *memory, guint64 limit);
+
+/**
+ * @brief Bytes of the budget
+ * @param memory The budget
+ * @return guint64 Bytes, 0 for no limit
+ */
+guint64 gst_hth_memory_get_limit (GstHthMemory *memory);
+
+/**
+ * @brief Set aside bytes held outside the queues, like preallocated pools
+ *
+ * The reserved bytes count in memory-used and leave less of the budget
+ * to the queues.
+ *
+ * @param memory The budget
+ * @param bytes Bytes reserved, replaces the previous reservation
+ */
+void gst_hth_memory_set_reserved (GstHthMemory *memory, guint64 bytes);
+
+/**
+ * @brief Count the bytes inside a queue and drop the buffers over the budget
+ *
+ * A dropped video buffer also drops the next delta units until a
+ * keyframe, so the decoder never gets a broken reference chain.
+ *
+ * @param memory The budget
+ * @param queue The queue, may be NULL
+ * @param priority Drop order of the queue
+ */
+void gst_hth_memory_watch_queue (GstHthMemory *memory, GstElement *queue, GstHthMemoryPriority priority);
+
+/**
+ * @brief Add the memory counters to a stats structure
+ *
+ * Adds memory-used, memory-reserved, memory-peak, max-memory,
+ * video-memory-used, audio-memory-used and text-memory-used, and
+ * video-memory-drops, audio-memory-drops and text-memory-drops.
+ *
+ * @param memory The budget
+ * @param stats Structure to fill
+ */
+void gst_hth_memory_append_stats (GstHthMemory *memory, GstStructure *stats);
+
+G_END_DECLS
+
+#endif /* __GST_HTHMEMORY_H__ */
@@ -0,0 +1,304 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** meta header */
+#include "gsththmeta.h" /**< For the telemetry and capture meta declarations */
+
+/** string header file */
+#include <string.h> /**< For strlen() and memcpy() */
+
+/**
+ * Meta names
+ *
+ * Both hthstreamsink and hthstreamsrc are built with this file, when they
+ * are loaded in the same process the second one reuses the registered types.
+ */
+
+#define TELEMETRY_META_API_NAME "GstHthTelemetryMetaAPI"
+#define TELEMETRY_META_IMPL_NAME "GstHthTelemetryMeta"
+#define CAPTURE_META_API_NAME "GstHthCaptureMetaAPI"
+#define CAPTURE_META_IMPL_NAME "GstHthCaptureMeta"
+
+//==============================================================================
+
+static gboolean gst_hth_telemetry_meta_init (GstMeta *meta, gpointer params, GstBuffer *buffer){
+    
+    GstHthTelemetryMeta *telemetryMeta = (GstHthTelemetryMeta*)meta;
+    
+    telemetryMeta->text = NULL;
+    telemetryMeta->sampleTime = GST_CLOCK_TIME_NONE;
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void gst_hth_telemetry_meta_free (GstMeta *meta, GstBuffer *buffer){
+    
+    GstHthTelemetryMeta *telemetryMeta = (GstHthTelemetryMeta*)meta;
+    
+    g_free(telemetryMeta->text);
+    telemetryMeta->text = NULL;
+}
+
+//==============================================================================
+
+static gboolean gst_hth_telemetry_meta_transform (GstBuffer *dest, GstMeta *meta, GstBuffer *buffer, GQuark type, gpointer data){
+    
+    GstHthTelemetryMeta *telemetryMeta = (GstHthTelemetryMeta*)meta;
+    
+    /** The sample describes the whole frame, so any copy keeps it */
+    if (GST_META_TRANSFORM_IS_COPY(type)) {
+        gst_buffer_add_hth_telemetry_meta(dest, telemetryMeta->text, telemetryMeta->sampleTime);
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
+//==============================================================================
+
+GType gst_hth_telemetry_meta_api_get_type (void){
+    
+    static volatile GType type = 0;
+    static const gchar *tags[] = { NULL };
+    
+    if (g_once_init_enter(&type)) {
+        GType _type = g_type_from_name(TELEMETRY_META_API_NAME);
+        if (_type == 0)
+            _type = gst_meta_api_type_register(TELEMETRY_META_API_NAME, tags);
+        g_once_init_leave(&type, _type);
+    }
+    
+    return type;
+}
+
+//==============================================================================
+
+const GstMetaInfo *gst_hth_telemetry_meta_get_info (void){
+    
+    static const GstMetaInfo *telemetryMetaInfo = NULL;
+    
+    if (g_once_init_enter((GstMetaInfo **)&telemetryMetaInfo)) {
+        const GstMetaInfo *metaInfo = gst_meta_get_info(TELEMETRY_META_IMPL_NAME);
+        if (metaInfo == NULL)
+            metaInfo = gst_meta_register(GST_HTH_TELEMETRY_META_API_TYPE,
+                                         TELEMETRY_META_IMPL_NAME,
+                                         sizeof(GstHthTelemetryMeta),
+                                         gst_hth_telemetry_meta_init,
+                                         gst_hth_telemetry_meta_free,
+                                         gst_hth_telemetry_meta_transform);
+        g_once_init_leave((GstMetaInfo **)&telemetryMetaInfo, (GstMetaInfo *)metaInfo);
+    }
+    
+    return telemetryMetaInfo;
+}
+
+//==============================================================================
+
+GstHthTelemetryMeta *gst_buffer_add_hth_telemetry_meta (GstBuffer *buffer, const gchar *text, GstClockTime sampleTime){
+    
+    GstHthTelemetryMeta *telemetryMeta;
+    
+    g_return_val_if_fail(gst_buffer_is_writable(buffer), NULL);
+    
+    telemetryMeta = (GstHthTelemetryMeta*)gst_buffer_add_meta(buffer, GST_HTH_TELEMETRY_META_INFO, NULL);
+    telemetryMeta->text = g_strdup(text);
+    telemetryMeta->sampleTime = sampleTime;
+    
+    return telemetryMeta;
+}
+
+//==============================================================================
+
+static gboolean gst_hth_capture_meta_init (GstMeta *meta, gpointer params, GstBuffer *buffer){
+    
+    ((GstHthCaptureMeta*)meta)->captureTime = GST_CLOCK_TIME_NONE;
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean gst_hth_capture_meta_transform (GstBuffer *dest, GstMeta *meta, GstBuffer *buffer, GQuark type, gpointer data){
+    
+    /** Duplicated frames keep the time of the frame they copy */
+    if (GST_META_TRANSFORM_IS_COPY(type)) {
+        gst_buffer_add_hth_capture_meta(dest, ((GstHthCaptureMeta*)meta)->captureTime);
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
+//==============================================================================
+
+GType gst_hth_capture_meta_api_get_type (void){
+    
+    static volatile GType type = 0;
+    static const gchar *tags[] = { NULL };
+    
+    /** No tags, the video encoders and filters copy it to their output */
+    if (g_once_init_enter(&type)) {
+        GType _type = g_type_from_name(CAPTURE_META_API_NAME);
+        if (_type == 0)
+            _type = gst_meta_api_type_register(CAPTURE_META_API_NAME, tags);
+        g_once_init_leave(&type, _type);
+    }
+    
+    return type;
+}
+
+//==============================================================================
+
+const GstMetaInfo *gst_hth_capture_meta_get_info (void){
+    
+    static const GstMetaInfo *captureMetaInfo = NULL;
+    
+    if (g_once_init_enter((GstMetaInfo **)&captureMetaInfo)) {
+        const GstMetaInfo *metaInfo = gst_meta_get_info(CAPTURE_META_IMPL_NAME);
+        if (metaInfo == NULL)
+            metaInfo = gst_meta_register(GST_HTH_CAPTURE_META_API_TYPE,
+                                         CAPTURE_META_IMPL_NAME,
+                                         sizeof(GstHthCaptureMeta),
+                                         gst_hth_capture_meta_init,
+                                         NULL,
+                                         gst_hth_capture_meta_transform);
+        g_once_init_leave((GstMetaInfo **)&captureMetaInfo, (GstMetaInfo *)metaInfo);
+    }
+    
+    return captureMetaInfo;
+}
+
+//==============================================================================
+
+GstHthCaptureMeta *gst_buffer_add_hth_capture_meta (GstBuffer *buffer, GstClockTime captureTime){
+    
+    GstHthCaptureMeta *captureMeta;
+    
+    g_return_val_if_fail(gst_buffer_is_writable(buffer), NULL);
+    
+    captureMeta = (GstHthCaptureMeta*)gst_buffer_add_meta(buffer, GST_HTH_CAPTURE_META_INFO, NULL);
+    captureMeta->captureTime = captureTime;
+    
+    return captureMeta;
+}
+
+//==============================================================================
+
+void gst_hth_frame_record_append (GstBuffer *frame, GstHthTelemetryMeta *meta, GstClockTime captureTime){
+    
+    GstStructure *record;
+    gchar *recordString;
+    gsize recordSize;
+    guint8 *block;
+    
+    record = gst_structure_new_empty(HTH_FRAME_RECORD_NAME);
+    if (meta != NULL)
+        gst_structure_set(record,
+                          "telemetry", G_TYPE_STRING, meta->text,
+                          "sample-time", G_TYPE_UINT64, meta->sampleTime,
+                          NULL);
+    if (GST_CLOCK_TIME_IS_VALID(captureTime))
+        gst_structure_set(record, "capture-time", G_TYPE_UINT64, captureTime, NULL);
+    recordString = gst_structure_to_string(record);
+    gst_structure_free(record);
+    
+    /** Record, then its size and the magic, so the receiver reads the frame from the end */
+    recordSize = strlen(recordString);
+    block = g_malloc(recordSize + HTH_FRAME_RECORD_FOOTER_SIZE);
+    memcpy(block, recordString, recordSize);
+    GST_WRITE_UINT32_BE(block + recordSize, recordSize);
+    GST_WRITE_UINT32_BE(block + recordSize + 4, HTH_FRAME_RECORD_MAGIC);
+    g_free(recordString);
+    
+    gst_buffer_append_memory(frame, gst_memory_new_wrapped(0, block, recordSize + HTH_FRAME_RECORD_FOOTER_SIZE,
+                                                           0, recordSize + HTH_FRAME_RECORD_FOOTER_SIZE, block, g_free));
+}
+
+//==============================================================================
+
+GstStructure *gst_hth_frame_record_strip (GstBuffer **frame){
+    
+    guint8 footer[HTH_FRAME_RECORD_FOOTER_SIZE];
+    GstStructure *structure;
+    gchar *recordString;
+    gsize frameSize = gst_buffer_get_size(*frame);
+    gsize recordSize;
+    
+    if (frameSize < HTH_FRAME_RECORD_FOOTER_SIZE
+        || gst_buffer_extract(*frame, frameSize - HTH_FRAME_RECORD_FOOTER_SIZE, footer, HTH_FRAME_RECORD_FOOTER_SIZE) != HTH_FRAME_RECORD_FOOTER_SIZE
+        || GST_READ_UINT32_BE(footer + 4) != HTH_FRAME_RECORD_MAGIC)
+        return NULL;
+    
+    recordSize = GST_READ_UINT32_BE(footer);
+    if (recordSize > frameSize - HTH_FRAME_RECORD_FOOTER_SIZE)
+        return NULL;
+    
+    recordString = g_malloc(recordSize + 1);
+    gst_buffer_extract(*frame, frameSize - HTH_FRAME_RECORD_FOOTER_SIZE - recordSize, recordString, recordSize);
+    recordString[recordSize] = '\0';
+    structure = gst_structure_from_string(recordString, NULL);
+    g_free(recordString);
+    
+    /** Encoded data that happens to end like a footer */
+    if (structure == NULL || !gst_structure_has_name(structure, HTH_FRAME_RECORD_NAME)) {
+        if (structure != NULL)
+            gst_structure_free(structure);
+        return NULL;
+    }
+    
+    /** Only the buffer is copied, the memory of the encoded data is shared */
+    *frame = gst_buffer_make_writable(*frame);
+    gst_buffer_resize(*frame, 0, frameSize - HTH_FRAME_RECORD_FOOTER_SIZE - recordSize);
+    
+    return structure;
+}
@@ -0,0 +1,166 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHMETA_H__
+#define __GST_HTHMETA_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Name of the structure carried by every per-frame record
+ *
+ * hthstreamsink serializes the frame-locked side data of one video frame
+ * into a GstStructure with this name and appends it to the encoded frame
+ * itself, followed by a footer. hthstreamsrc strips it before the decoder.
+ */
+#define HTH_FRAME_RECORD_NAME "hth-frame"
+
+#define HTH_FRAME_RECORD_MAGIC 0x48544852 /**< "HTHR", last 4 bytes of a frame with a record */
+#define HTH_FRAME_RECORD_FOOTER_SIZE 8 /**< Big endian record size then the magic */
+
+#define GST_HTH_TELEMETRY_META_API_TYPE (gst_hth_telemetry_meta_api_get_type())
+#define GST_HTH_TELEMETRY_META_INFO (gst_hth_telemetry_meta_get_info())
+
+/**
+ * @struct GstHthTelemetryMeta
+ *
+ * @brief Most recent serial telemetry sample attached to a video frame
+ *
+ */
+
+typedef struct _GstHthTelemetryMeta GstHthTelemetryMeta;
+
+struct _GstHthTelemetryMeta {
+    
+    GstMeta meta; /**< Parent struct */
+    
+    gchar *text; /**< Telemetry sample as received from serialtextsrc */
+    
+    GstClockTime sampleTime; /**< Running time at which the sample entered the sink */
+};
+
+GType gst_hth_telemetry_meta_api_get_type (void);
+const GstMetaInfo *gst_hth_telemetry_meta_get_info (void);
+
+/**
+ * @brief Attach a telemetry sample to a buffer
+ *
+ * @param buffer A writable buffer
+ * @param text Telemetry text, it is copied
+ * @param sampleTime Running time of the sample
+ * @return GstHthTelemetryMeta* The new meta
+ */
+GstHthTelemetryMeta *gst_buffer_add_hth_telemetry_meta (GstBuffer *buffer, const gchar *text, GstClockTime sampleTime);
+
+#define gst_buffer_get_hth_telemetry_meta(b) \
+    ((GstHthTelemetryMeta*)gst_buffer_get_meta((b), GST_HTH_TELEMETRY_META_API_TYPE))
+
+#define GST_HTH_CAPTURE_META_API_TYPE (gst_hth_capture_meta_api_get_type())
+#define GST_HTH_CAPTURE_META_INFO (gst_hth_capture_meta_get_info())
+
+/**
+ * @struct GstHthCaptureMeta
+ *
+ * @brief Capture time of a video frame, instead of burning it in the pixels
+ *
+ */
+
+typedef struct _GstHthCaptureMeta GstHthCaptureMeta;
+
+struct _GstHthCaptureMeta {
+    
+    GstMeta meta; /**< Parent struct */
+    
+    GstClockTime captureTime; /**< Clock time of the frame at the sender: base time plus the running time of its PTS */
+};
+
+GType gst_hth_capture_meta_api_get_type (void);
+const GstMetaInfo *gst_hth_capture_meta_get_info (void);
+
+/**
+ * @brief Attach a capture time to a buffer
+ *
+ * The meta is copied with the buffer, so it follows the frame through
+ * videorate and the encoder.
+ *
+ * @param buffer A writable buffer
+ * @param captureTime Clock time of the capture, in the time of the pipeline clock
+ * @return GstHthCaptureMeta* The new meta
+ */
+GstHthCaptureMeta *gst_buffer_add_hth_capture_meta (GstBuffer *buffer, GstClockTime captureTime);
+
+#define gst_buffer_get_hth_capture_meta(b) \
+    ((GstHthCaptureMeta*)gst_buffer_get_meta((b), GST_HTH_CAPTURE_META_API_TYPE))
+
+/**
+ * @brief Append the side data of a frame to the encoded frame
+ *
+ * The record and its footer go in a new memory block after the encoded
+ * data, the frame data is not copied. The record travels in the video
+ * track, so it can't be separated from its frame or arrive late.
+ *
+ * @param frame Writable encoded video frame
+ * @param meta Telemetry meta of the frame, NULL for none
+ * @param captureTime Capture time of the frame, GST_CLOCK_TIME_NONE for none
+ * @return void
+ */
+void gst_hth_frame_record_append (GstBuffer *frame, GstHthTelemetryMeta *meta, GstClockTime captureTime);
+
+/**
+ * @brief Remove the record appended by gst_hth_frame_record_append()
+ *
+ * Frames without a record are left untouched, the others are made
+ * writable and resized to the encoded data only.
+ *
+ * @param frame Encoded video frame, replaced by the stripped one
+ * @return GstStructure* The record or NULL when the frame has none
+ */
+GstStructure *gst_hth_frame_record_strip (GstBuffer **frame);
+
+G_END_DECLS
+
+#endif /* __GST_HTHMETA_H__ */
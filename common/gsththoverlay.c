@@ -0,0 +1,403 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** overlay header */
+#include "gsththoverlay.h" /**< For the overlay declarations */
+
+/** video library header */
+#include <gst/video/video.h> /**< For GstVideoInfo and gst_video_frame_map() */
+
+/** string header file */
+#include <string.h> /**< For memcpy() and memset() */
+
+#define FONT_WIDTH      5 /**< Dots of a glyph */
+#define FONT_HEIGHT     7
+#define FONT_LEFT       1 /**< Blank dots left of a glyph, inside its cell */
+#define FONT_TOP        2 /**< Blank dots above a glyph, inside its cell */
+#define CELL_WIDTH      7 /**< Dots of a cell, glyph and spacing */
+#define CELL_HEIGHT     11
+#define GLYPH_COUNT     12 /**< Digits, colon and dot */
+#define GLYPH_COLON     10
+#define GLYPH_DOT       11
+#define MAX_CHARS       20 /**< H:MM:SS.mmm with the hours of any guint64 time */
+#define MARGIN          4 /**< Dots between the line and the frame corner */
+#define SCALE_LINES     240 /**< Frame lines per dot size, 2 pixels per dot at 480 lines */
+#define LUMA_TEXT       235 /**< White, video range */
+#define LUMA_BACKGROUND 16 /**< Black, video range */
+
+/**
+ * @brief 5x7 font, one byte per row, the high bit of the 5 is the left dot
+ */
+static const guint8 font[GLYPH_COUNT][FONT_HEIGHT] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, /**< 0 */
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, /**< 1 */
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, /**< 2 */
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, /**< 3 */
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, /**< 4 */
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, /**< 5 */
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, /**< 6 */
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, /**< 7 */
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, /**< 8 */
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, /**< 9 */
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, /**< : */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}  /**< . */
+};
+
+//==============================================================================
+
+struct _GstHthOverlay {
+    
+    GMutex lock; /**< Protects the format, the line and the counters */
+    
+    GstVideoInfo info; /**< Format of the frames */
+    gboolean supported; /**< The format has an 8 bits luma plane */
+    guint scale; /**< Pixels per dot, 0 before the first caps */
+    guint cellWidth; /**< Pixels of a character */
+    guint cellHeight;
+    guint8 *atlas; /**< GLYPH_COUNT cells one after the other, rendered for scale */
+    guint8 *line; /**< The text rendered, MAX_CHARS cells wide */
+    gchar text[MAX_CHARS + 1]; /**< Character of each cell of line, zeros after the atlas changed */
+    
+    guint64 frames; /**< Frames drawn */
+    guint64 skipped; /**< Frames without time, too small or of an other format */
+    guint64 copies; /**< Frames shared upstream, copied before drawing */
+    guint64 drawTime; /**< Nanoseconds spent drawing the frames */
+};
+
+//==============================================================================
+
+/**
+ * @brief Draw the PTS of the frames, take the caps of the pad
+ *
+ * @param pad Watched pad
+ * @param info Probe info with the frame or the event
+ * @param user_data The GstHthOverlay
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_overlayProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Render every glyph for a dot size
+ *
+ * @param overlay The overlay, locked
+ * @param scale Pixels per dot
+ * @return void
+ */
+static void renderAtlas (GstHthOverlay *overlay, guint scale);
+
+/**
+ * @brief Copy the characters that changed from the atlas to the line
+ *
+ * @param overlay The overlay, locked
+ * @param text New text
+ * @param length Characters of the text
+ * @return void
+ */
+static void updateLine (GstHthOverlay *overlay, const gchar *text, guint length);
+
+/**
+ * @brief Glyph of a character of the time
+ *
+ * @param character Digit, colon or dot
+ * @return guint Index in the atlas
+ */
+static guint getGlyph (gchar character);
+
+//==============================================================================
+
+GstHthOverlay *gst_hth_overlay_new (void){
+    
+    GstHthOverlay *overlay = g_new0 (GstHthOverlay, 1);
+    
+    g_mutex_init (&overlay->lock);
+    
+    return overlay;
+}
+
+//==============================================================================
+
+void gst_hth_overlay_free (GstHthOverlay *overlay){
+    
+    g_free (overlay->atlas);
+    g_free (overlay->line);
+    g_mutex_clear (&overlay->lock);
+    g_free (overlay);
+}
+
+//==============================================================================
+
+void gst_hth_overlay_watch_pad (GstHthOverlay *overlay, GstPad *pad){
+    
+    if (pad == NULL)
+        return;
+    
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                       cb_overlayProbe, overlay, NULL);
+}
+
+//==============================================================================
+
+gboolean gst_hth_overlay_set_caps (GstHthOverlay *overlay, GstCaps *caps){
+    
+    GstVideoInfo info;
+    gboolean supported;
+    
+    if (!gst_video_info_from_caps (&info, caps)) {
+        g_mutex_lock (&overlay->lock);
+        overlay->supported = FALSE;
+        g_mutex_unlock (&overlay->lock);
+        return FALSE;
+    }
+    
+    /** The line is copied as is into the first component */
+    supported = (GST_VIDEO_INFO_IS_YUV (&info) || GST_VIDEO_INFO_IS_GRAY (&info))
+        && GST_VIDEO_INFO_COMP_DEPTH (&info, 0) == 8
+        && GST_VIDEO_INFO_COMP_PSTRIDE (&info, 0) == 1;
+    
+    g_mutex_lock (&overlay->lock);
+    overlay->info = info;
+    overlay->supported = supported;
+    if (supported)
+        renderAtlas (overlay, MAX (1, GST_VIDEO_INFO_HEIGHT (&info) / SCALE_LINES));
+    g_mutex_unlock (&overlay->lock);
+    
+    return supported;
+}
+
+//==============================================================================
+
+GstBuffer *gst_hth_overlay_draw (GstHthOverlay *overlay, GstBuffer *buffer, GstClockTime time){
+    
+    GstClockTime start = gst_util_get_timestamp ();
+    GstVideoFrame frame;
+    gchar text[MAX_CHARS + 1];
+    guint8 *plane;
+    guint lineStride;
+    guint length;
+    guint width;
+    guint margin;
+    guint row;
+    gint stride;
+    
+    g_mutex_lock (&overlay->lock);
+    
+    if (!overlay->supported || !GST_CLOCK_TIME_IS_VALID (time)) {
+        overlay->skipped++;
+        g_mutex_unlock (&overlay->lock);
+        return buffer;
+    }
+    
+    /** Same text as timeoverlay */
+    length = g_snprintf (text, sizeof (text), "%u:%02u:%02u.%03u",
+                         (guint) (time / (GST_SECOND * 60 * 60)),
+                         (guint) ((time / (GST_SECOND * 60)) % 60),
+                         (guint) ((time / GST_SECOND) % 60),
+                         (guint) ((time % GST_SECOND) / GST_MSECOND));
+    width = length * overlay->cellWidth;
+    margin = MARGIN * overlay->scale;
+    
+    if (margin + width > (guint) GST_VIDEO_INFO_WIDTH (&overlay->info)
+        || margin + overlay->cellHeight > (guint) GST_VIDEO_INFO_HEIGHT (&overlay->info)) {
+        overlay->skipped++;
+        g_mutex_unlock (&overlay->lock);
+        return buffer;
+    }
+    
+    /** Only a frame still referenced upstream costs a copy */
+    if (!gst_buffer_is_writable (buffer)) {
+        buffer = gst_buffer_make_writable (buffer);
+        overlay->copies++;
+    }
+    
+    if (!gst_video_frame_map (&frame, &overlay->info, buffer, GST_MAP_WRITE)) {
+        overlay->skipped++;
+        g_mutex_unlock (&overlay->lock);
+        return buffer;
+    }
+    
+    updateLine (overlay, text, length);
+    
+    plane = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
+    stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
+    plane += margin * stride + margin;
+    lineStride = MAX_CHARS * overlay->cellWidth;
+    
+    for (row = 0; row < overlay->cellHeight; row++)
+        memcpy (plane + row * stride, overlay->line + row * lineStride, width);
+    
+    gst_video_frame_unmap (&frame);
+    
+    overlay->frames++;
+    overlay->drawTime += gst_util_get_timestamp () - start;
+    
+    g_mutex_unlock (&overlay->lock);
+    
+    return buffer;
+}
+
+//==============================================================================
+
+void gst_hth_overlay_append_stats (GstHthOverlay *overlay, GstStructure *structure){
+    
+    g_mutex_lock (&overlay->lock);
+    
+    gst_structure_set (structure,
+                       "overlay-frames", G_TYPE_UINT64, overlay->frames,
+                       "overlay-skipped", G_TYPE_UINT64, overlay->skipped,
+                       "overlay-copies", G_TYPE_UINT64, overlay->copies,
+                       "overlay-time-mean", G_TYPE_UINT64, overlay->frames > 0 ? overlay->drawTime / overlay->frames : 0,
+                       NULL);
+    
+    g_mutex_unlock (&overlay->lock);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_overlayProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthOverlay *overlay = (GstHthOverlay*) user_data;
+    GstBuffer *buffer;
+    GstEvent *event;
+    GstCaps *caps;
+    
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        event = GST_PAD_PROBE_INFO_EVENT (info);
+        if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+            gst_event_parse_caps (event, &caps);
+            gst_hth_overlay_set_caps (overlay, caps);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+    
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    GST_PAD_PROBE_INFO_DATA (info) = gst_hth_overlay_draw (overlay, buffer, GST_BUFFER_PTS (buffer));
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static void renderAtlas (GstHthOverlay *overlay, guint scale){
+    
+    guint8 *cell;
+    guint glyph;
+    guint x;
+    guint y;
+    gint dotX;
+    gint dotY;
+    gboolean dot;
+    
+    if (scale == overlay->scale)
+        return;
+    
+    overlay->scale = scale;
+    overlay->cellWidth = CELL_WIDTH * scale;
+    overlay->cellHeight = CELL_HEIGHT * scale;
+    
+    g_free (overlay->atlas);
+    g_free (overlay->line);
+    overlay->atlas = g_malloc (GLYPH_COUNT * overlay->cellWidth * overlay->cellHeight);
+    overlay->line = g_malloc (MAX_CHARS * overlay->cellWidth * overlay->cellHeight);
+    
+    for (glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        cell = overlay->atlas + glyph * overlay->cellWidth * overlay->cellHeight;
+        for (y = 0; y < overlay->cellHeight; y++) {
+            for (x = 0; x < overlay->cellWidth; x++) {
+                dotX = (gint) (x / scale) - FONT_LEFT;
+                dotY = (gint) (y / scale) - FONT_TOP;
+                dot = dotX >= 0 && dotX < FONT_WIDTH && dotY >= 0 && dotY < FONT_HEIGHT
+                    && (font[glyph][dotY] >> (FONT_WIDTH - 1 - dotX)) & 1;
+                cell[y * overlay->cellWidth + x] = dot ? LUMA_TEXT : LUMA_BACKGROUND;
+            }
+        }
+    }
+    
+    /** Every character is copied again */
+    memset (overlay->text, 0, sizeof (overlay->text));
+}
+
+//==============================================================================
+
+static void updateLine (GstHthOverlay *overlay, const gchar *text, guint length){
+    
+    guint lineStride = MAX_CHARS * overlay->cellWidth;
+    const guint8 *cell;
+    guint i;
+    guint row;
+    
+    for (i = 0; i < length; i++) {
+        
+        /** The characters past the end of a shorter text are still in the line */
+        if (overlay->text[i] == text[i])
+            continue;
+        
+        cell = overlay->atlas + getGlyph (text[i]) * overlay->cellWidth * overlay->cellHeight;
+        for (row = 0; row < overlay->cellHeight; row++)
+            memcpy (overlay->line + row * lineStride + i * overlay->cellWidth,
+                    cell + row * overlay->cellWidth, overlay->cellWidth);
+    }
+    
+    memcpy (overlay->text, text, length + 1);
+}
+
+//==============================================================================
+
+static guint getGlyph (gchar character){
+    
+    switch (character) {
+        case ':':
+            return GLYPH_COLON;
+        case '.':
+            return GLYPH_DOT;
+        default:
+            return character - '0';
+    }
+}
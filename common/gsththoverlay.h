@@ -0,0 +1,124 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHOVERLAY_H__
+#define __GST_HTHOVERLAY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @struct GstHthOverlay
+ * @brief Timestamp burnt into the luma plane of raw video frames
+ *
+ * The digits are rendered once per frame size into a glyph atlas, the
+ * text line is kept rendered and only the characters that changed since
+ * the previous frame are copied again from the atlas. Each frame then
+ * gets the line copied row by row, white on black, without any text
+ * layout nor blending. Formats with an 8 bits luma plane only (I420,
+ * Y42B, Y444, NV12, GRAY8...), the others go through untouched.
+ */
+typedef struct _GstHthOverlay GstHthOverlay;
+
+/**
+ * @brief Create an overlay, it draws nothing until it gets caps
+ * @return GstHthOverlay* The overlay
+ */
+GstHthOverlay *gst_hth_overlay_new (void);
+
+/**
+ * @brief Free the overlay, the watched pads must be gone
+ * @param overlay The overlay
+ */
+void gst_hth_overlay_free (GstHthOverlay *overlay);
+
+/**
+ * @brief Draw the PTS on the frames going through a pad
+ *
+ * The caps are taken from the CAPS events of the pad.
+ *
+ * @param overlay The overlay
+ * @param pad Src pad carrying raw video
+ */
+void gst_hth_overlay_watch_pad (GstHthOverlay *overlay, GstPad *pad);
+
+/**
+ * @brief Take the format of the next frames
+ *
+ * The atlas is rendered again when the frame height changes.
+ *
+ * @param overlay The overlay
+ * @param caps Raw video caps
+ * @return gboolean FALSE when the format has no 8 bits luma plane
+ */
+gboolean gst_hth_overlay_set_caps (GstHthOverlay *overlay, GstCaps *caps);
+
+/**
+ * @brief Draw a time as H:MM:SS.mmm in the top left corner of a frame
+ *
+ * Writable frames are drawn in place, the others are copied first.
+ *
+ * @param overlay The overlay
+ * @param buffer Frame, the reference is taken
+ * @param time Time to draw, nothing is drawn when it is not valid
+ * @return GstBuffer* The frame, or its copy
+ */
+GstBuffer *gst_hth_overlay_draw (GstHthOverlay *overlay, GstBuffer *buffer, GstClockTime time);
+
+/**
+ * @brief Add the overlay counters to a stats structure
+ *
+ * Adds overlay-frames, overlay-skipped, overlay-copies and
+ * overlay-time-mean (ns).
+ *
+ * @param overlay The overlay
+ * @param structure Structure to fill
+ */
+void gst_hth_overlay_append_stats (GstHthOverlay *overlay, GstStructure *structure);
+
+G_END_DECLS
+
+#endif /* __GST_HTHOVERLAY_H__ */
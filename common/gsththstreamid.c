@@ -0,0 +1,123 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** stream id header */
+#include "gsththstreamid.h" /**< For the stream id header declarations */
+
+/** string header file */
+#include <string.h> /**< For memcmp() */
+
+#define STREAM_ID_MAGIC       "HTHS" /**< First bytes of the header */
+#define STREAM_ID_MAGIC_SIZE  4
+
+//==============================================================================
+
+GstMemory *gst_hth_stream_id_header_new (guint32 streamId, guint32 sequence){
+    
+    guint8 *header = g_malloc (HTH_STREAM_ID_HEADER_SIZE);
+    
+    memcpy (header, STREAM_ID_MAGIC, STREAM_ID_MAGIC_SIZE);
+    GST_WRITE_UINT32_BE (header + STREAM_ID_MAGIC_SIZE, streamId);
+    GST_WRITE_UINT32_BE (header + STREAM_ID_MAGIC_SIZE + 4, sequence);
+    
+    return gst_memory_new_wrapped (0, header, HTH_STREAM_ID_HEADER_SIZE, 0, HTH_STREAM_ID_HEADER_SIZE, header, g_free);
+}
+
+//==============================================================================
+
+gboolean gst_hth_stream_id_parse (const guint8 *data, gsize size, guint32 *streamId, guint32 *sequence){
+    
+    if (size < HTH_STREAM_ID_HEADER_SIZE || memcmp (data, STREAM_ID_MAGIC, STREAM_ID_MAGIC_SIZE) != 0)
+        return FALSE;
+    
+    *streamId = GST_READ_UINT32_BE (data + STREAM_ID_MAGIC_SIZE);
+    if (sequence != NULL)
+        *sequence = GST_READ_UINT32_BE (data + STREAM_ID_MAGIC_SIZE + 4);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+void gst_hth_sequence_update (GstHthSequence *sequence, guint32 number){
+    
+    gint32 delta;
+    
+    sequence->received++;
+    
+    if (!sequence->started) {
+        sequence->started = TRUE;
+        sequence->first = number;
+        sequence->highest = number;
+        return;
+    }
+    
+    /** Signed distance to the highest number, across the wrap */
+    delta = (gint32) (number - (guint32) sequence->highest);
+    if (delta > 0)
+        sequence->highest += delta;
+    else
+        sequence->reordered++;
+}
+
+//==============================================================================
+
+guint64 gst_hth_sequence_get_lost (const GstHthSequence *sequence){
+    
+    guint64 expected;
+    
+    if (!sequence->started)
+        return 0;
+    
+    expected = sequence->highest - sequence->first + 1;
+    
+    return expected > sequence->received ? expected - sequence->received : 0;
+}
@@ -0,0 +1,112 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHSTREAMID_H__
+#define __GST_HTHSTREAMID_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Size of the stream id header: "HTHS", the id and the sequence number, big endian
+ */
+#define HTH_STREAM_ID_HEADER_SIZE 12
+
+/**
+ * @struct GstHthSequence
+ * @brief Loss and reordering of the datagrams of one sender
+ *
+ * The sequence number is extended past its 32 bits wrap, a datagram older
+ * than the highest one seen counts as reordered.
+ */
+typedef struct {
+    gboolean started; /**< A datagram was seen */
+    guint64 first; /**< Extended number of the first datagram */
+    guint64 highest; /**< Extended number of the highest datagram */
+    guint64 received; /**< Datagrams seen */
+    guint64 reordered; /**< Datagrams older than the highest one, or repeated */
+} GstHthSequence;
+
+/**
+ * @brief Create the header that hthstreamsink puts in front of each datagram
+ *
+ * The header lets many senders share one hthstreamsrc port and keep their
+ * identity when their address or port changes.
+ *
+ * @param streamId Id of the sender, chosen by the application
+ * @param sequence Number of the datagram, one more for each datagram
+ * @return GstMemory* HTH_STREAM_ID_HEADER_SIZE bytes
+ */
+GstMemory *gst_hth_stream_id_header_new (guint32 streamId, guint32 sequence);
+
+/**
+ * @brief Read the stream id header of a datagram
+ *
+ * @param data Start of the datagram
+ * @param size Size of the datagram
+ * @param streamId Returns the id of the sender
+ * @param sequence Returns the number of the datagram, may be NULL
+ * @return gboolean FALSE if the datagram does not start with a header
+ */
+gboolean gst_hth_stream_id_parse (const guint8 *data, gsize size, guint32 *streamId, guint32 *sequence);
+
+/**
+ * @brief Count a datagram of a sender
+ * @param sequence The counters of the sender, zeroed to start
+ * @param number Sequence number of the datagram
+ */
+void gst_hth_sequence_update (GstHthSequence *sequence, guint32 number);
+
+/**
+ * @brief Datagrams missing between the first and the highest seen
+ * @param sequence The counters of the sender
+ * @return guint64 Datagrams lost, the late ones are not counted once they arrive
+ */
+guint64 gst_hth_sequence_get_lost (const GstHthSequence *sequence);
+
+G_END_DECLS
+
+#endif /* __GST_HTHSTREAMID_H__ */
@@ -0,0 +1,415 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** task pool header */
+#include "gsththtaskpool.h" /**< For the shared task pool declarations */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/** resource header file */
+#include <sys/resource.h> /**< For getrusage() */
+
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+#define YELLOW  "\033[1m\033[33m"   /** Warning state */
+
+#define SHARED_POOL_KEY "hth-shared-task-pool" /**< Data of the registry that holds the pool */
+#define POOL_TYPE_NAME  "GstHthTaskPool" /**< Registered once for all the plugin libraries */
+
+//==============================================================================
+
+/**
+ * @struct HthBoundedPool
+ * @brief GstTaskPool with one thread per core, grown to one per running task
+ *
+ * A GstTask loops on its thread until it is stopped, it can not give the
+ * thread back between two iterations. A task that waited for a thread
+ * would never run, so the pool grows as soon as the tasks outnumber the
+ * threads. The threads of stopped tasks are reused by the next ones.
+ */
+typedef struct {
+    GstTaskPool parent;
+    
+    GThreadPool *threads; /**< Worker threads, NULL until prepared */
+    guint cores; /**< Threads of the pool before it grows */
+    guint maxThreads; /**< Current limit of the thread pool, never below cores */
+    guint active; /**< Tasks pushed and not returned yet */
+    guint grows; /**< Tasks that made the pool grow past the cores */
+} HthBoundedPool;
+
+typedef struct {
+    GstTaskPoolClass parent_class;
+} HthBoundedPoolClass;
+
+/**
+ * @struct HthPoolTask
+ * @brief Function and data of a pushed task
+ */
+typedef struct {
+    GstTaskPoolFunction func;
+    gpointer data;
+} HthPoolTask;
+
+/**
+ * @struct HthSharedPool
+ * @brief The pool and its counters, one per process
+ *
+ * Each plugin library has its own copy of this code, so the pool is
+ * attached to the registry, the one object all of them see.
+ */
+typedef struct {
+    HthBoundedPool *pool; /**< Threads of the tasks */
+    gint tasks; /**< Tasks running on the pool, atomic */
+} HthSharedPool;
+
+//==============================================================================
+
+/**
+ * @brief Get the pool of the process, created and prepared on first use
+ *
+ * @return HthSharedPool* The pool, never freed
+ */
+static HthSharedPool *getSharedPool (void);
+
+/**
+ * @brief Type of the bounded pool, registered by the first library that needs it
+ *
+ * Called with the registry locked.
+ *
+ * @return GType The GstTaskPool subclass
+ */
+static GType getBoundedPoolType (void);
+
+/**
+ * @brief Set the vfuncs of the bounded pool
+ *
+ * @param klass Class of the subclass
+ * @return void
+ */
+static void boundedPoolClassInit (gpointer klass, gpointer data);
+
+/**
+ * @brief Create the worker threads, one per core to start with
+ *
+ * @param pool The pool
+ * @param error Set when the threads could not be created
+ * @return void
+ */
+static void boundedPoolPrepare (GstTaskPool *pool, GError **error);
+
+/**
+ * @brief Wait for the running tasks and free the worker threads
+ *
+ * @param pool The pool
+ * @return void
+ */
+static void boundedPoolCleanup (GstTaskPool *pool);
+
+/**
+ * @brief Run a task on a free worker thread, grow the pool when there is none
+ *
+ * @param pool The pool
+ * @param func Task function
+ * @param data Task data
+ * @param error Set when the pool is not prepared
+ * @return gpointer Always NULL, GstTask joins on its own state
+ */
+static gpointer boundedPoolPush (GstTaskPool *pool, GstTaskPoolFunction func, gpointer data, GError **error);
+
+/**
+ * @brief Nothing to join, the task is done when its function returned
+ *
+ * @param pool The pool
+ * @param id NULL
+ * @return void
+ */
+static void boundedPoolJoin (GstTaskPool *pool, gpointer id);
+
+/**
+ * @brief Run one task on a worker thread
+ *
+ * @param taskData The HthPoolTask
+ * @param poolData The HthBoundedPool
+ * @return void
+ */
+static void cb_boundedPoolThread (gpointer taskData, gpointer poolData);
+
+//==============================================================================
+
+gboolean gst_hth_task_pool_handle_message (GstMessage *message){
+    
+    GstStreamStatusType type;
+    GstElement *owner;
+    const GValue *value;
+    GstTask *task;
+    HthSharedPool *shared;
+    
+    if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+        return FALSE;
+    
+    gst_message_parse_stream_status (message, &type, &owner);
+    shared = getSharedPool ();
+    
+    switch (type) {
+        case GST_STREAM_STATUS_TYPE_CREATE:
+            value = gst_message_get_stream_status_object (message);
+            if (value == NULL || !G_VALUE_HOLDS_OBJECT (value) || !GST_IS_TASK (g_value_get_object (value)))
+                break;
+            task = GST_TASK (g_value_get_object (value));
+            gst_task_set_pool (task, GST_TASK_POOL (shared->pool));
+            break;
+    
+        case GST_STREAM_STATUS_TYPE_ENTER:
+            g_atomic_int_inc (&shared->tasks);
+            break;
+    
+        case GST_STREAM_STATUS_TYPE_LEAVE:
+            g_atomic_int_dec_and_test (&shared->tasks);
+            break;
+    
+        default:
+            break;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+void gst_hth_task_pool_append_stats (GstStructure *stats){
+    
+    HthSharedPool *shared = getSharedPool ();
+    HthBoundedPool *bounded = shared->pool;
+    guint threads = 0;
+    guint waiting = 0;
+    guint maxThreads;
+    guint grows;
+    
+    GST_OBJECT_LOCK (bounded);
+    if (bounded->threads != NULL) {
+        threads = g_thread_pool_get_num_threads (bounded->threads);
+        waiting = g_thread_pool_unprocessed (bounded->threads);
+    }
+    maxThreads = bounded->maxThreads;
+    grows = bounded->grows;
+    GST_OBJECT_UNLOCK (bounded);
+    
+    gst_structure_set (stats,
+                       "shared-pool-tasks", G_TYPE_INT, g_atomic_int_get (&shared->tasks),
+                       "shared-pool-threads", G_TYPE_UINT, threads,
+                       "shared-pool-cores", G_TYPE_UINT, bounded->cores,
+                       "shared-pool-max-threads", G_TYPE_UINT, maxThreads,
+                       "shared-pool-waiting", G_TYPE_UINT, waiting,
+                       "shared-pool-grows", G_TYPE_UINT, grows,
+                       "context-switches", G_TYPE_UINT64, gst_hth_task_pool_get_context_switches (),
+                       NULL);
+}
+
+//==============================================================================
+
+guint64 gst_hth_task_pool_get_context_switches (void){
+    
+    struct rusage usage;
+    
+    if (getrusage (RUSAGE_SELF, &usage) != 0)
+        return 0;
+    
+    return (guint64) usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+//==============================================================================
+
+static HthSharedPool *getSharedPool (void){
+    
+    GstRegistry *registry = gst_registry_get ();
+    HthSharedPool *shared;
+    GError *error = NULL;
+    
+    /** The lock of the registry object is shared by the copies of this code */
+    GST_OBJECT_LOCK (registry);
+    shared = g_object_get_data (G_OBJECT (registry), SHARED_POOL_KEY);
+    if (shared == NULL) {
+        shared = g_new0 (HthSharedPool, 1);
+        shared->pool = g_object_new (getBoundedPoolType (), NULL);
+        gst_object_ref_sink (shared->pool);
+        gst_task_pool_prepare (GST_TASK_POOL (shared->pool), &error);
+        if (error != NULL) {
+            printf (RED "Shared task pool: %s \n" RESET, error->message);
+            g_error_free (error);
+        }
+        g_object_set_data (G_OBJECT (registry), SHARED_POOL_KEY, shared);
+        printf (GREEN "Shared task pool created, %u threads \n" RESET, shared->pool->cores);
+    }
+    GST_OBJECT_UNLOCK (registry);
+    
+    return shared;
+}
+
+//==============================================================================
+
+static GType getBoundedPoolType (void){
+    
+    GType type;
+    
+    /** An other plugin library may have registered it with its own copy of this code */
+    type = g_type_from_name (POOL_TYPE_NAME);
+    if (type != 0)
+        return type;
+    
+    return g_type_register_static_simple (GST_TYPE_TASK_POOL, POOL_TYPE_NAME,
+                                          sizeof (HthBoundedPoolClass), boundedPoolClassInit,
+                                          sizeof (HthBoundedPool), NULL, 0);
+}
+
+//==============================================================================
+
+static void boundedPoolClassInit (gpointer klass, gpointer data){
+    
+    GstTaskPoolClass *poolClass = GST_TASK_POOL_CLASS (klass);
+    
+    poolClass->prepare = boundedPoolPrepare;
+    poolClass->cleanup = boundedPoolCleanup;
+    poolClass->push = boundedPoolPush;
+    poolClass->join = boundedPoolJoin;
+}
+
+//==============================================================================
+
+static void boundedPoolPrepare (GstTaskPool *pool, GError **error){
+    
+    HthBoundedPool *bounded = (HthBoundedPool*) pool;
+    
+    GST_OBJECT_LOCK (pool);
+    bounded->cores = MAX (g_get_num_processors (), 1);
+    bounded->maxThreads = MAX (bounded->cores, bounded->active);
+    bounded->threads = g_thread_pool_new (cb_boundedPoolThread, bounded, bounded->maxThreads, FALSE, error);
+    GST_OBJECT_UNLOCK (pool);
+}
+
+//==============================================================================
+
+static void boundedPoolCleanup (GstTaskPool *pool){
+    
+    HthBoundedPool *bounded = (HthBoundedPool*) pool;
+    GThreadPool *threads;
+    
+    GST_OBJECT_LOCK (pool);
+    threads = bounded->threads;
+    bounded->threads = NULL;
+    GST_OBJECT_UNLOCK (pool);
+    
+    /** The running and queued tasks finish first */
+    if (threads != NULL)
+        g_thread_pool_free (threads, FALSE, TRUE);
+}
+
+//==============================================================================
+
+static gpointer boundedPoolPush (GstTaskPool *pool, GstTaskPoolFunction func, gpointer data, GError **error){
+    
+    HthBoundedPool *bounded = (HthBoundedPool*) pool;
+    HthPoolTask *task;
+    
+    GST_OBJECT_LOCK (pool);
+    
+    if (bounded->threads == NULL) {
+        GST_OBJECT_UNLOCK (pool);
+        g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "The shared task pool is not prepared");
+        return NULL;
+    }
+    
+    /** A streaming task runs until it is stopped, a queued one would wait for ever */
+    bounded->active++;
+    if (bounded->active > bounded->maxThreads) {
+        bounded->maxThreads = bounded->active;
+        g_thread_pool_set_max_threads (bounded->threads, bounded->maxThreads, NULL);
+        bounded->grows++;
+        printf (YELLOW "Shared task pool: %u tasks on %u cores, the pool grows to %u threads \n" RESET,
+                bounded->active, bounded->cores, bounded->maxThreads);
+    }
+    
+    task = g_new (HthPoolTask, 1);
+    task->func = func;
+    task->data = data;
+    if (!g_thread_pool_push (bounded->threads, task, error)) {
+        bounded->active--;
+        g_free (task);
+    }
+    
+    GST_OBJECT_UNLOCK (pool);
+    
+    return NULL;
+}
+
+//==============================================================================
+
+static void boundedPoolJoin (GstTaskPool *pool, gpointer id){
+    
+    /** GstTask waits on its own state before it joins, like with the default pool */
+}
+
+//==============================================================================
+
+static void cb_boundedPoolThread (gpointer taskData, gpointer poolData){
+    
+    HthPoolTask *task = (HthPoolTask*) taskData;
+    HthBoundedPool *bounded = (HthBoundedPool*) poolData;
+    
+    task->func (task->data);
+    g_free (task);
+    
+    /** The thread stays in the pool for the next task */
+    GST_OBJECT_LOCK (bounded);
+    bounded->active--;
+    GST_OBJECT_UNLOCK (bounded);
+}
@@ -0,0 +1,91 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHTASKPOOL_H__
+#define __GST_HTHTASKPOOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Put a new streaming task of an internal element on the shared pool
+ *
+ * Call it from the handle_message of the bin for every message. The
+ * STREAM_STATUS CREATE message is posted synchronously before the task
+ * starts, so the task takes its thread from the process-wide pool shared
+ * by all the hth elements. The pool has one thread per core. A streaming
+ * task keeps its thread until it is stopped, so when the tasks outnumber
+ * the threads the pool grows to one thread per task instead of queuing
+ * one. The ENTER and LEAVE messages are counted for the stats.
+ *
+ * @param message Any message of a child
+ * @return gboolean TRUE if it was a stream status message
+ */
+gboolean gst_hth_task_pool_handle_message (GstMessage *message);
+
+/**
+ * @brief Add the scheduler counters to a stats structure
+ *
+ * Adds shared-pool-tasks (tasks running on the pool), shared-pool-threads,
+ * shared-pool-cores, shared-pool-max-threads (current limit of the pool),
+ * shared-pool-waiting (tasks without a thread, 0 unless a thread could not
+ * start), shared-pool-grows (tasks that made the pool grow past the cores)
+ * and context-switches (voluntary and involuntary switches of the process).
+ *
+ * @param stats Structure to fill
+ */
+void gst_hth_task_pool_append_stats (GstStructure *stats);
+
+/**
+ * @brief Voluntary and involuntary context switches of the process
+ *
+ * @return guint64 Switches since the process started
+ */
+guint64 gst_hth_task_pool_get_context_switches (void);
+
+G_END_DECLS
+
+#endif /* __GST_HTHTASKPOOL_H__ */
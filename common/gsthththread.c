@@ -0,0 +1,263 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** For pthread_setaffinity_np() and pthread_setname_np() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/** -- Includes -- */
+
+/** thread header */
+#include "gsthththread.h" /**< For the thread setup declarations */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/** stdlib header file */
+#include <stdlib.h> /**< For strtol() */
+
+/** string header file */
+#include <string.h> /**< For strcmp() */
+
+/** pthread header file */
+#include <pthread.h> /**< For the affinity, name and scheduling of the thread */
+
+/** sched header file */
+#include <sched.h> /**< For SCHED_FIFO and SCHED_RR */
+
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+
+#define THREAD_NAME_SIZE 16 /**< Limit of pthread_setname_np(), with the terminator */
+
+//==============================================================================
+
+/**
+ * @brief Parse a CPU list like "0-1,4"
+ *
+ * @param cpus The list
+ * @param set Returns the CPUs
+ * @return gboolean FALSE if the list is malformed or empty
+ */
+static gboolean parseCpus (const gchar *cpus, cpu_set_t *set);
+
+/**
+ * @brief Store one sample for each buffer with a PTS
+ *
+ * @param pad The watched pad
+ * @param info Probe info
+ * @param user_data The meter
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_jitterProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+//==============================================================================
+
+void gst_hth_thread_setup (const gchar *name, const gchar *cpus, const gchar *policy, gint priority){
+    
+    gchar threadName[THREAD_NAME_SIZE];
+    struct sched_param param;
+    cpu_set_t set;
+    gint schedPolicy;
+    
+    g_strlcpy (threadName, name, sizeof (threadName));
+    pthread_setname_np (pthread_self (), threadName);
+    
+    if (cpus != NULL && cpus[0] != '\0') {
+        if (!parseCpus (cpus, &set))
+            printf (RED "%s: invalid CPU list \"%s\" \n" RESET, threadName, cpus);
+        else if (pthread_setaffinity_np (pthread_self (), sizeof (set), &set) != 0)
+            printf (RED "%s could not be pinned to CPUs %s \n" RESET, threadName, cpus);
+        else
+            printf (GREEN "%s pinned to CPUs %s \n" RESET, threadName, cpus);
+    }
+    
+    if (policy == NULL || strcmp (policy, "other") == 0 || policy[0] == '\0')
+        return;
+    
+    if (strcmp (policy, "fifo") == 0)
+        schedPolicy = SCHED_FIFO;
+    else if (strcmp (policy, "rr") == 0)
+        schedPolicy = SCHED_RR;
+    else {
+        printf (RED "%s: unknown scheduling policy \"%s\" \n" RESET, threadName, policy);
+        return;
+    }
+    
+    param.sched_priority = CLAMP (priority, sched_get_priority_min (schedPolicy), sched_get_priority_max (schedPolicy));
+    
+    /** Needs CAP_SYS_NICE or an RLIMIT_RTPRIO, the thread keeps running without it */
+    if (pthread_setschedparam (pthread_self (), schedPolicy, &param) != 0)
+        printf (RED "%s could not get the %s policy \n" RESET, threadName, policy);
+    else
+        printf (GREEN "%s runs with %s priority %d \n" RESET, threadName, policy, param.sched_priority);
+}
+
+//==============================================================================
+
+void gst_hth_jitter_init (GstHthJitter *jitter, const gchar *name){
+    
+    memset (jitter, 0, sizeof (GstHthJitter));
+    jitter->name = name;
+    jitter->lastPts = GST_CLOCK_TIME_NONE;
+    gst_hth_histogram_reset (&jitter->samples);
+    g_mutex_init (&jitter->lock);
+}
+
+//==============================================================================
+
+void gst_hth_jitter_clear (GstHthJitter *jitter){
+    
+    g_mutex_clear (&jitter->lock);
+}
+
+//==============================================================================
+
+void gst_hth_jitter_watch_pad (GstHthJitter *jitter, GstPad *pad){
+    
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_jitterProbe, jitter, NULL);
+}
+
+//==============================================================================
+
+void gst_hth_jitter_append_stats (GstHthJitter *jitter, GstStructure *stats){
+    
+    gchar *field;
+    
+    g_mutex_lock (&jitter->lock);
+    
+    field = g_strdup_printf ("%s-jitter", jitter->name);
+    gst_hth_histogram_append_stats (&jitter->samples, stats, field);
+    g_free (field);
+    
+    field = g_strdup_printf ("%s-buffers", jitter->name);
+    gst_structure_set (stats, field, G_TYPE_UINT64, jitter->buffers, NULL);
+    g_free (field);
+    
+    g_mutex_unlock (&jitter->lock);
+}
+
+//==============================================================================
+
+guint64 gst_hth_jitter_get_buffers (GstHthJitter *jitter){
+    
+    guint64 buffers;
+    
+    g_mutex_lock (&jitter->lock);
+    buffers = jitter->buffers;
+    g_mutex_unlock (&jitter->lock);
+    
+    return buffers;
+}
+
+//==============================================================================
+
+static gboolean parseCpus (const gchar *cpus, cpu_set_t *set){
+    
+    gchar **ranges = g_strsplit (cpus, ",", -1);
+    gchar *end;
+    glong first, last, cpu;
+    gboolean valid = TRUE;
+    guint i;
+    
+    CPU_ZERO (set);
+    
+    for (i = 0; ranges[i] != NULL && valid; i++) {
+        
+        first = strtol (ranges[i], &end, 10);
+        last = first;
+        if (*end == '-')
+            last = strtol (end + 1, &end, 10);
+        
+        if (end == ranges[i] || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+            valid = FALSE;
+            break;
+        }
+        
+        for (cpu = first; cpu <= last; cpu++)
+            CPU_SET (cpu, set);
+    }
+    
+    g_strfreev (ranges);
+    
+    return valid && CPU_COUNT (set) > 0;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_jitterProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthJitter *jitter = (GstHthJitter*) user_data;
+    GstClockTime pts = GST_BUFFER_PTS (GST_PAD_PROBE_INFO_BUFFER (info));
+    gint64 arrival = g_get_monotonic_time ();
+    GstClockTimeDiff deviation;
+    
+    g_mutex_lock (&jitter->lock);
+    
+    jitter->buffers++;
+    if (!GST_CLOCK_TIME_IS_VALID (pts)) {
+        g_mutex_unlock (&jitter->lock);
+        return GST_PAD_PROBE_OK;
+    }
+    
+    /** Only forward steps, a seek or a discontinuity starts over */
+    if (GST_CLOCK_TIME_IS_VALID (jitter->lastPts) && pts > jitter->lastPts) {
+        deviation = (arrival - jitter->lastArrival) * GST_USECOND - (GstClockTimeDiff) (pts - jitter->lastPts);
+        gst_hth_histogram_record (&jitter->samples, ABS (deviation));
+    }
+    
+    jitter->lastPts = pts;
+    jitter->lastArrival = arrival;
+    
+    g_mutex_unlock (&jitter->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
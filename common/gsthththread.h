@@ -0,0 +1,137 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHTHREAD_H__
+#define __GST_HTHTHREAD_H__
+
+#include <gst/gst.h>
+
+#include "gsththhistogram.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Name, CPU set and scheduling of the calling thread
+ *
+ * Called from the STREAM_STATUS ENTER message, which the streaming thread
+ * posts itself before running its loop. Failures are printed and don't
+ * stop the thread (e.g. SCHED_FIFO needs CAP_SYS_NICE).
+ *
+ * @param name Thread name shown by top and perf, 15 characters at most
+ * @param cpus CPU list like "2" or "0-1,4", NULL or "" to keep the affinity
+ * @param policy "fifo", "rr", or NULL / "other" to keep the time sharing policy
+ * @param priority Real-time priority, 1 to 99
+ */
+void gst_hth_thread_setup (const gchar *name, const gchar *cpus, const gchar *policy, gint priority);
+
+/**
+ * @struct GstHthJitter
+ *
+ * @brief Scheduling jitter of the buffers crossing a pad
+ *
+ * Each sample is the difference between the wall clock interval and the
+ * PTS interval of two consecutive buffers, the delay added by the threads
+ * that carried them. The samples go in a histogram, so reading the
+ * percentiles costs the same whatever the number of buffers.
+ *
+ */
+
+typedef struct _GstHthJitter GstHthJitter;
+
+struct _GstHthJitter {
+    
+    const gchar *name; /**< Prefix of the stats fields */
+    GMutex lock; /**< Protects the histogram */
+    GstClockTime lastPts; /**< PTS of the previous buffer */
+    gint64 lastArrival; /**< Monotonic time of the previous buffer, in us */
+    GstHthHistogram samples; /**< Samples since the meter was initialized, in ns */
+    guint64 buffers; /**< Buffers that crossed the pad */
+};
+
+/**
+ * @brief Initialize a jitter meter
+ *
+ * @param jitter The meter
+ * @param name Prefix of the stats fields, a static string
+ */
+void gst_hth_jitter_init (GstHthJitter *jitter, const gchar *name);
+
+/**
+ * @brief Release the lock of a jitter meter
+ *
+ * @param jitter The meter
+ */
+void gst_hth_jitter_clear (GstHthJitter *jitter);
+
+/**
+ * @brief Measure the buffers crossing a pad
+ *
+ * @param jitter The meter, outlives the pad
+ * @param pad Pad to probe
+ */
+void gst_hth_jitter_watch_pad (GstHthJitter *jitter, GstPad *pad);
+
+/**
+ * @brief Add the jitter percentiles to a stats structure
+ *
+ * Adds <name>-jitter-p50, -p95, -p99, -p999, -min, -max and -mean in ns,
+ * and <name>-buffers.
+ *
+ * @param jitter The meter
+ * @param stats Structure to fill
+ */
+void gst_hth_jitter_append_stats (GstHthJitter *jitter, GstStructure *stats);
+
+/**
+ * @brief Buffers that crossed the pad
+ *
+ * @param jitter The meter
+ * @return guint64 Buffers since the meter was initialized
+ */
+guint64 gst_hth_jitter_get_buffers (GstHthJitter *jitter);
+
+G_END_DECLS
+
+#endif /* __GST_HTHTHREAD_H__ */
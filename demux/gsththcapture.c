@@ -0,0 +1,201 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** capture header */
+#include "gsththcapture.h" /**< For the capture file declarations */
+
+/** stdio header file */
+#include <stdio.h> /**< For fopen() and the buffered writes */
+
+/** string header file */
+#include <string.h> /**< For memcmp() */
+
+#define CAPTURE_BUFFER_SIZE (256 * 1024) /**< stdio buffer of the file, flushed on close */
+
+struct _GstHthCapture {
+    
+    FILE *file; /**< Capture file */
+    GMutex lock; /**< Serialises the records of the receive threads */
+    GstClockTime start; /**< Monotonic time of the first datagram */
+    guint64 datagrams; /**< Records written */
+    guint64 bytes; /**< Datagram bytes written */
+};
+
+struct _GstHthCaptureReader {
+    
+    FILE *file; /**< Capture file */
+};
+
+//==============================================================================
+
+GstHthCapture *gst_hth_capture_open (const gchar *path){
+    
+    GstHthCapture *capture;
+    FILE *file;
+    
+    file = fopen (path, "wb");
+    if (file == NULL)
+        return NULL;
+    
+    setvbuf (file, NULL, _IOFBF, CAPTURE_BUFFER_SIZE);
+    fwrite (HTH_CAPTURE_MAGIC, 1, strlen (HTH_CAPTURE_MAGIC), file);
+    
+    capture = g_new0 (GstHthCapture, 1);
+    capture->file = file;
+    capture->start = GST_CLOCK_TIME_NONE;
+    g_mutex_init (&capture->lock);
+    
+    return capture;
+}
+
+//==============================================================================
+
+void gst_hth_capture_write (GstHthCapture *capture, const struct sockaddr_in *from, const guint8 *data, gsize size){
+    
+    GstClockTime now = gst_util_get_timestamp ();
+    guint8 record[HTH_CAPTURE_RECORD_SIZE];
+    
+    size = MIN (size, HTH_CAPTURE_MAX_DATAGRAM);
+    
+    g_mutex_lock (&capture->lock);
+    
+    if (!GST_CLOCK_TIME_IS_VALID (capture->start))
+        capture->start = now;
+    
+    GST_WRITE_UINT64_LE (record, now - capture->start);
+    if (from != NULL) {
+        memcpy (record + 8, &from->sin_addr.s_addr, 4);
+        memcpy (record + 12, &from->sin_port, 2);
+    } else {
+        memset (record + 8, 0, 6);
+    }
+    GST_WRITE_UINT16_LE (record + 14, size);
+    
+    fwrite (record, 1, sizeof (record), capture->file);
+    fwrite (data, 1, size, capture->file);
+    capture->datagrams++;
+    capture->bytes += size;
+    
+    g_mutex_unlock (&capture->lock);
+}
+
+//==============================================================================
+
+void gst_hth_capture_append_stats (GstHthCapture *capture, GstStructure *stats){
+    
+    g_mutex_lock (&capture->lock);
+    gst_structure_set (stats,
+                       "capture-datagrams", G_TYPE_UINT64, capture->datagrams,
+                       "capture-bytes", G_TYPE_UINT64, capture->bytes,
+                       NULL);
+    g_mutex_unlock (&capture->lock);
+}
+
+//==============================================================================
+
+void gst_hth_capture_close (GstHthCapture *capture){
+    
+    fclose (capture->file);
+    g_mutex_clear (&capture->lock);
+    g_free (capture);
+}
+
+//==============================================================================
+
+GstHthCaptureReader *gst_hth_capture_reader_open (const gchar *path){
+    
+    GstHthCaptureReader *reader;
+    gchar magic[sizeof (HTH_CAPTURE_MAGIC) - 1];
+    FILE *file;
+    
+    file = fopen (path, "rb");
+    if (file == NULL)
+        return NULL;
+    
+    if (fread (magic, 1, sizeof (magic), file) != sizeof (magic) || memcmp (magic, HTH_CAPTURE_MAGIC, sizeof (magic)) != 0) {
+        fclose (file);
+        return NULL;
+    }
+    
+    reader = g_new0 (GstHthCaptureReader, 1);
+    reader->file = file;
+    
+    return reader;
+}
+
+//==============================================================================
+
+gboolean gst_hth_capture_reader_next (GstHthCaptureReader *reader, GstClockTime *arrival, struct sockaddr_in *from,
+                                      guint8 *data, gsize *size){
+    
+    guint8 record[HTH_CAPTURE_RECORD_SIZE];
+    
+    if (fread (record, 1, sizeof (record), reader->file) != sizeof (record))
+        return FALSE;
+    
+    *arrival = GST_READ_UINT64_LE (record);
+    memset (from, 0, sizeof (*from));
+    from->sin_family = AF_INET;
+    memcpy (&from->sin_addr.s_addr, record + 8, 4);
+    memcpy (&from->sin_port, record + 12, 2);
+    *size = GST_READ_UINT16_LE (record + 14);
+    
+    /** A capture cut while it was written ends on a partial record */
+    return fread (data, 1, *size, reader->file) == *size;
+}
+
+//==============================================================================
+
+void gst_hth_capture_reader_close (GstHthCaptureReader *reader){
+    
+    fclose (reader->file);
+    g_free (reader);
+}
@@ -0,0 +1,145 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHCAPTURE_H__
+#define __GST_HTHCAPTURE_H__
+
+#include <gst/gst.h>
+#include <netinet/in.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief First bytes of a capture file
+ *
+ * Followed by one record per datagram: arrival time in ns since the first
+ * datagram (64 bits), sender address and port (network order), length
+ * (16 bits), then the datagram as received, stream id header included.
+ * The integers are little endian.
+ */
+#define HTH_CAPTURE_MAGIC "HTHCAP01"
+
+/**
+ * @brief Size of the record header in front of each datagram
+ */
+#define HTH_CAPTURE_RECORD_SIZE 16
+
+/**
+ * @brief Largest datagram of a record, the length field is 16 bits
+ */
+#define HTH_CAPTURE_MAX_DATAGRAM G_MAXUINT16
+
+/**
+ * @struct GstHthCapture
+ * @brief Capture file being written, shared by the receive threads
+ */
+typedef struct _GstHthCapture GstHthCapture;
+
+/**
+ * @struct GstHthCaptureReader
+ * @brief Capture file being read back
+ */
+typedef struct _GstHthCaptureReader GstHthCaptureReader;
+
+/**
+ * @brief Create a capture file, truncated if it exists
+ * @param path File path
+ * @return GstHthCapture* The capture, NULL if the file could not be created
+ */
+GstHthCapture *gst_hth_capture_open (const gchar *path);
+
+/**
+ * @brief Append a datagram with its arrival time
+ *
+ * Called from the streaming or receive threads, the writes are buffered.
+ *
+ * @param capture The capture
+ * @param from Sender of the datagram, NULL when unknown
+ * @param data The datagram
+ * @param size Datagram size
+ */
+void gst_hth_capture_write (GstHthCapture *capture, const struct sockaddr_in *from, const guint8 *data, gsize size);
+
+/**
+ * @brief Add capture-datagrams and capture-bytes to a stats structure
+ * @param capture The capture
+ * @param stats Structure to fill
+ */
+void gst_hth_capture_append_stats (GstHthCapture *capture, GstStructure *stats);
+
+/**
+ * @brief Flush and close the capture file
+ * @param capture The capture
+ */
+void gst_hth_capture_close (GstHthCapture *capture);
+
+/**
+ * @brief Open a capture file
+ * @param path File path
+ * @return GstHthCaptureReader* The reader, NULL if the file is missing or is not a capture
+ */
+GstHthCaptureReader *gst_hth_capture_reader_open (const gchar *path);
+
+/**
+ * @brief Read the next datagram
+ * @param reader The reader
+ * @param arrival Arrival time since the first datagram
+ * @param from Sender of the datagram, address 0 when it was unknown
+ * @param data Filled with the datagram, at least HTH_CAPTURE_MAX_DATAGRAM bytes
+ * @param size Datagram size
+ * @return gboolean FALSE at the end of the file or on a truncated record
+ */
+gboolean gst_hth_capture_reader_next (GstHthCaptureReader *reader, GstClockTime *arrival, struct sockaddr_in *from,
+                                      guint8 *data, gsize *size);
+
+/**
+ * @brief Close a capture file
+ * @param reader The reader
+ */
+void gst_hth_capture_reader_close (GstHthCaptureReader *reader);
+
+G_END_DECLS
+
+#endif /* __GST_HTHCAPTURE_H__ */
@@ -0,0 +1,1033 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** For pthread_setaffinity_np() and recvmmsg() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/** -- Includes -- */
+
+/** receiver header */
+#include "gsththreceiver.h" /**< For the receive engine declarations */
+
+/** stream id header */
+#include "gsththstreamid.h" /**< For gst_hth_stream_id_parse() */
+
+/** thread header */
+#include "gsthththread.h" /**< For gst_hth_thread_setup() */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/** string header file */
+#include <string.h> /**< For memset() */
+
+/** errno header file */
+#include <errno.h> /**< For errno */
+
+/** unistd header file */
+#include <unistd.h> /**< For close() */
+
+/** poll header file */
+#include <poll.h> /**< For poll() */
+
+/** pthread header file */
+#include <pthread.h> /**< For pthread_setaffinity_np() */
+#include <sched.h> /**< For sched_getaffinity() */
+
+/** socket header files */
+#include <sys/socket.h> /**< For socket(), bind() and recvmmsg() */
+#include <netinet/in.h> /**< For sockaddr_in */
+#include <arpa/inet.h> /**< For inet_ntop() */
+
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+#define YELLOW  "\033[1m\033[33m"   /** Sender timed out */
+
+#define POLL_TIMEOUT_MS        100 /**< The threads check the stop flag at this interval */
+#define SOCKET_RECEIVE_BUFFER  (4 * 1024 * 1024) /**< SO_RCVBUF of each socket */
+#define SENDER_KEY_SIZE        (INET_ADDRSTRLEN + 8) /**< "address:port" or "stream<id>" */
+#define RECEIVE_BATCH          32 /**< Datagrams read by one recvmmsg() */
+#define POOL_MAX_BUFFERS       (RECEIVE_BATCH * 16) /**< Datagrams of one worker held downstream before the pool runs out */
+#define POOL_WAIT_US           1000 /**< Pause of a thread whose pool is empty under a memory limit */
+
+//==============================================================================
+
+/**
+ * @struct HthReceiverSender
+ * @brief Sender data of the callbacks and its last activity
+ */
+typedef struct {
+    gpointer data; /**< Returned by senderNew */
+    gint64 lastSeen; /**< Monotonic time of the last datagram, in us */
+    GstHthSequence sequence; /**< Loss and reordering, with the stream id header */
+    gint refCount; /**< One for the senders table and one per datagram being passed, atomic */
+} HthReceiverSender;
+
+/**
+ * @struct HthReceiverWorker
+ * @brief One socket, one thread and the senders hashed to them
+ */
+typedef struct {
+    
+    GstHthReceiver *receiver; /**< Engine of the worker */
+    guint index; /**< Worker number, also the CPU it is pinned to */
+    gint socket; /**< SO_REUSEPORT socket, -1 when closed */
+    GThread *thread; /**< Receive thread */
+    
+    GstBufferPool *pool; /**< Datagram buffers, preallocated when the worker starts */
+    guint poolBuffers; /**< Maximum buffers of the pool */
+    
+    GMutex lock; /**< Protects the senders and the counters */
+    GHashTable *senders; /**< Sender key -> HthReceiverSender */
+    gint64 lastExpiry; /**< Monotonic time of the last idle senders check, in us */
+    guint64 packets; /**< Datagrams received */
+    guint64 bytes; /**< Bytes received */
+    guint64 syscalls; /**< recvmmsg() calls that returned datagrams */
+    guint64 poolExhausted; /**< Batches that got less buffers than RECEIVE_BATCH from the pool */
+    guint64 poolDrops; /**< Datagrams discarded because the pool was empty */
+    guint64 expired; /**< Senders forgotten after the timeout */
+    
+} HthReceiverWorker;
+
+struct _GstHthReceiver {
+    
+    guint port; /**< UDP port of all the sockets */
+    guint workersCount; /**< Number of workers of the last start */
+    HthReceiverWorker *workers; /**< HTH_RECEIVER_MAX_WORKERS workers */
+    GstHthReceiverCallbacks callbacks; /**< Sender callbacks */
+    gpointer userData; /**< Passed to the callbacks */
+    gint64 senderTimeout; /**< Idle time before a sender is forgotten, in us, 0 for never */
+    gboolean streamIds; /**< The senders are identified by the stream id header when present */
+    gchar *threadCpus; /**< CPU list of all the threads, NULL to pin one thread per CPU */
+    gchar *threadPolicy; /**< Scheduling policy of the threads */
+    gint threadPriority; /**< Real-time priority of the threads */
+    guint64 poolMemory; /**< Bytes shared by the pools of all the workers, 0 for no limit */
+    GstHthCapture *capture; /**< Record of the datagrams received, NULL for none */
+    GstHthCaptureReader *replay; /**< Capture fed instead of the sockets, NULL when receiving */
+    gboolean replayRealtime; /**< The replay keeps the original arrival times */
+    gint64 replayStart; /**< Monotonic time of the first replayed datagram, in us */
+    gint64 replayEnd; /**< Monotonic time of the end of the capture, in us, 0 before */
+    gint running; /**< Cleared to stop the threads, atomic */
+};
+
+//==============================================================================
+
+/**
+ * @brief Open a SO_REUSEPORT socket bound to the port of the engine
+ *
+ * @param receiver The engine
+ * @return gint The socket, -1 on failure
+ */
+static gint openSocket (GstHthReceiver *receiver);
+
+/**
+ * @brief Create and activate the buffer pool of a worker
+ *
+ * @param worker The worker
+ * @return gboolean FALSE if the buffers could not be preallocated
+ */
+static gboolean startPool (HthReceiverWorker *worker);
+
+/**
+ * @brief Fill the empty slots of a batch with mapped buffers of the pool
+ *
+ * A slot is refilled only after its buffer was received into, so the
+ * pool is not touched for the datagrams that did not arrive.
+ *
+ * @param worker The worker
+ * @param buffers Buffers of the batch, the first filled ones are kept
+ * @param maps Write mappings of the buffers
+ * @param filled Number of slots already filled
+ * @return guint Number of slots filled, less than RECEIVE_BATCH when the pool ran out,
+ *         0 after a datagram was discarded for lack of buffers
+ */
+static guint fillBatch (HthReceiverWorker *worker, GstBuffer **buffers, GstMapInfo *maps, guint filled);
+
+/**
+ * @brief Receive thread of a worker
+ *
+ * @param data The worker
+ * @return gpointer NULL
+ */
+static gpointer receiveThread (gpointer data);
+
+/**
+ * @brief Thread of the replay, reads the capture into the pooled buffers
+ *
+ * @param data The worker 0
+ * @return gpointer NULL
+ */
+static gpointer replayThread (gpointer data);
+
+/**
+ * @brief Pin the calling thread to one of the CPUs the process may run on
+ *
+ * @param index Worker number, picks the index-th allowed CPU and wraps around them
+ * @return void
+ */
+static void pinThread (guint index);
+
+/**
+ * @brief Pass one datagram to its sender, creating it when it is new
+ *
+ * @param worker The worker that received it
+ * @param key Sender key
+ * @param buffer The datagram, the ownership is taken
+ * @param sequence Sequence number of the datagram, NULL without stream id header
+ * @return void
+ */
+static void dispatchPacket (HthReceiverWorker *worker, const gchar *key, GstBuffer *buffer, const guint32 *sequence);
+
+/**
+ * @brief Forget the senders of a worker idle for longer than the timeout
+ *
+ * Runs in the receive thread, at most every POLL_TIMEOUT_MS.
+ *
+ * @param worker The worker
+ * @return void
+ */
+static void expireSenders (HthReceiverWorker *worker);
+
+/**
+ * @brief Build the sender key of a datagram
+ *
+ * @param receiver The engine
+ * @param address Source address of the datagram
+ * @param data The datagram, mapped
+ * @param size Size of the datagram
+ * @param key Returns the key, SENDER_KEY_SIZE bytes
+ * @param sequence Returns the sequence number of the header
+ * @return gboolean TRUE if the datagram starts with a stream id header, to strip from the buffer
+ */
+static gboolean buildSenderKey (GstHthReceiver *receiver, const struct sockaddr_in *address, const guint8 *data, gsize size,
+                                gchar *key, guint32 *sequence);
+
+/**
+ * @brief Trim a received buffer to its payload and pass it to its sender
+ *
+ * @param worker The worker that received it
+ * @param key Sender key
+ * @param buffer The datagram buffer, unmapped, the ownership is taken
+ * @param size Size of the datagram
+ * @param sequence Sequence number of the header, NULL without stream id header
+ * @return void
+ */
+static void dispatchDatagram (HthReceiverWorker *worker, const gchar *key, GstBuffer *buffer, gsize size, const guint32 *sequence);
+
+/**
+ * @brief Forget all the senders of a worker
+ *
+ * @param worker The worker
+ * @return void
+ */
+static void removeAllSenders (HthReceiverWorker *worker);
+
+/**
+ * @brief Release a reference to a sender, the last one calls senderRemoved
+ *
+ * Called without the lock of the worker, so a sender forgotten while one
+ * of its datagrams is being pushed is only removed once the push returned.
+ *
+ * @param receiver The engine
+ * @param entry The sender
+ * @return void
+ */
+static void releaseSender (GstHthReceiver *receiver, HthReceiverSender *entry);
+
+//==============================================================================
+
+GstHthReceiver *gst_hth_receiver_new (const GstHthReceiverCallbacks *callbacks, gpointer userData){
+    
+    GstHthReceiver *receiver;
+    guint i;
+    
+    receiver = g_new0 (GstHthReceiver, 1);
+    receiver->callbacks = *callbacks;
+    receiver->userData = userData;
+    receiver->workers = g_new0 (HthReceiverWorker, HTH_RECEIVER_MAX_WORKERS);
+    
+    /** The engine lives as long as its owner, the sockets only while it is started */
+    for (i = 0; i < HTH_RECEIVER_MAX_WORKERS; i++) {
+        receiver->workers[i].receiver = receiver;
+        receiver->workers[i].index = i;
+        receiver->workers[i].socket = -1;
+        g_mutex_init (&receiver->workers[i].lock);
+        receiver->workers[i].senders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    }
+    
+    return receiver;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_set_sender_timeout (GstHthReceiver *receiver, GstClockTime timeout){
+    
+    receiver->senderTimeout = GST_CLOCK_TIME_IS_VALID (timeout) ? (gint64) GST_TIME_AS_USECONDS (timeout) : 0;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_set_stream_ids (GstHthReceiver *receiver, gboolean streamIds){
+    
+    receiver->streamIds = streamIds;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_set_threads (GstHthReceiver *receiver, const gchar *cpus, const gchar *policy, gint priority){
+    
+    g_free (receiver->threadCpus);
+    g_free (receiver->threadPolicy);
+    receiver->threadCpus = g_strdup (cpus);
+    receiver->threadPolicy = g_strdup (policy);
+    receiver->threadPriority = priority;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_set_pool_memory (GstHthReceiver *receiver, guint64 bytes){
+    
+    receiver->poolMemory = bytes;
+}
+
+//==============================================================================
+
+guint64 gst_hth_receiver_get_pool_memory (GstHthReceiver *receiver){
+    
+    guint64 bytes = 0;
+    guint i;
+    
+    for (i = 0; i < receiver->workersCount; i++)
+        bytes += (guint64) receiver->workers[i].poolBuffers * HTH_RECEIVER_MAX_DATAGRAM;
+    
+    return bytes;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_set_capture (GstHthReceiver *receiver, GstHthCapture *capture){
+    
+    receiver->capture = capture;
+}
+
+//==============================================================================
+
+gboolean gst_hth_receiver_start (GstHthReceiver *receiver, guint port, guint workers){
+    
+    gchar threadName[16];
+    guint i;
+    
+    receiver->port = port;
+    receiver->workersCount = CLAMP (workers, 1, HTH_RECEIVER_MAX_WORKERS);
+    
+    /** All the sockets are bound before any thread reads, so the kernel spreads the senders on all of them */
+    for (i = 0; i < receiver->workersCount; i++) {
+        receiver->workers[i].socket = openSocket (receiver);
+        if (receiver->workers[i].socket < 0 || !startPool (&receiver->workers[i])) {
+            gst_hth_receiver_stop (receiver);
+            return FALSE;
+        }
+    }
+    
+    g_atomic_int_set (&receiver->running, TRUE);
+    
+    for (i = 0; i < receiver->workersCount; i++) {
+        g_snprintf (threadName, sizeof (threadName), "hth-rx-%u", i);
+        receiver->workers[i].thread = g_thread_new (threadName, receiveThread, &receiver->workers[i]);
+    }
+    
+    printf (GREEN "Receiving on port %u with %u threads \n" RESET, receiver->port, receiver->workersCount);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+gboolean gst_hth_receiver_start_replay (GstHthReceiver *receiver, const gchar *path, gboolean realtime){
+    
+    receiver->replay = gst_hth_capture_reader_open (path);
+    if (receiver->replay == NULL)
+        return FALSE;
+    
+    receiver->workersCount = 1;
+    receiver->replayRealtime = realtime;
+    receiver->replayStart = 0;
+    receiver->replayEnd = 0;
+    
+    if (!startPool (&receiver->workers[0])) {
+        gst_hth_receiver_stop (receiver);
+        return FALSE;
+    }
+    
+    g_atomic_int_set (&receiver->running, TRUE);
+    receiver->workers[0].thread = g_thread_new ("hth-replay", replayThread, &receiver->workers[0]);
+    
+    printf (GREEN "Replaying %s %s \n" RESET, path, realtime ? "with its original timing" : "as fast as possible");
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+void gst_hth_receiver_stop (GstHthReceiver *receiver){
+    
+    HthReceiverWorker *worker;
+    guint i;
+    
+    g_atomic_int_set (&receiver->running, FALSE);
+    
+    for (i = 0; i < receiver->workersCount; i++) {
+        
+        worker = &receiver->workers[i];
+        
+        if (worker->thread != NULL) {
+            g_thread_join (worker->thread);
+            worker->thread = NULL;
+        }
+        
+        if (worker->socket >= 0) {
+            close (worker->socket);
+            worker->socket = -1;
+        }
+        
+        removeAllSenders (worker);
+        
+        /** The buffers still held downstream keep the pool alive until they are released */
+        if (worker->pool != NULL) {
+            gst_buffer_pool_set_active (worker->pool, FALSE);
+            gst_object_unref (worker->pool);
+            worker->pool = NULL;
+            worker->poolBuffers = 0;
+        }
+    }
+    
+    if (receiver->replay != NULL) {
+        gst_hth_capture_reader_close (receiver->replay);
+        receiver->replay = NULL;
+    }
+}
+
+//==============================================================================
+
+void gst_hth_receiver_forget_sender (GstHthReceiver *receiver, const gchar *key){
+    
+    HthReceiverWorker *worker;
+    HthReceiverSender *entry;
+    guint i;
+    
+    for (i = 0; i < receiver->workersCount; i++) {
+        
+        worker = &receiver->workers[i];
+        
+        g_mutex_lock (&worker->lock);
+        entry = g_hash_table_lookup (worker->senders, key);
+        if (entry != NULL)
+            g_hash_table_remove (worker->senders, key);
+        g_mutex_unlock (&worker->lock);
+        
+        if (entry != NULL) {
+            releaseSender (receiver, entry);
+            return;
+        }
+    }
+}
+
+//==============================================================================
+
+void gst_hth_receiver_append_stats (GstHthReceiver *receiver, GstStructure *stats){
+    
+    HthReceiverWorker *worker;
+    gchar *packetsField;
+    guint64 packets = 0;
+    guint64 bytes = 0;
+    guint64 syscalls = 0;
+    guint64 poolExhausted = 0;
+    guint64 poolDrops = 0;
+    guint64 expired = 0;
+    guint64 lost = 0;
+    guint64 reordered = 0;
+    GHashTableIter iter;
+    gpointer entry;
+    guint senders = 0;
+    guint i;
+    
+    for (i = 0; i < receiver->workersCount; i++) {
+        
+        worker = &receiver->workers[i];
+        packetsField = g_strdup_printf ("worker%u-packets", i);
+        
+        g_mutex_lock (&worker->lock);
+        gst_structure_set (stats, packetsField, G_TYPE_UINT64, worker->packets, NULL);
+        packets += worker->packets;
+        bytes += worker->bytes;
+        syscalls += worker->syscalls;
+        poolExhausted += worker->poolExhausted;
+        poolDrops += worker->poolDrops;
+        expired += worker->expired;
+        senders += g_hash_table_size (worker->senders);
+        g_hash_table_iter_init (&iter, worker->senders);
+        while (g_hash_table_iter_next (&iter, NULL, &entry)) {
+            lost += gst_hth_sequence_get_lost (&((HthReceiverSender*) entry)->sequence);
+            reordered += ((HthReceiverSender*) entry)->sequence.reordered;
+        }
+        g_mutex_unlock (&worker->lock);
+        
+        g_free (packetsField);
+    }
+    
+    gst_structure_set (stats,
+                       "receive-threads", G_TYPE_UINT, receiver->workersCount,
+                       "receive-packets", G_TYPE_UINT64, packets,
+                       "receive-bytes", G_TYPE_UINT64, bytes,
+                       "senders", G_TYPE_UINT, senders,
+                       "receive-syscalls", G_TYPE_UINT64, syscalls,
+                       "packets-per-syscall", G_TYPE_DOUBLE, syscalls > 0 ? (gdouble) packets / syscalls : 0.0,
+                       "pool-exhaustion", G_TYPE_UINT64, poolExhausted,
+                       "pool-drops", G_TYPE_UINT64, poolDrops,
+                       "senders-expired", G_TYPE_UINT64, expired,
+                       "receive-lost", G_TYPE_UINT64, lost,
+                       "receive-reordered", G_TYPE_UINT64, reordered,
+                       "receive-pool-memory", G_TYPE_UINT64, gst_hth_receiver_get_pool_memory (receiver),
+                       NULL);
+    
+    if (receiver->replay != NULL) {
+        worker = &receiver->workers[0];
+        g_mutex_lock (&worker->lock);
+        gst_structure_set (stats,
+                           "replay-elapsed", G_TYPE_UINT64, receiver->replayStart > 0
+                               ? (guint64) ((receiver->replayEnd > 0 ? receiver->replayEnd : g_get_monotonic_time ())
+                                            - receiver->replayStart) * GST_USECOND : 0,
+                           "replay-done", G_TYPE_BOOLEAN, receiver->replayEnd > 0,
+                           NULL);
+        g_mutex_unlock (&worker->lock);
+    }
+}
+
+//==============================================================================
+
+void gst_hth_receiver_free (GstHthReceiver *receiver){
+    
+    guint i;
+    
+    if (receiver == NULL)
+        return;
+    
+    gst_hth_receiver_stop (receiver);
+    
+    for (i = 0; i < HTH_RECEIVER_MAX_WORKERS; i++) {
+        g_hash_table_destroy (receiver->workers[i].senders);
+        g_mutex_clear (&receiver->workers[i].lock);
+    }
+    
+    g_free (receiver->threadCpus);
+    g_free (receiver->threadPolicy);
+    g_free (receiver->workers);
+    g_free (receiver);
+}
+
+//==============================================================================
+
+static gint openSocket (GstHthReceiver *receiver){
+    
+    struct sockaddr_in address;
+    gint enable = 1;
+    gint bufferSize = SOCKET_RECEIVE_BUFFER;
+    gint fd;
+    
+    fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf (RED "Receive socket could not be created: %s \n" RESET, g_strerror (errno));
+        return -1;
+    }
+    
+    /** Every socket of the group sets SO_REUSEPORT before bind */
+    if (setsockopt (fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof (enable)) < 0) {
+        printf (RED "SO_REUSEPORT not supported: %s \n" RESET, g_strerror (errno));
+        close (fd);
+        return -1;
+    }
+    
+    /** Not fatal, the kernel limit (net.core.rmem_max) may be lower */
+    setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof (bufferSize));
+    
+    memset (&address, 0, sizeof (address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl (INADDR_ANY);
+    address.sin_port = htons (receiver->port);
+    
+    if (bind (fd, (struct sockaddr*) &address, sizeof (address)) < 0) {
+        printf (RED "Receive socket could not be bound to port %u: %s \n" RESET, receiver->port, g_strerror (errno));
+        close (fd);
+        return -1;
+    }
+    
+    return fd;
+}
+
+//==============================================================================
+
+static gboolean startPool (HthReceiverWorker *worker){
+    
+    GstHthReceiver *receiver = worker->receiver;
+    GstStructure *config;
+    
+    /** The memory limit is split evenly, one batch is the least a worker can read with */
+    worker->poolBuffers = POOL_MAX_BUFFERS;
+    if (receiver->poolMemory > 0)
+        worker->poolBuffers = CLAMP (receiver->poolMemory / receiver->workersCount / HTH_RECEIVER_MAX_DATAGRAM,
+                                     RECEIVE_BATCH, POOL_MAX_BUFFERS);
+    
+    worker->pool = gst_buffer_pool_new ();
+    
+    /** A batch worth of buffers is allocated up front, the rest on demand up to the maximum */
+    config = gst_buffer_pool_get_config (worker->pool);
+    gst_buffer_pool_config_set_params (config, NULL, HTH_RECEIVER_MAX_DATAGRAM, RECEIVE_BATCH, worker->poolBuffers);
+    
+    if (!gst_buffer_pool_set_config (worker->pool, config) || !gst_buffer_pool_set_active (worker->pool, TRUE)) {
+        printf (RED "Buffer pool of receive thread %u could not be started \n" RESET, worker->index);
+        gst_object_unref (worker->pool);
+        worker->pool = NULL;
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static guint fillBatch (HthReceiverWorker *worker, GstBuffer **buffers, GstMapInfo *maps, guint filled){
+    
+    GstBufferPoolAcquireParams params = { 0, };
+    
+    /** Never wait for the pool, the receive thread has to keep draining the socket */
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    
+    while (filled < RECEIVE_BATCH) {
+        if (gst_buffer_pool_acquire_buffer (worker->pool, &buffers[filled], &params) != GST_FLOW_OK)
+            break;
+        gst_buffer_map (buffers[filled], &maps[filled], GST_MAP_WRITE);
+        filled++;
+    }
+    
+    if (filled < RECEIVE_BATCH) {
+        
+        g_mutex_lock (&worker->lock);
+        worker->poolExhausted++;
+        g_mutex_unlock (&worker->lock);
+        
+        /** Under a memory limit the socket fills up and the kernel drops the datagrams instead */
+        if (filled == 0 && worker->receiver->poolMemory > 0) {
+            g_usleep (POOL_WAIT_US);
+            return 0;
+        }
+        
+        /**
+         * Everything is held downstream. The oldest datagram is discarded so the socket keeps
+         * draining, rather than allocating outside the pool
+         */
+        if (filled == 0 && recv (worker->socket, NULL, 0, MSG_DONTWAIT | MSG_TRUNC) >= 0) {
+            g_mutex_lock (&worker->lock);
+            worker->poolDrops++;
+            g_mutex_unlock (&worker->lock);
+        }
+    }
+    
+    return filled;
+}
+
+//==============================================================================
+
+static gpointer receiveThread (gpointer data){
+    
+    HthReceiverWorker *worker = (HthReceiverWorker*) data;
+    GstHthReceiver *receiver = worker->receiver;
+    GstBuffer *buffers[RECEIVE_BATCH];
+    GstMapInfo maps[RECEIVE_BATCH];
+    struct mmsghdr messages[RECEIVE_BATCH];
+    struct iovec vectors[RECEIVE_BATCH];
+    struct sockaddr_in senders[RECEIVE_BATCH];
+    struct pollfd pollSocket;
+    gchar key[SENDER_KEY_SIZE];
+    gchar threadName[16];
+    guint32 sequence;
+    gboolean hasHeader;
+    guint filled = 0;
+    gint received;
+    gint i;
+    
+    /** Without a CPU list each thread gets its own CPU among the allowed ones */
+    g_snprintf (threadName, sizeof (threadName), "hth-rx-%u", worker->index);
+    if (receiver->threadCpus == NULL || receiver->threadCpus[0] == '\0')
+        pinThread (worker->index);
+    gst_hth_thread_setup (threadName, receiver->threadCpus, receiver->threadPolicy, receiver->threadPriority);
+    
+    pollSocket.fd = worker->socket;
+    pollSocket.events = POLLIN;
+    worker->lastExpiry = g_get_monotonic_time ();
+    
+    while (g_atomic_int_get (&receiver->running)) {
+        
+        expireSenders (worker);
+        
+        /** Wakes up regularly to see the stop flag */
+        if (poll (&pollSocket, 1, POLL_TIMEOUT_MS) <= 0)
+            continue;
+        
+        filled = fillBatch (worker, buffers, maps, filled);
+        if (filled == 0)
+            continue;
+        
+        /** The datagrams land directly in the pooled buffers */
+        memset (messages, 0, sizeof (struct mmsghdr) * filled);
+        for (i = 0; i < (gint) filled; i++) {
+            vectors[i].iov_base = maps[i].data;
+            vectors[i].iov_len = maps[i].size;
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof (senders[i]);
+        }
+        
+        received = recvmmsg (worker->socket, messages, filled, MSG_DONTWAIT, NULL);
+        if (received <= 0) {
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                printf (RED "Receive thread %u: %s \n" RESET, worker->index, g_strerror (errno));
+            continue;
+        }
+        
+        g_mutex_lock (&worker->lock);
+        worker->syscalls++;
+        g_mutex_unlock (&worker->lock);
+        
+        for (i = 0; i < received; i++) {
+            
+            if (receiver->capture != NULL)
+                gst_hth_capture_write (receiver->capture, &senders[i], maps[i].data, messages[i].msg_len);
+            
+            hasHeader = buildSenderKey (receiver, &senders[i], maps[i].data, messages[i].msg_len, key, &sequence);
+            
+            /** Last access to the data */
+            gst_buffer_unmap (buffers[i], &maps[i]);
+            dispatchDatagram (worker, key, buffers[i], messages[i].msg_len, hasHeader ? &sequence : NULL);
+        }
+        
+        /** The buffers not received into are kept for the next batch */
+        filled -= received;
+        memmove (buffers, &buffers[received], sizeof (GstBuffer*) * filled);
+        memmove (maps, &maps[received], sizeof (GstMapInfo) * filled);
+    }
+    
+    for (i = 0; i < (gint) filled; i++) {
+        gst_buffer_unmap (buffers[i], &maps[i]);
+        gst_buffer_unref (buffers[i]);
+    }
+    
+    return NULL;
+}
+
+//==============================================================================
+
+static gpointer replayThread (gpointer data){
+    
+    HthReceiverWorker *worker = (HthReceiverWorker*) data;
+    GstHthReceiver *receiver = worker->receiver;
+    GstBufferPoolAcquireParams params = { 0, };
+    GHashTableIter iter;
+    gpointer entry;
+    struct sockaddr_in sender;
+    GstClockTime arrival;
+    GstBuffer *buffer = NULL;
+    GstMapInfo map;
+    gchar key[SENDER_KEY_SIZE];
+    guint32 sequence;
+    gboolean hasHeader;
+    gint64 due;
+    gsize size;
+    
+    gst_hth_thread_setup ("hth-replay", receiver->threadCpus, receiver->threadPolicy, receiver->threadPriority);
+    
+    /** Waiting on the pool would not see the stop flag */
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    worker->lastExpiry = g_get_monotonic_time ();
+    
+    while (g_atomic_int_get (&receiver->running)) {
+        
+        expireSenders (worker);
+        
+        /** The pool is the backpressure, as fast as possible is as fast as the decoders */
+        if (buffer == NULL && gst_buffer_pool_acquire_buffer (worker->pool, &buffer, &params) != GST_FLOW_OK) {
+            buffer = NULL;
+            g_usleep (POOL_WAIT_US);
+            continue;
+        }
+        
+        gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+        if (!gst_hth_capture_reader_next (receiver->replay, &arrival, &sender, map.data, &size)) {
+            gst_buffer_unmap (buffer, &map);
+            break;
+        }
+        hasHeader = buildSenderKey (receiver, &sender, map.data, size, key, &sequence);
+        gst_buffer_unmap (buffer, &map);
+        
+        if (receiver->replayStart == 0) {
+            g_mutex_lock (&worker->lock);
+            receiver->replayStart = g_get_monotonic_time ();
+            g_mutex_unlock (&worker->lock);
+        }
+        
+        /** Short sleeps, so a stop is not held back by a long gap of the capture */
+        due = receiver->replayStart + (gint64) (arrival / GST_USECOND);
+        while (receiver->replayRealtime && g_atomic_int_get (&receiver->running) && g_get_monotonic_time () < due)
+            g_usleep (MIN (due - g_get_monotonic_time (), POLL_TIMEOUT_MS * 1000));
+        
+        dispatchDatagram (worker, key, buffer, size, hasHeader ? &sequence : NULL);
+        buffer = NULL;
+    }
+    
+    if (buffer != NULL)
+        gst_buffer_unref (buffer);
+    
+    if (!g_atomic_int_get (&receiver->running))
+        return NULL;
+    
+    /** End of the capture, the senders stay until the engine is stopped */
+    g_mutex_lock (&worker->lock);
+    receiver->replayEnd = g_get_monotonic_time ();
+    g_hash_table_iter_init (&iter, worker->senders);
+    while (g_hash_table_iter_next (&iter, NULL, &entry))
+        receiver->callbacks.senderEnd (((HthReceiverSender*) entry)->data, receiver->userData);
+    g_mutex_unlock (&worker->lock);
+    
+    printf (GREEN "Replay finished \n" RESET);
+    
+    return NULL;
+}
+
+//==============================================================================
+
+static void pinThread (guint index){
+    
+    cpu_set_t allowed;
+    cpu_set_t cpus;
+    guint count;
+    guint cpu;
+    
+    /** Only the CPUs of the affinity the process got from taskset or its cpuset */
+    if (sched_getaffinity (0, sizeof (allowed), &allowed) != 0 || CPU_COUNT (&allowed) == 0)
+        return;
+    
+    count = index % CPU_COUNT (&allowed);
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET (cpu, &allowed) && count-- == 0)
+            break;
+    }
+    
+    CPU_ZERO (&cpus);
+    CPU_SET (cpu, &cpus);
+    
+    /** Not fatal, the thread keeps the affinity of the process */
+    if (pthread_setaffinity_np (pthread_self (), sizeof (cpus), &cpus) != 0)
+        printf (RED "Receive thread %u could not be pinned to CPU %u \n" RESET, index, cpu);
+}
+
+//==============================================================================
+
+static void dispatchPacket (HthReceiverWorker *worker, const gchar *key, GstBuffer *buffer, const guint32 *sequence){
+    
+    GstHthReceiver *receiver = worker->receiver;
+    HthReceiverSender *entry;
+    gpointer data;
+    
+    g_mutex_lock (&worker->lock);
+    worker->packets++;
+    worker->bytes += gst_buffer_get_size (buffer);
+    entry = g_hash_table_lookup (worker->senders, key);
+    g_mutex_unlock (&worker->lock);
+    
+    /** Only this thread adds senders to its table, the key can't be added meanwhile */
+    if (entry == NULL) {
+        data = receiver->callbacks.senderNew (key, worker->index, receiver->userData);
+        if (data == NULL) {
+            gst_buffer_unref (buffer);
+            return;
+        }
+        entry = g_new0 (HthReceiverSender, 1);
+        entry->data = data;
+        entry->refCount = 1;
+        
+        g_mutex_lock (&worker->lock);
+        g_hash_table_insert (worker->senders, g_strdup (key), entry);
+        g_mutex_unlock (&worker->lock);
+    }
+    
+    g_mutex_lock (&worker->lock);
+    entry = g_hash_table_lookup (worker->senders, key);
+    if (entry != NULL) {
+        entry->lastSeen = g_get_monotonic_time ();
+        if (sequence != NULL)
+            gst_hth_sequence_update (&entry->sequence, *sequence);
+        g_atomic_int_inc (&entry->refCount);
+    }
+    g_mutex_unlock (&worker->lock);
+    
+    /** Forgotten by gst_hth_receiver_forget_sender() in between */
+    if (entry == NULL) {
+        gst_buffer_unref (buffer);
+        return;
+    }
+    
+    /** The push blocks while the demuxer and the decoders work, the lock is free for the stats and the other senders */
+    receiver->callbacks.senderPacket (entry->data, buffer, receiver->userData);
+    releaseSender (receiver, entry);
+}
+
+//==============================================================================
+
+static void releaseSender (GstHthReceiver *receiver, HthReceiverSender *entry){
+    
+    if (!g_atomic_int_dec_and_test (&entry->refCount))
+        return;
+    
+    receiver->callbacks.senderRemoved (entry->data, receiver->userData);
+    g_free (entry);
+}
+
+//==============================================================================
+
+static void removeAllSenders (HthReceiverWorker *worker){
+    
+    GstHthReceiver *receiver = worker->receiver;
+    GHashTableIter iter;
+    gpointer entry;
+    GList *removed = NULL;
+    GList *item;
+    
+    g_mutex_lock (&worker->lock);
+    g_hash_table_iter_init (&iter, worker->senders);
+    while (g_hash_table_iter_next (&iter, NULL, &entry)) {
+        removed = g_list_prepend (removed, entry);
+        g_hash_table_iter_remove (&iter);
+    }
+    g_mutex_unlock (&worker->lock);
+    
+    for (item = removed; item != NULL; item = item->next)
+        releaseSender (receiver, (HthReceiverSender*) item->data);
+    
+    g_list_free (removed);
+}
+
+//==============================================================================
+
+static void expireSenders (HthReceiverWorker *worker){
+    
+    GstHthReceiver *receiver = worker->receiver;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer entry;
+    GList *expired = NULL;
+    GList *item;
+    gint64 now = g_get_monotonic_time ();
+    
+    if (receiver->senderTimeout == 0 || now - worker->lastExpiry < POLL_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND)
+        return;
+    worker->lastExpiry = now;
+    
+    g_mutex_lock (&worker->lock);
+    g_hash_table_iter_init (&iter, worker->senders);
+    while (g_hash_table_iter_next (&iter, &key, &entry)) {
+        if (now - ((HthReceiverSender*) entry)->lastSeen < receiver->senderTimeout)
+            continue;
+        printf (YELLOW "Sender %s timed out \n" RESET, (const gchar*) key);
+        expired = g_list_prepend (expired, entry);
+        g_hash_table_iter_remove (&iter);
+        worker->expired++;
+    }
+    g_mutex_unlock (&worker->lock);
+    
+    /** Outside the lock, the owner removes its chain asynchronously */
+    for (item = expired; item != NULL; item = item->next)
+        releaseSender (receiver, (HthReceiverSender*) item->data);
+    
+    g_list_free (expired);
+}
+
+//==============================================================================
+
+static gboolean buildSenderKey (GstHthReceiver *receiver, const struct sockaddr_in *address, const guint8 *data, gsize size,
+                                gchar *key, guint32 *sequence){
+    
+    gchar host[INET_ADDRSTRLEN];
+    guint32 streamId;
+    
+    if (receiver->streamIds && gst_hth_stream_id_parse (data, size, &streamId, sequence)) {
+        g_snprintf (key, SENDER_KEY_SIZE, "stream%u", streamId);
+        return TRUE;
+    }
+    
+    inet_ntop (AF_INET, &address->sin_addr, host, sizeof (host));
+    g_snprintf (key, SENDER_KEY_SIZE, "%s:%u", host, ntohs (address->sin_port));
+    
+    return FALSE;
+}
+
+//==============================================================================
+
+static void dispatchDatagram (HthReceiverWorker *worker, const gchar *key, GstBuffer *buffer, gsize size, const guint32 *sequence){
+    
+    /** The header is not part of the Matroska stream */
+    if (sequence != NULL)
+        gst_buffer_resize (buffer, HTH_STREAM_ID_HEADER_SIZE, size - HTH_STREAM_ID_HEADER_SIZE);
+    else
+        gst_buffer_resize (buffer, 0, size);
+    
+    dispatchPacket (worker, key, buffer, sequence);
+}
@@ -0,0 +1,221 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHRECEIVER_H__
+#define __GST_HTHRECEIVER_H__
+
+#include <gst/gst.h>
+
+#include "gsththcapture.h"
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Largest datagram received, bigger ones are truncated
+ */
+#define HTH_RECEIVER_MAX_DATAGRAM 65536
+
+/**
+ * @brief Maximum number of receive threads
+ */
+#define HTH_RECEIVER_MAX_WORKERS 64
+
+/**
+ * @struct GstHthReceiverCallbacks
+ * @brief Functions called by the receive threads
+ *
+ * senderNew and senderPacket run in the receive thread that owns the
+ * sender, without any lock of the engine held. A sender is always served by
+ * the same thread, the kernel hashes the address and port of the sender
+ * to one of the SO_REUSEPORT sockets. senderRemoved is only called once no
+ * senderPacket of the sender is running.
+ */
+typedef struct {
+    
+    /** A datagram from a new sender arrived, returns the sender data or NULL to drop it */
+    gpointer (*senderNew) (const gchar *key, guint worker, gpointer userData);
+    
+    /** A datagram of a known sender, the ownership of the buffer is taken */
+    GstFlowReturn (*senderPacket) (gpointer sender, GstBuffer *buffer, gpointer userData);
+    
+    /** The sender is forgotten, no more packets are passed for it */
+    void (*senderRemoved) (gpointer sender, gpointer userData);
+    
+    /** The replay reached the end of the capture, no more packets follow for the sender */
+    void (*senderEnd) (gpointer sender, gpointer userData);
+    
+} GstHthReceiverCallbacks;
+
+/**
+ * @struct GstHthReceiver
+ * @brief Receive engine with one SO_REUSEPORT socket and one thread per worker
+ *
+ * Each thread reads batches of datagrams with recvmmsg() straight into the
+ * buffers of its own GstBufferPool.
+ */
+typedef struct _GstHthReceiver GstHthReceiver;
+
+/**
+ * @brief Create a receive engine, nothing is opened until it is started
+ * @param callbacks Functions called for the senders
+ * @param userData Passed to the callbacks
+ * @return GstHthReceiver* The engine
+ */
+GstHthReceiver *gst_hth_receiver_new (const GstHthReceiverCallbacks *callbacks, gpointer userData);
+
+/**
+ * @brief Forget the senders that sent nothing for a while
+ * Set before gst_hth_receiver_start(). senderRemoved is called from the
+ * receive thread of the sender.
+ * @param receiver The engine, stopped
+ * @param timeout Idle time, GST_CLOCK_TIME_NONE or 0 to keep the senders until stop
+ */
+void gst_hth_receiver_set_sender_timeout (GstHthReceiver *receiver, GstClockTime timeout);
+
+/**
+ * @brief Identify the senders by the stream id header of their datagrams
+ * Set before gst_hth_receiver_start(). The key becomes "stream<id>" and the
+ * header is stripped, datagrams without a header keep the address key.
+ * @param receiver The engine, stopped
+ * @param streamIds TRUE to read the header
+ */
+void gst_hth_receiver_set_stream_ids (GstHthReceiver *receiver, gboolean streamIds);
+
+/**
+ * @brief CPU set and scheduling of the receive threads
+ * Set before gst_hth_receiver_start(), see gst_hth_thread_setup().
+ * @param receiver The engine, stopped
+ * @param cpus CPU list shared by all the threads, NULL to pin thread N to the Nth CPU the process may run on
+ * @param policy other, fifo or rr
+ * @param priority Real-time priority
+ */
+void gst_hth_receiver_set_threads (GstHthReceiver *receiver, const gchar *cpus, const gchar *policy, gint priority);
+
+/**
+ * @brief Bound the buffer pools of the receive threads
+ * Set before gst_hth_receiver_start(). The bytes are split between the
+ * threads, each keeps at least one batch. A thread whose pool is empty
+ * stops reading and lets the kernel drop the datagrams.
+ * @param receiver The engine, stopped
+ * @param bytes Bytes of all the pools, 0 for the default size and no limit
+ */
+void gst_hth_receiver_set_pool_memory (GstHthReceiver *receiver, guint64 bytes);
+
+/**
+ * @brief Bytes the buffer pools of the running threads may allocate
+ * @param receiver The engine
+ * @return guint64 Bytes, 0 when stopped
+ */
+guint64 gst_hth_receiver_get_pool_memory (GstHthReceiver *receiver);
+
+/**
+ * @brief Record every datagram received
+ * Set before gst_hth_receiver_start(). The datagrams are written before the
+ * stream id header is stripped.
+ * @param receiver The engine, stopped
+ * @param capture The capture, NULL for none, owned by the caller until the engine is stopped
+ */
+void gst_hth_receiver_set_capture (GstHthReceiver *receiver, GstHthCapture *capture);
+
+/**
+ * @brief Open the sockets and start the receive threads
+ * @param receiver The engine, stopped
+ * @param port UDP port
+ * @param workers Number of sockets and receive threads
+ * @return gboolean FALSE if one socket could not be opened or bound
+ */
+gboolean gst_hth_receiver_start (GstHthReceiver *receiver, guint port, guint workers);
+
+/**
+ * @brief Feed the datagrams of a capture instead of the sockets
+ *
+ * One thread reads the capture and passes the datagrams through the same
+ * sender keys, stream id header handling and callbacks as the sockets.
+ * With realtime the datagrams keep their original spacing, otherwise they
+ * go as fast as the senders take them. senderEnd is called for every
+ * sender at the end of the capture.
+ *
+ * @param receiver The engine, stopped
+ * @param path Capture written with gst_hth_receiver_set_capture()
+ * @param realtime Keep the original arrival times
+ * @return gboolean FALSE if the capture could not be opened
+ */
+gboolean gst_hth_receiver_start_replay (GstHthReceiver *receiver, const gchar *path, gboolean realtime);
+
+/**
+ * @brief Stop the receive threads, close the sockets and forget all the senders
+ * @param receiver The engine
+ */
+void gst_hth_receiver_stop (GstHthReceiver *receiver);
+
+/**
+ * @brief Forget one sender, its next datagram creates it again
+ * The sender is removed once the datagram being passed to it, if any, is done.
+ * @param receiver The engine
+ * @param key Sender key passed to senderNew
+ */
+void gst_hth_receiver_forget_sender (GstHthReceiver *receiver, const gchar *key);
+
+/**
+ * @brief Add the receive counters to a stats structure
+ * Adds receive-packets, receive-bytes, senders, worker<N>-packets,
+ * receive-syscalls, packets-per-syscall, pool-exhaustion, senders-expired,
+ * receive-pool-memory, and receive-lost and receive-reordered of the current
+ * senders with a stream id header. While replaying, replay-elapsed (ns
+ * since the first datagram) and replay-done are added too.
+ * @param receiver The engine
+ * @param stats Structure to fill
+ */
+void gst_hth_receiver_append_stats (GstHthReceiver *receiver, GstStructure *stats);
+
+/**
+ * @brief Stop and free the engine
+ * @param receiver The engine
+ */
+void gst_hth_receiver_free (GstHthReceiver *receiver);
+
+G_END_DECLS
+
+#endif /* __GST_HTHRECEIVER_H__ */
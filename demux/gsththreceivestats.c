@@ -0,0 +1,489 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** receive stats header */
+#include "gsththreceivestats.h" /**< For the receive stats declarations */
+
+/** stream id header */
+#include "gsththstreamid.h" /**< For the sequence number of the datagrams */
+
+/** latency tracer header */
+#include "gsththlatency.h" /**< For the decode time histograms */
+
+#define JITTER_GAIN 16 /**< Smoothing of the arrival jitter, as in RFC 3550 */
+
+//==============================================================================
+
+/**
+ * @brief Name of each branch, prefix of its stats fields
+ */
+static const gchar *branchNames[GST_HTH_RECEIVE_BRANCHES] = { "video", "audio", "text" };
+
+struct _GstHthReceiveStats {
+    
+    GstElement *owner; /**< Element posting the messages */
+    GMutex lock; /**< Protects the counters */
+    GstClockTime interval; /**< Period of the messages, 0 for none */
+    GstClockTime lastPost; /**< Monotonic time of the previous message */
+    
+    gboolean streamIds; /**< The datagrams start with the stream id header */
+    guint64 datagrams; /**< Datagrams received */
+    guint64 bytes; /**< Bytes received, stream id headers included */
+    GstHthSequence sequence; /**< Loss and reordering, with the stream id header */
+    GstClockTime lastArrival; /**< Monotonic time of the previous datagram */
+    GstClockTime lastGap; /**< Time between the two previous datagrams */
+    GstClockTime jitter; /**< Smoothed variation of the time between datagrams */
+    
+    guint64 demuxErrors; /**< Errors and warnings of the demuxer */
+    guint64 demuxResyncs; /**< Discontinuities after the first buffer of a demuxer pad */
+    
+    GstHthLatency *decodeLatency; /**< Residency of the buffers in the decoders */
+    guint64 decodedFrames; /**< Frames leaving the video decoder */
+    GstClockTime rateTime; /**< Monotonic time of the previous stats, for decoded-fps */
+    guint64 rateFrames; /**< Decoded frames at the previous stats */
+    
+    GWeakRef queues[GST_HTH_RECEIVE_BRANCHES]; /**< Queue of each branch, gone with a rebuild */
+    GstClockTime outputTime[GST_HTH_RECEIVE_BRANCHES]; /**< Running time of the last buffer out */
+    GstClockTime outputArrival[GST_HTH_RECEIVE_BRANCHES]; /**< Monotonic time of the last buffer out */
+};
+
+/**
+ * @struct HthDemuxPad
+ * @brief Probe data of one demuxer pad
+ */
+typedef struct {
+    GstHthReceiveStats *stats; /**< The counters */
+    gboolean started; /**< A buffer already went through */
+} HthDemuxPad;
+
+/**
+ * @struct HthOutputPad
+ * @brief Probe data of one output pad
+ */
+typedef struct {
+    GstHthReceiveStats *stats; /**< The counters */
+    GstHthReceiveBranch branch; /**< Branch of the pad */
+} HthOutputPad;
+
+//==============================================================================
+
+/**
+ * @brief Count a datagram and strip its stream id header
+ *
+ * @param pad Src pad of the transport
+ * @param info Probe info with the datagram
+ * @param user_data The GstHthReceiveStats
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_transportProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count the discontinuities leaving the demuxer
+ *
+ * @param pad Pad linked to the demuxer
+ * @param info Probe info with the buffer
+ * @param user_data The HthDemuxPad
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_demuxProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count a decoded video frame
+ *
+ * @param pad Src pad of the video decoder
+ * @param info Probe info with the frame
+ * @param user_data The GstHthReceiveStats
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_decodedProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Keep the running time leaving a branch and post the periodic message
+ *
+ * @param pad Src pad of the element
+ * @param info Probe info with the buffer
+ * @param user_data The HthOutputPad
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_outputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Add the fill of the queue of each branch to a structure
+ *
+ * @param stats The counters
+ * @param structure Structure to fill
+ */
+static void appendQueues (GstHthReceiveStats *stats, GstStructure *structure);
+
+//==============================================================================
+
+GstHthReceiveStats *gst_hth_receive_stats_new (GstElement *owner){
+    
+    GstHthReceiveStats *stats = g_new0 (GstHthReceiveStats, 1);
+    guint i;
+    
+    stats->owner = owner;
+    g_mutex_init (&stats->lock);
+    stats->lastPost = GST_CLOCK_TIME_NONE;
+    stats->lastArrival = GST_CLOCK_TIME_NONE;
+    stats->lastGap = GST_CLOCK_TIME_NONE;
+    stats->rateTime = GST_CLOCK_TIME_NONE;
+    
+    for (i = 0; i < GST_HTH_RECEIVE_BRANCHES; i++) {
+        g_weak_ref_init (&stats->queues[i], NULL);
+        stats->outputTime[i] = GST_CLOCK_TIME_NONE;
+        stats->outputArrival[i] = GST_CLOCK_TIME_NONE;
+    }
+    
+    /** Never posts, the decode time goes out with the other counters */
+    stats->decodeLatency = gst_hth_latency_new (NULL);
+    
+    return stats;
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_free (GstHthReceiveStats *stats){
+    
+    guint i;
+    
+    for (i = 0; i < GST_HTH_RECEIVE_BRANCHES; i++)
+        g_weak_ref_clear (&stats->queues[i]);
+    
+    gst_hth_latency_free (stats->decodeLatency);
+    g_mutex_clear (&stats->lock);
+    g_free (stats);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_set_interval (GstHthReceiveStats *stats, GstClockTime interval){
+    
+    g_mutex_lock (&stats->lock);
+    stats->interval = interval;
+    g_mutex_unlock (&stats->lock);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_set_stream_ids (GstHthReceiveStats *stats, gboolean streamIds){
+    
+    g_mutex_lock (&stats->lock);
+    stats->streamIds = streamIds;
+    g_mutex_unlock (&stats->lock);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_watch_transport (GstHthReceiveStats *stats, GstPad *pad){
+    
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_transportProbe, stats, NULL);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_watch_demux_pad (GstHthReceiveStats *stats, GstPad *pad){
+    
+    HthDemuxPad *demuxPad = g_new0 (HthDemuxPad, 1);
+    
+    demuxPad->stats = stats;
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_demuxProbe, demuxPad, g_free);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_watch_branch (GstHthReceiveStats *stats, GstHthReceiveBranch branch, GstElement *queue,
+                                         GstElement *decoder){
+    
+    GstPad *sinkPad;
+    GstPad *srcPad;
+    gchar *name;
+    
+    g_weak_ref_set (&stats->queues[branch], queue);
+    
+    if (decoder == NULL)
+        return;
+    
+    sinkPad = gst_element_get_static_pad (decoder, "sink");
+    srcPad = gst_element_get_static_pad (decoder, "src");
+    
+    /** Same stage name, the probes of the previous decoder are removed */
+    name = g_strdup_printf ("%s-decode", branchNames[branch]);
+    gst_hth_latency_add_stage (stats->decodeLatency, name, sinkPad, srcPad, FALSE);
+    g_free (name);
+    
+    if (branch == GST_HTH_RECEIVE_VIDEO)
+        gst_pad_add_probe (srcPad, GST_PAD_PROBE_TYPE_BUFFER, cb_decodedProbe, stats, NULL);
+    
+    gst_object_unref (sinkPad);
+    gst_object_unref (srcPad);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_watch_output (GstHthReceiveStats *stats, GstHthReceiveBranch branch, GstPad *pad){
+    
+    HthOutputPad *outputPad = g_new0 (HthOutputPad, 1);
+    
+    outputPad->stats = stats;
+    outputPad->branch = branch;
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_outputProbe, outputPad, g_free);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_count_demux_error (GstHthReceiveStats *stats){
+    
+    g_mutex_lock (&stats->lock);
+    stats->demuxErrors++;
+    g_mutex_unlock (&stats->lock);
+}
+
+//==============================================================================
+
+void gst_hth_receive_stats_append (GstHthReceiveStats *stats, GstStructure *structure){
+    
+    GstClockTime now = gst_util_get_timestamp ();
+    gdouble fps = 0.0;
+    gint64 avOffset = 0;
+    
+    g_mutex_lock (&stats->lock);
+    
+    if (GST_CLOCK_TIME_IS_VALID (stats->rateTime) && now > stats->rateTime)
+        fps = (gdouble) (stats->decodedFrames - stats->rateFrames) * GST_SECOND / (now - stats->rateTime);
+    stats->rateTime = now;
+    stats->rateFrames = stats->decodedFrames;
+    
+    /** Both positions brought to the same wall clock instant */
+    if (GST_CLOCK_TIME_IS_VALID (stats->outputTime[GST_HTH_RECEIVE_VIDEO])
+        && GST_CLOCK_TIME_IS_VALID (stats->outputTime[GST_HTH_RECEIVE_AUDIO]))
+        avOffset = GST_CLOCK_DIFF (stats->outputTime[GST_HTH_RECEIVE_AUDIO], stats->outputTime[GST_HTH_RECEIVE_VIDEO])
+            - GST_CLOCK_DIFF (stats->outputArrival[GST_HTH_RECEIVE_AUDIO], stats->outputArrival[GST_HTH_RECEIVE_VIDEO]);
+    
+    gst_structure_set (structure,
+                       "datagrams-received", G_TYPE_UINT64, stats->datagrams,
+                       "bytes-received", G_TYPE_UINT64, stats->bytes,
+                       "datagrams-lost", G_TYPE_UINT64, gst_hth_sequence_get_lost (&stats->sequence),
+                       "datagrams-reordered", G_TYPE_UINT64, stats->sequence.reordered,
+                       "arrival-jitter", G_TYPE_UINT64, stats->jitter,
+                       "demux-errors", G_TYPE_UINT64, stats->demuxErrors,
+                       "demux-resyncs", G_TYPE_UINT64, stats->demuxResyncs,
+                       "decoded-frames", G_TYPE_UINT64, stats->decodedFrames,
+                       "decoded-fps", G_TYPE_DOUBLE, fps,
+                       "av-offset", G_TYPE_INT64, avOffset,
+                       NULL);
+    
+    g_mutex_unlock (&stats->lock);
+    
+    gst_hth_latency_append_stats (stats->decodeLatency, structure);
+    appendQueues (stats, structure);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_transportProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthReceiveStats *stats = (GstHthReceiveStats*) user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime now = gst_util_get_timestamp ();
+    GstClockTime gap;
+    GstMapInfo map;
+    gboolean hasHeader = FALSE;
+    guint32 streamId;
+    guint32 number;
+    
+    g_mutex_lock (&stats->lock);
+    
+    if (stats->streamIds) {
+        gst_buffer_map (buffer, &map, GST_MAP_READ);
+        hasHeader = gst_hth_stream_id_parse (map.data, map.size, &streamId, &number);
+        gst_buffer_unmap (buffer, &map);
+    }
+    
+    stats->datagrams++;
+    stats->bytes += gst_buffer_get_size (buffer);
+    if (hasHeader)
+        gst_hth_sequence_update (&stats->sequence, number);
+    
+    if (GST_CLOCK_TIME_IS_VALID (stats->lastArrival)) {
+        gap = now - stats->lastArrival;
+        if (GST_CLOCK_TIME_IS_VALID (stats->lastGap))
+            stats->jitter += (ABS (GST_CLOCK_DIFF (stats->lastGap, gap)) - (gint64) stats->jitter) / JITTER_GAIN;
+        stats->lastGap = gap;
+    }
+    stats->lastArrival = now;
+    
+    g_mutex_unlock (&stats->lock);
+    
+    /** The header is not part of the Matroska stream */
+    if (hasHeader) {
+        buffer = gst_buffer_make_writable (buffer);
+        gst_buffer_resize (buffer, HTH_STREAM_ID_HEADER_SIZE, -1);
+        GST_PAD_PROBE_INFO_DATA (info) = buffer;
+    }
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_demuxProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthDemuxPad *demuxPad = (HthDemuxPad*) user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    
+    /** The first buffer of a stream is always a discontinuity */
+    if (demuxPad->started && GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT)) {
+        g_mutex_lock (&demuxPad->stats->lock);
+        demuxPad->stats->demuxResyncs++;
+        g_mutex_unlock (&demuxPad->stats->lock);
+    }
+    
+    demuxPad->started = TRUE;
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_decodedProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthReceiveStats *stats = (GstHthReceiveStats*) user_data;
+    
+    g_mutex_lock (&stats->lock);
+    stats->decodedFrames++;
+    g_mutex_unlock (&stats->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_outputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    HthOutputPad *outputPad = (HthOutputPad*) user_data;
+    GstHthReceiveStats *stats = outputPad->stats;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime now = gst_util_get_timestamp ();
+    GstClockTime runningTime = GST_CLOCK_TIME_NONE;
+    GstStructure *message;
+    GstEvent *segmentEvent;
+    const GstSegment *segment;
+    gboolean post = FALSE;
+    
+    segmentEvent = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+    if (segmentEvent != NULL && GST_BUFFER_PTS_IS_VALID (buffer)) {
+        gst_event_parse_segment (segmentEvent, &segment);
+        runningTime = gst_segment_to_running_time (segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+    }
+    if (segmentEvent != NULL)
+        gst_event_unref (segmentEvent);
+    
+    g_mutex_lock (&stats->lock);
+    
+    if (GST_CLOCK_TIME_IS_VALID (runningTime)) {
+        stats->outputTime[outputPad->branch] = runningTime;
+        stats->outputArrival[outputPad->branch] = now;
+    }
+    
+    if (!GST_CLOCK_TIME_IS_VALID (stats->lastPost))
+        stats->lastPost = now;
+    
+    if (stats->interval > 0 && now - stats->lastPost >= stats->interval) {
+        stats->lastPost = now;
+        post = TRUE;
+    }
+    
+    g_mutex_unlock (&stats->lock);
+    
+    if (post) {
+        message = gst_structure_new_empty (HTH_RECEIVE_STATS_MESSAGE);
+        gst_hth_receive_stats_append (stats, message);
+        gst_element_post_message (stats->owner, gst_message_new_element (GST_OBJECT (stats->owner), message));
+    }
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static void appendQueues (GstHthReceiveStats *stats, GstStructure *structure){
+    
+    GstElement *queue;
+    guint levelBuffers, levelBytes;
+    guint64 levelTime;
+    gchar *field;
+    guint i;
+    
+    for (i = 0; i < GST_HTH_RECEIVE_BRANCHES; i++) {
+        
+        levelBuffers = 0;
+        levelBytes = 0;
+        levelTime = 0;
+        
+        queue = g_weak_ref_get (&stats->queues[i]);
+        if (queue != NULL) {
+            g_object_get (queue, "current-level-buffers", &levelBuffers, "current-level-bytes", &levelBytes,
+                          "current-level-time", &levelTime, NULL);
+            gst_object_unref (queue);
+        }
+        
+        field = g_strdup_printf ("%s-queue-buffers", branchNames[i]);
+        gst_structure_set (structure, field, G_TYPE_UINT, levelBuffers, NULL);
+        g_free (field);
+        field = g_strdup_printf ("%s-queue-bytes", branchNames[i]);
+        gst_structure_set (structure, field, G_TYPE_UINT, levelBytes, NULL);
+        g_free (field);
+        field = g_strdup_printf ("%s-queue-time", branchNames[i]);
+        gst_structure_set (structure, field, G_TYPE_UINT64, levelTime, NULL);
+        g_free (field);
+    }
+}
@@ -0,0 +1,173 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHRECEIVESTATS_H__
+#define __GST_HTHRECEIVESTATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Name of the periodic element message
+ */
+#define HTH_RECEIVE_STATS_MESSAGE "hth-receiver-stats"
+
+/**
+ * @enum GstHthReceiveBranch
+ * @brief Branches of the receiver, same order as the branches of hthstreamsrc
+ */
+typedef enum {
+    GST_HTH_RECEIVE_VIDEO,
+    GST_HTH_RECEIVE_AUDIO,
+    GST_HTH_RECEIVE_TEXT,
+    GST_HTH_RECEIVE_BRANCHES
+} GstHthReceiveBranch;
+
+/**
+ * @struct GstHthReceiveStats
+ * @brief Counters of the transport, the demuxer, the decoders and the output
+ *
+ * Everything is measured with pad probes, the queues are only read when
+ * the stats are built.
+ */
+typedef struct _GstHthReceiveStats GstHthReceiveStats;
+
+/**
+ * @brief Create the counters
+ * @param owner Element posting the periodic messages, not referenced
+ * @return GstHthReceiveStats* The counters, all at 0
+ */
+GstHthReceiveStats *gst_hth_receive_stats_new (GstElement *owner);
+
+/**
+ * @brief Free the counters
+ * @param stats The counters
+ */
+void gst_hth_receive_stats_free (GstHthReceiveStats *stats);
+
+/**
+ * @brief Period of the HTH_RECEIVE_STATS_MESSAGE element messages
+ *
+ * Posted from the streaming thread of the first buffer leaving the element
+ * after the period.
+ *
+ * @param stats The counters
+ * @param interval Period, 0 posts nothing
+ */
+void gst_hth_receive_stats_set_interval (GstHthReceiveStats *stats, GstClockTime interval);
+
+/**
+ * @brief Expect the stream id header on the datagrams of the transport
+ *
+ * @param stats The counters
+ * @param streamIds TRUE when the senders prefix their datagrams with the header
+ */
+void gst_hth_receive_stats_set_stream_ids (GstHthReceiveStats *stats, gboolean streamIds);
+
+/**
+ * @brief Count the datagrams of the transport
+ *
+ * With gst_hth_receive_stats_set_stream_ids() the stream id header is
+ * stripped and its sequence number gives the loss and the reordering.
+ *
+ * @param stats The counters
+ * @param pad Src pad of the transport
+ */
+void gst_hth_receive_stats_watch_transport (GstHthReceiveStats *stats, GstPad *pad);
+
+/**
+ * @brief Count the resyncs of the demuxer, the discontinuities after the first buffer
+ *
+ * @param stats The counters
+ * @param pad Pad linked to a demuxer src pad
+ */
+void gst_hth_receive_stats_watch_demux_pad (GstHthReceiveStats *stats, GstPad *pad);
+
+/**
+ * @brief Measure the queue and the decoder of a branch, again after each rebuild
+ *
+ * @param stats The counters
+ * @param branch The branch
+ * @param queue The queue, its fill is read with the stats
+ * @param decoder The decoder, NULL for the text branch
+ */
+void gst_hth_receive_stats_watch_branch (GstHthReceiveStats *stats, GstHthReceiveBranch branch, GstElement *queue,
+                                         GstElement *decoder);
+
+/**
+ * @brief Follow the running time leaving a branch, for the A/V offset
+ *
+ * @param stats The counters
+ * @param branch The branch
+ * @param pad Src pad of the element for the branch
+ */
+void gst_hth_receive_stats_watch_output (GstHthReceiveStats *stats, GstHthReceiveBranch branch, GstPad *pad);
+
+/**
+ * @brief Count an error or a warning of the demuxer
+ *
+ * @param stats The counters
+ */
+void gst_hth_receive_stats_count_demux_error (GstHthReceiveStats *stats);
+
+/**
+ * @brief Add the receiver counters to a stats structure
+ *
+ * Adds datagrams-received, bytes-received, datagrams-lost,
+ * datagrams-reordered, arrival-jitter (ns), demux-errors, demux-resyncs,
+ * video-decode-latency-p50/p95/p99, audio-decode-latency-p50/p95/p99,
+ * decoded-frames, decoded-fps (since the previous call),
+ * <branch>-queue-buffers, <branch>-queue-bytes, <branch>-queue-time and
+ * av-offset (ns, video ahead of audio when positive).
+ *
+ * @param stats The counters
+ * @param structure Structure to fill
+ */
+void gst_hth_receive_stats_append (GstHthReceiveStats *stats, GstStructure *structure);
+
+G_END_DECLS
+
+#endif /* __GST_HTHRECEIVESTATS_H__ */
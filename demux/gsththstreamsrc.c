@@ -71,13 +71,40 @@
 #include <gst/gst.h> /**< For all gstreamer functions */
 
 /** stdlib header file */
-#include <stdlib.h> /**<  */
+#include <stdlib.h> /**< For malloc() */
 
 /** stdio header file */
 #include <stdio.h> /**< For printf() */
 
 /** string header file */
-#include <string.h> /**< For strncmp() */
+#include <string.h> /**< For strncmp() and strcmp() */
+
+/** hth meta header */
+#include "gsththmeta.h" /**< For the per-frame telemetry meta */
+
+/** hth branch header */
+#include "gsththbranch.h" /**< For the branch rebuild bookkeeping */
+
+/** task pool header */
+#include "gsththtaskpool.h" /**< For the shared streaming thread pool */
+
+/** thread header */
+#include "gsthththread.h" /**< For the affinity, scheduling and jitter of the streaming threads */
+
+/** memory budget */
+#include "gsththmemory.h" /**< For the max-memory accounting of the queues and pools */
+
+/** latency tracer */
+#include "gsththlatency.h" /**< For the residency histograms of the stages */
+
+/** receiver stats */
+#include "gsththreceivestats.h" /**< For the transport, demuxer, decoder and output counters */
+
+/** impairment */
+#include "gsththimpairment.h" /**< For the hthimpair element between udpsrc and the demuxer */
+
+/** time overlay */
+#include "gsththoverlay.h" /**< For the capture time drawn on the decoded frames */
 
 /**
  * @brief Colors for printed messages
@@ -114,15 +141,20 @@ GST_DEBUG_CATEGORY_STATIC (gst_hthstreamsrc_debug);
 //==============================================================================
 
 /**
- * Exit error flags
+ * Branches
+ *
+ * A failure of an element of one branch rebuilds only that branch,
+ * udpsrc and the demuxer are shared by all of them.
  */
+typedef enum {
+    BRANCH_NONE = -1,
+    BRANCH_VIDEO,
+    BRANCH_AUDIO,
+    BRANCH_TEXT,
+    BRANCH_COUNT
+} HthStreamBranch;
 
-#define EXIT_ELEMENT_CREATION_FAILURE  -1 /**< Creation elements failure flag */
-#define EXIT_ELEMENT_LINKING_FAILURE   -2 /**< Linking elements failure flag */
-#define EXIT_PADS_LINKING_FAILURE      -3 /**< Pads elements failure flag */
-#define EXIT_GHOSTPAD_CREATION_FAILURE -4 /**< Ghost pads elements failure flag */
-#define EXIT_GET_PAD_FAILURE           -5 /**< Get static pad failure flag */
-#define EXIT_SET_GHOSTH_PAD_FAILURE    -6 /**< Set ghosth pad failure flag */
+#define MAX_BRANCH_ELEMENTS 4 /**< Elements of the longest branch (audio) */
 
 //==============================================================================
 
@@ -131,12 +163,119 @@ GST_DEBUG_CATEGORY_STATIC (gst_hthstreamsrc_debug);
  */
 
 #define DEFAULT_PORT                5000 /** Udp src plugin default port */
+#define DEFAULT_FRAME_TELEMETRY     FALSE /** Serial text is output on the text src pad */
+#define DEFAULT_RECEIVE_THREADS     0 /** One udpsrc and one sender */
+#define DEFAULT_SENDER_TIMEOUT      5000 /** Milliseconds without datagrams before the pads of a sender are removed */
+#define DEFAULT_STREAM_ID_HEADER    FALSE /** Senders identified by their address and port */
+#define DEFAULT_SHARED_TASK_POOL    FALSE /** Every streaming task gets its own thread */
+#define DEFAULT_CPUS                NULL /** Threads not pinned */
+#define DEFAULT_RT_POLICY           "other" /** Time sharing scheduling */
+#define DEFAULT_RT_PRIORITY         10 /** Real-time priority with fifo or rr */
+#define DEFAULT_MAX_MEMORY          0 /** Queues and receive pools limited only by their own sizes */
+#define RECEIVE_POOL_MEMORY_SHARE   25 /** Percent of max-memory preallocated by the receive pools */
+#define DEFAULT_LATENCY_TRACING     FALSE /** No probe measures the stages */
+#define DEFAULT_LATENCY_INTERVAL    1000 /** Milliseconds between two hth-latency messages */
+#define DEFAULT_RECEIVER_STATS_INTERVAL 1000 /** Milliseconds between two hth-receiver-stats messages */
+#define DEFAULT_CAPTURE_LOCATION    NULL /** Datagrams not recorded */
+#define DEFAULT_REPLAY_LOCATION     NULL /** Datagrams received from the network */
+#define DEFAULT_REPLAY_REALTIME     TRUE /** Captures replayed with their original timing */
+#define DEFAULT_IMPAIRMENT          NULL /** udpsrc output goes straight to the demuxer */
+#define DEFAULT_DRAW_CAPTURE_TIME   FALSE /** The capture time only goes out as a meta */
+#define MAX_TELEMETRY_RECORDS       64 /** Records waiting for their video frame */
 
 enum{
     PROP_0,
-    PROP_PORT
+    PROP_PORT,
+    PROP_FRAME_TELEMETRY,
+    PROP_RECEIVE_THREADS,
+    PROP_SENDER_TIMEOUT,
+    PROP_STREAM_ID_HEADER,
+    PROP_SHARED_TASK_POOL,
+    PROP_VIDEO_CPUS,
+    PROP_AUDIO_CPUS,
+    PROP_TEXT_CPUS,
+    PROP_TRANSPORT_CPUS,
+    PROP_RT_POLICY,
+    PROP_RT_PRIORITY,
+    PROP_MAX_MEMORY,
+    PROP_LATENCY_TRACING,
+    PROP_LATENCY_INTERVAL,
+    PROP_RECEIVER_STATS_INTERVAL,
+    PROP_CAPTURE_LOCATION,
+    PROP_REPLAY_LOCATION,
+    PROP_REPLAY_REALTIME,
+    PROP_IMPAIRMENT,
+    PROP_DRAW_CAPTURE_TIME,
+    PROP_STATS
+};
+
+/**
+ * @struct TelemetryRecord
+ *
+ * @brief Per-frame telemetry received at the end of an encoded video frame
+ *
+ */
+typedef struct {
+    GstClockTime pts; /**< PTS of the video frame the record belongs to */
+    gchar *text; /**< Telemetry sample */
+    GstClockTime sampleTime; /**< Running time of the sample at the sender */
+    GstClockTime captureTime; /**< Clock time of the frame at the sender, with time-overlay=meta */
+} TelemetryRecord;
+
+/**
+ * @struct SenderChain
+ *
+ * @brief Demuxer and decoders of one sender when receive-threads is set
+ *
+ */
+typedef struct {
+    Gsththstreamsrc *hthstreamsrc; /**< Element that owns the chain */
+    gchar *key; /**< Sender address:port */
+    gchar *padSuffix; /**< Key usable in a pad name */
+    GstElement *bin; /**< Bin with the demuxer and the branches of the sender */
+    GstElement *demux; /**< Demuxer of the sender */
+    GstPad *feedPad; /**< Pushes the datagrams of the sender into the demuxer */
+    GstPad *srcPads[BRANCH_COUNT]; /**< video_src_%s, audio_src_%s and text_src_%s pads of the element */
+    gboolean waitKeyframe; /**< A video frame was dropped at the full queue, the deltas are dropped too */
+} SenderChain;
+
+#define SENDER_BRANCH_KEY "hth-branch" /**< Data of the queue of a sender branch, the branch + 1 */
+
+/**
+ * Elements of the branches of a sender chain, in data flow order
+ */
+static const gchar *branchFactories[BRANCH_COUNT][MAX_BRANCH_ELEMENTS] = {
+    { "queue2", "theoradec", "videoconvert", NULL },
+    { "queue2", "vorbisdec", "audioconvert", "audioresample" },
+    { "queue2", "identity", NULL, NULL }
 };
 
+#define DECODER_POSITION 1 /**< The decoder follows the queue in the video and audio branches */
+
+/**
+ * Decoder of each codec hthstreamsink can send, matched on the caps of the demuxer pad
+ */
+typedef struct {
+    const gchar *mediaType;
+    const gchar *factory;
+} CodecDecoder;
+
+static const CodecDecoder codecDecoders[] = {
+    { "video/x-theora", "theoradec" },
+    { "video/x-vp8", "vp8dec" },
+    { "video/x-h264", "avdec_h264" },
+    { "audio/x-vorbis", "vorbisdec" },
+    { "audio/x-opus", "opusdec" },
+    { NULL, NULL }
+};
+
+/**
+ * Factories of the sender chains, looked up once so a new sender skips the registry
+ */
+static GstElementFactory *demuxFactory = NULL;
+static GstElementFactory *branchFactoryCache[BRANCH_COUNT][MAX_BRANCH_ELEMENTS];
+static GstElementFactory *decoderFactoryCache[G_N_ELEMENTS (codecDecoders)];
+
 //==============================================================================
 
 /**
@@ -153,6 +292,27 @@ static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
                                                                    GST_STATIC_CAPS_ANY
 );
 
+/**
+ * @brief Per sender src pads, created when the demuxer of a sender finds a track
+ */
+static GstStaticPadTemplate video_sender_factory = GST_STATIC_PAD_TEMPLATE ("video_src_%s",
+                                                                            GST_PAD_SRC,
+                                                                            GST_PAD_SOMETIMES,
+                                                                            GST_STATIC_CAPS_ANY
+);
+static GstStaticPadTemplate audio_sender_factory = GST_STATIC_PAD_TEMPLATE ("audio_src_%s",
+                                                                            GST_PAD_SRC,
+                                                                            GST_PAD_SOMETIMES,
+                                                                            GST_STATIC_CAPS_ANY
+);
+static GstStaticPadTemplate text_sender_factory = GST_STATIC_PAD_TEMPLATE ("text_src_%s",
+                                                                           GST_PAD_SRC,
+                                                                           GST_PAD_SOMETIMES,
+                                                                           GST_STATIC_CAPS_ANY
+);
+
+static const gchar *senderPadTemplates[BRANCH_COUNT] = { "video_src_%s", "audio_src_%s", "text_src_%s" };
+
 //==============================================================================
 
 #define gst_hthstreamsrc_parent_class parent_class
@@ -178,12 +338,30 @@ static GstStateChangeReturn gst_bin_change_state (GstElement * element, GstState
 static void createElements(Gsththstreamsrc *hthstreamsrc);
 
 /**
- * @brief verify if all elements were cretated
+ * @brief Create the elements of one branch
  *
  * @param hthstreamsrc The plugin instance
+ * @param branch The branch
  * @return void
  */
-static void verifyAllElementsCreated(Gsththstreamsrc *hthstreamsrc);
+static void createBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
+/**
+ * @brief verify if all elements were cretated
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return gboolean FALSE if one element is missing
+ */
+static gboolean verifyAllElementsCreated(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief verify if all the elements of one branch were created
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if one element is missing
+ */
+static gboolean verifyBranchElementsCreated(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
  * @brief Set some elements properties like udpsink host and port
@@ -201,6 +379,15 @@ static void setElementsPropsValues(Gsththstreamsrc *hthstreamsrc);
  */
 static void addElementsToBin(Gsththstreamsrc *hthstreamsrc);
 
+/**
+ * @brief Add the elements of one branch to the main bin
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void addBranchElementsToBin(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
 /**
  * @brief Link the internal plugins
  *
@@ -208,17 +395,26 @@ static void addElementsToBin(Gsththstreamsrc *hthstreamsrc);
  * necessary create a correct pads connection
  *
  * @param hthstreamsrc The plugin instance
- * @return void
+ * @return gboolean FALSE if one link fails
+ */
+static gboolean linkBinElements(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Link the elements of one branch and its entry pad with the queue
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if one link fails
  */
-static void linkBinElements(Gsththstreamsrc *hthstreamsrc);
+static gboolean linkBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
  * @brief Creates the audio and video ghost pads from src template
  *
  * @param hthstreamsrc
- * @return void
+ * @return gboolean FALSE if one pad could not be created
  */
-static void createPluginGhostPads(Gsththstreamsrc *hthstreamsrc);
+static gboolean createPluginGhostPads(Gsththstreamsrc *hthstreamsrc);
 
 /**
  * @brief set plugin ghost pads with the las video and audio plugin
@@ -234,541 +430,2516 @@ static void createPluginGhostPads(Gsththstreamsrc *hthstreamsrc);
  * ==============================
  *
  * @param hthstreamsrc The plugin instance
- * @return void
+ * @return gboolean FALSE if one ghost pad target could not be set
  */
-static void setPluginSrcPads(Gsththstreamsrc *hthstreamsrc);
+static gboolean setPluginSrcPads(Gsththstreamsrc *hthstreamsrc);
 
 /**
- * @brief set plugin's properties with new values
+ * @brief Set the ghost pad target to the last element of one branch
  *
- * @param object
- * @param prop_id property id
- * @param value new property value
- * @param pspec
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if the target could not be set
  */
-static void gst_hthstreamsrc_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+static gboolean setBranchSrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
- * @brief Obtain the values of the plugin's properties
+ * @brief Create the pads between the demuxer pads and the branch queues
  *
- * @param object
- * @param prop_id property id
- * @param value
- * @param pspec
+ * The demuxer combines the flow returns of all its pads, so an error
+ * of one branch would stop the others. The entry pads drop the data of a
+ * failed branch and hide its errors from the demuxer.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return gboolean FALSE if the pads could not be created
  */
-static void gst_hthstreamsrc_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean createBranchEntryPads(Gsththstreamsrc *hthstreamsrc);
 
-//==============================================================================
+/**
+ * @brief Get the fields of the elements of one branch, in data flow order
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @param elements Returns the addresses of the element fields
+ * @return guint Number of elements
+ */
+static guint getBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch, GstElement **elements[MAX_BRANCH_ELEMENTS]);
 
+/**
+ * @brief Get the restart bookkeeping of one branch
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return GstHthBranch* The bookkeeping
+ */
+static GstHthBranch *getBranchState(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
+/**
+ * @brief Get the ghost src pad that outputs one branch
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return GstPad* The ghost pad
+ */
+static GstPad *getBranchGhostPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
-//==============================================================================
+/**
+ * @brief Get the entry src pad that feeds the queue of one branch
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return GstPad* The entry src pad
+ */
+static GstPad *getBranchEntrySrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
- * @brief Demuxer add pads callback function
+ * @brief Get the entry sink pad linked to the demuxer pad of one branch
  *
- * @param demux The demux element with sometimes pad
- * @param new_pad New pad, can be audio or video type
  * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return GstPad* The entry sink pad
  */
-static void cb_matroskaDemuxPadAdded (GstElement *demux, GstPad *new_pad, Gsththstreamsrc *hthstreamsrc);
+static GstPad *getBranchEntrySinkPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
+ * @brief Get the src pad of the last element of one branch
  *
- * @param filter
- * @param buffer
- * @param user_data
- * @return
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return GstPad* The pad, unref after usage. NULL if the element is missing
  */
-int filter_handoff_callback(GstElement* filter, GstBuffer* buffer, void* user_data);
-//==============================================================================
+static GstPad *getBranchLastSrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
 /**
- * @brief GObject vmethod implementations
- * initialize the hthstreamsrc class
+ * @brief Find the branch of an internal element
  *
+ * @param hthstreamsrc The plugin instance
+ * @param object Source of a bus message
+ * @return HthStreamBranch BRANCH_NONE for udpsrc and the demuxer
  */
-static void gst_hthstreamsrc_class_init (GsththstreamsrcClass * klass){
-    
-    printf(WHITE "Bin-plugin  -- hthstreamsrc Class Init ---  \n" RESET);
-    
-    GObjectClass *gobject_class;
-    GstElementClass *gstelement_class;
-    
-    gobject_class = (GObjectClass *) klass;
-    gstelement_class = (GstElementClass *) klass;
-    
-    gobject_class->set_property = gst_hthstreamsrc_set_property;
-    gobject_class->get_property = gst_hthstreamsrc_get_property;
-    
-    /** Install properties*/
-    g_object_class_install_property (gobject_class, PROP_PORT,
-                                     g_param_spec_int ("port", "Port", "The port that receives the packets",
-                                                       0, G_MAXUINT16,
-                                                       0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
-    
-    gst_element_class_set_details_simple(gstelement_class,
-                                         "hthstreamsrc",
-                                         "FIXME:Generic",
-                                         "FIXME:Generic Template Element",
-                                         "basultobd <<user@hostname.org>>");
-    
-    gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_bin_change_state);
-}
+static HthStreamBranch findElementBranch(Gsththstreamsrc *hthstreamsrc, GstObject *object);
 
-//==============================================================================
+/**
+ * @brief Rebuild the branch of the elements that post an error
+ *
+ * The error is replaced by a warning and the branch is rebuilt from
+ * another thread. The errors of udpsrc and the demuxer, and of a branch
+ * that keeps failing, are forwarded.
+ *
+ * @param bin The plugin instance
+ * @param message Message posted by an internal element
+ */
+static void gst_hthstreamsrc_handle_message (GstBin *bin, GstMessage *message);
 
 /**
- * @brief initialize the new element
+ * @brief Replace the elements of a failed branch with new ones
  *
+ * Runs from gst_element_call_async(), not from a streaming thread.
  *
- * instantiate pads and add them to element
- * set pad calback functions
- * initialize instance structure
+ * @param element The plugin instance
+ * @param user_data The branch
+ */
+static void cb_rebuildBranch(GstElement *element, gpointer user_data);
+
+/**
+ * @brief Replace the elements of one branch and bring them to the state of the bin
+ *
+ * Posts an error when the branch could not be built.
  *
  * @param hthstreamsrc The plugin instance
- * @return void
+ * @param branch The branch
+ * @return gboolean FALSE if the branch is left without elements
  */
-static void gst_hthstreamsrc_init (Gsththstreamsrc *hthstreamsrc) {
-    
-    printf(WHITE "Bin-plugin  -- hthstreamsrc Init ---  \n" RESET);
-    
-    hthstreamsrc->port = DEFAULT_PORT;
-    printf(GREEN "Default port %d \n" RESET, hthstreamsrc->port);
-    
-    gboolean isVideoSrcPadActivated;
-    gboolean isAudioSrcPadActivated;
-    gboolean isTextSrcPadActivated;
-    
-    /** Elements  */
-    createElements(hthstreamsrc);
-    verifyAllElementsCreated(hthstreamsrc);
-    setElementsPropsValues(hthstreamsrc);
-    
-    /** Bin */
-    addElementsToBin(hthstreamsrc);
-    linkBinElements(hthstreamsrc);
-    
-    /** Pads */
-    createPluginGhostPads(hthstreamsrc);
-    setPluginSrcPads(hthstreamsrc);
-    
-    /** plugin src pads */
-    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->videoSrcPad);
-    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->audioSrcPad);
-    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->textSrcPad);
-    
-    /** Active the pads  */
-    isVideoSrcPadActivated = gst_pad_set_active (hthstreamsrc->videoSrcPad, TRUE);
-    if (!isVideoSrcPadActivated)
-        printf(RED "videoSrcPad: gst_pad_set_active = FALSE" RESET);
-    
-    isAudioSrcPadActivated = gst_pad_set_active (hthstreamsrc->audioSrcPad, TRUE);
-    if (!isAudioSrcPadActivated)
-        printf(RED "aduioSrcPad: gst_pad_set_active = FALSE" RESET);
-    
-    isTextSrcPadActivated = gst_pad_set_active (hthstreamsrc->textSrcPad, TRUE);
-    if (!isTextSrcPadActivated)
-        printf(RED "aduioSrcPad: gst_pad_set_active = FALSE" RESET);
-    
-    /**
-     * Set this if the element always outputs data in the
-     * exact same format as it receives as input
-     * */
-    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->videoSrcPad);
-    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->audioSrcPad);
-    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->textSrcPad);
-    
-}
+static gboolean rebuildBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
-//==============================================================================
+/**
+ * @brief Codec of the track of a demuxer pad
+ *
+ * @param pad Demuxer pad with its caps
+ * @return gint Index in codecDecoders, -1 for a codec without decoder
+ */
+static gint getPadCodec(GstPad *pad);
 
-static void gst_hthstreamsrc_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
-    
-    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (object);
-    
-    switch (prop_id) {
-        
-        case PROP_PORT:
-            
-            hthstreamsrc->port = g_value_get_int(value);
-            g_object_set (hthstreamsrc->plugin_udp_src, "port", hthstreamsrc->port, NULL);
-            printf(GREEN "New port: %d \n" RESET , hthstreamsrc->port);
-            break;
-        
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
-    }
-}
+/**
+ * @brief Turn on the loss concealment of opusdec
+ *
+ * Does nothing with the other decoders.
+ *
+ * @param decoder Decoder of a branch or of a sender chain, may be NULL
+ * @return void
+ */
+static void configureDecoder(GstElement *decoder);
 
-//==============================================================================
+/**
+ * @brief Rebuild the video or audio branch with the decoder of a new track
+ *
+ * Runs in the demuxer thread, before the track is linked to the branch.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch BRANCH_VIDEO or BRANCH_AUDIO
+ * @param pad Demuxer pad of the track
+ * @return void
+ */
+static void selectBranchDecoder(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch, GstPad *pad);
 
-static void gst_hthstreamsrc_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
-    
-    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (object);
-    
-    switch (prop_id) {
-        case PROP_PORT:
-            g_value_set_int (value, hthstreamsrc->port);
-            break;
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
-    }
-}
+/**
+ * @brief Stop the elements of one branch and remove them from the bin
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void teardownBranch(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
-//==============================================================================
+/**
+ * @brief Bring the elements of a rebuilt branch to the state of the bin
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void syncBranchStates(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
 
-static void createElements(Gsththstreamsrc *hthstreamsrc) {
-    
-    /**
-     * Create all internal elements
-     */
+/**
+ * @brief Put the frame record and per-frame telemetry probes on the video branch
+ *
+ * Used at init and when the video branch is rebuilt. The records are
+ * always stripped, the decoder must not see them.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void setBranchTelemetry(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
+/**
+ * @brief Build the stats structure
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return GstStructure* hthstreamsrc-stats structure
+ */
+static GstStructure *createStatsStructure(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Replace one of the thread string properties
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param field The property field
+ * @param value New value
+ * @return void
+ */
+static void setThreadString(Gsththstreamsrc *hthstreamsrc, gchar **field, const GValue *value);
+
+/**
+ * @brief Name, pin and schedule an internal streaming thread
+ *
+ * Runs in the thread that posted the STREAM_STATUS ENTER message.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param message STREAM_STATUS message of a child
+ * @return void
+ */
+static void setupStreamingThread(Gsththstreamsrc *hthstreamsrc, GstMessage *message);
+
+/**
+ * @brief Measure the jitter of the buffers leaving each branch
+ *
+ * The watched pads are kept when a branch is rebuilt.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void watchBranchJitter(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Count the buffers inside a branch queue against max-memory
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param queue The queue, of the element or of a sender chain
+ * @param branch The branch of the queue, sets its drop order
+ */
+static void watchBranchMemory(Gsththstreamsrc *hthstreamsrc, GstElement *queue, HthStreamBranch branch);
+
+/**
+ * @brief Turn the latency probes on or off
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param enable TRUE to install the probes of every branch
+ * @return void
+ */
+static void setLatencyTracing(Gsththstreamsrc *hthstreamsrc, gboolean enable);
+
+/**
+ * @brief Add the latency stages of one branch
+ *
+ * One stage from the demuxer input to its pad of the branch, one per
+ * element and one from the entry pad to the ghost src pad. Only the
+ * single sender mode is traced.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void traceBranchLatency(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
+/**
+ * @brief Remove the latency probes of one branch before its elements go
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void untraceBranchLatency(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
+/**
+ * @brief Install the receiver counters on the transport, the demuxer and the branches
+ *
+ * The transport is counted at the demuxer input, after the impairment.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void watchReceiveStats(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Install the capture probe on udpsrc, ahead of the impairment and the receiver counters
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void watchCapture(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Create the capture file of capture-location and pass it to the receive engine
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return gboolean FALSE if the file could not be created, an error is posted
+ */
+static gboolean openCapture(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Flush and close the capture file, if any
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void closeCapture(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Put hthimpair between udpsrc and the demuxer, or take it out
+ *
+ * @param hthstreamsrc The plugin instance, in the NULL state
+ * @param description Properties of hthimpair, NULL or empty for none
+ * @return void
+ */
+static void setImpairment(Gsththstreamsrc *hthstreamsrc, const gchar *description);
+
+/**
+ * @brief Measure the queue and the decoder of one branch, again after a rebuild
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void watchBranchReceiveStats(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch);
+
+/**
+ * @brief Tell if a message source is a demuxer, of the element or of a sender
+ *
+ * @param object Source of the message
+ * @return gboolean TRUE for a matroskademux
+ */
+static gboolean isDemuxer(GstObject *object);
+
+/**
+ * @brief Look up the factories of the sender chains
+ *
+ * A missing factory stays NULL, the chains that need it fail when a
+ * sender appears.
+ *
+ * @return void
+ */
+static void loadSenderFactories(void);
+
+/**
+ * @brief Create an element from a cached factory
+ *
+ * @param factory The factory, may be NULL
+ * @return GstElement* The element, NULL if the factory is missing
+ */
+static GstElement *createSenderElement(GstElementFactory *factory);
+
+/**
+ * @brief Name prefix of the src pads of one branch
+ *
+ * @param branch The branch
+ * @return const gchar* video_src, audio_src or text_src
+ */
+static const gchar *getBranchPadPrefix(HthStreamBranch branch);
+
+/**
+ * @brief Branch of a demuxer pad
+ *
+ * @param padName Name of the demuxer pad
+ * @return HthStreamBranch BRANCH_NONE for the unknown tracks
+ */
+static HthStreamBranch getDemuxPadBranch(const gchar *padName);
+
+/**
+ * @brief First datagram of a sender, creates its chain
+ *
+ * Runs in the receive thread that owns the sender.
+ *
+ * @param key Sender address:port
+ * @param worker Receive thread number
+ * @param userData The plugin instance
+ * @return gpointer The SenderChain, NULL to drop the datagram
+ */
+static gpointer cb_senderNew(const gchar *key, guint worker, gpointer userData);
+
+/**
+ * @brief Push a datagram into the demuxer of its sender
+ *
+ * @param sender The SenderChain
+ * @param buffer The datagram
+ * @param userData The plugin instance
+ * @return GstFlowReturn Flow return of the demuxer
+ */
+static GstFlowReturn cb_senderPacket(gpointer sender, GstBuffer *buffer, gpointer userData);
+
+/**
+ * @brief The receive engine forgot a sender, its chain is removed
+ *
+ * @param sender The SenderChain
+ * @param userData The plugin instance
+ */
+static void cb_senderRemoved(gpointer sender, gpointer userData);
+
+/**
+ * @brief The replay reached the end of the capture, the demuxer of the sender gets EOS
+ *
+ * @param sender The SenderChain
+ * @param userData The plugin instance
+ */
+static void cb_senderEnd(gpointer sender, gpointer userData);
+
+/**
+ * @brief Whether the datagrams go through the receive engine instead of udpsrc
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return gboolean TRUE with receive threads or a replay
+ */
+static gboolean usesReceiver(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Record the datagrams of udpsrc in the capture
+ *
+ * @param pad Src pad of udpsrc
+ * @param info Probe info with the datagram
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_captureProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Create the bin with the demuxer of a sender and add it to the element
+ *
+ * The branches are created when the demuxer finds the tracks.
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param key Sender address:port
+ * @return SenderChain* The chain, NULL if the demuxer could not be created
+ */
+static SenderChain *createSenderChain(Gsththstreamsrc *hthstreamsrc, const gchar *key);
+
+/**
+ * @brief Demuxer of a sender add pads callback function
+ *
+ * @param demuxer The demuxer of the sender
+ * @param pad New pad
+ * @param user_data The SenderChain
+ */
+static void cb_senderDemuxPadAdded(GstElement *demuxer, GstPad *pad, gpointer user_data);
+
+/**
+ * @brief Create the decoders of one track of a sender and expose them as a pad of the element
+ *
+ * @param chain The sender chain
+ * @param branch Branch of the track
+ * @param demuxPad Demuxer pad of the track
+ * @return gboolean FALSE if the elements could not be created or linked
+ */
+static gboolean createSenderBranch(SenderChain *chain, HthStreamBranch branch, GstPad *demuxPad);
+
+/**
+ * @brief Whether a queue reached one of its limits, the next buffer would block
+ *
+ * @param queue The queue2
+ * @return gboolean TRUE if the queue is full
+ */
+static gboolean isQueueFull(GstElement *queue);
+
+/**
+ * @brief Drop a buffer of a sender instead of blocking on its full branch queue
+ *
+ * The receive thread pushes through the demuxer into the queues of all its
+ * senders, a sender whose decoder falls behind must not stall the others.
+ *
+ * @param pad Sink pad of the queue
+ * @param info Probe info with the buffer
+ * @param user_data The SenderChain
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP while the queue is full
+ */
+static GstPadProbeReturn cb_senderQueueProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Remove a sender chain from gst_element_call_async()
+ *
+ * @param element The plugin instance
+ * @param user_data The SenderChain
+ */
+static void cb_removeSenderChain(GstElement *element, gpointer user_data);
+
+/**
+ * @brief Remove the pads and the bin of a sender and free the chain
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param chain The sender chain
+ * @return void
+ */
+static void removeSenderChain(Gsththstreamsrc *hthstreamsrc, SenderChain *chain);
+
+/**
+ * @brief Find the sender chain that contains an internal element
+ *
+ * @param hthstreamsrc The plugin instance
+ * @param object Source of a bus message
+ * @return gchar* Copy of the sender key, NULL if the object is not in a sender chain
+ */
+static gchar *findSenderKey(Gsththstreamsrc *hthstreamsrc, GstObject *object);
+
+/**
+ * @brief Forget a failed sender from gst_element_call_async()
+ *
+ * The receive thread of the sender may be posting the error,
+ * so the engine lock can't be taken from the bus handler.
+ *
+ * @param element The plugin instance
+ * @param user_data The sender key
+ */
+static void cb_forgetSender(GstElement *element, gpointer user_data);
+
+/**
+ * @brief Receive engine callbacks
+ */
+static const GstHthReceiverCallbacks senderCallbacks = {
+    cb_senderNew,
+    cb_senderPacket,
+    cb_senderRemoved,
+    cb_senderEnd
+};
+
+/**
+ * @brief set plugin's properties with new values
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value new property value
+ * @param pspec
+ */
+static void gst_hthstreamsrc_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+
+/**
+ * @brief Obtain the values of the plugin's properties
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value
+ * @param pspec
+ */
+static void gst_hthstreamsrc_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
+
+//==============================================================================
+
+
+
+//==============================================================================
+
+/**
+ * @brief Demuxer add pads callback function
+ *
+ * @param demux The demux element with sometimes pad
+ * @param new_pad New pad, can be audio or video type
+ * @param hthstreamsrc The plugin instance
+ */
+static void cb_matroskaDemuxPadAdded (GstElement *demux, GstPad *new_pad, Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Strip the record hthstreamsink appended to an encoded video frame
+ *
+ * Runs in the demuxer thread. With frame-telemetry the record is kept
+ * until cb_videoTelemetryProbe applies it to the decoded frame.
+ *
+ * @param pad Video queue sink pad
+ * @param info Probe info with the encoded frame
+ * @param user_data The plugin instance, NULL to strip only
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_frameRecordProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Attach the record of each decoded frame as a GstHthTelemetryMeta
+ *
+ * The capture time of the record sent with the frame is attached as a
+ * GstHthCaptureMeta, and drawn on the frame with draw-capture-time.
+ *
+ * @param pad plugin_video_dec src pad
+ * @param info Probe info with the decoded frame or the caps
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_videoTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Free a telemetry record
+ *
+ * @param data The record
+ */
+static void telemetryRecordFree(gpointer data);
+
+/**
+ * @brief Drop all the pending and applied telemetry records
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void clearTelemetryRecords(Gsththstreamsrc *hthstreamsrc);
+
+/**
+ * @brief Free the resources that are not owned by the bin
+ *
+ * @param object The plugin instance
+ */
+static void gst_hthstreamsrc_finalize (GObject * object);
+//==============================================================================
+
+/**
+ * @brief GObject vmethod implementations
+ * initialize the hthstreamsrc class
+ *
+ */
+static void gst_hthstreamsrc_class_init (GsththstreamsrcClass * klass){
+    
+    printf(WHITE "Bin-plugin  -- hthstreamsrc Class Init ---  \n" RESET);
+    
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    GstBinClass *gstbin_class;
+    
+    gobject_class = (GObjectClass *) klass;
+    gstelement_class = (GstElementClass *) klass;
+    gstbin_class = (GstBinClass *) klass;
+    
+    gstbin_class->handle_message = gst_hthstreamsrc_handle_message;
+    
+    gobject_class->set_property = gst_hthstreamsrc_set_property;
+    gobject_class->get_property = gst_hthstreamsrc_get_property;
+    gobject_class->finalize = gst_hthstreamsrc_finalize;
+    
+    /** Install properties*/
+    g_object_class_install_property (gobject_class, PROP_PORT,
+                                     g_param_spec_int ("port", "Port", "The port that receives the packets",
+                                                       0, G_MAXUINT16,
+                                                       0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_FRAME_TELEMETRY,
+                                     g_param_spec_boolean ("frame-telemetry", "Frame telemetry",
+                                                           "Output the per-frame telemetry sent by hthstreamsink as a meta of the video frames (NULL state only)",
+                                                           DEFAULT_FRAME_TELEMETRY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RECEIVE_THREADS,
+                                     g_param_spec_uint ("receive-threads", "Receive threads",
+                                                        "SO_REUSEPORT sockets and receive threads shared by many senders, each sender gets its own pads. 0 receives one sender with udpsrc",
+                                                        0, HTH_RECEIVER_MAX_WORKERS, DEFAULT_RECEIVE_THREADS,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_SENDER_TIMEOUT,
+                                     g_param_spec_uint ("sender-timeout", "Sender timeout",
+                                                        "Milliseconds without datagrams before the pads of a sender are removed, 0 keeps them until stop (receive-threads > 0)",
+                                                        0, G_MAXUINT, DEFAULT_SENDER_TIMEOUT,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STREAM_ID_HEADER,
+                                     g_param_spec_boolean ("stream-id-header", "Stream id header",
+                                                           "Identify the senders by the stream-id of hthstreamsink instead of their address (receive-threads > 0 or replay-location)",
+                                                           DEFAULT_STREAM_ID_HEADER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_SHARED_TASK_POOL,
+                                     g_param_spec_boolean ("shared-task-pool", "Shared task pool",
+                                                           "Run the streaming tasks of the internal elements on the pool shared by all the hth elements of the process, one thread per core, grown to one per task when they outnumber the cores",
+                                                           DEFAULT_SHARED_TASK_POOL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_VIDEO_CPUS,
+                                     g_param_spec_string ("video-cpus", "Video CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the video queue thread, it runs the video decoder",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_AUDIO_CPUS,
+                                     g_param_spec_string ("audio-cpus", "Audio CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the audio queue thread, it runs the audio decoder",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_TEXT_CPUS,
+                                     g_param_spec_string ("text-cpus", "Text CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the text queue thread, it runs the text decoder",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_TRANSPORT_CPUS,
+                                     g_param_spec_string ("transport-cpus", "Transport CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the udpsrc thread and of the receive threads",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RT_POLICY,
+                                     g_param_spec_string ("rt-policy", "Real-time policy",
+                                                          "Scheduling of the internal streaming threads: other, fifo or rr",
+                                                          DEFAULT_RT_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RT_PRIORITY,
+                                     g_param_spec_int ("rt-priority", "Real-time priority",
+                                                       "Priority of the internal streaming threads with rt-policy fifo or rr",
+                                                       1, 99, DEFAULT_RT_PRIORITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_MAX_MEMORY,
+                                     g_param_spec_uint64 ("max-memory", "Max memory",
+                                                          "Bytes the buffers of the internal queues and receive pools may hold, the queues share the rest and drop video above 80% of it, audio above 95% and text only when full; 0 for no limit",
+                                                          0, G_MAXUINT64, DEFAULT_MAX_MEMORY,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_LATENCY_TRACING,
+                                     g_param_spec_boolean ("latency-tracing", "Latency tracing",
+                                                           "Measure the time the buffers spend in the demuxer, every internal element and the whole branch",
+                                                           DEFAULT_LATENCY_TRACING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_LATENCY_INTERVAL,
+                                     g_param_spec_uint ("latency-interval", "Latency interval",
+                                                        "Milliseconds between two hth-latency element messages while latency-tracing is on, 0 posts none",
+                                                        0, G_MAXUINT, DEFAULT_LATENCY_INTERVAL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RECEIVER_STATS_INTERVAL,
+                                     g_param_spec_uint ("receiver-stats-interval", "Receiver stats interval",
+                                                        "Milliseconds between two hth-receiver-stats element messages, 0 posts none",
+                                                        0, G_MAXUINT, DEFAULT_RECEIVER_STATS_INTERVAL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_CAPTURE_LOCATION,
+                                     g_param_spec_string ("capture-location", "Capture location",
+                                                          "File recording every received datagram with its arrival time, NULL records nothing",
+                                                          DEFAULT_CAPTURE_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_REPLAY_LOCATION,
+                                     g_param_spec_string ("replay-location", "Replay location",
+                                                          "Capture file fed to the sender chains instead of the network, each sender gets its own pads",
+                                                          DEFAULT_REPLAY_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_REPLAY_REALTIME,
+                                     g_param_spec_boolean ("replay-realtime", "Replay realtime",
+                                                           "Replay the capture with its original arrival times, otherwise as fast as the decoders take it",
+                                                           DEFAULT_REPLAY_REALTIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_IMPAIRMENT,
+                                     g_param_spec_string ("impairment", "Impairment",
+                                                          "Properties of an hthimpair element put between udpsrc and the demuxer, e.g. \"loss=1 delay=40 seed=7\" (receive-threads=0)",
+                                                          DEFAULT_IMPAIRMENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DRAW_CAPTURE_TIME,
+                                     g_param_spec_boolean ("draw-capture-time", "Draw capture time",
+                                                           "Draw the capture time sent by an hthstreamsink with time-overlay=meta on the video frames (frame-telemetry=true)",
+                                                           DEFAULT_DRAW_CAPTURE_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STATS,
+                                     g_param_spec_boxed ("stats", "Statistics",
+                                                         "Restarts and time-to-restore of the branches, thread, memory, latency and receiver counters",
+                                                         GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    
+    gst_element_class_set_details_simple(gstelement_class,
+                                         "hthstreamsrc",
+                                         "FIXME:Generic",
+                                         "FIXME:Generic Template Element",
+                                         "basultobd <<user@hostname.org>>");
+    
+    gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_bin_change_state);
+    
+    gst_element_class_add_static_pad_template (gstelement_class, &video_sender_factory);
+    gst_element_class_add_static_pad_template (gstelement_class, &audio_sender_factory);
+    gst_element_class_add_static_pad_template (gstelement_class, &text_sender_factory);
+    
+    loadSenderFactories();
+}
+
+//==============================================================================
+
+/**
+ * @brief initialize the new element
+ *
+ *
+ * instantiate pads and add them to element
+ * set pad calback functions
+ * initialize instance structure
+ *
+ * @param hthstreamsrc The plugin instance
+ * @return void
+ */
+static void gst_hthstreamsrc_init (Gsththstreamsrc *hthstreamsrc) {
+    
+    printf(WHITE "Bin-plugin  -- hthstreamsrc Init ---  \n" RESET);
+    
+    hthstreamsrc->port = DEFAULT_PORT;
+    printf(GREEN "Default port %d \n" RESET, hthstreamsrc->port);
+    hthstreamsrc->frameTelemetry = DEFAULT_FRAME_TELEMETRY;
+    hthstreamsrc->receiveThreads = DEFAULT_RECEIVE_THREADS;
+    hthstreamsrc->senderTimeout = DEFAULT_SENDER_TIMEOUT;
+    hthstreamsrc->streamIdHeader = DEFAULT_STREAM_ID_HEADER;
+    hthstreamsrc->sharedTaskPool = DEFAULT_SHARED_TASK_POOL;
+    hthstreamsrc->videoCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsrc->audioCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsrc->textCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsrc->transportCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsrc->rtPolicy = g_strdup(DEFAULT_RT_POLICY);
+    hthstreamsrc->rtPriority = DEFAULT_RT_PRIORITY;
+    hthstreamsrc->memory = gst_hth_memory_new();
+    gst_hth_memory_set_limit(hthstreamsrc->memory, DEFAULT_MAX_MEMORY);
+    hthstreamsrc->latencyTracing = DEFAULT_LATENCY_TRACING;
+    hthstreamsrc->latency = gst_hth_latency_new(GST_ELEMENT(hthstreamsrc));
+    hthstreamsrc->latencyInterval = DEFAULT_LATENCY_INTERVAL;
+    gst_hth_latency_set_interval(hthstreamsrc->latency, DEFAULT_LATENCY_INTERVAL * GST_MSECOND);
+    hthstreamsrc->receiveStats = gst_hth_receive_stats_new(GST_ELEMENT(hthstreamsrc));
+    hthstreamsrc->receiverStatsInterval = DEFAULT_RECEIVER_STATS_INTERVAL;
+    gst_hth_receive_stats_set_interval(hthstreamsrc->receiveStats, DEFAULT_RECEIVER_STATS_INTERVAL * GST_MSECOND);
+    
+    /** Multi sender receive */
+    hthstreamsrc->receiver = gst_hth_receiver_new(&senderCallbacks, hthstreamsrc);
+    hthstreamsrc->senderChains = NULL;
+    hthstreamsrc->receiverStopping = FALSE;
+    hthstreamsrc->senderQueueDrops = 0;
+    
+    /** Capture and replay */
+    hthstreamsrc->captureLocation = g_strdup(DEFAULT_CAPTURE_LOCATION);
+    hthstreamsrc->replayLocation = g_strdup(DEFAULT_REPLAY_LOCATION);
+    hthstreamsrc->replayRealtime = DEFAULT_REPLAY_REALTIME;
+    hthstreamsrc->capture = NULL;
+    
+    /** Impairment */
+    hthstreamsrc->impairment = g_strdup(DEFAULT_IMPAIRMENT);
+    hthstreamsrc->plugin_impairment = NULL;
+    
+    /** Frame telemetry */
+    g_mutex_init(&hthstreamsrc->telemetryLock);
+    g_queue_init(&hthstreamsrc->telemetryRecords);
+    hthstreamsrc->currentTelemetry = NULL;
+    hthstreamsrc->drawCaptureTime = DEFAULT_DRAW_CAPTURE_TIME;
+    hthstreamsrc->overlay = gst_hth_overlay_new();
+    hthstreamsrc->videoDecoder = codecDecoders[0].factory;
+    hthstreamsrc->audioDecoder = codecDecoders[3].factory;
+    
+    /** Branches */
+    gst_hth_branch_init(&hthstreamsrc->videoBranch, GST_ELEMENT(hthstreamsrc), "video");
+    gst_hth_branch_init(&hthstreamsrc->audioBranch, GST_ELEMENT(hthstreamsrc), "audio");
+    gst_hth_branch_init(&hthstreamsrc->textBranch, GST_ELEMENT(hthstreamsrc), "text");
+    gst_hth_jitter_init(&hthstreamsrc->videoJitter, "video");
+    gst_hth_jitter_init(&hthstreamsrc->audioJitter, "audio");
+    gst_hth_jitter_init(&hthstreamsrc->textJitter, "text");
+    
+    gboolean isVideoSrcPadActivated;
+    gboolean isAudioSrcPadActivated;
+    gboolean isTextSrcPadActivated;
+    gboolean isBuilt;
+    
+    /** Elements  */
+    createElements(hthstreamsrc);
+    isBuilt = verifyAllElementsCreated(hthstreamsrc) && createBranchEntryPads(hthstreamsrc);
+    
+    if (isBuilt) {
+        setElementsPropsValues(hthstreamsrc);
+        
+        /** Bin */
+        addElementsToBin(hthstreamsrc);
+        isBuilt = linkBinElements(hthstreamsrc);
+    }
+    
+    /** Pads */
+    if (!createPluginGhostPads(hthstreamsrc)) {
+        hthstreamsrc->constructionFailed = TRUE;
+        return;
+    }
+    if (isBuilt)
+        isBuilt = setPluginSrcPads(hthstreamsrc);
+    
+    /** Reported when the element goes to READY */
+    hthstreamsrc->constructionFailed = !isBuilt;
+    
+    /** plugin src pads */
+    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->videoSrcPad);
+    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->audioSrcPad);
+    gst_element_add_pad (GST_ELEMENT (hthstreamsrc), hthstreamsrc->textSrcPad);
+    
+    /** Active the pads  */
+    isVideoSrcPadActivated = gst_pad_set_active (hthstreamsrc->videoSrcPad, TRUE);
+    if (!isVideoSrcPadActivated)
+        printf(RED "videoSrcPad: gst_pad_set_active = FALSE" RESET);
+    
+    isAudioSrcPadActivated = gst_pad_set_active (hthstreamsrc->audioSrcPad, TRUE);
+    if (!isAudioSrcPadActivated)
+        printf(RED "aduioSrcPad: gst_pad_set_active = FALSE" RESET);
+    
+    isTextSrcPadActivated = gst_pad_set_active (hthstreamsrc->textSrcPad, TRUE);
+    if (!isTextSrcPadActivated)
+        printf(RED "aduioSrcPad: gst_pad_set_active = FALSE" RESET);
+    
+    /**
+     * Set this if the element always outputs data in the
+     * exact same format as it receives as input
+     * */
+    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->videoSrcPad);
+    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->audioSrcPad);
+    GST_PAD_SET_PROXY_CAPS (hthstreamsrc->textSrcPad);
+    
+    if (isBuilt) {
+        setBranchTelemetry(hthstreamsrc, BRANCH_VIDEO);
+        watchBranchJitter(hthstreamsrc);
+        watchBranchMemory(hthstreamsrc, hthstreamsrc->plugin_video_queue, BRANCH_VIDEO);
+        watchBranchMemory(hthstreamsrc, hthstreamsrc->plugin_audio_queue, BRANCH_AUDIO);
+        watchBranchMemory(hthstreamsrc, hthstreamsrc->plugin_text_queue, BRANCH_TEXT);
+        watchCapture(hthstreamsrc);
+        watchReceiveStats(hthstreamsrc);
+    }
+    
+}
+
+//==============================================================================
+
+static void gst_hthstreamsrc_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (object);
+    
+    switch (prop_id) {
+        
+        case PROP_PORT:
+            
+            hthstreamsrc->port = g_value_get_int(value);
+            g_object_set (hthstreamsrc->plugin_udp_src, "port", hthstreamsrc->port, NULL);
+            printf(GREEN "New port: %d \n" RESET , hthstreamsrc->port);
+            break;
+        
+        case PROP_FRAME_TELEMETRY:
+            
+            /** The records of the stream already received are not kept */
+            if (GST_STATE(hthstreamsrc) != GST_STATE_NULL) {
+                printf(RED "frame-telemetry can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            hthstreamsrc->frameTelemetry = g_value_get_boolean(value);
+            printf(GREEN "New frame telemetry: %d \n" RESET , hthstreamsrc->frameTelemetry);
+            break;
+        
+        case PROP_RECEIVE_THREADS:
+            
+            /** udpsrc binds the port from READY */
+            if (GST_STATE(hthstreamsrc) != GST_STATE_NULL) {
+                printf(RED "receive-threads can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            hthstreamsrc->receiveThreads = g_value_get_uint(value);
+            printf(GREEN "New receive threads: %u \n" RESET , hthstreamsrc->receiveThreads);
+            break;
+        
+        case PROP_SENDER_TIMEOUT:
+            
+            /** Applied when the receive threads start */
+            hthstreamsrc->senderTimeout = g_value_get_uint(value);
+            printf(GREEN "New sender timeout: %u ms \n" RESET , hthstreamsrc->senderTimeout);
+            break;
+        
+        case PROP_STREAM_ID_HEADER:
+            
+            hthstreamsrc->streamIdHeader = g_value_get_boolean(value);
+            printf(GREEN "New stream id header: %d \n" RESET , hthstreamsrc->streamIdHeader);
+            break;
+        
+        case PROP_SHARED_TASK_POOL:
+            
+            /** The tasks are created when going to PAUSED */
+            if (GST_STATE(hthstreamsrc) > GST_STATE_READY) {
+                printf(RED "shared-task-pool can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            hthstreamsrc->sharedTaskPool = g_value_get_boolean(value);
+            printf(GREEN "New shared task pool: %d \n" RESET , hthstreamsrc->sharedTaskPool);
+            break;
+        
+        case PROP_VIDEO_CPUS:
+            
+            setThreadString(hthstreamsrc, &hthstreamsrc->videoCpus, value);
+            printf(GREEN "New video CPUs: %s \n" RESET , hthstreamsrc->videoCpus ? hthstreamsrc->videoCpus : "all");
+            break;
+        
+        case PROP_AUDIO_CPUS:
+            
+            setThreadString(hthstreamsrc, &hthstreamsrc->audioCpus, value);
+            printf(GREEN "New audio CPUs: %s \n" RESET , hthstreamsrc->audioCpus ? hthstreamsrc->audioCpus : "all");
+            break;
+        
+        case PROP_TEXT_CPUS:
+            
+            setThreadString(hthstreamsrc, &hthstreamsrc->textCpus, value);
+            printf(GREEN "New text CPUs: %s \n" RESET , hthstreamsrc->textCpus ? hthstreamsrc->textCpus : "all");
+            break;
+        
+        case PROP_TRANSPORT_CPUS:
+            
+            setThreadString(hthstreamsrc, &hthstreamsrc->transportCpus, value);
+            printf(GREEN "New transport CPUs: %s \n" RESET , hthstreamsrc->transportCpus ? hthstreamsrc->transportCpus : "all");
+            break;
+        
+        case PROP_RT_POLICY:
+            
+            setThreadString(hthstreamsrc, &hthstreamsrc->rtPolicy, value);
+            printf(GREEN "New real-time policy: %s \n" RESET , hthstreamsrc->rtPolicy);
+            break;
+        
+        case PROP_RT_PRIORITY:
+            
+            GST_OBJECT_LOCK(hthstreamsrc);
+            hthstreamsrc->rtPriority = g_value_get_int(value);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            printf(GREEN "New real-time priority: %d \n" RESET , hthstreamsrc->rtPriority);
+            break;
+        
+        case PROP_MAX_MEMORY:
+            
+            gst_hth_memory_set_limit(hthstreamsrc->memory, g_value_get_uint64(value));
+            printf(GREEN "New max memory: %" G_GUINT64_FORMAT " bytes \n" RESET , g_value_get_uint64(value));
+            break;
+        
+        case PROP_LATENCY_TRACING:
+            
+            setLatencyTracing(hthstreamsrc, g_value_get_boolean(value));
+            printf(GREEN "New latency tracing: %d \n" RESET , hthstreamsrc->latencyTracing);
+            break;
+        
+        case PROP_LATENCY_INTERVAL:
+            
+            hthstreamsrc->latencyInterval = g_value_get_uint(value);
+            gst_hth_latency_set_interval(hthstreamsrc->latency, hthstreamsrc->latencyInterval * GST_MSECOND);
+            printf(GREEN "New latency interval: %u ms \n" RESET , hthstreamsrc->latencyInterval);
+            break;
+            
+        case PROP_RECEIVER_STATS_INTERVAL:
+            hthstreamsrc->receiverStatsInterval = g_value_get_uint(value);
+            gst_hth_receive_stats_set_interval(hthstreamsrc->receiveStats, hthstreamsrc->receiverStatsInterval * GST_MSECOND);
+            printf(GREEN "New receiver stats interval: %u ms \n" RESET , hthstreamsrc->receiverStatsInterval);
+            break;
+        
+        case PROP_CAPTURE_LOCATION:
+            
+            /** The file is created when going to PAUSED */
+            if (GST_STATE(hthstreamsrc) > GST_STATE_READY) {
+                printf(RED "capture-location can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            g_free(hthstreamsrc->captureLocation);
+            hthstreamsrc->captureLocation = g_value_dup_string(value);
+            printf(GREEN "New capture location: %s \n" RESET , hthstreamsrc->captureLocation ? hthstreamsrc->captureLocation : "none");
+            break;
+        
+        case PROP_REPLAY_LOCATION:
+            
+            /** udpsrc is locked from READY */
+            if (GST_STATE(hthstreamsrc) != GST_STATE_NULL) {
+                printf(RED "replay-location can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            g_free(hthstreamsrc->replayLocation);
+            hthstreamsrc->replayLocation = g_value_dup_string(value);
+            printf(GREEN "New replay location: %s \n" RESET , hthstreamsrc->replayLocation ? hthstreamsrc->replayLocation : "none");
+            break;
+        
+        case PROP_REPLAY_REALTIME:
+            
+            /** Applied when the replay starts */
+            hthstreamsrc->replayRealtime = g_value_get_boolean(value);
+            printf(GREEN "New replay realtime: %d \n" RESET , hthstreamsrc->replayRealtime);
+            break;
+        
+        case PROP_IMPAIRMENT:
+            
+            /** udpsrc and the demuxer are relinked */
+            if (GST_STATE(hthstreamsrc) != GST_STATE_NULL) {
+                printf(RED "impairment can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setImpairment(hthstreamsrc, g_value_get_string(value));
+            break;
+        
+        case PROP_DRAW_CAPTURE_TIME:
+            
+            g_atomic_int_set(&hthstreamsrc->drawCaptureTime, g_value_get_boolean(value));
+            printf(GREEN "New draw capture time: %d \n" RESET , g_value_get_boolean(value));
+            break;
+        
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static void gst_hthstreamsrc_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (object);
+    
+    switch (prop_id) {
+        case PROP_PORT:
+            g_value_set_int (value, hthstreamsrc->port);
+            break;
+        case PROP_FRAME_TELEMETRY:
+            g_value_set_boolean (value, hthstreamsrc->frameTelemetry);
+            break;
+        case PROP_RECEIVE_THREADS:
+            g_value_set_uint (value, hthstreamsrc->receiveThreads);
+            break;
+        case PROP_SENDER_TIMEOUT:
+            g_value_set_uint (value, hthstreamsrc->senderTimeout);
+            break;
+        case PROP_STREAM_ID_HEADER:
+            g_value_set_boolean (value, hthstreamsrc->streamIdHeader);
+            break;
+        case PROP_SHARED_TASK_POOL:
+            g_value_set_boolean (value, hthstreamsrc->sharedTaskPool);
+            break;
+        case PROP_VIDEO_CPUS:
+            GST_OBJECT_LOCK(hthstreamsrc);
+            g_value_set_string (value, hthstreamsrc->videoCpus);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            break;
+        case PROP_AUDIO_CPUS:
+            GST_OBJECT_LOCK(hthstreamsrc);
+            g_value_set_string (value, hthstreamsrc->audioCpus);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            break;
+        case PROP_TEXT_CPUS:
+            GST_OBJECT_LOCK(hthstreamsrc);
+            g_value_set_string (value, hthstreamsrc->textCpus);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            break;
+        case PROP_TRANSPORT_CPUS:
+            GST_OBJECT_LOCK(hthstreamsrc);
+            g_value_set_string (value, hthstreamsrc->transportCpus);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            break;
+        case PROP_RT_POLICY:
+            GST_OBJECT_LOCK(hthstreamsrc);
+            g_value_set_string (value, hthstreamsrc->rtPolicy);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            break;
+        case PROP_RT_PRIORITY:
+            g_value_set_int (value, hthstreamsrc->rtPriority);
+            break;
+        case PROP_MAX_MEMORY:
+            g_value_set_uint64 (value, gst_hth_memory_get_limit(hthstreamsrc->memory));
+            break;
+        case PROP_LATENCY_TRACING:
+            g_value_set_boolean (value, hthstreamsrc->latencyTracing);
+            break;
+        case PROP_LATENCY_INTERVAL:
+            g_value_set_uint (value, hthstreamsrc->latencyInterval);
+            break;
+        case PROP_RECEIVER_STATS_INTERVAL:
+            g_value_set_uint (value, hthstreamsrc->receiverStatsInterval);
+            break;
+        case PROP_CAPTURE_LOCATION:
+            g_value_set_string (value, hthstreamsrc->captureLocation);
+            break;
+        case PROP_REPLAY_LOCATION:
+            g_value_set_string (value, hthstreamsrc->replayLocation);
+            break;
+        case PROP_REPLAY_REALTIME:
+            g_value_set_boolean (value, hthstreamsrc->replayRealtime);
+            break;
+        case PROP_IMPAIRMENT:
+            g_value_set_string (value, hthstreamsrc->impairment);
+            break;
+        case PROP_DRAW_CAPTURE_TIME:
+            g_value_set_boolean (value, g_atomic_int_get(&hthstreamsrc->drawCaptureTime));
+            break;
+        case PROP_STATS:
+            g_value_take_boxed (value, createStatsStructure(hthstreamsrc));
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static void gst_hthstreamsrc_finalize (GObject * object){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (object);
+    
+    clearTelemetryRecords(hthstreamsrc);
+    g_mutex_clear(&hthstreamsrc->telemetryLock);
+    
+    gst_hth_receiver_free(hthstreamsrc->receiver);
+    
+    /** The entry pads have no parent */
+    if (hthstreamsrc->videoEntrySinkPad) {
+        gst_object_unref(hthstreamsrc->videoEntrySinkPad);
+        gst_object_unref(hthstreamsrc->videoEntrySrcPad);
+    }
+    if (hthstreamsrc->audioEntrySinkPad) {
+        gst_object_unref(hthstreamsrc->audioEntrySinkPad);
+        gst_object_unref(hthstreamsrc->audioEntrySrcPad);
+    }
+    if (hthstreamsrc->textEntrySinkPad) {
+        gst_object_unref(hthstreamsrc->textEntrySinkPad);
+        gst_object_unref(hthstreamsrc->textEntrySrcPad);
+    }
+    
+    g_free(hthstreamsrc->videoCpus);
+    g_free(hthstreamsrc->audioCpus);
+    g_free(hthstreamsrc->textCpus);
+    g_free(hthstreamsrc->transportCpus);
+    g_free(hthstreamsrc->rtPolicy);
+    g_free(hthstreamsrc->captureLocation);
+    g_free(hthstreamsrc->replayLocation);
+    g_free(hthstreamsrc->impairment);
+    gst_hth_jitter_clear(&hthstreamsrc->videoJitter);
+    gst_hth_jitter_clear(&hthstreamsrc->audioJitter);
+    gst_hth_jitter_clear(&hthstreamsrc->textJitter);
+    gst_hth_memory_unref(hthstreamsrc->memory);
+    gst_hth_latency_free(hthstreamsrc->latency);
+    gst_hth_receive_stats_free(hthstreamsrc->receiveStats);
+    gst_hth_overlay_free(hthstreamsrc->overlay);
+    
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+//==============================================================================
+
+static void createElements(Gsththstreamsrc *hthstreamsrc) {
+    
+    /**
+     * Create all internal elements
+     */
+    
+    /** udp src*/
+    hthstreamsrc->plugin_udp_src = gst_element_factory_make("udpsrc", "udp-receiver");
+    
+    /** demuxer */
+    hthstreamsrc->plugin_matroska_demux = gst_element_factory_make("matroskademux", "demuxer");
+    
+    /** add matroska demuxer element pad added callback */
+    if (hthstreamsrc->plugin_matroska_demux != NULL)
+        g_signal_connect(hthstreamsrc->plugin_matroska_demux, "pad-added", G_CALLBACK(cb_matroskaDemuxPadAdded), hthstreamsrc);
+    
+    createBranchElements(hthstreamsrc, BRANCH_VIDEO);
+    createBranchElements(hthstreamsrc, BRANCH_AUDIO);
+    createBranchElements(hthstreamsrc, BRANCH_TEXT);
+    
+}
+
+//==============================================================================
+
+static void createBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch) {
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            hthstreamsrc->plugin_video_queue = gst_element_factory_make("queue2", "video-queue");
+            hthstreamsrc->plugin_video_dec = gst_element_factory_make(hthstreamsrc->videoDecoder, "video-dec");
+            hthstreamsrc->plugin_video_convert = gst_element_factory_make("videoconvert", "audio-converter");
+            break;
+    
+        case BRANCH_AUDIO:
+            hthstreamsrc->plugin_audio_queue = gst_element_factory_make("queue2", "audio-queue");
+            hthstreamsrc->plugin_audio_dec = gst_element_factory_make(hthstreamsrc->audioDecoder, "audio-decoder");
+            hthstreamsrc->plugin_audio_convert = gst_element_factory_make("audioconvert", "audio-convert");
+            hthstreamsrc->plugin_audio_resample = gst_element_factory_make("audioresample","audio-resample");
+            configureDecoder(hthstreamsrc->plugin_audio_dec);
+            break;
+    
+        case BRANCH_TEXT:
+            hthstreamsrc->plugin_text_queue = gst_element_factory_make("queue2", "text-queue");
+            hthstreamsrc->plugin_identity = gst_element_factory_make("identity", "text-filter");
+            break;
+    
+        default:
+            break;
+    }
+    
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+}
+
+//==============================================================================
+
+static gboolean verifyAllElementsCreated(Gsththstreamsrc *hthstreamsrc){
+    
+    /**
+     * Verify that all the internal plugins are created properly
+     */
+    
+    gboolean allElementsCreated; /**< Boolean that stores the function return values*/
+    
+    allElementsCreated = verifyBranchElementsCreated(hthstreamsrc, BRANCH_VIDEO)
+        && verifyBranchElementsCreated(hthstreamsrc, BRANCH_AUDIO)
+        && verifyBranchElementsCreated(hthstreamsrc, BRANCH_TEXT)
+        && hthstreamsrc->plugin_matroska_demux
+        && hthstreamsrc->plugin_udp_src;
+    
+    if(!allElementsCreated){
+        printf (RED "One element could not be created\n" RESET);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean verifyBranchElementsCreated(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    guint i;
+    
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+        if (*elements[i] == NULL) {
+            printf (RED "One element of the %s branch could not be created\n" RESET, getBranchState(hthstreamsrc, branch)->name);
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void setElementsPropsValues(Gsththstreamsrc *hthstreamsrc){
+    
+    /**
+     * Configure the streaming capabilities filter
+     */
+    g_object_set (hthstreamsrc->plugin_udp_src, "port", hthstreamsrc->port, NULL);
+    
+}
+
+
+//==============================================================================
+
+static void addElementsToBin(Gsththstreamsrc *hthstreamsrc){
+    
+    /**
+    * Add elements to the bin hthstreamsrc
+    */
+    
+    addBranchElementsToBin(hthstreamsrc, BRANCH_VIDEO);
+    addBranchElementsToBin(hthstreamsrc, BRANCH_AUDIO);
+    addBranchElementsToBin(hthstreamsrc, BRANCH_TEXT);
+    
+    gst_bin_add_many(GST_BIN(hthstreamsrc) ,
+                     GST_ELEMENT(hthstreamsrc->plugin_matroska_demux),
+                     GST_ELEMENT(hthstreamsrc->plugin_udp_src),
+                     NULL);
+}
+
+//==============================================================================
+
+static void addBranchElementsToBin(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    guint i;
+    
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    for (i = 0; i < elementsCount; i++)
+        gst_bin_add(GST_BIN(hthstreamsrc), *elements[i]);
+}
+
+//==============================================================================
+
+static gboolean linkBinElements(Gsththstreamsrc *hthstreamsrc){
+    
+    
+    gboolean link_ok; /**< Boolean that stores the function return values*/
+    
+    /** link udp src and matroska demux*/
+    link_ok = gst_element_link(hthstreamsrc->plugin_udp_src, hthstreamsrc->plugin_matroska_demux);
+    if (!link_ok){
+        printf(RED "UDP src fail linking pads with matroska demuxer" RESET);
+        return FALSE;
+    }
+    
+    /** The demuxer pads are linked to the entry pads when they are added */
+    return linkBranchElements(hthstreamsrc, BRANCH_VIDEO)
+        && linkBranchElements(hthstreamsrc, BRANCH_AUDIO)
+        && linkBranchElements(hthstreamsrc, BRANCH_TEXT);
+}
+
+//==============================================================================
+
+static gboolean linkBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstHthBranch *branchState = getBranchState(hthstreamsrc, branch);
+    GstPad *queueSinkPad;
+    guint elementsCount;
+    guint i;
+    gboolean link_ok; /**< Boolean that stores the function return values*/
+    GstPadLinkReturn padLink_ok; /**< Stores the function return values with a specific format*/
+    
+    /** Link the neccesary elements for do a correct analysis of the flow */
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    for (i = 0; i + 1 < elementsCount; i++) {
+        link_ok = gst_element_link(*elements[i], *elements[i + 1]);
+        if (!link_ok){
+            printf(RED "Fail linking %s elements" RESET, branchState->name);
+            return FALSE;
+        }
+    }
+    
+    /** The branch queue is fed by the entry pads, not by the demuxer pad directly */
+    queueSinkPad = gst_element_get_static_pad(*elements[0], "sink");
+    padLink_ok = gst_pad_link(getBranchEntrySrcPad(hthstreamsrc, branch), queueSinkPad);
+    gst_object_unref(queueSinkPad);
+    
+    if (padLink_ok != GST_PAD_LINK_OK){
+        printf(RED "%s entry pad linking with queue fails" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean createPluginGhostPads(Gsththstreamsrc *hthstreamsrc){
+    
+    /**
+     * Create src ghost pads
+     */
+    
+    hthstreamsrc->audioSrcPad = gst_ghost_pad_new_no_target_from_template ("audio_src",
+                                                                            gst_static_pad_template_get (&src_factory));
+    if (!hthstreamsrc->audioSrcPad) {
+        printf(RED "hthstreamsrc audio src ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    hthstreamsrc->videoSrcPad = gst_ghost_pad_new_no_target_from_template ("video_src",
+                                                                            gst_static_pad_template_get (&src_factory));
+    if (!hthstreamsrc->videoSrcPad) {
+        printf(RED "hthstreamsrc video src ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    hthstreamsrc->textSrcPad = gst_ghost_pad_new_no_target_from_template ("text_src",
+                                                                           gst_static_pad_template_get (&src_factory));
+    if (!hthstreamsrc->textSrcPad) {
+        printf(RED "hthstreamsrc text src ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean setPluginSrcPads(Gsththstreamsrc *hthstreamsrc){
+    
+    /**
+     * Link the ghost pads with the last element of the audio and video flow respectively
+     */
+    
+    return setBranchSrcPad(hthstreamsrc, BRANCH_VIDEO)
+        && setBranchSrcPad(hthstreamsrc, BRANCH_AUDIO)
+        && setBranchSrcPad(hthstreamsrc, BRANCH_TEXT);
+}
+
+//==============================================================================
+
+static gboolean setBranchSrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstHthBranch *branchState = getBranchState(hthstreamsrc, branch);
+    gboolean setGhostPad_ok; /**< Boolean that stores the function return values*/
+    GstPad *elementSrcPad;
+    
+    /** Get static pad of the last element of the branch */
+    elementSrcPad = getBranchLastSrcPad(hthstreamsrc, branch);
+    if (elementSrcPad == NULL) {
+        printf(RED "Fail on get %s src pad of element \n" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    /** Set ghost pad with the element src pad*/
+    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)getBranchGhostPad(hthstreamsrc, branch), elementSrcPad);
+    gst_object_unref(elementSrcPad);
+    if(!setGhostPad_ok){
+        printf(RED "%s ghost pad could not be linked with element src pad \n" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean createBranchEntryPads(Gsththstreamsrc *hthstreamsrc){
+    
+    hthstreamsrc->videoEntrySinkPad = gst_hth_branch_entry_new(&hthstreamsrc->videoBranch, "video_entry", &hthstreamsrc->videoEntrySrcPad);
+    hthstreamsrc->audioEntrySinkPad = gst_hth_branch_entry_new(&hthstreamsrc->audioBranch, "audio_entry", &hthstreamsrc->audioEntrySrcPad);
+    hthstreamsrc->textEntrySinkPad = gst_hth_branch_entry_new(&hthstreamsrc->textBranch, "text_entry", &hthstreamsrc->textEntrySrcPad);
+    
+    if (!hthstreamsrc->videoEntrySinkPad || !hthstreamsrc->audioEntrySinkPad || !hthstreamsrc->textEntrySinkPad) {
+        printf(RED "hthstreamsrc branch entry pads could not be created \n" RESET);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void cb_matroskaDemuxPadAdded (GstElement *demuxer, GstPad* pad, Gsththstreamsrc *hthstreamsrc) {
+    
+    char *padName; /**< type of pad that ig going to be created*/
+    GstPad *entryPad; /**< stores the entry sink pad of the branch*/
+    GstPadLinkReturn padLink_ok; /**< Stores the function return values with a specific format*/
+    
+    padName = gst_pad_get_name(pad);
+    
+    printf ("Received new pad '%s' from '%s':\n", GST_PAD_NAME (pad), GST_ELEMENT_NAME (demuxer));
+    
+    if(strncmp(padName, VIDEO_PREFIX, VIDEO_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
+    
+        entryPad = hthstreamsrc->videoEntrySinkPad;
+    
+    }else if(strncmp(padName, AUDIO_PREFIX, AUDIO_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
+    
+        entryPad = hthstreamsrc->audioEntrySinkPad;
+    
+    } else if (strncmp(padName, TEXT_PREFIX, TEXT_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
+    
+        entryPad = hthstreamsrc->textEntrySinkPad;
+    
+    } else {
+    
+        g_free (padName);
+        return;
+    }
+    
+    /** The sender may send an other codec than the one of the current decoder */
+    if (!gst_pad_is_linked(entryPad) && entryPad == hthstreamsrc->videoEntrySinkPad)
+        selectBranchDecoder(hthstreamsrc, BRANCH_VIDEO, pad);
+    else if (!gst_pad_is_linked(entryPad) && entryPad == hthstreamsrc->audioEntrySinkPad)
+        selectBranchDecoder(hthstreamsrc, BRANCH_AUDIO, pad);
+    
+    /** Only the first track of each type is output */
+    padLink_ok = gst_pad_is_linked(entryPad) ? GST_PAD_LINK_WAS_LINKED : gst_pad_link(pad, entryPad);
+    if (padLink_ok != GST_PAD_LINK_OK){
+        printf(RED "New pad %s linking fails \n" RESET, padName);
+        g_free (padName);
+        return;
+    }
+    
+    printf(GREEN "Linked pad %s of demuxer\n" RESET, padName);
     
-    /** udp src*/
-    hthstreamsrc->plugin_udp_src = gst_element_factory_make("udpsrc", "udp-receiver");
+    g_free (padName);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_frameRecordProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
     
-    /** demuxer */
-    hthstreamsrc->plugin_matroska_demux = gst_element_factory_make("matroskademux", "demuxer");
+    Gsththstreamsrc *hthstreamsrc = (Gsththstreamsrc*)user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstStructure *recordStructure;
+    TelemetryRecord *record;
     
-    /** add matroska demuxer element pad added callback */
-    g_signal_connect(hthstreamsrc->plugin_matroska_demux, "pad-added", G_CALLBACK(cb_matroskaDemuxPadAdded), hthstreamsrc);
+    /** Most frames have no record */
+    recordStructure = gst_hth_frame_record_strip(&buffer);
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    if (recordStructure == NULL)
+        return GST_PAD_PROBE_OK;
+    
+    if (hthstreamsrc == NULL || !hthstreamsrc->frameTelemetry) {
+        gst_structure_free(recordStructure);
+        return GST_PAD_PROBE_OK;
+    }
+    
+    record = g_new0(TelemetryRecord, 1);
+    record->pts = GST_BUFFER_PTS(buffer);
+    record->text = g_strdup(gst_structure_get_string(recordStructure, "telemetry"));
+    if (!gst_structure_get_uint64(recordStructure, "sample-time", &record->sampleTime))
+        record->sampleTime = GST_CLOCK_TIME_NONE;
+    if (!gst_structure_get_uint64(recordStructure, "capture-time", &record->captureTime))
+        record->captureTime = GST_CLOCK_TIME_NONE;
+    gst_structure_free(recordStructure);
+    
+    g_mutex_lock(&hthstreamsrc->telemetryLock);
+    g_queue_push_tail(&hthstreamsrc->telemetryRecords, record);
+    if (g_queue_get_length(&hthstreamsrc->telemetryRecords) > MAX_TELEMETRY_RECORDS)
+        telemetryRecordFree(g_queue_pop_head(&hthstreamsrc->telemetryRecords));
+    g_mutex_unlock(&hthstreamsrc->telemetryLock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_videoTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC(user_data);
+    GstBuffer *buffer;
+    TelemetryRecord *record;
+    GstEvent *event;
+    GstCaps *caps;
+    gchar *text;
+    GstClockTime sampleTime;
+    GstClockTime captureTime = GST_CLOCK_TIME_NONE;
+    
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+            gst_event_parse_caps(event, &caps);
+            gst_hth_overlay_set_caps(hthstreamsrc->overlay, caps);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+    
+    if (!hthstreamsrc->frameTelemetry)
+        return GST_PAD_PROBE_OK;
     
-    /** video elements */
-    hthstreamsrc->plugin_theora_dec = gst_element_factory_make("theoradec", "video-dec");
-    hthstreamsrc->plugin_video_convert = gst_element_factory_make("videoconvert", "audio-converter");
+    buffer = GST_PAD_PROBE_INFO_BUFFER(info);
     
-    /** audio elements */
-    hthstreamsrc->plugin_vorbis_dec = gst_element_factory_make("vorbisdec", "audio-decoder");
-    hthstreamsrc->plugin_audio_convert = gst_element_factory_make("audioconvert", "audio-convert");
-    hthstreamsrc->plugin_audio_resample = gst_element_factory_make("audioresample","audio-resample");
+    g_mutex_lock(&hthstreamsrc->telemetryLock);
     
-    /** text elements */
-    hthstreamsrc->plugin_identity = gst_element_factory_make("identity", "text-filter");
-    g_signal_connect(hthstreamsrc->plugin_identity, "handoff", G_CALLBACK (filter_handoff_callback), NULL);
+    /** The last record at or before the frame is the one sent with it */
+    record = g_queue_peek_head(&hthstreamsrc->telemetryRecords);
+    while (record != NULL
+           && (!GST_BUFFER_PTS_IS_VALID(buffer) || !GST_CLOCK_TIME_IS_VALID(record->pts)
+               || record->pts <= GST_BUFFER_PTS(buffer))) {
+        telemetryRecordFree(hthstreamsrc->currentTelemetry);
+        hthstreamsrc->currentTelemetry = g_queue_pop_head(&hthstreamsrc->telemetryRecords);
+        record = g_queue_peek_head(&hthstreamsrc->telemetryRecords);
+    }
     
-    /** queues */
-    hthstreamsrc->plugin_video_queue = gst_element_factory_make("queue2", "video-queue");
-    hthstreamsrc->plugin_audio_queue = gst_element_factory_make("queue2", "audio-queue");
-    hthstreamsrc->plugin_text_queue = gst_element_factory_make("queue2", "text-queue");
+    record = hthstreamsrc->currentTelemetry;
+    if (record == NULL) {
+        g_mutex_unlock(&hthstreamsrc->telemetryLock);
+        return GST_PAD_PROBE_OK;
+    }
+    text = g_strdup(record->text);
+    sampleTime = record->sampleTime;
+    
+    /** Unlike the telemetry, a capture time only belongs to its own frame */
+    if (record->pts == GST_BUFFER_PTS(buffer))
+        captureTime = record->captureTime;
+    
+    g_mutex_unlock(&hthstreamsrc->telemetryLock);
+    
+    buffer = gst_buffer_make_writable(buffer);
+    if (text != NULL)
+        gst_buffer_add_hth_telemetry_meta(buffer, text, sampleTime);
+    if (GST_CLOCK_TIME_IS_VALID(captureTime)) {
+        gst_buffer_add_hth_capture_meta(buffer, captureTime);
+        if (g_atomic_int_get(&hthstreamsrc->drawCaptureTime))
+            buffer = gst_hth_overlay_draw(hthstreamsrc->overlay, buffer, captureTime);
+    }
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    g_free(text);
     
+    return GST_PAD_PROBE_OK;
 }
 
+//==============================================================================
+
+static void telemetryRecordFree(gpointer data){
+    
+    TelemetryRecord *record = (TelemetryRecord*)data;
+    
+    if (record == NULL)
+        return;
+    
+    g_free(record->text);
+    g_free(record);
+}
 
 //==============================================================================
 
-static void verifyAllElementsCreated(Gsththstreamsrc *hthstreamsrc){
+static void clearTelemetryRecords(Gsththstreamsrc *hthstreamsrc){
     
-    /**
-     * Verify that all the internal plugins are created properly
-     */
+    g_mutex_lock(&hthstreamsrc->telemetryLock);
+    g_queue_clear_full(&hthstreamsrc->telemetryRecords, telemetryRecordFree);
+    telemetryRecordFree(hthstreamsrc->currentTelemetry);
+    hthstreamsrc->currentTelemetry = NULL;
+    g_mutex_unlock(&hthstreamsrc->telemetryLock);
+}
+
+//==============================================================================
+
+static guint getBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch, GstElement **elements[MAX_BRANCH_ELEMENTS]){
     
-    gboolean allElementsCreated; /**< Boolean that stores the function return values*/
+    guint elementsCount = 0;
     
-    allElementsCreated = hthstreamsrc->plugin_theora_dec
-        && hthstreamsrc->plugin_video_convert
-        && hthstreamsrc->plugin_vorbis_dec
-        && hthstreamsrc->plugin_audio_convert
-        && hthstreamsrc->plugin_audio_resample
-        && hthstreamsrc->plugin_identity
-        && hthstreamsrc->plugin_audio_queue
-        && hthstreamsrc->plugin_video_queue
-        && hthstreamsrc->plugin_text_queue
-        && hthstreamsrc->plugin_matroska_demux
-        && hthstreamsrc->plugin_udp_src;
+    switch (branch) {
+        case BRANCH_VIDEO:
+            elements[elementsCount++] = &hthstreamsrc->plugin_video_queue;
+            elements[elementsCount++] = &hthstreamsrc->plugin_video_dec;
+            elements[elementsCount++] = &hthstreamsrc->plugin_video_convert;
+            break;
     
-    if(!allElementsCreated){
-        printf (RED "One element could not be created\n" RESET);
-        exit(EXIT_ELEMENT_CREATION_FAILURE);
+        case BRANCH_AUDIO:
+            elements[elementsCount++] = &hthstreamsrc->plugin_audio_queue;
+            elements[elementsCount++] = &hthstreamsrc->plugin_audio_dec;
+            elements[elementsCount++] = &hthstreamsrc->plugin_audio_convert;
+            elements[elementsCount++] = &hthstreamsrc->plugin_audio_resample;
+            break;
+    
+        case BRANCH_TEXT:
+            elements[elementsCount++] = &hthstreamsrc->plugin_text_queue;
+            elements[elementsCount++] = &hthstreamsrc->plugin_identity;
+            break;
+    
+        default:
+            break;
+    }
+    
+    return elementsCount;
+}
+
+//==============================================================================
+
+static GstHthBranch *getBranchState(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return &hthstreamsrc->videoBranch;
+        case BRANCH_AUDIO:
+            return &hthstreamsrc->audioBranch;
+        default:
+            return &hthstreamsrc->textBranch;
+    }
+}
+
+//==============================================================================
+
+static GstPad *getBranchGhostPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return hthstreamsrc->videoSrcPad;
+        case BRANCH_AUDIO:
+            return hthstreamsrc->audioSrcPad;
+        default:
+            return hthstreamsrc->textSrcPad;
+    }
+}
+
+//==============================================================================
+
+static GstPad *getBranchEntrySrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return hthstreamsrc->videoEntrySrcPad;
+        case BRANCH_AUDIO:
+            return hthstreamsrc->audioEntrySrcPad;
+        default:
+            return hthstreamsrc->textEntrySrcPad;
+    }
+}
+
+//==============================================================================
+
+static GstPad *getBranchEntrySinkPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return hthstreamsrc->videoEntrySinkPad;
+        case BRANCH_AUDIO:
+            return hthstreamsrc->audioEntrySinkPad;
+        default:
+            return hthstreamsrc->textEntrySinkPad;
+    }
+}
+
+//==============================================================================
+
+static GstPad *getBranchLastSrcPad(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    if (elementsCount == 0 || *elements[elementsCount - 1] == NULL)
+        return NULL;
+    
+    return gst_element_get_static_pad (*elements[elementsCount - 1], "src");
+}
+
+//==============================================================================
+
+static HthStreamBranch findElementBranch(Gsththstreamsrc *hthstreamsrc, GstObject *object){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    HthStreamBranch branch;
+    guint elementsCount;
+    guint i;
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+        for (i = 0; i < elementsCount; i++) {
+            if (*elements[i] != NULL && object == GST_OBJECT(*elements[i])) {
+                GST_OBJECT_UNLOCK(hthstreamsrc);
+                return branch;
+            }
+        }
+    }
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    return BRANCH_NONE;
+}
+
+//==============================================================================
+
+static void gst_hthstreamsrc_handle_message (GstBin *bin, GstMessage *message){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (bin);
+    HthStreamBranch branch;
+    GstHthBranchAction action;
+    gchar *senderKey;
+    GError *error;
+    gchar *debug;
+    
+    /** Before the task of the child starts, the message is still forwarded */
+    if (hthstreamsrc->sharedTaskPool)
+        gst_hth_task_pool_handle_message(message);
+    
+    /** Posted by the streaming thread itself, before its loop */
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_STREAM_STATUS)
+        setupStreamingThread(hthstreamsrc, message);
+    
+    if ((GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR || GST_MESSAGE_TYPE(message) == GST_MESSAGE_WARNING)
+        && isDemuxer(GST_MESSAGE_SRC(message)))
+        gst_hth_receive_stats_count_demux_error(hthstreamsrc->receiveStats);
+    
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_ERROR) {
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    /** A failed sender chain is dropped, the other senders keep going */
+    senderKey = findSenderKey(hthstreamsrc, GST_MESSAGE_SRC(message));
+    if (senderKey != NULL) {
+        
+        gst_message_parse_error(message, &error, &debug);
+        printf(RED "Sender %s failed: %s, removing it \n" RESET, senderKey, error->message);
+        
+        gst_element_post_message(GST_ELEMENT(hthstreamsrc),
+                                 gst_message_new_warning(GST_OBJECT(hthstreamsrc), error, debug));
+        g_error_free(error);
+        g_free(debug);
+        
+        gst_element_call_async(GST_ELEMENT(hthstreamsrc), cb_forgetSender, senderKey, g_free);
+        gst_message_unref(message);
+        return;
+    }
+    
+    /** Errors of udpsrc or the demuxer stop the whole element */
+    branch = findElementBranch(hthstreamsrc, GST_MESSAGE_SRC(message));
+    if (branch == BRANCH_NONE) {
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    action = gst_hth_branch_fail(getBranchState(hthstreamsrc, branch));
+    if (action == GST_HTH_BRANCH_GIVE_UP) {
+        printf(RED "%s branch keeps failing, giving up \n" RESET, getBranchState(hthstreamsrc, branch)->name);
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    if (action == GST_HTH_BRANCH_REBUILD) {
+    
+        gst_message_parse_error(message, &error, &debug);
+        printf(RED "%s branch failed: %s, rebuilding \n" RESET, getBranchState(hthstreamsrc, branch)->name, error->message);
+    
+        /** The application still gets to know about the failure */
+        gst_element_post_message(GST_ELEMENT(hthstreamsrc),
+                                 gst_message_new_warning(GST_OBJECT(hthstreamsrc), error, debug));
+        g_error_free(error);
+        g_free(debug);
+    
+        gst_element_call_async(GST_ELEMENT(hthstreamsrc), cb_rebuildBranch, GINT_TO_POINTER(branch), NULL);
+    }
+    
+    gst_message_unref(message);
+}
+
+//==============================================================================
+
+static void cb_rebuildBranch(GstElement *element, gpointer user_data){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (element);
+    HthStreamBranch branch = (HthStreamBranch) GPOINTER_TO_INT(user_data);
+    GstHthBranch *branchState = getBranchState(hthstreamsrc, branch);
+    GstPad *lastSrcPad;
+    
+    printf(YELLOW "Rebuilding the %s branch \n" RESET, branchState->name);
+    
+    if (!rebuildBranchElements(hthstreamsrc, branch))
+        return;
+    
+    /** The restore ends with the first buffer leaving the element */
+    lastSrcPad = getBranchLastSrcPad(hthstreamsrc, branch);
+    gst_hth_branch_rebuilt(branchState, lastSrcPad);
+    gst_object_unref(lastSrcPad);
+}
+
+//==============================================================================
+
+static gboolean rebuildBranchElements(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstHthBranch *branchState = getBranchState(hthstreamsrc, branch);
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    
+    teardownBranch(hthstreamsrc, branch);
+    
+    createBranchElements(hthstreamsrc, branch);
+    if (!verifyBranchElementsCreated(hthstreamsrc, branch)) {
+        teardownBranch(hthstreamsrc, branch);
+        GST_ELEMENT_ERROR (hthstreamsrc, CORE, FAILED, ("The %s branch could not be rebuilt", branchState->name), (NULL));
+        return FALSE;
+    }
+    addBranchElementsToBin(hthstreamsrc, branch);
+    if (!linkBranchElements(hthstreamsrc, branch) || !setBranchSrcPad(hthstreamsrc, branch)) {
+        teardownBranch(hthstreamsrc, branch);
+        GST_ELEMENT_ERROR (hthstreamsrc, CORE, FAILED, ("The %s branch could not be rebuilt", branchState->name), (NULL));
+        return FALSE;
+    }
+    setBranchTelemetry(hthstreamsrc, branch);
+    
+    /** The queue comes first in every branch */
+    getBranchElements(hthstreamsrc, branch, elements);
+    watchBranchMemory(hthstreamsrc, *elements[0], branch);
+    watchBranchReceiveStats(hthstreamsrc, branch);
+    if (hthstreamsrc->latencyTracing)
+        traceBranchLatency(hthstreamsrc, branch);
+    
+    syncBranchStates(hthstreamsrc, branch);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gint getPadCodec(GstPad *pad){
+    
+    GstCaps *caps;
+    const gchar *mediaType;
+    gint codec = -1;
+    guint i;
+    
+    caps = gst_pad_get_current_caps(pad);
+    if (caps == NULL)
+        return -1;
+    
+    mediaType = gst_structure_get_name(gst_caps_get_structure(caps, 0));
+    for (i = 0; codecDecoders[i].mediaType != NULL; i++) {
+        if (strcmp(codecDecoders[i].mediaType, mediaType) == 0) {
+            codec = i;
+            break;
+        }
+    }
+    
+    gst_caps_unref(caps);
+    
+    return codec;
+}
+
+//==============================================================================
+
+static void configureDecoder(GstElement *decoder){
+    
+    GstElementFactory *factory;
+    
+    if (decoder == NULL)
+        return;
+    
+    /** A lost packet is rebuilt from the FEC data of the next one, or concealed when both are lost */
+    factory = gst_element_get_factory(decoder);
+    if (factory != NULL && strcmp(gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)), "opusdec") == 0)
+        g_object_set(G_OBJECT(decoder), "use-inband-fec", TRUE, "plc", TRUE, NULL);
+}
+
+//==============================================================================
+
+static void selectBranchDecoder(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch, GstPad *pad){
+    
+    const gchar **decoder = branch == BRANCH_VIDEO ? &hthstreamsrc->videoDecoder : &hthstreamsrc->audioDecoder;
+    gint codec = getPadCodec(pad);
+    
+    /** Unknown codecs go to the current decoder, which refuses them */
+    if (codec < 0 || strcmp(*decoder, codecDecoders[codec].factory) == 0)
+        return;
+    
+    printf(YELLOW "%s track is %s, rebuilding the branch with %s \n" RESET, getBranchState(hthstreamsrc, branch)->name,
+           codecDecoders[codec].mediaType, codecDecoders[codec].factory);
+    
+    /** No buffer went into the branch yet, the elements are replaced as they are */
+    *decoder = codecDecoders[codec].factory;
+    rebuildBranchElements(hthstreamsrc, branch);
+}
+
+//==============================================================================
+
+static void teardownBranch(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstElement *element;
+    guint elementsCount;
+    guint i;
+    
+    untraceBranchLatency(hthstreamsrc, branch);
+    
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+    
+        GST_OBJECT_LOCK(hthstreamsrc);
+        element = *elements[i];
+        *elements[i] = NULL;
+        GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+        if (element == NULL)
+            continue;
+    
+        /** Removing the element unlinks it from the entry pad and the ghost pad */
+        gst_element_set_state(element, GST_STATE_NULL);
+        if (GST_OBJECT_PARENT(element) != NULL)
+            gst_bin_remove(GST_BIN(hthstreamsrc), element);
+        else
+            gst_object_unref(element);
+    }
+}
+
+//==============================================================================
+
+static void syncBranchStates(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    
+    /** Downstream first, so no element pushes into one that is not running */
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    while (elementsCount > 0) {
+        elementsCount--;
+        gst_element_sync_state_with_parent(*elements[elementsCount]);
+    }
+}
+
+//==============================================================================
+
+static void setBranchTelemetry(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstPad *queueSinkPad;
+    GstPad *decoderSrcPad;
+    
+    if (branch != BRANCH_VIDEO)
+        return;
+    
+    queueSinkPad = gst_element_get_static_pad (hthstreamsrc->plugin_video_queue, "sink");
+    gst_pad_add_probe(queueSinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_frameRecordProbe, hthstreamsrc, NULL);
+    gst_object_unref(queueSinkPad);
+    
+    /** Ahead of videoconvert, the frames still have the planar format of the decoder; the metas are copied through it */
+    decoderSrcPad = gst_element_get_static_pad (hthstreamsrc->plugin_video_dec, "src");
+    gst_pad_add_probe(decoderSrcPad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                      cb_videoTelemetryProbe, hthstreamsrc, NULL);
+    gst_object_unref(decoderSrcPad);
+}
+
+//==============================================================================
+
+static GstStructure *createStatsStructure(Gsththstreamsrc *hthstreamsrc){
+    
+    GstStructure *stats = gst_structure_new_empty("hthstreamsrc-stats");
+    
+    gst_hth_branch_append_stats(&hthstreamsrc->videoBranch, stats);
+    gst_hth_branch_append_stats(&hthstreamsrc->audioBranch, stats);
+    gst_hth_branch_append_stats(&hthstreamsrc->textBranch, stats);
+    gst_hth_task_pool_append_stats(stats);
+    gst_hth_jitter_append_stats(&hthstreamsrc->videoJitter, stats);
+    gst_hth_jitter_append_stats(&hthstreamsrc->audioJitter, stats);
+    gst_hth_jitter_append_stats(&hthstreamsrc->textJitter, stats);
+    gst_hth_memory_append_stats(hthstreamsrc->memory, stats);
+    gst_hth_latency_append_stats(hthstreamsrc->latency, stats);
+    gst_hth_receive_stats_append(hthstreamsrc->receiveStats, stats);
+    
+    if (usesReceiver(hthstreamsrc)) {
+        gst_hth_receiver_append_stats(hthstreamsrc->receiver, stats);
+        gst_structure_set(stats, "sender-queue-drops", G_TYPE_UINT, (guint) g_atomic_int_get(&hthstreamsrc->senderQueueDrops), NULL);
+    }
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    if (hthstreamsrc->capture != NULL)
+        gst_hth_capture_append_stats(hthstreamsrc->capture, stats);
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    gst_hth_overlay_append_stats(hthstreamsrc->overlay, stats);
+    
+    if (hthstreamsrc->plugin_impairment != NULL)
+        gst_hth_impairment_append_stats(hthstreamsrc->plugin_impairment, stats);
+    
+    return stats;
+}
+
+//==============================================================================
+
+static void loadSenderFactories(void){
+    
+    HthStreamBranch branch;
+    guint i;
+    
+    demuxFactory = gst_element_factory_find("matroskademux");
+    
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        for (i = 0; i < MAX_BRANCH_ELEMENTS && branchFactories[branch][i] != NULL; i++)
+            branchFactoryCache[branch][i] = gst_element_factory_find(branchFactories[branch][i]);
+    }
+    
+    for (i = 0; codecDecoders[i].mediaType != NULL; i++)
+        decoderFactoryCache[i] = gst_element_factory_find(codecDecoders[i].factory);
+}
+
+//==============================================================================
+
+static GstElement *createSenderElement(GstElementFactory *factory){
+    
+    if (factory == NULL)
+        return NULL;
+    
+    return gst_element_factory_create(factory, NULL);
+}
+
+//==============================================================================
+
+static const gchar *getBranchPadPrefix(HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return "video_src";
+        case BRANCH_AUDIO:
+            return "audio_src";
+        default:
+            return "text_src";
+    }
+}
+
+//==============================================================================
+
+static HthStreamBranch getDemuxPadBranch(const gchar *padName){
+    
+    if (strncmp(padName, VIDEO_PREFIX, VIDEO_PREFIX_LEN) == PREFIX_CMP_SUCCESS)
+        return BRANCH_VIDEO;
+    if (strncmp(padName, AUDIO_PREFIX, AUDIO_PREFIX_LEN) == PREFIX_CMP_SUCCESS)
+        return BRANCH_AUDIO;
+    if (strncmp(padName, TEXT_PREFIX, TEXT_PREFIX_LEN) == PREFIX_CMP_SUCCESS)
+        return BRANCH_TEXT;
+    
+    return BRANCH_NONE;
+}
+
+//==============================================================================
+
+static gpointer cb_senderNew(const gchar *key, guint worker, gpointer userData){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC(userData);
+    SenderChain *chain;
+    GstStructure *added;
+    gint64 setupStart = g_get_monotonic_time();
+    GstClockTime setupTime;
+    
+    chain = createSenderChain(hthstreamsrc, key);
+    if (chain == NULL)
+        return NULL;
+    
+    /** The decoders are created later, when the demuxer finds the tracks */
+    setupTime = (g_get_monotonic_time() - setupStart) * GST_USECOND;
+    printf(GREEN "New sender %s on receive thread %u, setup %" G_GUINT64_FORMAT " us \n" RESET,
+           key, worker, GST_TIME_AS_USECONDS(setupTime));
+    
+    added = gst_structure_new("hth-sender-added",
+                              "sender", G_TYPE_STRING, key,
+                              "receive-thread", G_TYPE_UINT, worker,
+                              "setup-time", G_TYPE_UINT64, setupTime,
+                              NULL);
+    gst_element_post_message(GST_ELEMENT(hthstreamsrc), gst_message_new_element(GST_OBJECT(hthstreamsrc), added));
+    
+    return chain;
+}
+
+//==============================================================================
+
+static GstFlowReturn cb_senderPacket(gpointer sender, GstBuffer *buffer, gpointer userData){
+    
+    SenderChain *chain = (SenderChain*) sender;
+    
+    /** The receive thread is the streaming thread of the demuxer, cb_senderQueueProbe keeps it from blocking */
+    return gst_pad_push(chain->feedPad, buffer);
+}
+
+//==============================================================================
+
+static void cb_senderRemoved(gpointer sender, gpointer userData){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC(userData);
+    
+    /** The element is stopping, the receive threads are already joined */
+    if (hthstreamsrc->receiverStopping) {
+        removeSenderChain(hthstreamsrc, (SenderChain*) sender);
+        return;
     }
     
+    gst_element_call_async(GST_ELEMENT(hthstreamsrc), cb_removeSenderChain, sender, NULL);
+}
+
+//==============================================================================
+
+static void cb_senderEnd(gpointer sender, gpointer userData){
+    
+    SenderChain *chain = (SenderChain*) sender;
+    
+    /** The demuxer forwards it to the pads of the sender */
+    gst_pad_push_event(chain->feedPad, gst_event_new_eos());
 }
 
 //==============================================================================
 
-static void setElementsPropsValues(Gsththstreamsrc *hthstreamsrc){
-    
-    /**
-     * Configure the streaming capabilities filter
-     */
-    g_object_set (hthstreamsrc->plugin_udp_src, "port", hthstreamsrc->port, NULL);
+static gboolean usesReceiver(Gsththstreamsrc *hthstreamsrc){
     
+    return hthstreamsrc->receiveThreads > 0 || hthstreamsrc->replayLocation != NULL;
 }
 
-
 //==============================================================================
 
-static void addElementsToBin(Gsththstreamsrc *hthstreamsrc){
+static SenderChain *createSenderChain(Gsththstreamsrc *hthstreamsrc, const gchar *key){
+    
+    SenderChain *chain;
+    GstPad *demuxSinkPad;
+    GstPadLinkReturn padLink_ok; /**< Stores the function return values with a specific format*/
+    GstEvent *streamStart;
+    GstCaps *caps;
+    GstSegment segment;
+    gchar *name;
+    
+    chain = g_new0(SenderChain, 1);
+    chain->hthstreamsrc = hthstreamsrc;
+    chain->key = g_strdup(key);
+    
+    /** gst-launch splits the pad names on dots */
+    chain->padSuffix = g_strdelimit(g_strdup(key), ".:", '_');
+    
+    name = g_strdup_printf("sender-%s", chain->padSuffix);
+    chain->bin = gst_bin_new(name);
+    g_free(name);
+    
+    chain->demux = createSenderElement(demuxFactory);
+    if (chain->demux == NULL) {
+        printf(RED "Demuxer of sender %s could not be created \n" RESET, key);
+        gst_object_unref(chain->bin);
+        g_free(chain->padSuffix);
+        g_free(chain->key);
+        g_free(chain);
+        return NULL;
+    }
     
-    /**
-    * Add elements to the bin hthstreamsrc
-    */
+    gst_bin_add(GST_BIN(chain->bin), chain->demux);
+    g_signal_connect(chain->demux, "pad-added", G_CALLBACK(cb_senderDemuxPadAdded), chain);
     
-    gst_bin_add_many(GST_BIN(hthstreamsrc) ,
-                     GST_ELEMENT(hthstreamsrc->plugin_theora_dec),
-                     GST_ELEMENT(hthstreamsrc->plugin_video_convert),
-                     GST_ELEMENT(hthstreamsrc->plugin_vorbis_dec),
-                     GST_ELEMENT(hthstreamsrc->plugin_audio_convert),
-                     GST_ELEMENT(hthstreamsrc->plugin_audio_resample),
-                     GST_ELEMENT(hthstreamsrc->plugin_identity),
-                     GST_ELEMENT(hthstreamsrc->plugin_video_queue),
-                     GST_ELEMENT(hthstreamsrc->plugin_audio_queue),
-                     GST_ELEMENT(hthstreamsrc->plugin_text_queue),
-                     GST_ELEMENT(hthstreamsrc->plugin_matroska_demux),
-                     GST_ELEMENT(hthstreamsrc->plugin_udp_src),
-                     NULL);
+    /** A timed out chain with the same key may still be waiting for its removal */
+    if (!gst_bin_add(GST_BIN(hthstreamsrc), chain->bin)) {
+        gst_object_unref(chain->bin);
+        g_free(chain->padSuffix);
+        g_free(chain->key);
+        g_free(chain);
+        return NULL;
+    }
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    hthstreamsrc->senderChains = g_list_prepend(hthstreamsrc->senderChains, chain);
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    /** The receive thread pushes the datagrams into the demuxer through this pad */
+    name = g_strdup_printf("feed_%s", chain->padSuffix);
+    chain->feedPad = gst_pad_new(name, GST_PAD_SRC);
+    g_free(name);
+    gst_pad_set_active(chain->feedPad, TRUE);
+    
+    demuxSinkPad = gst_element_get_static_pad(chain->demux, "sink");
+    padLink_ok = gst_pad_link(chain->feedPad, demuxSinkPad);
+    gst_object_unref(demuxSinkPad);
+    if (padLink_ok != GST_PAD_LINK_OK)
+        printf(RED "Feed pad of sender %s linking with demuxer fails \n" RESET, key);
+    
+    gst_element_sync_state_with_parent(chain->bin);
+    
+    /** Sticky events of the byte stream, the demuxer gets them with the first datagram */
+    streamStart = gst_event_new_stream_start(chain->key);
+    gst_event_set_group_id(streamStart, gst_util_group_id_next());
+    gst_pad_push_event(chain->feedPad, streamStart);
+    
+    caps = gst_caps_new_empty_simple("video/x-matroska");
+    gst_pad_push_event(chain->feedPad, gst_event_new_caps(caps));
+    gst_caps_unref(caps);
+    
+    gst_segment_init(&segment, GST_FORMAT_BYTES);
+    gst_pad_push_event(chain->feedPad, gst_event_new_segment(&segment));
+    
+    return chain;
 }
 
 //==============================================================================
 
-static void linkBinElements(Gsththstreamsrc *hthstreamsrc){
+static void cb_senderDemuxPadAdded(GstElement *demuxer, GstPad *pad, gpointer user_data){
     
+    SenderChain *chain = (SenderChain*) user_data;
+    HthStreamBranch branch;
+    gchar *padName;
     
-    gboolean link_ok; /**< Boolean that stores the function return values*/
+    padName = gst_pad_get_name(pad);
+    branch = getDemuxPadBranch(padName);
+    
+    /** Only the first track of each type is output */
+    if (branch != BRANCH_NONE && chain->srcPads[branch] == NULL) {
+        if (createSenderBranch(chain, branch, pad))
+            printf(GREEN "Linked pad %s of sender %s \n" RESET, padName, chain->key);
+        else
+            printf(RED "Pad %s of sender %s could not be linked \n" RESET, padName, chain->key);
+    }
     
-    /** link udp src and matroska demux*/
-    link_ok = gst_element_link(hthstreamsrc->plugin_udp_src, hthstreamsrc->plugin_matroska_demux);
-    if (!link_ok){
-        printf(RED "UDP src fail linking pads with matroska demuxer" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
+    g_free(padName);
+}
+
+//==============================================================================
+
+static gboolean createSenderBranch(SenderChain *chain, HthStreamBranch branch, GstPad *demuxPad){
+    
+    Gsththstreamsrc *hthstreamsrc = chain->hthstreamsrc;
+    GstElement *elements[MAX_BRANCH_ELEMENTS];
+    GstPadTemplate *padTemplate;
+    GstPad *queueSinkPad;
+    GstPad *lastSrcPad;
+    GstPad *chainPad;
+    GstPad *srcPad;
+    GstPadLinkReturn padLink_ok; /**< Stores the function return values with a specific format*/
+    GstElementFactory *factory;
+    guint elementsCount;
+    guint i;
+    gchar *name;
+    gint codec = branch != BRANCH_TEXT ? getPadCodec(demuxPad) : -1;
+    
+    /** Same elements as the branches of the single sender mode, with the decoder of the track */
+    for (elementsCount = 0; elementsCount < MAX_BRANCH_ELEMENTS && branchFactories[branch][elementsCount] != NULL; elementsCount++) {
+        factory = branchFactoryCache[branch][elementsCount];
+        if (elementsCount == DECODER_POSITION && codec >= 0)
+            factory = decoderFactoryCache[codec];
+        elements[elementsCount] = createSenderElement(factory);
+        if (elements[elementsCount] == NULL) {
+            while (elementsCount > 0)
+                gst_object_unref(elements[--elementsCount]);
+            return FALSE;
+        }
     }
     
-    /** Link the neccesary elements for do a correct analysis of video flow */
-    link_ok = gst_element_link_many(hthstreamsrc->plugin_theora_dec,
-                                    hthstreamsrc->plugin_video_convert,
-                                    NULL);
+    configureDecoder(elements[DECODER_POSITION]);
     
-    if (!link_ok){
-        printf(RED "Fail linking video elements" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
-    }
+    /** The queue thread is set up like the one of the same branch of the single sender mode */
+    g_object_set_data(G_OBJECT(elements[0]), SENDER_BRANCH_KEY, GINT_TO_POINTER(branch + 1));
     
-    /** Link the neccesary elements for do a correct analysis of audio flow */
-    link_ok = gst_element_link_many(hthstreamsrc->plugin_vorbis_dec,
-                                    hthstreamsrc->plugin_audio_convert,
-                                    hthstreamsrc->plugin_audio_resample,
-                                    NULL);
+    /** Ahead of the memory probe, a buffer dropped at the full queue is never counted */
+    queueSinkPad = gst_element_get_static_pad(elements[0], "sink");
+    gst_pad_add_probe(queueSinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_senderQueueProbe, chain, NULL);
+    gst_object_unref(queueSinkPad);
+    watchBranchMemory(hthstreamsrc, elements[0], branch);
     
-    if (!link_ok){
-        printf(RED "Fail linking audio elements" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
+    /** From here the elements belong to the chain and are freed with it */
+    for (i = 0; i < elementsCount; i++)
+        gst_bin_add(GST_BIN(chain->bin), elements[i]);
+    
+    for (i = 0; i + 1 < elementsCount; i++) {
+        if (!gst_element_link(elements[i], elements[i + 1]))
+            return FALSE;
     }
     
+    /** Downstream first, so no element pushes into one that is not running */
+    for (i = elementsCount; i > 0; i--)
+        gst_element_sync_state_with_parent(elements[i - 1]);
+    
+    queueSinkPad = gst_element_get_static_pad(elements[0], "sink");
+    padLink_ok = gst_pad_link(demuxPad, queueSinkPad);
+    
+    /** The per-frame telemetry is only output in the single sender mode, the records are dropped */
+    if (branch == BRANCH_VIDEO)
+        gst_pad_add_probe(queueSinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_frameRecordProbe, NULL, NULL);
+    gst_object_unref(queueSinkPad);
+    if (padLink_ok != GST_PAD_LINK_OK)
+        return FALSE;
+    
+    /** Ghost pad of the chain bin, ghosted again on the element */
+    lastSrcPad = gst_element_get_static_pad(elements[elementsCount - 1], "src");
+    chainPad = gst_ghost_pad_new(getBranchPadPrefix(branch), lastSrcPad);
+    gst_object_unref(lastSrcPad);
+    gst_pad_set_active(chainPad, TRUE);
+    gst_element_add_pad(chain->bin, chainPad);
+    
+    name = g_strdup_printf("%s_%s", getBranchPadPrefix(branch), chain->padSuffix);
+    padTemplate = gst_element_class_get_pad_template(GST_ELEMENT_GET_CLASS(hthstreamsrc), senderPadTemplates[branch]);
+    srcPad = gst_ghost_pad_new_from_template(name, chainPad, padTemplate);
+    g_free(name);
+    
+    gst_pad_set_active(srcPad, TRUE);
+    chain->srcPads[branch] = srcPad;
+    gst_element_add_pad(GST_ELEMENT(hthstreamsrc), srcPad);
+    
+    return TRUE;
 }
 
 //==============================================================================
 
-static void createPluginGhostPads(Gsththstreamsrc *hthstreamsrc){
+static gboolean isQueueFull(GstElement *queue){
     
-    /**
-     * Create src ghost pads
-     */
+    guint buffers, maxBuffers;
+    guint bytes, maxBytes;
+    guint64 time, maxTime;
     
-    hthstreamsrc->audioSrcPad = gst_ghost_pad_new_no_target_from_template ("audio_src",
-                                                                            gst_static_pad_template_get (&src_factory));
-    if (!hthstreamsrc->audioSrcPad) {
-        printf(RED "hthstreamsrc audio src ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
-    }
+    g_object_get(queue,
+                 "current-level-buffers", &buffers, "max-size-buffers", &maxBuffers,
+                 "current-level-bytes", &bytes, "max-size-bytes", &maxBytes,
+                 "current-level-time", &time, "max-size-time", &maxTime,
+                 NULL);
     
-    hthstreamsrc->videoSrcPad = gst_ghost_pad_new_no_target_from_template ("video_src",
-                                                                            gst_static_pad_template_get (&src_factory));
-    if (!hthstreamsrc->videoSrcPad) {
-        printf(RED "hthstreamsrc video src ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
+    /** 0 disables a limit */
+    return (maxBuffers > 0 && buffers >= maxBuffers) ||
+           (maxBytes > 0 && bytes >= maxBytes) ||
+           (maxTime > 0 && time >= maxTime);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_senderQueueProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    SenderChain *chain = (SenderChain*) user_data;
+    GstElement *queue = GST_PAD_PARENT(pad);
+    HthStreamBranch branch = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(queue), SENDER_BRANCH_KEY)) - 1;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gboolean drop = isQueueFull(queue);
+    
+    /** Only the receive thread of the sender pushes here, the queue only empties in between */
+    if (branch == BRANCH_VIDEO) {
+        if (drop)
+            chain->waitKeyframe = TRUE;
+        else if (chain->waitKeyframe && !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+            chain->waitKeyframe = FALSE;
+        drop = chain->waitKeyframe;
     }
     
-    hthstreamsrc->textSrcPad = gst_ghost_pad_new_no_target_from_template ("text_src",
-                                                                           gst_static_pad_template_get (&src_factory));
-    if (!hthstreamsrc->textSrcPad) {
-        printf(RED "hthstreamsrc text src ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
-    }
+    if (!drop)
+        return GST_PAD_PROBE_OK;
+    
+    g_atomic_int_inc(&chain->hthstreamsrc->senderQueueDrops);
     
+    return GST_PAD_PROBE_DROP;
 }
 
 //==============================================================================
 
-static void setPluginSrcPads(Gsththstreamsrc *hthstreamsrc){
+static void cb_removeSenderChain(GstElement *element, gpointer user_data){
     
-    /**
-     * Link the ghost pads with the last element of the audio and video flow respectively
-     */
-    
-    gboolean setGhostPad_ok; /**< Boolean that stores the function return values*/
+    removeSenderChain(GST_HTHSTREAMSRC(element), (SenderChain*) user_data);
+}
+
+//==============================================================================
+
+static void removeSenderChain(Gsththstreamsrc *hthstreamsrc, SenderChain *chain){
     
-    /** Get static pads of the created elements*/
-    GstPad *videoSrcPad1 = gst_element_get_static_pad (hthstreamsrc->plugin_video_convert, "src");
-    if (videoSrcPad1 == NULL) {
-        printf(RED "Fail on get video src pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
-    }
+    HthStreamBranch branch;
     
-    GstPad *audioSrcPad1 = gst_element_get_static_pad (hthstreamsrc->plugin_audio_resample, "src");
-    if (audioSrcPad1 == NULL) {
-        printf(RED "Fail on get audio src pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
-    }
+    GST_OBJECT_LOCK(hthstreamsrc);
+    hthstreamsrc->senderChains = g_list_remove(hthstreamsrc->senderChains, chain);
+    GST_OBJECT_UNLOCK(hthstreamsrc);
     
-    GstPad *textSrcPad1 = gst_element_get_static_pad (hthstreamsrc->plugin_identity, "src");
-    if (textSrcPad1 == NULL) {
-        printf(RED "Fail on get audio src pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        if (chain->srcPads[branch] == NULL)
+            continue;
+        gst_pad_set_active(chain->srcPads[branch], FALSE);
+        gst_element_remove_pad(GST_ELEMENT(hthstreamsrc), chain->srcPads[branch]);
     }
     
-    /** Set ghost pads with the elements src pads*/
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsrc->videoSrcPad, videoSrcPad1);
-    if(!setGhostPad_ok){
-        printf(RED "Video ghost pad could not be linked with element src pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
-    }
+    /** Removing the bin unlinks the feed pad */
+    gst_element_set_state(chain->bin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(hthstreamsrc), chain->bin);
     
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsrc->audioSrcPad, audioSrcPad1);
-    if(!setGhostPad_ok){
-        printf(RED "Audio ghost pad could not be linked with element src pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
-    }
+    gst_pad_set_active(chain->feedPad, FALSE);
+    gst_object_unref(chain->feedPad);
     
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsrc->textSrcPad, textSrcPad1);
-    if(!setGhostPad_ok){
-        printf(RED "Text ghost pad could not be linked with element src pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
-    }
+    printf(YELLOW "Sender %s removed \n" RESET, chain->key);
+    gst_element_post_message(GST_ELEMENT(hthstreamsrc),
+                             gst_message_new_element(GST_OBJECT(hthstreamsrc),
+                                                     gst_structure_new("hth-sender-removed", "sender", G_TYPE_STRING, chain->key, NULL)));
     
+    g_free(chain->padSuffix);
+    g_free(chain->key);
+    g_free(chain);
 }
 
 //==============================================================================
 
-static void cb_matroskaDemuxPadAdded (GstElement *demuxer, GstPad* pad, Gsththstreamsrc *hthstreamsrc) {
+static gchar *findSenderKey(Gsththstreamsrc *hthstreamsrc, GstObject *object){
     
-    char *padName; /**< type of pad that ig going to be created*/
-    GstPad *sinkpad; /**< stores the sink pads of the audio and video queue*/
-    gboolean audioPadsLink_ok; /**< Boolean that stores the function return values*/
-    gboolean videoPadsLink_ok; /**< Boolean that stores the function return values*/
-    gboolean textPadsLink_ok; /**< Boolean that stores the function return values*/
-    GstPadLinkReturn audioPadLink_ok; /**< Stores the function return values with a specific format*/
-    GstPadLinkReturn videoPadLink_ok; /**< Stores the function return values with a specific format*/
-    GstPadLinkReturn textPadLink_ok; /**< Stores the function return values with a specific format*/
+    GstObject *child = object;
+    GList *item;
+    gchar *key = NULL;
     
-    padName = gst_pad_get_name(pad);
+    /** The child of the element that contains the object */
+    while (child != NULL && GST_OBJECT_PARENT(child) != GST_OBJECT(hthstreamsrc))
+        child = GST_OBJECT_PARENT(child);
     
-    printf ("Received new pad '%s' from '%s':\n", GST_PAD_NAME (pad), GST_ELEMENT_NAME (demuxer));
+    if (child == NULL)
+        return NULL;
     
-    if(strncmp(padName, VIDEO_PREFIX, VIDEO_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
-        
-        sinkpad = gst_element_get_static_pad(hthstreamsrc->plugin_video_queue, "sink");
-        if (sinkpad == NULL) {
-            printf(RED "Fail on get video queue sink pad \n" RESET);
-            exit(EXIT_GET_PAD_FAILURE);
-        }
-        
-        videoPadLink_ok = gst_pad_link(pad, sinkpad);
-        if (videoPadLink_ok != GST_PAD_LINK_OK){
-            printf(RED "New video pad linking fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
-        }
-        
-        videoPadsLink_ok = gst_element_link_pads(hthstreamsrc->plugin_video_queue, "src", hthstreamsrc->plugin_theora_dec, "sink");
-        if (!videoPadsLink_ok){
-            printf(RED "Video queue pad linking with decoder pad fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
-        }
-        
-        gst_object_unref(sinkpad);
-        
-        printf(GREEN "Linked pad %s of demuxer\n" RESET, padName);
-        
-    }else if(strncmp(padName, AUDIO_PREFIX, AUDIO_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
-        
-        sinkpad = gst_element_get_static_pad(hthstreamsrc->plugin_audio_queue, "sink");
-        if (sinkpad == NULL) {
-            printf(RED "Fail on get audio queue sink pad \n" RESET);
-            exit(EXIT_GET_PAD_FAILURE);
-        }
-        
-        audioPadLink_ok = gst_pad_link(pad, sinkpad);
-        if (audioPadLink_ok != GST_PAD_LINK_OK){
-            printf(RED "New audio pad linking fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
-        }
-        
-        audioPadsLink_ok = gst_element_link_pads(hthstreamsrc->plugin_audio_queue, "src", hthstreamsrc->plugin_vorbis_dec, "sink");
-        if (!audioPadsLink_ok){
-            printf(RED "Audio queue pad linking with decoder pad fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
-        }
-        
-        gst_object_unref(sinkpad);
-        
-        printf (GREEN "Linked pad %s of demuxer\n" RESET, padName);
-        
-    } else if (strncmp(padName, TEXT_PREFIX, TEXT_PREFIX_LEN) == PREFIX_CMP_SUCCESS){
-        
-        sinkpad = gst_element_get_static_pad(hthstreamsrc->plugin_text_queue, "sink");
-        if (sinkpad == NULL) {
-            printf(RED "Fail on get text queue sink pad \n" RESET);
-            exit(EXIT_GET_PAD_FAILURE);
-        }
-        
-        textPadLink_ok = gst_pad_link(pad, sinkpad);
-        if (textPadLink_ok != GST_PAD_LINK_OK){
-            printf(RED "New text pad linking fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
-        }
-        
-        textPadsLink_ok = gst_element_link_pads(hthstreamsrc->plugin_text_queue, "src", hthstreamsrc->plugin_identity, "sink");
-        if (!textPadsLink_ok){
-            printf(RED "Text queue pad linking with decoder pad fails" RESET);
-            exit(EXIT_PADS_LINKING_FAILURE);
+    GST_OBJECT_LOCK(hthstreamsrc);
+    for (item = hthstreamsrc->senderChains; item != NULL; item = item->next) {
+        if (GST_OBJECT(((SenderChain*) item->data)->bin) == child) {
+            key = g_strdup(((SenderChain*) item->data)->key);
+            break;
         }
-        
-        gst_object_unref(sinkpad);
-        
-        printf (GREEN "Linked pad %s of demuxer\n" RESET, padName);
     }
+    GST_OBJECT_UNLOCK(hthstreamsrc);
     
-    g_free (padName);
+    return key;
 }
 
 //==============================================================================
 
-int filter_handoff_callback(GstElement* filter, GstBuffer* buffer, void* user_data)
-{
-    
-    printf("cb_sink_handoff\n");
-    GstMapInfo info;
-    int i;
-    int numero;
-    if(!gst_buffer_map (buffer, &info, GST_MAP_READ))
-    {
-        printf("ERROR: MAPPING IS NOT VALID\n");
-    }
+static void cb_forgetSender(GstElement *element, gpointer user_data){
     
-    numero = info.size;
-    char *cadena = (char*)malloc(sizeof(char)*info.size);
-    strncpy(cadena, (char*)info.data, info.size);
-    printf("Cadena: %s - Longitud: %d \n",(unsigned char*)cadena, numero );
-    for(i=0; i < numero; i++){
-        printf("<%02x>", cadena[i]);
-    }
-    printf("\n");
-    gst_buffer_unmap (buffer, &info);
-    free(cadena);
-    return 0;
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC(element);
     
+    /** The sender is created again with its next datagram */
+    gst_hth_receiver_forget_sender(hthstreamsrc->receiver, (const gchar*) user_data);
 }
 
 //==============================================================================
 
 static GstStateChangeReturn gst_bin_change_state (GstElement *element, GstStateChange trans) {
     
-    //GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC (element);
+    GstStateChangeReturn ret;
     
     switch (trans)
     {
         case GST_STATE_CHANGE_NULL_TO_READY:
             printf(BLUE "GST_STATE_CHANGE_NULL_TO_READY\n" RESET);
+            if (hthstreamsrc->constructionFailed) {
+                GST_ELEMENT_ERROR (hthstreamsrc, CORE, FAILED, ("Internal elements could not be created or linked"), (NULL));
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            /** The receive threads own the port, udpsrc stays in NULL */
+            gst_element_set_locked_state(hthstreamsrc->plugin_udp_src, usesReceiver(hthstreamsrc));
             break;
         
         case GST_STATE_CHANGE_READY_TO_PAUSED:
@@ -794,7 +2965,65 @@ static GstStateChangeReturn gst_bin_change_state (GstElement *element, GstStateC
             break;
     }
     
-    return GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+    if (ret == GST_STATE_CHANGE_FAILURE)
+        return ret;
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            gst_hth_receive_stats_set_stream_ids(hthstreamsrc->receiveStats, hthstreamsrc->streamIdHeader);
+            if (!openCapture(hthstreamsrc))
+                return GST_STATE_CHANGE_FAILURE;
+            if (!usesReceiver(hthstreamsrc))
+                break;
+            hthstreamsrc->receiverStopping = FALSE;
+            gst_hth_receiver_set_sender_timeout(hthstreamsrc->receiver, hthstreamsrc->senderTimeout * GST_MSECOND);
+            gst_hth_receiver_set_stream_ids(hthstreamsrc->receiver, hthstreamsrc->streamIdHeader);
+            GST_OBJECT_LOCK(hthstreamsrc);
+            gst_hth_receiver_set_threads(hthstreamsrc->receiver, hthstreamsrc->transportCpus,
+                                         hthstreamsrc->rtPolicy, hthstreamsrc->rtPriority);
+            GST_OBJECT_UNLOCK(hthstreamsrc);
+            gst_hth_receiver_set_pool_memory(hthstreamsrc->receiver,
+                                             gst_hth_memory_get_limit(hthstreamsrc->memory) / 100 * RECEIVE_POOL_MEMORY_SHARE);
+            if (hthstreamsrc->replayLocation != NULL) {
+                if (!gst_hth_receiver_start_replay(hthstreamsrc->receiver, hthstreamsrc->replayLocation, hthstreamsrc->replayRealtime)) {
+                    GST_ELEMENT_ERROR (hthstreamsrc, RESOURCE, OPEN_READ, ("Could not replay the capture %s", hthstreamsrc->replayLocation), (NULL));
+                    closeCapture(hthstreamsrc);
+                    return GST_STATE_CHANGE_FAILURE;
+                }
+            }
+            else if (!gst_hth_receiver_start(hthstreamsrc->receiver, hthstreamsrc->port, hthstreamsrc->receiveThreads)) {
+                GST_ELEMENT_ERROR (hthstreamsrc, RESOURCE, OPEN_READ, ("Could not open the receive sockets on port %d", hthstreamsrc->port), (NULL));
+                closeCapture(hthstreamsrc);
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            /** The pools are preallocated, the queues get the rest of the budget */
+            gst_hth_memory_set_reserved(hthstreamsrc->memory, gst_hth_receiver_get_pool_memory(hthstreamsrc->receiver));
+            /** Live source, like udpsrc */
+            ret = GST_STATE_CHANGE_NO_PREROLL;
+            break;
+        
+        case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+            if (usesReceiver(hthstreamsrc))
+                ret = GST_STATE_CHANGE_NO_PREROLL;
+            break;
+        
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            clearTelemetryRecords(hthstreamsrc);
+            /** The sender chains are READY, the threads blocked in a push get FLUSHING */
+            hthstreamsrc->receiverStopping = TRUE;
+            gst_hth_receiver_stop(hthstreamsrc->receiver);
+            gst_hth_memory_set_reserved(hthstreamsrc->memory, 0);
+            /** udpsrc is READY too, nothing writes to the capture anymore */
+            closeCapture(hthstreamsrc);
+            break;
+        
+        default:
+            break;
+    }
+    
+    return ret;
 }
 
 
@@ -846,3 +3075,317 @@ VERSION,
 "GStreamer",
 "http://gstreamer.net/"
 )
+
+//==============================================================================
+
+static void setThreadString(Gsththstreamsrc *hthstreamsrc, gchar **field, const GValue *value){
+    
+    /** Applied when the next streaming thread starts */
+    GST_OBJECT_LOCK(hthstreamsrc);
+    g_free(*field);
+    *field = g_value_dup_string(value);
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+}
+
+//==============================================================================
+
+static void setupStreamingThread(Gsththstreamsrc *hthstreamsrc, GstMessage *message){
+    
+    GstStreamStatusType type;
+    GstElement *owner;
+    HthStreamBranch branch;
+    const gchar *name;
+    gchar **field;
+    gchar *cpus;
+    gchar *policy;
+    gint priority;
+    
+    gst_message_parse_stream_status(message, &type, &owner);
+    if (type != GST_STREAM_STATUS_TYPE_ENTER || owner == NULL)
+        return;
+    
+    if (owner == hthstreamsrc->plugin_udp_src) {
+        name = "hth-rx";
+        field = &hthstreamsrc->transportCpus;
+    } else {
+        
+        /** The queues of the sender chains carry their branch */
+        branch = findElementBranch(hthstreamsrc, GST_OBJECT(owner));
+        if (branch == BRANCH_NONE)
+            branch = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(owner), SENDER_BRANCH_KEY)) - 1;
+        
+        switch (branch) {
+            case BRANCH_VIDEO:
+                name = "hth-video-dec";
+                field = &hthstreamsrc->videoCpus;
+                break;
+            case BRANCH_AUDIO:
+                name = "hth-audio-dec";
+                field = &hthstreamsrc->audioCpus;
+                break;
+            case BRANCH_TEXT:
+                name = "hth-text-dec";
+                field = &hthstreamsrc->textCpus;
+                break;
+            default:
+                return;
+        }
+    }
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    cpus = g_strdup(*field);
+    policy = g_strdup(hthstreamsrc->rtPolicy);
+    priority = hthstreamsrc->rtPriority;
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    gst_hth_thread_setup(name, cpus, policy, priority);
+    
+    g_free(cpus);
+    g_free(policy);
+}
+
+//==============================================================================
+
+static void watchBranchJitter(Gsththstreamsrc *hthstreamsrc){
+    
+    /** The ghost src pads, the buffers leave the element from the branch threads */
+    gst_hth_jitter_watch_pad(&hthstreamsrc->videoJitter, hthstreamsrc->videoSrcPad);
+    gst_hth_jitter_watch_pad(&hthstreamsrc->audioJitter, hthstreamsrc->audioSrcPad);
+    gst_hth_jitter_watch_pad(&hthstreamsrc->textJitter, hthstreamsrc->textSrcPad);
+}
+
+//==============================================================================
+
+static void watchBranchMemory(Gsththstreamsrc *hthstreamsrc, GstElement *queue, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            gst_hth_memory_watch_queue(hthstreamsrc->memory, queue, GST_HTH_MEMORY_VIDEO);
+            break;
+        case BRANCH_AUDIO:
+            gst_hth_memory_watch_queue(hthstreamsrc->memory, queue, GST_HTH_MEMORY_AUDIO);
+            break;
+        case BRANCH_TEXT:
+            gst_hth_memory_watch_queue(hthstreamsrc->memory, queue, GST_HTH_MEMORY_TEXT);
+            break;
+        default:
+            break;
+    }
+}
+
+//==============================================================================
+
+static void setLatencyTracing(Gsththstreamsrc *hthstreamsrc, gboolean enable){
+    
+    HthStreamBranch branch;
+    
+    if (hthstreamsrc->latencyTracing == enable)
+        return;
+    
+    hthstreamsrc->latencyTracing = enable;
+    
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsrc->constructionFailed)
+        return;
+    
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        if (enable)
+            traceBranchLatency(hthstreamsrc, branch);
+        else
+            untraceBranchLatency(hthstreamsrc, branch);
+    }
+}
+
+//==============================================================================
+
+static void traceBranchLatency(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    const gchar *branchName = getBranchState(hthstreamsrc, branch)->name;
+    GstPad *entryPad;
+    GstPad *exitPad;
+    guint elementsCount;
+    guint i;
+    gchar *name;
+    
+    /** The datagrams have no frame timestamps, a frame is timed from its last datagram */
+    entryPad = gst_element_get_static_pad(hthstreamsrc->plugin_matroska_demux, "sink");
+    name = g_strdup_printf("%s-demux", branchName);
+    gst_hth_latency_add_stage(hthstreamsrc->latency, name, entryPad, getBranchEntrySinkPad(hthstreamsrc, branch), TRUE);
+    g_free(name);
+    gst_object_unref(entryPad);
+    
+    elementsCount = getBranchElements(hthstreamsrc, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+        
+        entryPad = gst_element_get_static_pad(*elements[i], "sink");
+        exitPad = gst_element_get_static_pad(*elements[i], "src");
+        name = g_strdup_printf("%s-%s", branchName, GST_OBJECT_NAME(gst_element_get_factory(*elements[i])));
+        
+        gst_hth_latency_add_stage(hthstreamsrc->latency, name, entryPad, exitPad, FALSE);
+        
+        g_free(name);
+        if (entryPad != NULL)
+            gst_object_unref(entryPad);
+        if (exitPad != NULL)
+            gst_object_unref(exitPad);
+    }
+    
+    name = g_strdup_printf("%s-total", branchName);
+    gst_hth_latency_add_stage(hthstreamsrc->latency, name, getBranchEntrySrcPad(hthstreamsrc, branch),
+                              getBranchGhostPad(hthstreamsrc, branch), FALSE);
+    g_free(name);
+}
+
+//==============================================================================
+
+static void untraceBranchLatency(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    gchar *prefix = g_strdup_printf("%s-", getBranchState(hthstreamsrc, branch)->name);
+    
+    gst_hth_latency_detach_stages(hthstreamsrc->latency, prefix);
+    g_free(prefix);
+}
+
+//==============================================================================
+
+static void watchReceiveStats(Gsththstreamsrc *hthstreamsrc){
+    
+    GstPad *transportPad;
+    HthStreamBranch branch;
+    
+    /** The impairment, when set, is between udpsrc and the demuxer */
+    transportPad = gst_element_get_static_pad(hthstreamsrc->plugin_matroska_demux, "sink");
+    gst_hth_receive_stats_watch_transport(hthstreamsrc->receiveStats, transportPad);
+    gst_object_unref(transportPad);
+    
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        /** The entry pads and the ghost pads outlive a rebuild */
+        gst_hth_receive_stats_watch_demux_pad(hthstreamsrc->receiveStats, getBranchEntrySinkPad(hthstreamsrc, branch));
+        gst_hth_receive_stats_watch_output(hthstreamsrc->receiveStats, (GstHthReceiveBranch) branch,
+                                           getBranchGhostPad(hthstreamsrc, branch));
+        watchBranchReceiveStats(hthstreamsrc, branch);
+    }
+}
+
+//==============================================================================
+
+static void watchBranchReceiveStats(Gsththstreamsrc *hthstreamsrc, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    
+    /** The queue comes first and the decoder second, the text branch has no decoder */
+    getBranchElements(hthstreamsrc, branch, elements);
+    gst_hth_receive_stats_watch_branch(hthstreamsrc->receiveStats, (GstHthReceiveBranch) branch, *elements[0],
+                                       branch == BRANCH_TEXT ? NULL : *elements[1]);
+}
+
+//==============================================================================
+
+static gboolean isDemuxer(GstObject *object){
+    
+    GstElementFactory *factory;
+    
+    if (!GST_IS_ELEMENT(object))
+        return FALSE;
+    
+    factory = gst_element_get_factory(GST_ELEMENT(object));
+    
+    return factory != NULL && strcmp(GST_OBJECT_NAME(factory), "matroskademux") == 0;
+}
+
+//==============================================================================
+
+static void watchCapture(Gsththstreamsrc *hthstreamsrc){
+    
+    GstPad *transportPad;
+    
+    /** The datagram as received, before the impairment and before its header is stripped */
+    transportPad = gst_element_get_static_pad(hthstreamsrc->plugin_udp_src, "src");
+    gst_pad_add_probe(transportPad, GST_PAD_PROBE_TYPE_BUFFER, cb_captureProbe, hthstreamsrc, NULL);
+    gst_object_unref(transportPad);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_captureProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsrc *hthstreamsrc = GST_HTHSTREAMSRC(user_data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstMapInfo map;
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    if (hthstreamsrc->capture != NULL && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        /** udpsrc does not tell the sender of the datagram */
+        gst_hth_capture_write(hthstreamsrc->capture, NULL, map.data, map.size);
+        gst_buffer_unmap(buffer, &map);
+    }
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static gboolean openCapture(Gsththstreamsrc *hthstreamsrc){
+    
+    GstHthCapture *capture;
+    
+    if (hthstreamsrc->captureLocation == NULL)
+        return TRUE;
+    
+    capture = gst_hth_capture_open(hthstreamsrc->captureLocation);
+    if (capture == NULL) {
+        GST_ELEMENT_ERROR (hthstreamsrc, RESOURCE, OPEN_WRITE, ("Could not create the capture %s", hthstreamsrc->captureLocation), (NULL));
+        return FALSE;
+    }
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    hthstreamsrc->capture = capture;
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    gst_hth_receiver_set_capture(hthstreamsrc->receiver, capture);
+    printf(GREEN "Capturing the datagrams to %s \n" RESET, hthstreamsrc->captureLocation);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void closeCapture(Gsththstreamsrc *hthstreamsrc){
+    
+    GstHthCapture *capture;
+    
+    GST_OBJECT_LOCK(hthstreamsrc);
+    capture = hthstreamsrc->capture;
+    hthstreamsrc->capture = NULL;
+    GST_OBJECT_UNLOCK(hthstreamsrc);
+    
+    if (capture == NULL)
+        return;
+    
+    gst_hth_receiver_set_capture(hthstreamsrc->receiver, NULL);
+    gst_hth_capture_close(capture);
+}
+
+//==============================================================================
+
+static void setImpairment(Gsththstreamsrc *hthstreamsrc, const gchar *description){
+    
+    if (hthstreamsrc->plugin_impairment != NULL) {
+        gst_hth_impairment_remove(GST_BIN(hthstreamsrc), hthstreamsrc->plugin_impairment,
+                                  hthstreamsrc->plugin_udp_src, hthstreamsrc->plugin_matroska_demux);
+        hthstreamsrc->plugin_impairment = NULL;
+    }
+    
+    g_free(hthstreamsrc->impairment);
+    hthstreamsrc->impairment = NULL;
+    
+    if (description == NULL || *description == '\0' || hthstreamsrc->constructionFailed)
+        return;
+    
+    hthstreamsrc->plugin_impairment = gst_hth_impairment_insert(GST_BIN(hthstreamsrc), hthstreamsrc->plugin_udp_src,
+                                                                hthstreamsrc->plugin_matroska_demux, description);
+    if (hthstreamsrc->plugin_impairment != NULL)
+        hthstreamsrc->impairment = g_strdup(description);
+}
@@ -47,6 +47,14 @@
 #define __GST_HTHSTREAMSRC_H__
 
 #include <gst/gst.h>
+
+#include "gsththbranch.h"
+#include "gsthththread.h"
+#include "gsththmemory.h"
+#include "gsththlatency.h"
+#include "gsththreceiver.h"
+#include "gsththreceivestats.h"
+#include "gsththoverlay.h"
     
     G_BEGIN_DECLS
 
@@ -74,10 +82,10 @@
         /** Video stream */
         GstElement *plugin_video_convert;   /**  takes an incoming stream of timestamped video frames
     									* It will produce a perfect stream that matches the source pad's framerate */
-        GstElement *plugin_theora_dec;   /** This element encodes raw video into a Theora stream */
+        GstElement *plugin_video_dec;   /** This element decodes the video track, theoradec, vp8dec or avdec_h264 */
         
         /** Audio stream */
-        GstElement *plugin_vorbis_dec;    /** This element decodes a raw float audio stream */
+        GstElement *plugin_audio_dec;    /** This element decodes the audio track, vorbisdec or opusdec */
         GstElement *plugin_audio_resample;
         GstElement *plugin_audio_convert; /** This element converts raw audio buffers between various possible formats */
         
@@ -97,12 +105,81 @@
         
         /** Demuxer */
         GstElement *plugin_matroska_demux; /** This element demuxes different input streams into a Matroska file */
+        GstPad *videoEntrySinkPad; /**< Linked to the demuxer pads, isolate the demuxer from the branch failures */
+        GstPad *videoEntrySrcPad;  /**< Linked to the branch queues, relinked when a branch is rebuilt */
+        GstPad *audioEntrySinkPad;
+        GstPad *audioEntrySrcPad;
+        GstPad *textEntrySinkPad;
+        GstPad *textEntrySrcPad;
         
         /** Plugin transport */
         GstElement *plugin_udp_src; /**< Plugin that receive UDP packets from the network */
         
         /** Destination port */
         gint port;
+        
+        /** Frame telemetry */
+        gboolean frameTelemetry; /**< Put the per-frame telemetry records back on the decoded frames */
+        GMutex telemetryLock; /**< Protects the telemetry records */
+        GQueue telemetryRecords; /**< Received records not applied yet, sorted by PTS */
+        gpointer currentTelemetry; /**< Last record applied to a video frame */
+        gint drawCaptureTime; /**< Draw the capture time of the records on the frames, atomic */
+        GstHthOverlay *overlay; /**< Glyph overlay drawing the capture time */
+
+        /** Decoders */
+        const gchar *videoDecoder; /**< Factory of plugin_video_dec, from the caps of the last video track */
+        const gchar *audioDecoder; /**< Factory of plugin_audio_dec */
+        
+        /** Branch rebuild */
+        gboolean constructionFailed; /**< Internal elements missing, the element fails to go to READY */
+        GstHthBranch videoBranch; /**< Restart bookkeeping of each branch */
+        GstHthBranch audioBranch;
+        GstHthBranch textBranch;
+        
+        /** Multi sender receive */
+        guint receiveThreads; /**< SO_REUSEPORT receive threads, 0 to use udpsrc */
+        guint senderTimeout; /**< Idle milliseconds before a sender is removed, 0 for never */
+        gboolean streamIdHeader; /**< Senders identified by the stream id header */
+        GstHthReceiver *receiver; /**< Receive engine, started in PAUSED */
+        GList *senderChains; /**< SenderChain of each sender, protected by the object lock */
+        gboolean receiverStopping; /**< The sender chains are removed synchronously */
+        gint senderQueueDrops; /**< Buffers of the senders dropped at their full branch queue, atomic */
+        
+        /** Capture and replay */
+        gchar *captureLocation; /**< File recording the received datagrams, NULL for none */
+        gchar *replayLocation; /**< Capture fed to the sender chains instead of the sockets, NULL for none */
+        gboolean replayRealtime; /**< The capture is replayed with its original timing */
+        GstHthCapture *capture; /**< Open from PAUSED, protected by the object lock */
+        
+        /** Impairment */
+        gchar *impairment; /**< Properties of hthimpair, NULL for none */
+        GstElement *plugin_impairment; /**< hthimpair between udpsrc and the demuxer, NULL for none */
+        
+        /** Shared task pool */
+        gboolean sharedTaskPool; /**< The streaming tasks of the children run on the shared pool */
+        
+        /** Streaming threads */
+        gchar *videoCpus; /**< CPU list of the video thread, NULL for all */
+        gchar *audioCpus; /**< CPU list of the audio thread, NULL for all */
+        gchar *textCpus; /**< CPU list of the text thread, NULL for all */
+        gchar *transportCpus; /**< CPU list of the transport threads, NULL for all */
+        gchar *rtPolicy; /**< other, fifo or rr */
+        gint rtPriority; /**< Priority with fifo or rr */
+        GstHthJitter videoJitter; /**< Jitter of the buffers leaving each branch */
+        GstHthJitter audioJitter;
+        GstHthJitter textJitter;
+        
+        /** Memory budget */
+        GstHthMemory *memory; /**< max-memory and the bytes charged by the queues and pools */
+        
+        /** Latency tracing */
+        gboolean latencyTracing; /**< Probes installed on the stages */
+        guint latencyInterval; /**< Milliseconds between two hth-latency messages */
+        GstHthLatency *latency; /**< Residency histograms of the stages */
+        
+        /** Receiver stats */
+        guint receiverStatsInterval; /**< Milliseconds between two hth-receiver-stats messages */
+        GstHthReceiveStats *receiveStats; /**< Counters of the transport, demuxer, decoders and output */
     };
 
 /**
@@ -0,0 +1,1047 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+/**
+ * SECTION:element-hthimpair
+ *
+ * Loss, delay, jitter, reordering, duplication and bandwidth cap of a
+ * network link, applied to the datagrams between matroskamux and udpsink
+ * or between udpsrc and matroskademux. The decisions come from a seeded
+ * generator, so the same input gives the same impairment.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 udpsrc port=xxxx ! hthimpair loss=1 delay=40 jitter=10 seed=7 ! matroskademux ! ...
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** impair plugin header */
+#include "gsththimpair.h" /**< For all elements of the plugin */
+
+/** gstreamer header file */
+#include <gst/gst.h> /**< For all gstreamer functions */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/**
+ * @brief Colors for printed messages
+ *
+ */
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state, playing state or close state*/
+#define YELLOW  "\033[1m\033[33m"   /** Pause state  */
+#define BLUE    "\033[1m\033[34m"   /** Ready state */
+#define WHITE   "\033[1m\033[37m"   /** Normal text of functions*/
+
+GST_DEBUG_CATEGORY_STATIC (gst_hthimpair_debug);
+#define GST_CAT_DEFAULT gst_hthimpair_debug
+
+//==============================================================================
+
+/**
+ * Parameters
+ */
+
+#define DEFAULT_LOSS                0.0 /**< No random loss */
+#define DEFAULT_BURST_ENTER         0.0 /**< Never in the bad state */
+#define DEFAULT_BURST_EXIT          25.0 /**< Bursts of 4 datagrams on average */
+#define DEFAULT_BURST_LOSS          100.0 /**< Everything is lost in the bad state */
+#define DEFAULT_DELAY               0 /**< No delay */
+#define DEFAULT_JITTER              0 /**< No jitter */
+#define DEFAULT_REORDER             0.0 /**< Order kept */
+#define DEFAULT_DUPLICATE           0.0 /**< No duplicates */
+#define DEFAULT_BANDWIDTH           0 /**< Unlimited */
+#define DEFAULT_LIMIT               1000 /**< Datagrams queued, like the netem default */
+#define DEFAULT_SEED                1 /**< Same impairment on every run */
+
+enum{
+    PROP_0,
+    PROP_LOSS,
+    PROP_BURST_ENTER,
+    PROP_BURST_EXIT,
+    PROP_BURST_LOSS,
+    PROP_DELAY,
+    PROP_JITTER,
+    PROP_REORDER,
+    PROP_DUPLICATE,
+    PROP_BANDWIDTH,
+    PROP_LIMIT,
+    PROP_SEED,
+    PROP_STATS
+};
+
+/**
+ * @struct ImpairItem
+ *
+ * @brief Buffer or serialized event waiting for its departure
+ *
+ */
+typedef struct {
+    gint64 departure; /**< Monotonic time to push it, in us */
+    GstMiniObject *object; /**< GstBuffer or GstEvent, owned */
+} ImpairItem;
+
+//==============================================================================
+
+/**
+ * @brief The capabilities of the inputs and outputs.
+ *
+ * Any datagram stream, the element does not look into the buffers
+ *
+ */
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+                                                                     GST_PAD_SINK,
+                                                                     GST_PAD_ALWAYS,
+                                                                     GST_STATIC_CAPS_ANY
+);
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+                                                                    GST_PAD_SRC,
+                                                                    GST_PAD_ALWAYS,
+                                                                    GST_STATIC_CAPS_ANY
+);
+
+//==============================================================================
+
+#define gst_hthimpair_parent_class parent_class
+G_DEFINE_TYPE (Gsththimpair, gst_hthimpair, GST_TYPE_ELEMENT);
+
+//==============================================================================
+
+/**
+ * @brief Set plugin's properties with new values
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value new property value
+ * @param pspec
+ */
+static void gst_hthimpair_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+
+/**
+ * @brief Obtain the values of the plugin's properties
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value
+ * @param pspec
+ */
+static void gst_hthimpair_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
+
+/**
+ * @brief Free the queue, the generator and the lock
+ *
+ * @param object The plugin instance
+ */
+static void gst_hthimpair_finalize (GObject * object);
+
+/**
+ * @brief Seed the generator when going to PAUSED
+ *
+ * @param element The plugin instance
+ * @param trans The state transition
+ * @return GstStateChangeReturn
+ */
+static GstStateChangeReturn gst_hthimpair_change_state (GstElement *element, GstStateChange trans);
+
+/**
+ * @brief Lose, duplicate and schedule a datagram
+ *
+ * Without delay, jitter nor bandwidth cap the datagram is pushed from the
+ * calling thread when nothing is waiting, otherwise the task pushes it.
+ *
+ * @param pad Sink pad
+ * @param parent The plugin instance
+ * @param buffer The datagram
+ * @return GstFlowReturn Return of the last push of the task
+ */
+static GstFlowReturn gst_hthimpair_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer);
+
+/**
+ * @brief Keep the serialized events behind the datagrams queued before them
+ *
+ * @param pad Sink pad
+ * @param parent The plugin instance
+ * @param event The event
+ * @return gboolean Event handled
+ */
+static gboolean gst_hthimpair_sink_event (GstPad *pad, GstObject *parent, GstEvent *event);
+
+/**
+ * @brief Add the delay to the latency of upstream
+ *
+ * @param pad Src pad
+ * @param parent The plugin instance
+ * @param query The query
+ * @return gboolean Query answered
+ */
+static gboolean gst_hthimpair_src_query (GstPad *pad, GstObject *parent, GstQuery *query);
+
+/**
+ * @brief Start and stop the task of the src pad
+ *
+ * @param pad Src pad
+ * @param parent The plugin instance
+ * @param mode Scheduling mode, only push
+ * @param active Activate or deactivate
+ * @return gboolean Task started or stopped
+ */
+static gboolean gst_hthimpair_src_activate_mode (GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active);
+
+/**
+ * @brief Task of the src pad, pushes the items when their departure comes
+ *
+ * @param user_data The plugin instance
+ */
+static void cb_pushLoop(gpointer user_data);
+
+/**
+ * @brief Decide if a datagram is lost with the Gilbert-Elliott model
+ *
+ * Always draws two numbers, so the decisions of the next datagrams don't
+ * depend on the state of this one.
+ *
+ * @param hthimpair The plugin instance, locked
+ * @return gboolean TRUE if the datagram is lost
+ */
+static gboolean isLost(Gsththimpair *hthimpair);
+
+/**
+ * @brief Departure time of a datagram that arrives now
+ *
+ * @param hthimpair The plugin instance, locked
+ * @param now Monotonic time, in us
+ * @param size Datagram size, for the bandwidth cap
+ * @return gint64 Monotonic departure time, in us
+ */
+static gint64 getDeparture(Gsththimpair *hthimpair, gint64 now, gsize size);
+
+/**
+ * @brief Queue an item, after the items that leave at the same time
+ *
+ * @param hthimpair The plugin instance, locked
+ * @param object Buffer or event, the ownership is taken
+ * @param departure Monotonic departure time, in us
+ * @return void
+ */
+static void queueItem(Gsththimpair *hthimpair, GstMiniObject *object, gint64 departure);
+
+/**
+ * @brief Drop every item waiting for its departure
+ *
+ * @param hthimpair The plugin instance, locked
+ * @return void
+ */
+static void clearQueue(Gsththimpair *hthimpair);
+
+/**
+ * @brief Whether the datagrams go straight through
+ *
+ * @param hthimpair The plugin instance, locked
+ * @return gboolean TRUE without delay, jitter nor bandwidth cap, and nothing waiting
+ */
+static gboolean isPassthrough(Gsththimpair *hthimpair);
+
+/**
+ * @brief Uniform draw between 0 and 100
+ *
+ * @param hthimpair The plugin instance, locked
+ * @return gdouble Percent
+ */
+static gdouble drawPercent(Gsththimpair *hthimpair);
+
+/**
+ * @brief Build the stats structure
+ *
+ * @param hthimpair The plugin instance
+ * @return GstStructure* hthimpair-stats structure
+ */
+static GstStructure *createStatsStructure(Gsththimpair *hthimpair);
+
+//==============================================================================
+
+/**
+ * @brief GObject vmethod implementations
+ * initialize the hthimpair class
+ *
+ */
+static void gst_hthimpair_class_init (GsththimpairClass * klass){
+    
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    
+    gobject_class = (GObjectClass *) klass;
+    gstelement_class = (GstElementClass *) klass;
+    
+    gobject_class->set_property = gst_hthimpair_set_property;
+    gobject_class->get_property = gst_hthimpair_get_property;
+    gobject_class->finalize = gst_hthimpair_finalize;
+    gstelement_class->change_state = gst_hthimpair_change_state;
+    
+    /** Install properties */
+    g_object_class_install_property (gobject_class, PROP_LOSS,
+                                     g_param_spec_double ("loss", "Loss",
+                                                          "Percent of the datagrams lost at random, in the good state of the burst model",
+                                                          0.0, 100.0, DEFAULT_LOSS,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BURST_ENTER,
+                                     g_param_spec_double ("burst-enter", "Burst enter",
+                                                          "Percent chance per datagram to start a loss burst (Gilbert-Elliott p), 0 disables the bursts",
+                                                          0.0, 100.0, DEFAULT_BURST_ENTER,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BURST_EXIT,
+                                     g_param_spec_double ("burst-exit", "Burst exit",
+                                                          "Percent chance per datagram to end a loss burst (Gilbert-Elliott r)",
+                                                          0.0, 100.0, DEFAULT_BURST_EXIT,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BURST_LOSS,
+                                     g_param_spec_double ("burst-loss", "Burst loss",
+                                                          "Percent of the datagrams lost during a burst",
+                                                          0.0, 100.0, DEFAULT_BURST_LOSS,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DELAY,
+                                     g_param_spec_uint ("delay", "Delay",
+                                                        "Milliseconds added to every datagram",
+                                                        0, G_MAXUINT / 1000, DEFAULT_DELAY,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_JITTER,
+                                     g_param_spec_uint ("jitter", "Jitter",
+                                                        "Milliseconds of uniform variation around the delay, more than the datagram spacing reorders them",
+                                                        0, G_MAXUINT / 1000, DEFAULT_JITTER,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_REORDER,
+                                     g_param_spec_double ("reorder", "Reorder",
+                                                          "Percent of the datagrams sent without the delay, ahead of the ones before them (needs delay)",
+                                                          0.0, 100.0, DEFAULT_REORDER,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DUPLICATE,
+                                     g_param_spec_double ("duplicate", "Duplicate",
+                                                          "Percent of the datagrams sent twice",
+                                                          0.0, 100.0, DEFAULT_DUPLICATE,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BANDWIDTH,
+                                     g_param_spec_uint ("bandwidth", "Bandwidth",
+                                                        "kbit/s of the link, the datagrams wait until the previous ones are sent. 0 for unlimited",
+                                                        0, G_MAXUINT, DEFAULT_BANDWIDTH,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_LIMIT,
+                                     g_param_spec_uint ("limit", "Limit",
+                                                        "Datagrams waiting for their departure, the next ones are dropped",
+                                                        1, G_MAXUINT, DEFAULT_LIMIT,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_SEED,
+                                     g_param_spec_uint ("seed", "Seed",
+                                                        "Seed of the random decisions, applied when going to PAUSED",
+                                                        0, G_MAXUINT, DEFAULT_SEED,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STATS,
+                                     g_param_spec_boxed ("stats", "Statistics",
+                                                         "Datagrams in and out, lost, dropped by the limit, duplicated and reordered",
+                                                         GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    
+    gst_element_class_set_details_simple(gstelement_class,
+                                         "hthimpair",
+                                         "Filter/Network",
+                                         "Seeded loss, burst loss, delay, jitter, reordering, duplication and bandwidth cap of datagrams",
+                                         "basultobd <<basultobd@gmail.com>>");
+    
+    gst_element_class_add_pad_template (gstelement_class,
+                                        gst_static_pad_template_get (&src_factory));
+    gst_element_class_add_pad_template (gstelement_class,
+                                        gst_static_pad_template_get (&sink_factory));
+}
+
+//==============================================================================
+
+static void gst_hthimpair_init (Gsththimpair *hthimpair){
+    
+    hthimpair->sinkPad = gst_pad_new_from_static_template (&sink_factory, "sink");
+    gst_pad_set_chain_function (hthimpair->sinkPad, GST_DEBUG_FUNCPTR(gst_hthimpair_chain));
+    gst_pad_set_event_function (hthimpair->sinkPad, GST_DEBUG_FUNCPTR(gst_hthimpair_sink_event));
+    GST_PAD_SET_PROXY_CAPS (hthimpair->sinkPad);
+    GST_PAD_SET_PROXY_ALLOCATION (hthimpair->sinkPad);
+    gst_element_add_pad (GST_ELEMENT (hthimpair), hthimpair->sinkPad);
+    
+    hthimpair->srcPad = gst_pad_new_from_static_template (&src_factory, "src");
+    gst_pad_set_activatemode_function (hthimpair->srcPad, GST_DEBUG_FUNCPTR(gst_hthimpair_src_activate_mode));
+    gst_pad_set_query_function (hthimpair->srcPad, GST_DEBUG_FUNCPTR(gst_hthimpair_src_query));
+    GST_PAD_SET_PROXY_CAPS (hthimpair->srcPad);
+    gst_element_add_pad (GST_ELEMENT (hthimpair), hthimpair->srcPad);
+    
+    hthimpair->loss = DEFAULT_LOSS;
+    hthimpair->burstEnter = DEFAULT_BURST_ENTER;
+    hthimpair->burstExit = DEFAULT_BURST_EXIT;
+    hthimpair->burstLoss = DEFAULT_BURST_LOSS;
+    hthimpair->delay = DEFAULT_DELAY;
+    hthimpair->jitter = DEFAULT_JITTER;
+    hthimpair->reorder = DEFAULT_REORDER;
+    hthimpair->duplicate = DEFAULT_DUPLICATE;
+    hthimpair->bandwidth = DEFAULT_BANDWIDTH;
+    hthimpair->limit = DEFAULT_LIMIT;
+    hthimpair->seed = DEFAULT_SEED;
+    
+    g_mutex_init(&hthimpair->lock);
+    g_cond_init(&hthimpair->cond);
+    hthimpair->rand = g_rand_new_with_seed(DEFAULT_SEED);
+    hthimpair->burstBad = FALSE;
+    g_queue_init(&hthimpair->queue);
+    hthimpair->linkFree = 0;
+    hthimpair->pushing = FALSE;
+    hthimpair->flushing = TRUE;
+    hthimpair->srcResult = GST_FLOW_FLUSHING;
+}
+
+//==============================================================================
+
+static void gst_hthimpair_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (object);
+    
+    /** Applied to the next datagram */
+    g_mutex_lock(&hthimpair->lock);
+    switch (prop_id) {
+        
+        case PROP_LOSS:
+            hthimpair->loss = g_value_get_double(value);
+            printf(GREEN "New loss: %.2f %% \n" RESET , hthimpair->loss);
+            break;
+        
+        case PROP_BURST_ENTER:
+            hthimpair->burstEnter = g_value_get_double(value);
+            printf(GREEN "New burst enter: %.2f %% \n" RESET , hthimpair->burstEnter);
+            break;
+        
+        case PROP_BURST_EXIT:
+            hthimpair->burstExit = g_value_get_double(value);
+            printf(GREEN "New burst exit: %.2f %% \n" RESET , hthimpair->burstExit);
+            break;
+        
+        case PROP_BURST_LOSS:
+            hthimpair->burstLoss = g_value_get_double(value);
+            printf(GREEN "New burst loss: %.2f %% \n" RESET , hthimpair->burstLoss);
+            break;
+        
+        case PROP_DELAY:
+            hthimpair->delay = g_value_get_uint(value);
+            printf(GREEN "New delay: %u ms \n" RESET , hthimpair->delay);
+            break;
+        
+        case PROP_JITTER:
+            hthimpair->jitter = g_value_get_uint(value);
+            printf(GREEN "New jitter: %u ms \n" RESET , hthimpair->jitter);
+            break;
+        
+        case PROP_REORDER:
+            hthimpair->reorder = g_value_get_double(value);
+            printf(GREEN "New reorder: %.2f %% \n" RESET , hthimpair->reorder);
+            break;
+        
+        case PROP_DUPLICATE:
+            hthimpair->duplicate = g_value_get_double(value);
+            printf(GREEN "New duplicate: %.2f %% \n" RESET , hthimpair->duplicate);
+            break;
+        
+        case PROP_BANDWIDTH:
+            hthimpair->bandwidth = g_value_get_uint(value);
+            printf(GREEN "New bandwidth: %u kbit/s \n" RESET , hthimpair->bandwidth);
+            break;
+        
+        case PROP_LIMIT:
+            hthimpair->limit = g_value_get_uint(value);
+            printf(GREEN "New limit: %u \n" RESET , hthimpair->limit);
+            break;
+        
+        case PROP_SEED:
+            hthimpair->seed = g_value_get_uint(value);
+            printf(GREEN "New seed: %u \n" RESET , hthimpair->seed);
+            break;
+        
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&hthimpair->lock);
+}
+
+//==============================================================================
+
+static void gst_hthimpair_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (object);
+    
+    if (prop_id == PROP_STATS) {
+        g_value_take_boxed (value, createStatsStructure(hthimpair));
+        return;
+    }
+    
+    g_mutex_lock(&hthimpair->lock);
+    switch (prop_id) {
+        case PROP_LOSS:
+            g_value_set_double (value, hthimpair->loss);
+            break;
+        case PROP_BURST_ENTER:
+            g_value_set_double (value, hthimpair->burstEnter);
+            break;
+        case PROP_BURST_EXIT:
+            g_value_set_double (value, hthimpair->burstExit);
+            break;
+        case PROP_BURST_LOSS:
+            g_value_set_double (value, hthimpair->burstLoss);
+            break;
+        case PROP_DELAY:
+            g_value_set_uint (value, hthimpair->delay);
+            break;
+        case PROP_JITTER:
+            g_value_set_uint (value, hthimpair->jitter);
+            break;
+        case PROP_REORDER:
+            g_value_set_double (value, hthimpair->reorder);
+            break;
+        case PROP_DUPLICATE:
+            g_value_set_double (value, hthimpair->duplicate);
+            break;
+        case PROP_BANDWIDTH:
+            g_value_set_uint (value, hthimpair->bandwidth);
+            break;
+        case PROP_LIMIT:
+            g_value_set_uint (value, hthimpair->limit);
+            break;
+        case PROP_SEED:
+            g_value_set_uint (value, hthimpair->seed);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&hthimpair->lock);
+}
+
+//==============================================================================
+
+static void gst_hthimpair_finalize (GObject * object){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (object);
+    
+    clearQueue(hthimpair);
+    g_rand_free(hthimpair->rand);
+    g_cond_clear(&hthimpair->cond);
+    g_mutex_clear(&hthimpair->lock);
+    
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+//==============================================================================
+
+static GstStateChangeReturn gst_hthimpair_change_state (GstElement *element, GstStateChange trans){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (element);
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            /** Every run starts from the same decisions */
+            g_mutex_lock(&hthimpair->lock);
+            g_rand_set_seed(hthimpair->rand, hthimpair->seed);
+            hthimpair->burstBad = FALSE;
+            hthimpair->linkFree = 0;
+            g_mutex_unlock(&hthimpair->lock);
+            break;
+        
+        default:
+            break;
+    }
+    
+    return GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+}
+
+//==============================================================================
+
+static GstFlowReturn gst_hthimpair_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (parent);
+    GstFlowReturn ret;
+    gboolean duplicated;
+    gint64 now;
+    gsize size;
+    
+    size = gst_buffer_get_size(buffer);
+    
+    g_mutex_lock(&hthimpair->lock);
+    
+    ret = hthimpair->srcResult;
+    if (ret != GST_FLOW_OK) {
+        g_mutex_unlock(&hthimpair->lock);
+        gst_buffer_unref(buffer);
+        return ret;
+    }
+    
+    hthimpair->buffersIn++;
+    
+    /** The same draws whatever the datagram turns out to be */
+    if (isLost(hthimpair)) {
+        g_mutex_unlock(&hthimpair->lock);
+        gst_buffer_unref(buffer);
+        return GST_FLOW_OK;
+    }
+    duplicated = drawPercent(hthimpair) < hthimpair->duplicate;
+    if (duplicated)
+        hthimpair->duplicates++;
+    
+    if (isPassthrough(hthimpair)) {
+        hthimpair->buffersOut += duplicated ? 2 : 1;
+        hthimpair->bytesOut += duplicated ? 2 * size : size;
+        g_mutex_unlock(&hthimpair->lock);
+        
+        /** The duplicate shares the memory of the datagram */
+        if (duplicated) {
+            ret = gst_pad_push(hthimpair->srcPad, gst_buffer_ref(buffer));
+            if (ret != GST_FLOW_OK) {
+                gst_buffer_unref(buffer);
+                return ret;
+            }
+        }
+        return gst_pad_push(hthimpair->srcPad, buffer);
+    }
+    
+    now = g_get_monotonic_time();
+    if (duplicated)
+        queueItem(hthimpair, GST_MINI_OBJECT_CAST(gst_buffer_ref(buffer)), getDeparture(hthimpair, now, size));
+    queueItem(hthimpair, GST_MINI_OBJECT_CAST(buffer), getDeparture(hthimpair, now, size));
+    
+    g_mutex_unlock(&hthimpair->lock);
+    
+    return GST_FLOW_OK;
+}
+
+//==============================================================================
+
+static gboolean gst_hthimpair_sink_event (GstPad *pad, GstObject *parent, GstEvent *event){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (parent);
+    ImpairItem *last;
+    gboolean ret;
+    
+    switch (GST_EVENT_TYPE (event)) {
+        
+        case GST_EVENT_FLUSH_START:
+            ret = gst_pad_push_event(hthimpair->srcPad, event);
+            
+            g_mutex_lock(&hthimpair->lock);
+            hthimpair->flushing = TRUE;
+            hthimpair->srcResult = GST_FLOW_FLUSHING;
+            g_cond_signal(&hthimpair->cond);
+            g_mutex_unlock(&hthimpair->lock);
+            
+            /** Waits for the push in progress */
+            gst_pad_pause_task(hthimpair->srcPad);
+            return ret;
+        
+        case GST_EVENT_FLUSH_STOP:
+            g_mutex_lock(&hthimpair->lock);
+            clearQueue(hthimpair);
+            hthimpair->linkFree = 0;
+            hthimpair->flushing = FALSE;
+            hthimpair->srcResult = GST_FLOW_OK;
+            g_mutex_unlock(&hthimpair->lock);
+            
+            ret = gst_pad_push_event(hthimpair->srcPad, event);
+            gst_pad_start_task(hthimpair->srcPad, cb_pushLoop, hthimpair, NULL);
+            return ret;
+        
+        default:
+            break;
+    }
+    
+    if (!GST_EVENT_IS_SERIALIZED(event))
+        return gst_pad_event_default(pad, parent, event);
+    
+    g_mutex_lock(&hthimpair->lock);
+    
+    if (hthimpair->flushing) {
+        g_mutex_unlock(&hthimpair->lock);
+        gst_event_unref(event);
+        return FALSE;
+    }
+    
+    if (g_queue_is_empty(&hthimpair->queue) && !hthimpair->pushing) {
+        g_mutex_unlock(&hthimpair->lock);
+        return gst_pad_event_default(pad, parent, event);
+    }
+    
+    /** Leaves with the last datagram queued, EOS included */
+    last = g_queue_peek_tail(&hthimpair->queue);
+    queueItem(hthimpair, GST_MINI_OBJECT_CAST(event), last != NULL ? last->departure : g_get_monotonic_time());
+    
+    g_mutex_unlock(&hthimpair->lock);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean gst_hthimpair_src_query (GstPad *pad, GstObject *parent, GstQuery *query){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (parent);
+    GstClockTime minLatency;
+    GstClockTime maxLatency;
+    gboolean live;
+    guint delay;
+    guint jitter;
+    
+    if (GST_QUERY_TYPE(query) != GST_QUERY_LATENCY)
+        return gst_pad_query_default(pad, parent, query);
+    
+    if (!gst_pad_peer_query(hthimpair->sinkPad, query))
+        return FALSE;
+    
+    g_mutex_lock(&hthimpair->lock);
+    delay = hthimpair->delay;
+    jitter = hthimpair->jitter;
+    g_mutex_unlock(&hthimpair->lock);
+    
+    gst_query_parse_latency(query, &live, &minLatency, &maxLatency);
+    minLatency += delay * GST_MSECOND;
+    if (GST_CLOCK_TIME_IS_VALID(maxLatency))
+        maxLatency += (delay + jitter) * GST_MSECOND;
+    gst_query_set_latency(query, live, minLatency, maxLatency);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean gst_hthimpair_src_activate_mode (GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (parent);
+    gboolean ret;
+    
+    if (mode != GST_PAD_MODE_PUSH)
+        return FALSE;
+    
+    if (active) {
+        g_mutex_lock(&hthimpair->lock);
+        hthimpair->flushing = FALSE;
+        hthimpair->srcResult = GST_FLOW_OK;
+        g_mutex_unlock(&hthimpair->lock);
+        
+        return gst_pad_start_task(pad, cb_pushLoop, hthimpair, NULL);
+    }
+    
+    g_mutex_lock(&hthimpair->lock);
+    hthimpair->flushing = TRUE;
+    hthimpair->srcResult = GST_FLOW_FLUSHING;
+    g_cond_signal(&hthimpair->cond);
+    g_mutex_unlock(&hthimpair->lock);
+    
+    ret = gst_pad_stop_task(pad);
+    
+    g_mutex_lock(&hthimpair->lock);
+    clearQueue(hthimpair);
+    g_mutex_unlock(&hthimpair->lock);
+    
+    return ret;
+}
+
+//==============================================================================
+
+static void cb_pushLoop(gpointer user_data){
+    
+    Gsththimpair *hthimpair = GST_HTHIMPAIR (user_data);
+    ImpairItem *item;
+    GstMiniObject *object;
+    GstFlowReturn ret;
+    gboolean isEos;
+    gsize size;
+    
+    g_mutex_lock(&hthimpair->lock);
+    
+    while (!hthimpair->flushing && g_queue_is_empty(&hthimpair->queue))
+        g_cond_wait(&hthimpair->cond, &hthimpair->lock);
+    
+    if (hthimpair->flushing) {
+        g_mutex_unlock(&hthimpair->lock);
+        gst_pad_pause_task(hthimpair->srcPad);
+        return;
+    }
+    
+    /** A datagram queued meanwhile may leave earlier, the queue is looked at again */
+    item = g_queue_peek_head(&hthimpair->queue);
+    if (item->departure > g_get_monotonic_time()) {
+        g_cond_wait_until(&hthimpair->cond, &hthimpair->lock, item->departure);
+        g_mutex_unlock(&hthimpair->lock);
+        return;
+    }
+    
+    g_queue_pop_head(&hthimpair->queue);
+    object = item->object;
+    g_slice_free(ImpairItem, item);
+    hthimpair->pushing = TRUE;
+    g_mutex_unlock(&hthimpair->lock);
+    
+    if (GST_IS_EVENT(object)) {
+        isEos = GST_EVENT_TYPE(GST_EVENT_CAST(object)) == GST_EVENT_EOS;
+        gst_pad_push_event(hthimpair->srcPad, GST_EVENT_CAST(object));
+        ret = isEos ? GST_FLOW_EOS : GST_FLOW_OK;
+        size = 0;
+    } else {
+        size = gst_buffer_get_size(GST_BUFFER_CAST(object));
+        ret = gst_pad_push(hthimpair->srcPad, GST_BUFFER_CAST(object));
+    }
+    
+    g_mutex_lock(&hthimpair->lock);
+    hthimpair->pushing = FALSE;
+    if (size > 0 && ret == GST_FLOW_OK) {
+        hthimpair->buffersOut++;
+        hthimpair->bytesOut += size;
+    }
+    /** A flush may have reset it meanwhile */
+    if (!hthimpair->flushing)
+        hthimpair->srcResult = ret;
+    g_mutex_unlock(&hthimpair->lock);
+    
+    if (ret == GST_FLOW_OK)
+        return;
+    
+    gst_pad_pause_task(hthimpair->srcPad);
+    
+    /** Like queue: the errors stop the pipeline, upstream gets the return with its next datagram */
+    if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+        GST_ELEMENT_ERROR (hthimpair, STREAM, FAILED, ("Internal data stream error."),
+                           ("streaming stopped, reason %s", gst_flow_get_name(ret)));
+        gst_pad_push_event(hthimpair->srcPad, gst_event_new_eos());
+    }
+}
+
+//==============================================================================
+
+static gboolean isLost(Gsththimpair *hthimpair){
+    
+    gdouble transition = drawPercent(hthimpair);
+    gdouble loss = drawPercent(hthimpair);
+    
+    if (!hthimpair->burstBad && transition < hthimpair->burstEnter) {
+        hthimpair->burstBad = TRUE;
+        hthimpair->bursts++;
+    } else if (hthimpair->burstBad && transition < hthimpair->burstExit) {
+        hthimpair->burstBad = FALSE;
+    }
+    
+    if (hthimpair->burstBad) {
+        if (loss >= hthimpair->burstLoss)
+            return FALSE;
+        hthimpair->burstDrops++;
+        return TRUE;
+    }
+    
+    if (loss >= hthimpair->loss)
+        return FALSE;
+    hthimpair->lossDrops++;
+    return TRUE;
+}
+
+//==============================================================================
+
+static gint64 getDeparture(Gsththimpair *hthimpair, gint64 now, gsize size){
+    
+    gdouble reorder = drawPercent(hthimpair);
+    gdouble jitter = drawPercent(hthimpair);
+    gint64 departure;
+    
+    if (hthimpair->delay > 0 && reorder < hthimpair->reorder) {
+        /** Overtakes the datagrams still delayed */
+        departure = now;
+        hthimpair->reordered++;
+    } else {
+        /** Uniform in [delay - jitter, delay + jitter] */
+        departure = now + (gint64) hthimpair->delay * 1000
+            + (gint64) ((jitter / 50.0 - 1.0) * hthimpair->jitter * 1000);
+        departure = MAX(departure, now);
+    }
+    
+    /** The link sends one datagram at a time */
+    if (hthimpair->bandwidth > 0) {
+        departure = MAX(departure, hthimpair->linkFree) + (gint64) size * 8 * 1000 / hthimpair->bandwidth;
+        hthimpair->linkFree = departure;
+    }
+    
+    return departure;
+}
+
+//==============================================================================
+
+static void queueItem(Gsththimpair *hthimpair, GstMiniObject *object, gint64 departure){
+    
+    ImpairItem *item;
+    GList *link;
+    
+    if (GST_IS_BUFFER(object) && g_queue_get_length(&hthimpair->queue) >= hthimpair->limit) {
+        hthimpair->limitDrops++;
+        gst_mini_object_unref(object);
+        return;
+    }
+    
+    item = g_slice_new(ImpairItem);
+    item->departure = departure;
+    item->object = object;
+    
+    /** Usually the datagram goes last, the walk only goes back over the ones that leave later */
+    for (link = hthimpair->queue.tail; link != NULL; link = link->prev) {
+        if (((ImpairItem*) link->data)->departure <= departure)
+            break;
+    }
+    
+    if (link == NULL)
+        g_queue_push_head(&hthimpair->queue, item);
+    else
+        g_queue_insert_after(&hthimpair->queue, link, item);
+    
+    g_cond_signal(&hthimpair->cond);
+}
+
+//==============================================================================
+
+static void clearQueue(Gsththimpair *hthimpair){
+    
+    ImpairItem *item;
+    
+    while ((item = g_queue_pop_head(&hthimpair->queue)) != NULL) {
+        gst_mini_object_unref(item->object);
+        g_slice_free(ImpairItem, item);
+    }
+}
+
+//==============================================================================
+
+static gboolean isPassthrough(Gsththimpair *hthimpair){
+    
+    return hthimpair->delay == 0 && hthimpair->jitter == 0 && hthimpair->bandwidth == 0
+        && g_queue_is_empty(&hthimpair->queue) && !hthimpair->pushing;
+}
+
+//==============================================================================
+
+static gdouble drawPercent(Gsththimpair *hthimpair){
+    
+    return g_rand_double_range(hthimpair->rand, 0.0, 100.0);
+}
+
+//==============================================================================
+
+static GstStructure *createStatsStructure(Gsththimpair *hthimpair){
+    
+    GstStructure *stats;
+    
+    g_mutex_lock(&hthimpair->lock);
+    stats = gst_structure_new("hthimpair-stats",
+                              "buffers-in", G_TYPE_UINT64, hthimpair->buffersIn,
+                              "buffers-out", G_TYPE_UINT64, hthimpair->buffersOut,
+                              "bytes-out", G_TYPE_UINT64, hthimpair->bytesOut,
+                              "loss-drops", G_TYPE_UINT64, hthimpair->lossDrops,
+                              "burst-drops", G_TYPE_UINT64, hthimpair->burstDrops,
+                              "bursts", G_TYPE_UINT64, hthimpair->bursts,
+                              "limit-drops", G_TYPE_UINT64, hthimpair->limitDrops,
+                              "duplicates", G_TYPE_UINT64, hthimpair->duplicates,
+                              "reordered", G_TYPE_UINT64, hthimpair->reordered,
+                              "queued", G_TYPE_UINT, g_queue_get_length(&hthimpair->queue),
+                              NULL);
+    g_mutex_unlock(&hthimpair->lock);
+    
+    return stats;
+}
+
+//==============================================================================
+
+/**
+ *
+ * @brief entry point to initialize the plug-in
+ *
+ * initialize the plug-in itself
+ * register the element factories and other features
+ */
+static gboolean hthimpair_init (GstPlugin * hthimpair){
+    
+    printf(WHITE "Plugin  -- hthimpair --- Init plugin function \n" RESET);
+    
+    /** Debug category for fltering log messages */
+    GST_DEBUG_CATEGORY_INIT (gst_hthimpair_debug, "hthimpair", 0, "Network impairment");
+    
+    return gst_element_register (hthimpair, "hthimpair", GST_RANK_NONE, GST_TYPE_HTHIMPAIR);
+}
+
+//==============================================================================
+
+/* PACKAGE: this is usually set by autotools depending on some _INIT macro
+ * in configure.ac and then written into and defined in config.h, but we can
+ * just set it ourselves here in case someone doesn't use autotools to
+ * compile this code. GST_PLUGIN_DEFINE needs PACKAGE to be defined.
+ */
+#ifndef PACKAGE
+#define PACKAGE "myfirsththimpair"
+#endif
+
+/* gstreamer looks for this structure to register plugins
+ *
+ * exchange the string 'Template hthimpair' with your plugin description
+ */
+GST_PLUGIN_DEFINE (
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    hthimpair,
+    "Network impairment of datagrams",
+    hthimpair_init,
+    VERSION,
+    "LGPL",
+    "GStreamer",
+    "http://gstreamer.net/"
+)
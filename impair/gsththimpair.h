@@ -0,0 +1,134 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHIMPAIR_H__
+#define __GST_HTHIMPAIR_H__
+
+#include <gst/gst.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* #defines don't like whitespacey bits */
+#define GST_TYPE_HTHIMPAIR (gst_hthimpair_get_type())
+#define GST_HTHIMPAIR(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HTHIMPAIR,Gsththimpair))
+#define GST_HTHIMPAIR_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_HTHIMPAIR,GsththimpairClass))
+#define GST_IS_HTHIMPAIR(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HTHIMPAIR))
+#define GST_IS_HTHIMPAIR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_HTHIMPAIR))
+
+/**
+ * @struct Gsththimpair
+ *
+ * @brief Network impairment applied to the buffers that go through the element
+ *
+ * Every buffer is a datagram: it is lost, duplicated, delayed or held by
+ * the bandwidth cap as a whole. The buffers waiting for their departure
+ * are pushed by the task of the src pad.
+ *
+ */
+
+typedef struct _Gsththimpair      Gsththimpair;
+
+struct _Gsththimpair{
+    
+    GstElement parent; /**< Parent struct. This element defines the plugin type */
+    
+    GstPad *sinkPad; /**< Datagrams in */
+    GstPad *srcPad; /**< Datagrams out, pushed by the task when they are delayed */
+    
+    /** Impairment, protected by the lock */
+    gdouble loss; /**< Percent of the datagrams lost in the good state */
+    gdouble burstEnter; /**< Percent chance per datagram to go from the good to the bad state */
+    gdouble burstExit; /**< Percent chance per datagram to go back to the good state */
+    gdouble burstLoss; /**< Percent of the datagrams lost in the bad state */
+    guint delay; /**< Milliseconds added to every datagram */
+    guint jitter; /**< Milliseconds of random variation around the delay */
+    gdouble reorder; /**< Percent of the datagrams sent at once, ahead of the delayed ones */
+    gdouble duplicate; /**< Percent of the datagrams sent twice */
+    guint bandwidth; /**< kbit/s of the link, 0 for unlimited */
+    guint limit; /**< Datagrams waiting for their departure before the next ones are dropped */
+    guint seed; /**< Seed of the random generator, applied when going to PAUSED */
+    
+    /** Scheduler */
+    GMutex lock; /**< Protects the properties, the queue and the stats */
+    GCond cond; /**< Signals the task, a datagram was queued or the element is flushing */
+    GRand *rand; /**< Deterministic for a given seed and input */
+    gboolean burstBad; /**< Gilbert-Elliott state */
+    GQueue queue; /**< ImpairItem sorted by departure time */
+    gint64 linkFree; /**< Monotonic time the bandwidth cap is free again, in us */
+    gboolean pushing; /**< The task is pushing an item taken from the queue */
+    gboolean flushing; /**< The src pad is inactive or flushing */
+    GstFlowReturn srcResult; /**< Return of the last push of the task */
+    
+    /** Stats, protected by the lock */
+    guint64 buffersIn; /**< Datagrams received */
+    guint64 buffersOut; /**< Datagrams pushed, duplicates included */
+    guint64 bytesOut; /**< Bytes pushed */
+    guint64 lossDrops; /**< Datagrams lost in the good state */
+    guint64 burstDrops; /**< Datagrams lost in the bad state */
+    guint64 limitDrops; /**< Datagrams dropped because the queue was full */
+    guint64 duplicates; /**< Datagrams sent twice */
+    guint64 reordered; /**< Datagrams sent ahead of the delayed ones */
+    guint64 bursts; /**< Times the bad state was entered */
+    
+};
+
+/**
+ * @struct GsththimpairClass
+ *
+ * @brief Generic struct that defines the plugin class.
+ *
+ */
+
+typedef struct _GsththimpairClass GsththimpairClass;
+
+struct _GsththimpairClass {
+    GstElementClass parent_class; /**< Parent plugin class */
+};
+
+GType gst_hthimpair_get_type (void);
+G_END_DECLS
+
+#endif /* __GST_HTHIMPAIR_H__ */
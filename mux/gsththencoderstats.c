@@ -0,0 +1,257 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** encoder stats header */
+#include "gsththencoderstats.h" /**< For the encoder stats declarations */
+
+/** latency tracer header */
+#include "gsththlatency.h" /**< For the encode time histogram */
+
+/** histogram header */
+#include "gsththhistogram.h" /**< For the frame size histogram */
+
+#define ENCODE_STAGE "encode" /**< Latency stage of the encoder, prefix of its stats fields */
+
+//==============================================================================
+
+struct _GstHthEncoderStats {
+    
+    GMutex lock; /**< Protects the counters */
+    GstHthLatency *encodeLatency; /**< Residency of the frames in the encoder */
+    
+    guint64 framesIn; /**< Raw frames entering the encoder */
+    guint64 framesOut; /**< Encoded frames leaving the encoder */
+    GstHthHistogram sizes; /**< Sizes of the encoded frames */
+    
+    guint64 keyframes; /**< Keyframes encoded */
+    guint64 keyframeBytes; /**< Bytes of all the keyframes */
+    guint64 keyframeLastSize; /**< Size of the last keyframe */
+    guint64 framesSinceKeyframe; /**< Frames encoded since the last keyframe */
+    guint64 keyframeIntervalFrames; /**< Frames between the last two keyframes */
+    GstClockTime keyframeLastPts; /**< PTS of the last keyframe */
+    GstClockTime keyframeInterval; /**< PTS distance of the last two keyframes */
+    
+    guint64 bytesSent; /**< Bytes of the datagrams sent */
+    guint64 datagramsSent; /**< Datagrams sent */
+    GstClockTime lastPost; /**< Monotonic time of the previous message */
+};
+
+//==============================================================================
+
+/**
+ * @brief Count a raw frame entering the encoder
+ *
+ * @param pad Sink pad of the encoder
+ * @param info Probe info with the buffer
+ * @param user_data The GstHthEncoderStats
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_encoderInputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count the size and type of an encoded frame
+ *
+ * @param pad Src pad of the encoder
+ * @param info Probe info with the buffer
+ * @param user_data The GstHthEncoderStats
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_encoderOutputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+//==============================================================================
+
+GstHthEncoderStats *gst_hth_encoder_stats_new (void){
+    
+    GstHthEncoderStats *stats = g_new0 (GstHthEncoderStats, 1);
+    
+    g_mutex_init (&stats->lock);
+    stats->keyframeLastPts = GST_CLOCK_TIME_NONE;
+    stats->lastPost = GST_CLOCK_TIME_NONE;
+    gst_hth_histogram_reset (&stats->sizes);
+    
+    /** Never posts, the encode time goes out with the other counters */
+    stats->encodeLatency = gst_hth_latency_new (NULL);
+    
+    return stats;
+}
+
+//==============================================================================
+
+void gst_hth_encoder_stats_free (GstHthEncoderStats *stats){
+    
+    gst_hth_latency_free (stats->encodeLatency);
+    g_mutex_clear (&stats->lock);
+    g_free (stats);
+}
+
+//==============================================================================
+
+void gst_hth_encoder_stats_watch_encoder (GstHthEncoderStats *stats, GstElement *encoder){
+    
+    GstPad *sinkPad;
+    GstPad *srcPad;
+    
+    if (encoder == NULL)
+        return;
+    
+    sinkPad = gst_element_get_static_pad (encoder, "sink");
+    srcPad = gst_element_get_static_pad (encoder, "src");
+    
+    gst_pad_add_probe (sinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_encoderInputProbe, stats, NULL);
+    gst_pad_add_probe (srcPad, GST_PAD_PROBE_TYPE_BUFFER, cb_encoderOutputProbe, stats, NULL);
+    
+    /** Same stage name, the probes of the previous encoder are removed */
+    gst_hth_latency_add_stage (stats->encodeLatency, ENCODE_STAGE, sinkPad, srcPad, FALSE);
+    
+    gst_object_unref (sinkPad);
+    gst_object_unref (srcPad);
+}
+
+//==============================================================================
+
+gboolean gst_hth_encoder_stats_count_datagram (GstHthEncoderStats *stats, gsize bytes, GstClockTime interval){
+    
+    GstClockTime now = gst_util_get_timestamp ();
+    gboolean post = FALSE;
+    
+    g_mutex_lock (&stats->lock);
+    
+    stats->bytesSent += bytes;
+    stats->datagramsSent++;
+    
+    if (!GST_CLOCK_TIME_IS_VALID (stats->lastPost))
+        stats->lastPost = now;
+    
+    if (interval > 0 && now - stats->lastPost >= interval) {
+        stats->lastPost = now;
+        post = TRUE;
+    }
+    
+    g_mutex_unlock (&stats->lock);
+    
+    return post;
+}
+
+//==============================================================================
+
+void gst_hth_encoder_stats_append (GstHthEncoderStats *stats, GstStructure *structure){
+    
+    g_mutex_lock (&stats->lock);
+    
+    gst_structure_set (structure,
+                       "video-frames-in", G_TYPE_UINT64, stats->framesIn,
+                       "video-frames-out", G_TYPE_UINT64, stats->framesOut,
+                       "frame-size-p50", G_TYPE_UINT64, gst_hth_histogram_get_percentile (&stats->sizes, 50.0),
+                       "frame-size-p95", G_TYPE_UINT64, gst_hth_histogram_get_percentile (&stats->sizes, 95.0),
+                       "frame-size-p99", G_TYPE_UINT64, gst_hth_histogram_get_percentile (&stats->sizes, 99.0),
+                       "frame-size-max", G_TYPE_UINT64, stats->sizes.max,
+                       "keyframes", G_TYPE_UINT64, stats->keyframes,
+                       "keyframe-size-last", G_TYPE_UINT64, stats->keyframeLastSize,
+                       "keyframe-size-mean", G_TYPE_UINT64, stats->keyframes > 0 ? stats->keyframeBytes / stats->keyframes : 0,
+                       "keyframe-interval-frames", G_TYPE_UINT64, stats->keyframeIntervalFrames,
+                       "keyframe-interval", G_TYPE_UINT64, stats->keyframeInterval,
+                       "bytes-sent", G_TYPE_UINT64, stats->bytesSent,
+                       "datagrams-sent", G_TYPE_UINT64, stats->datagramsSent,
+                       NULL);
+    
+    g_mutex_unlock (&stats->lock);
+    
+    gst_hth_latency_append_stats (stats->encodeLatency, structure);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_encoderInputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthEncoderStats *stats = (GstHthEncoderStats*) user_data;
+    
+    g_mutex_lock (&stats->lock);
+    stats->framesIn++;
+    g_mutex_unlock (&stats->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_encoderOutputProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthEncoderStats *stats = (GstHthEncoderStats*) user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    guint64 size = gst_buffer_get_size (buffer);
+    
+    g_mutex_lock (&stats->lock);
+    
+    stats->framesOut++;
+    gst_hth_histogram_record (&stats->sizes, size);
+    stats->framesSinceKeyframe++;
+    
+    if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        
+        stats->keyframes++;
+        stats->keyframeBytes += size;
+        stats->keyframeLastSize = size;
+        
+        /** Intervals need two keyframes */
+        if (stats->keyframes > 1)
+            stats->keyframeIntervalFrames = stats->framesSinceKeyframe;
+        if (GST_BUFFER_PTS_IS_VALID (buffer) && GST_CLOCK_TIME_IS_VALID (stats->keyframeLastPts)
+            && GST_BUFFER_PTS (buffer) > stats->keyframeLastPts)
+            stats->keyframeInterval = GST_BUFFER_PTS (buffer) - stats->keyframeLastPts;
+        
+        stats->keyframeLastPts = GST_BUFFER_PTS (buffer);
+        stats->framesSinceKeyframe = 0;
+    }
+    
+    g_mutex_unlock (&stats->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
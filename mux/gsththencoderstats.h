@@ -0,0 +1,116 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHENCODERSTATS_H__
+#define __GST_HTHENCODERSTATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @brief Name of the periodic element message
+ */
+#define HTH_ENCODER_STATS_MESSAGE "hth-encoder-stats"
+
+/**
+ * @struct GstHthEncoderStats
+ * @brief Counters of the video encoder and of the datagrams sent
+ *
+ * The encoder and the sender are watched with pad probes, the encode time
+ * is the residency of a frame in the encoder, matched by PTS.
+ */
+typedef struct _GstHthEncoderStats GstHthEncoderStats;
+
+/**
+ * @brief Create the counters
+ * @return GstHthEncoderStats* The counters, all at 0
+ */
+GstHthEncoderStats *gst_hth_encoder_stats_new (void);
+
+/**
+ * @brief Free the counters, the watched pads must be gone or detached
+ * @param stats The counters
+ */
+void gst_hth_encoder_stats_free (GstHthEncoderStats *stats);
+
+/**
+ * @brief Count the frames entering and leaving a video encoder
+ *
+ * A rebuilt encoder replaces the previous one, the counters go on.
+ *
+ * @param stats The counters
+ * @param encoder The encoder, may be NULL
+ */
+void gst_hth_encoder_stats_watch_encoder (GstHthEncoderStats *stats, GstElement *encoder);
+
+/**
+ * @brief Count one datagram sent
+ *
+ * @param stats The counters
+ * @param bytes Size of the datagram
+ * @param interval Period of the messages, 0 for none
+ * @return gboolean TRUE once per interval, the caller posts the message
+ */
+gboolean gst_hth_encoder_stats_count_datagram (GstHthEncoderStats *stats, gsize bytes, GstClockTime interval);
+
+/**
+ * @brief Add the encoder and sender counters to a stats structure
+ *
+ * Adds video-frames-in, video-frames-out, the encode-latency-* fields of
+ * GstHthLatency, frame-size-p50, frame-size-p95, frame-size-p99 and
+ * frame-size-max since the counters were created,
+ * keyframes, keyframe-size-last, keyframe-size-mean,
+ * keyframe-interval-frames, keyframe-interval (ns), bytes-sent and
+ * datagrams-sent.
+ *
+ * @param stats The counters
+ * @param structure Structure to fill
+ */
+void gst_hth_encoder_stats_append (GstHthEncoderStats *stats, GstStructure *structure);
+
+G_END_DECLS
+
+#endif /* __GST_HTHENCODERSTATS_H__ */
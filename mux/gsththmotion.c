@@ -0,0 +1,491 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** motion gate header */
+#include "gsththmotion.h" /**< For the motion gate declarations */
+
+/** video library header */
+#include <gst/video/video.h> /**< For GstVideoInfo and gst_video_frame_map() */
+
+/** string header file */
+#include <string.h> /**< For memcpy() */
+
+#define GRID_COLUMNS    64 /**< Cells of the luma grid */
+#define GRID_ROWS       36
+#define GRID_CELLS      (GRID_COLUMNS * GRID_ROWS)
+#define NOISE_LEVEL     12 /**< Luma difference of a cell below which it did not change */
+#define CORNER_ROWS     5 /**< Cells of the top left corner where the time is drawn, 1/7 of the height */
+#define CORNER_COLUMNS  24 /**< 3/8 of the width, room for timeoverlay and its padding */
+
+//==============================================================================
+
+struct _GstHthMotion {
+    
+    GMutex lock; /**< Protects the whole gate */
+    
+    GstVideoInfo info; /**< Format of the frames */
+    gboolean supported; /**< The format has an 8 bits luma plane of 2x2 pixels at least */
+    guint32 *lineSums; /**< Luma of the lines of one grid row added column by column, one per pixel of the width */
+    
+    gboolean enabled; /**< Static frames are dropped */
+    gdouble threshold; /**< Percent of the cells that must change */
+    GstClockTime keepalive; /**< Time between two frames of a static scene */
+    gboolean skipDuplicates; /**< Frames repeated by videorate are dropped */
+    gboolean ignoreCorner; /**< The time corner is left out of the grid */
+    
+    guint8 grid[GRID_CELLS]; /**< Samples of the current frame */
+    guint8 reference[GRID_CELLS]; /**< Samples of the last frame let through */
+    gboolean hasReference; /**< reference holds a frame of the current format */
+    GstClockTime referencePts; /**< PTS of the last frame let through */
+    gboolean keepaliveInFlight; /**< The frame in the encoder is a keepalive */
+    gboolean isStatic; /**< The last frame did not change enough */
+    gdouble score; /**< Percent of the cells changed in the last frame */
+    
+    guint64 frames; /**< Frames gated */
+    guint64 skipped; /**< Static frames dropped */
+    guint64 duplicates; /**< Repeated frames dropped */
+    guint64 keepalives; /**< Static frames let through */
+    guint64 keepalivesEncoded; /**< Keepalives seen leaving the encoder */
+    guint64 keepaliveBytes; /**< Bytes of the encoded keepalives */
+};
+
+//==============================================================================
+
+/**
+ * @brief Gate the frames entering the encoder, take the caps of the pad
+ *
+ * @param pad Encoder sink pad
+ * @param info Probe info with the frame or the event
+ * @param user_data The GstHthMotion
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP for a static or repeated frame
+ */
+static GstPadProbeReturn cb_motionSinkProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count the bytes of the encoded keepalives
+ *
+ * @param pad Encoder src pad
+ * @param info Probe info with the encoded frame
+ * @param user_data The GstHthMotion
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_motionSrcProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Decide if a frame reaches the encoder
+ *
+ * @param motion The gate
+ * @param buffer Raw frame
+ * @return gboolean FALSE when the frame is static or repeated and no keepalive is due
+ */
+static gboolean gateFrame (GstHthMotion *motion, GstBuffer *buffer);
+
+/**
+ * @brief A static or repeated frame is let through to keep the stream alive
+ *
+ * Frames without time, or going back in time, are always keepalives.
+ *
+ * @param motion The gate, locked
+ * @param pts PTS of the frame
+ * @return gboolean TRUE when motion-keepalive elapsed since the last frame let through
+ */
+static gboolean isKeepaliveDue (GstHthMotion *motion, GstClockTime pts);
+
+/**
+ * @brief Reduce the luma plane to the mean of each cell of the grid
+ *
+ * @param motion The gate, locked
+ * @param plane First luma line
+ * @param stride Bytes between two luma lines
+ * @return void
+ */
+static void sampleGrid (GstHthMotion *motion, const guint8 *plane, gint stride);
+
+/**
+ * @brief Add a luma line to the sums of its columns
+ *
+ * A plain loop over the line, vectorized by the compiler.
+ *
+ * @param sums Sums of the columns
+ * @param line Luma line
+ * @param width Pixels of the line
+ * @return void
+ */
+static void addLine (guint32 *sums, const guint8 *line, guint width);
+
+/**
+ * @brief Cells of the grid that changed from the reference
+ *
+ * A plain loop over two byte arrays, vectorized by the compiler.
+ *
+ * @param grid Samples of the current frame
+ * @param reference Samples of the last frame let through
+ * @return guint Cells whose difference is above NOISE_LEVEL
+ */
+static guint countChangedCells (const guint8 *grid, const guint8 *reference);
+
+//==============================================================================
+
+GstHthMotion *gst_hth_motion_new (void){
+    
+    GstHthMotion *motion = g_new0 (GstHthMotion, 1);
+    
+    g_mutex_init (&motion->lock);
+    motion->referencePts = GST_CLOCK_TIME_NONE;
+    
+    return motion;
+}
+
+//==============================================================================
+
+void gst_hth_motion_free (GstHthMotion *motion){
+    
+    g_mutex_clear (&motion->lock);
+    g_free (motion->lineSums);
+    g_free (motion);
+}
+
+//==============================================================================
+
+void gst_hth_motion_configure (GstHthMotion *motion, gboolean enabled, gdouble threshold, GstClockTime keepalive){
+    
+    g_mutex_lock (&motion->lock);
+    
+    /** A gate turned on again starts from the next frame */
+    if (enabled && !motion->enabled)
+        motion->hasReference = FALSE;
+    
+    motion->enabled = enabled;
+    motion->threshold = threshold;
+    motion->keepalive = keepalive;
+    
+    g_mutex_unlock (&motion->lock);
+}
+
+//==============================================================================
+
+void gst_hth_motion_skip_duplicates (GstHthMotion *motion, gboolean skip){
+    
+    g_mutex_lock (&motion->lock);
+    motion->skipDuplicates = skip;
+    g_mutex_unlock (&motion->lock);
+}
+
+//==============================================================================
+
+void gst_hth_motion_ignore_time_corner (GstHthMotion *motion, gboolean ignore){
+    
+    g_mutex_lock (&motion->lock);
+    if (ignore != motion->ignoreCorner)
+        motion->hasReference = FALSE;
+    motion->ignoreCorner = ignore;
+    g_mutex_unlock (&motion->lock);
+}
+
+//==============================================================================
+
+void gst_hth_motion_watch_encoder (GstHthMotion *motion, GstElement *encoder){
+    
+    GstPad *pad;
+    
+    pad = gst_element_get_static_pad (encoder, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                       cb_motionSinkProbe, motion, NULL);
+    gst_object_unref (pad);
+    
+    pad = gst_element_get_static_pad (encoder, "src");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_motionSrcProbe, motion, NULL);
+    gst_object_unref (pad);
+}
+
+//==============================================================================
+
+void gst_hth_motion_append_stats (GstHthMotion *motion, GstStructure *structure){
+    
+    guint64 bytesSaved = 0;
+    
+    g_mutex_lock (&motion->lock);
+    
+    /** A static or repeated frame would have cost about as much as a keepalive */
+    if (motion->keepalivesEncoded > 0)
+        bytesSaved = (motion->skipped + motion->duplicates) * (motion->keepaliveBytes / motion->keepalivesEncoded);
+    
+    gst_structure_set (structure,
+                       "motion-frames", G_TYPE_UINT64, motion->frames,
+                       "motion-skipped", G_TYPE_UINT64, motion->skipped,
+                       "motion-duplicates", G_TYPE_UINT64, motion->duplicates,
+                       "motion-keepalives", G_TYPE_UINT64, motion->keepalives,
+                       "motion-static", G_TYPE_BOOLEAN, motion->isStatic,
+                       "motion-score", G_TYPE_DOUBLE, motion->score,
+                       "motion-skipped-ratio", G_TYPE_DOUBLE,
+                       motion->frames > 0 ? (gdouble) (motion->skipped + motion->duplicates) / motion->frames : 0.0,
+                       "motion-bytes-saved", G_TYPE_UINT64, bytesSaved,
+                       NULL);
+    
+    g_mutex_unlock (&motion->lock);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_motionSinkProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthMotion *motion = (GstHthMotion*) user_data;
+    GstVideoInfo videoInfo;
+    GstEvent *event;
+    GstCaps *caps;
+    gboolean parsed;
+    
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    
+        event = GST_PAD_PROBE_INFO_EVENT (info);
+    
+        if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+            gst_event_parse_caps (event, &caps);
+            parsed = gst_video_info_from_caps (&videoInfo, caps);
+    
+            g_mutex_lock (&motion->lock);
+            motion->info = videoInfo;
+            motion->supported = parsed
+                && (GST_VIDEO_INFO_IS_YUV (&videoInfo) || GST_VIDEO_INFO_IS_GRAY (&videoInfo))
+                && GST_VIDEO_INFO_COMP_DEPTH (&videoInfo, 0) == 8
+                && GST_VIDEO_INFO_WIDTH (&videoInfo) >= 2 && GST_VIDEO_INFO_HEIGHT (&videoInfo) >= 2;
+            motion->hasReference = FALSE;
+            g_free (motion->lineSums);
+            motion->lineSums = motion->supported ? g_new (guint32, GST_VIDEO_INFO_WIDTH (&videoInfo)) : NULL;
+            g_mutex_unlock (&motion->lock);
+        }
+        else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+            g_mutex_lock (&motion->lock);
+            motion->hasReference = FALSE;
+            motion->referencePts = GST_CLOCK_TIME_NONE;
+            g_mutex_unlock (&motion->lock);
+        }
+    
+        return GST_PAD_PROBE_OK;
+    }
+    
+    return gateFrame (motion, GST_PAD_PROBE_INFO_BUFFER (info)) ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_motionSrcProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    GstHthMotion *motion = (GstHthMotion*) user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    
+    /** The encoder pushes each frame before it takes the next one */
+    g_mutex_lock (&motion->lock);
+    if (motion->keepaliveInFlight) {
+        motion->keepalivesEncoded++;
+        motion->keepaliveBytes += gst_buffer_get_size (buffer);
+        motion->keepaliveInFlight = FALSE;
+    }
+    g_mutex_unlock (&motion->lock);
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static gboolean gateFrame (GstHthMotion *motion, GstBuffer *buffer){
+    
+    GstClockTime pts = GST_BUFFER_PTS (buffer);
+    GstVideoFrame frame;
+    guint cells;
+    
+    g_mutex_lock (&motion->lock);
+    
+    motion->keepaliveInFlight = FALSE;
+    
+    if (!motion->enabled && !motion->skipDuplicates) {
+        g_mutex_unlock (&motion->lock);
+        return TRUE;
+    }
+    
+    motion->frames++;
+    
+    /** videorate flags the frames it repeats as gaps, the receiver already shows the same picture */
+    if (motion->skipDuplicates && GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP)
+        && GST_CLOCK_TIME_IS_VALID (motion->referencePts)) {
+        
+        if (!isKeepaliveDue (motion, pts)) {
+            motion->duplicates++;
+            g_mutex_unlock (&motion->lock);
+            return FALSE;
+        }
+        
+        /** Same picture, the reference grid is still right */
+        motion->keepalives++;
+        motion->keepaliveInFlight = TRUE;
+        motion->referencePts = pts;
+        g_mutex_unlock (&motion->lock);
+        return TRUE;
+    }
+    
+    if (!motion->enabled || !motion->supported
+        || !gst_video_frame_map (&frame, &motion->info, buffer, GST_MAP_READ)) {
+        motion->hasReference = FALSE;
+        motion->referencePts = pts;
+        g_mutex_unlock (&motion->lock);
+        return TRUE;
+    }
+    
+    sampleGrid (motion, GST_VIDEO_FRAME_COMP_DATA (&frame, 0), GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0));
+    gst_video_frame_unmap (&frame);
+    
+    if (!motion->hasReference) {
+        motion->score = 100.0;
+        motion->isStatic = FALSE;
+    }
+    else {
+        cells = motion->ignoreCorner ? GRID_CELLS - CORNER_ROWS * CORNER_COLUMNS : GRID_CELLS;
+        motion->score = countChangedCells (motion->grid, motion->reference) * 100.0 / cells;
+        motion->isStatic = motion->score < motion->threshold;
+    }
+    
+    if (motion->isStatic) {
+    
+        if (!isKeepaliveDue (motion, pts)) {
+            motion->skipped++;
+            g_mutex_unlock (&motion->lock);
+            return FALSE;
+        }
+    
+        motion->keepalives++;
+        motion->keepaliveInFlight = TRUE;
+    }
+    
+    /** The next frames are compared with what the receiver shows */
+    memcpy (motion->reference, motion->grid, GRID_CELLS);
+    motion->hasReference = TRUE;
+    motion->referencePts = pts;
+    
+    g_mutex_unlock (&motion->lock);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean isKeepaliveDue (GstHthMotion *motion, GstClockTime pts){
+    
+    return !GST_CLOCK_TIME_IS_VALID (pts) || !GST_CLOCK_TIME_IS_VALID (motion->referencePts)
+        || pts < motion->referencePts || pts - motion->referencePts >= motion->keepalive;
+}
+
+//==============================================================================
+
+static void sampleGrid (GstHthMotion *motion, const guint8 *plane, gint stride){
+    
+    guint width = GST_VIDEO_INFO_WIDTH (&motion->info);
+    guint height = GST_VIDEO_INFO_HEIGHT (&motion->info);
+    guint32 sum;
+    guint column;
+    guint row;
+    guint top;
+    guint bottom;
+    guint left;
+    guint right;
+    guint x;
+    guint y;
+    
+    /** Every pixel counts, an object smaller than a cell still moves its mean */
+    for (row = 0; row < GRID_ROWS; row++) {
+    
+        top = row * height / GRID_ROWS;
+        bottom = MAX ((row + 1) * height / GRID_ROWS, top + 1);
+    
+        memset (motion->lineSums, 0, width * sizeof (guint32));
+        for (y = top; y < bottom; y++)
+            addLine (motion->lineSums, plane + y * stride, width);
+    
+        for (column = 0; column < GRID_COLUMNS; column++) {
+            
+            /** The same constant in both grids never changes */
+            if (motion->ignoreCorner && row < CORNER_ROWS && column < CORNER_COLUMNS) {
+                motion->grid[row * GRID_COLUMNS + column] = 0;
+                continue;
+            }
+            
+            left = column * width / GRID_COLUMNS;
+            right = MAX ((column + 1) * width / GRID_COLUMNS, left + 1);
+            
+            sum = 0;
+            for (x = left; x < right; x++)
+                sum += motion->lineSums[x];
+            motion->grid[row * GRID_COLUMNS + column] = sum / ((right - left) * (bottom - top));
+        }
+    }
+}
+
+//==============================================================================
+
+static void addLine (guint32 *sums, const guint8 *line, guint width){
+    
+    guint x;
+    
+    for (x = 0; x < width; x++)
+        sums[x] += line[x];
+}
+
+//==============================================================================
+
+static guint countChangedCells (const guint8 *grid, const guint8 *reference){
+    
+    guint changed = 0;
+    guint i;
+    
+    for (i = 0; i < GRID_CELLS; i++)
+        changed += ABS ((gint) grid[i] - (gint) reference[i]) > NOISE_LEVEL;
+    
+    return changed;
+}
@@ -0,0 +1,136 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHMOTION_H__
+#define __GST_HTHMOTION_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * @struct GstHthMotion
+ * @brief Frame gate in front of the video encoder
+ *
+ * Every frame is reduced to a grid of the mean luma of each cell, every
+ * pixel counted, and compared with the grid of the last frame let
+ * through. While fewer cells than the threshold changed the frames
+ * are dropped, only one keepalive frame per interval reaches the encoder.
+ * The first frame that changed is let through at once. Formats with an
+ * 8 bits luma plane only, the others are never dropped. The top left
+ * corner can be left out, the time drawn there changes on every frame.
+ *
+ * The frames videorate repeats carry GST_BUFFER_FLAG_GAP, they can be
+ * dropped without looking at the pixels, with the same keepalive.
+ */
+typedef struct _GstHthMotion GstHthMotion;
+
+/**
+ * @brief Create a gate, it lets every frame through until configured
+ * @return GstHthMotion* The gate
+ */
+GstHthMotion *gst_hth_motion_new (void);
+
+/**
+ * @brief Free the gate, the watched encoder must be gone
+ * @param motion The gate
+ */
+void gst_hth_motion_free (GstHthMotion *motion);
+
+/**
+ * @brief Set the gating parameters, they apply from the next frame
+ *
+ * @param motion The gate
+ * @param enabled Drop the static frames
+ * @param threshold Percent of the cells that must change to be motion
+ * @param keepalive Time between two frames of a static scene
+ */
+void gst_hth_motion_configure (GstHthMotion *motion, gboolean enabled, gdouble threshold, GstClockTime keepalive);
+
+/**
+ * @brief Drop the frames repeated by videorate, even with the gate off
+ *
+ * @param motion The gate
+ * @param skip TRUE to drop the GAP frames between two keepalives
+ */
+void gst_hth_motion_skip_duplicates (GstHthMotion *motion, gboolean skip);
+
+/**
+ * @brief Leave the corner of the time overlay out of the comparison
+ *
+ * @param motion The gate
+ * @param ignore TRUE while glyph or timeoverlay draws the time
+ */
+void gst_hth_motion_ignore_time_corner (GstHthMotion *motion, gboolean ignore);
+
+/**
+ * @brief Gate the frames entering an encoder
+ *
+ * The sink pad drops the static frames, the src pad measures the size
+ * of the keepalive frames to estimate the bytes saved. Install it before
+ * the other probes of the sink pad so they only see the frames encoded.
+ *
+ * @param motion The gate
+ * @param encoder Video encoder, one frame out for each frame in
+ */
+void gst_hth_motion_watch_encoder (GstHthMotion *motion, GstElement *encoder);
+
+/**
+ * @brief Add the gate counters to a stats structure
+ *
+ * Adds motion-frames, motion-skipped, motion-duplicates,
+ * motion-keepalives, motion-static, motion-score (percent of the cells
+ * changed in the last frame), motion-skipped-ratio and motion-bytes-saved
+ * (static and repeated frames dropped times the mean size of the encoded
+ * keepalives).
+ *
+ * @param motion The gate
+ * @param structure Structure to fill
+ */
+void gst_hth_motion_append_stats (GstHthMotion *motion, GstStructure *structure);
+
+G_END_DECLS
+
+#endif /* __GST_HTHMOTION_H__ */
@@ -68,12 +68,49 @@
 /** gstreamer header file */
 #include <gst/gst.h> /**< For all gstreamer functions */
 
-/** stdlib header file */
-#include <stdlib.h> /**< For exit()  */
-
 /** stdio header file */
 #include <stdio.h> /**< For printf() */
 
+/** ioctl header files */
+#include <sys/ioctl.h> /**< For ioctl() */
+#include <linux/sockios.h> /**< For SIOCOUTQ */
+
+/** hth meta header */
+#include "gsththmeta.h" /**< For the per-frame telemetry meta */
+
+/** hth branch header */
+#include "gsththbranch.h" /**< For the branch rebuild bookkeeping */
+
+/** task pool header */
+#include "gsththtaskpool.h" /**< For the shared streaming thread pool */
+
+/** thread header */
+#include "gsthththread.h" /**< For the affinity, scheduling and jitter of the streaming threads */
+
+/** stream id header */
+#include "gsththstreamid.h" /**< For the header of the datagrams */
+
+/** memory budget */
+#include "gsththmemory.h" /**< For the max-memory accounting of the queues */
+
+/** latency tracer */
+#include "gsththlatency.h" /**< For the residency histograms of the stages */
+
+/** encoder stats */
+#include "gsththencoderstats.h" /**< For the encoder and sender counters */
+
+/** impairment */
+#include "gsththimpairment.h" /**< For the hthimpair element between the muxer and udpsink */
+
+/** time overlay */
+#include "gsththoverlay.h" /**< For the glyph timestamp drawn on the frames */
+
+/** motion gate */
+#include "gsththmotion.h" /**< For the static frames dropped ahead of the encoder */
+
+/** string header file */
+#include <string.h> /**< For strcmp() */
+
 /**
  * @brief Colors for printed messages
  *
@@ -90,14 +127,45 @@ GST_DEBUG_CATEGORY_STATIC (gst_hthstreamsink_debug);
 
 //==============================================================================
 /**
- * Exit error flags
+ * Branches
+ *
+ * A failure of an element of one branch rebuilds only that branch,
+ * the muxer and udpsink are shared by all of them.
+ */
+typedef enum {
+    BRANCH_NONE = -1,
+    BRANCH_VIDEO,
+    BRANCH_AUDIO,
+    BRANCH_TEXT,
+    BRANCH_COUNT
+} HthStreamBranch;
+
+#define MAX_BRANCH_ELEMENTS 5 /**< Elements of the longest branch (video) */
+
+#define INPUT_RAW "raw" /**< video-input and audio-input of a branch that encodes */
+
+/**
+ * Parsers of the encoded inputs, the branch feeds them straight to the muxer
+ */
+typedef struct {
+    const gchar *input; /**< video-input or audio-input */
+    HthStreamBranch branch;
+    const gchar *factory;
+} EncodedInput;
+
+static const EncodedInput encodedInputs[] = {
+    { "theora", BRANCH_VIDEO, "theoraparse" },
+    { "vp8", BRANCH_VIDEO, "identity" }, /**< matroskamux takes the frames as they are */
+    { "h264", BRANCH_VIDEO, "h264parse" }, /**< Byte-stream converted to the avc access units of matroskamux */
+    { "vorbis", BRANCH_AUDIO, "vorbisparse" },
+    { "opus", BRANCH_AUDIO, "opusparse" },
+    { NULL, BRANCH_NONE, NULL }
+};
+
+/**
+ * Frame sizes of opusenc in ms, the frame-size enum takes the integer part
  */
-#define EXIT_ELEMENT_CREATION_FAILURE  -1 /**< Creation elements failure flag */
-#define EXIT_ELEMENT_LINKING_FAILURE   -2 /**< Linking elements failure flag */
-#define EXIT_PADS_LINKING_FAILURE      -3 /**< Pads elements failure flag */
-#define EXIT_GHOSTPAD_CREATION_FAILURE -4 /**< Ghost pads elements failure flag */
-#define EXIT_GET_PAD_FAILURE           -5 /**< Get static pad failure flag */
-#define EXIT_SET_GHOSTH_PAD_FAILURE    -6 /**< Set ghosth pad failure flag */
+static const gdouble opusFrameSizes[] = { 2.5, 5.0, 10.0, 20.0, 40.0, 60.0 };
 
 //==============================================================================
 
@@ -107,11 +175,73 @@ GST_DEBUG_CATEGORY_STATIC (gst_hthstreamsink_debug);
 
 #define DEFAULT_HOST                    ((const char *)"127.0.0.1") /**< udpsrc default host */
 #define DEFAULT_PORT                    5000 /**< udpsrc default port */
+#define DEFAULT_FRAME_TELEMETRY         FALSE /**< Serial text travels as a sparse subtitle track */
+#define DEFAULT_STREAM_ID               0 /**< Datagrams sent without the stream id header */
+#define DEFAULT_SHARED_TASK_POOL        FALSE /**< Every streaming task gets its own thread */
+#define DEFAULT_CPUS                    NULL /**< Threads not pinned */
+#define DEFAULT_RT_POLICY               "other" /**< Time sharing scheduling */
+#define DEFAULT_RT_PRIORITY             10 /**< Real-time priority with fifo or rr */
+#define DEFAULT_QUEUELESS               FALSE /**< One queue2 thread per branch */
+#define DEFAULT_VIDEO_DEADLINE          0 /**< Late video frames are encoded anyway */
+#define DEFAULT_MAX_MEMORY              0 /**< Queues limited only by their own sizes */
+#define DEFAULT_LATENCY_TRACING         FALSE /**< No probe measures the stages */
+#define DEFAULT_LATENCY_INTERVAL        1000 /**< Milliseconds between two hth-latency messages */
+#define DEFAULT_ENCODER_STATS_INTERVAL  1000 /**< Milliseconds between two hth-encoder-stats messages */
+#define DEFAULT_IMPAIRMENT              NULL /**< The muxer output goes straight to udpsink */
+#define DEFAULT_TIME_OVERLAY            TIME_OVERLAY_GLYPH /**< Timestamp copied from the glyph atlas */
+#define DEFAULT_MOTION_GATE             FALSE /**< Every frame is encoded */
+#define DEFAULT_MOTION_THRESHOLD        1.0 /**< Percent of the luma cells that must change */
+#define DEFAULT_MOTION_KEEPALIVE        1000 /**< Milliseconds between two frames of a static scene */
+#define DEFAULT_SKIP_DUPLICATES         FALSE /**< Frames repeated by videorate become Theora duplicate packets */
+#define DEFAULT_VIDEO_INPUT             INPUT_RAW /**< Raw frames, encoded with theoraenc */
+#define DEFAULT_AUDIO_INPUT             INPUT_RAW /**< Raw samples, encoded with vorbisenc */
+#define DEFAULT_AUDIO_CODEC             AUDIO_CODEC_VORBIS /**< Encoder of the raw audio */
+#define DEFAULT_OPUS_FRAME_SIZE         10.0 /**< Milliseconds of audio in each Opus packet */
+#define DEFAULT_OPUS_BITRATE            64000 /**< Bits per second of opusenc */
+#define DEFAULT_OPUS_INBAND_FEC         TRUE /**< Each packet carries a low bitrate copy of the previous one */
+#define DEFAULT_OPUS_DTX                FALSE /**< Silence is sent at the full packet rate */
+
+#define OPUS_FEC_LOSS_PERCENTAGE        10 /**< Expected loss told to opusenc, without it the FEC data is not added */
+
+#define TIME_OVERLAY_GLYPH              "glyph" /**< identity with the glyph overlay probe */
+#define TIME_OVERLAY_PANGO              "pango" /**< timeoverlay element */
+#define TIME_OVERLAY_META               "meta" /**< identity attaching the capture time, sent in the frame records */
+
+#define AUDIO_CODEC_VORBIS              "vorbis" /**< vorbisenc */
+#define AUDIO_CODEC_OPUS                "opus" /**< opusenc in restricted low delay mode */
 
 enum{
     PROP_0,
     PROP_HOST,
-    PROP_PORT
+    PROP_PORT,
+    PROP_FRAME_TELEMETRY,
+    PROP_STREAM_ID,
+    PROP_SHARED_TASK_POOL,
+    PROP_VIDEO_CPUS,
+    PROP_AUDIO_CPUS,
+    PROP_TEXT_CPUS,
+    PROP_RT_POLICY,
+    PROP_RT_PRIORITY,
+    PROP_QUEUELESS,
+    PROP_VIDEO_DEADLINE,
+    PROP_MAX_MEMORY,
+    PROP_LATENCY_TRACING,
+    PROP_LATENCY_INTERVAL,
+    PROP_ENCODER_STATS_INTERVAL,
+    PROP_IMPAIRMENT,
+    PROP_TIME_OVERLAY,
+    PROP_MOTION_GATE,
+    PROP_MOTION_THRESHOLD,
+    PROP_MOTION_KEEPALIVE,
+    PROP_SKIP_DUPLICATES,
+    PROP_VIDEO_INPUT,
+    PROP_AUDIO_INPUT,
+    PROP_AUDIO_CODEC,
+    PROP_OPUS_FRAME_SIZE,
+    PROP_OPUS_BITRATE,
+    PROP_OPUS_INBAND_FEC,
+    PROP_OPUS_DTX,
+    PROP_STATS
 };
 
 //==============================================================================
@@ -154,12 +284,30 @@ static GstStateChangeReturn gst_bin_change_state (GstElement * element, GstState
 static void createElements(Gsththstreamsink *hthstreamsink);
 
 /**
- * @brief verify if all elements were cretated
+ * @brief Create the elements of one branch
  *
  * @param hthstreamsink The plugin instance
+ * @param branch The branch
  * @return void
  */
-static void verifyAllElementsCreated(Gsththstreamsink *hthstreamsink);
+static void createBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief verify if all elements were cretated
+ *
+ * @param hthstreamsink The plugin instance
+ * @return gboolean FALSE if one element is missing
+ */
+static gboolean verifyAllElementsCreated(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief verify if all the elements of one branch were created
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if one element is missing
+ */
+static gboolean verifyBranchElementsCreated(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
 
 /**
  * @brief Set some elements properties like udpsink host and port
@@ -169,6 +317,53 @@ static void verifyAllElementsCreated(Gsththstreamsink *hthstreamsink);
  */
 static void setElementsPropsValues(Gsththstreamsink *hthstreamsink);
 
+/**
+ * @brief Set the properties of the elements of one branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void setBranchPropsValues(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Count the buffers inside the queue of a branch against max-memory
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch of the queue
+ */
+static void watchBranchMemory(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Turn the latency probes on or off
+ *
+ * @param hthstreamsink The plugin instance
+ * @param enable TRUE to install the probes of every branch
+ * @return void
+ */
+static void setLatencyTracing(Gsththstreamsink *hthstreamsink, gboolean enable);
+
+/**
+ * @brief Add the latency stages of one branch
+ *
+ * One stage per element, one from the muxer pad to the muxer output and
+ * one from the ghost sink pad to the muxer output.
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void traceBranchLatency(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Remove the latency probes of one branch before its elements go
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void untraceBranchLatency(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
 /**
  * @brief Add elements to the main bin
  *
@@ -177,6 +372,15 @@ static void setElementsPropsValues(Gsththstreamsink *hthstreamsink);
  */
 static void addElementsToBin(Gsththstreamsink *hthstreamsink);
 
+/**
+ * @brief Add the elements of one branch to the main bin
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void addBranchElementsToBin(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
 /**
  * @brief Link the internal plugins
  *
@@ -184,17 +388,26 @@ static void addElementsToBin(Gsththstreamsink *hthstreamsink);
  * necessary create a correct pads connection
  *
  * @param hthstreamsink The plugin instance
- * @return void
+ * @return gboolean FALSE if one link fails
+ */
+static gboolean linkBinElements(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Link the elements of one branch and the branch with its muxer pad
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if one link fails
  */
-static void linkBinElements(Gsththstreamsink *hthstreamsink);
+static gboolean linkBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
 
 /**
  * @brief Creates the audio and video ghost pads from src template
  *
  * @param hthstreamsink
- * @return void
+ * @return gboolean FALSE if one pad could not be created
  */
-static void createPluginGhostPads(Gsththstreamsink *hthstreamsink);
+static gboolean createPluginGhostPads(Gsththstreamsink *hthstreamsink);
 
 /**
  * @brief set plugin ghost pads with the las video and audio plugin
@@ -210,9 +423,241 @@ static void createPluginGhostPads(Gsththstreamsink *hthstreamsink);
  * ==============================
  *
  * @param hthstreamsink The plugin instance
+ * @return gboolean FALSE if one ghost pad target could not be set
+ */
+static gboolean setPluginSinkPads(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Set the ghost pad target to the first element of one branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if the target could not be set
+ */
+static gboolean setBranchSinkPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Get the fields of the elements of one branch, in data flow order
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @param elements Returns the addresses of the element fields
+ * @return guint Number of elements
+ */
+static guint getBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, GstElement **elements[MAX_BRANCH_ELEMENTS]);
+
+/**
+ * @brief Get the restart bookkeeping of one branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return GstHthBranch* The bookkeeping
+ */
+static GstHthBranch *getBranchState(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Get the ghost sink pad that feeds one branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return GstPad* The ghost pad
+ */
+static GstPad *getBranchGhostPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Get the field of the muxer request pad of one branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return GstPad** Address of the field
+ */
+static GstPad **getBranchMuxPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Get the muxer request pad template name of one branch
+ *
+ * @param branch The branch
+ * @return const gchar* Pad template name
+ */
+static const gchar *getBranchMuxPadTemplate(HthStreamBranch branch);
+
+/**
+ * @brief Find the branch of an internal element
+ *
+ * @param hthstreamsink The plugin instance
+ * @param object Source of a bus message
+ * @return HthStreamBranch BRANCH_NONE for the muxer and udpsink
+ */
+static HthStreamBranch findElementBranch(Gsththstreamsink *hthstreamsink, GstObject *object);
+
+/**
+ * @brief Rebuild the branch of the elements that post an error
+ *
+ * The error is replaced by a warning and the branch is rebuilt from
+ * another thread. The errors of the muxer and udpsink, and of a branch
+ * that keeps failing, are forwarded.
+ *
+ * @param bin The plugin instance
+ * @param message Message posted by an internal element
+ */
+static void gst_hthstreamsink_handle_message (GstBin *bin, GstMessage *message);
+
+/**
+ * @brief Replace the elements of a failed branch with new ones
+ *
+ * Runs from gst_element_call_async(), not from a streaming thread.
+ *
+ * @param element The plugin instance
+ * @param user_data The branch
+ */
+static void cb_rebuildBranch(GstElement *element, gpointer user_data);
+
+/**
+ * @brief Replace the elements of a branch with new ones, in the NULL state
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return gboolean FALSE if the elements could not be created or linked,
+ * they are removed
+ */
+static gboolean buildBranch(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Stop the elements of one branch and remove them from the bin
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void teardownBranch(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Bring the elements of a rebuilt branch to the state of the bin
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void syncBranchStates(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Build the stats structure
+ *
+ * @param hthstreamsink The plugin instance
+ * @return GstStructure* hthstreamsink-stats structure
+ */
+static GstStructure *createStatsStructure(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Replace one of the thread string properties
+ *
+ * @param hthstreamsink The plugin instance
+ * @param field The property field
+ * @param value New value
+ * @return void
+ */
+static void setThreadString(Gsththstreamsink *hthstreamsink, gchar **field, const GValue *value);
+
+/**
+ * @brief Name, pin and schedule an internal streaming thread
+ *
+ * Runs in the thread that posted the STREAM_STATUS ENTER message.
+ *
+ * @param hthstreamsink The plugin instance
+ * @param message STREAM_STATUS message of a child
+ * @return void
+ */
+static void setupStreamingThread(Gsththstreamsink *hthstreamsink, GstMessage *message);
+
+/**
+ * @brief Name, pin and schedule the calling thread as one of a branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch Branch whose CPU list applies
+ * @param role enc for the thread entering the branch, tx for its queue thread
+ * @return void
+ */
+static void setupBranchThread(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, const gchar *role);
+
+/**
+ * @brief Set up the upstream threads that run the encoders
+ *
+ * Without a queue ahead of the encoders, the overlay, videorate and the
+ * encoders run in the thread that pushes into the ghost sink pad. The
+ * probes stay on the ghost pads when the branches are rebuilt.
+ *
+ * @param hthstreamsink The plugin instance
+ * @return void
+ */
+static void watchEncoderThreads(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Set up a new thread entering a ghost sink pad
+ *
+ * @param pad Ghost sink pad of a branch
+ * @param info Probe info with the buffer
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn Always GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_encoderThreadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Measure the jitter of the buffers leaving each branch
+ *
+ * The watched pads are kept when a branch is rebuilt.
+ *
+ * @param hthstreamsink The plugin instance
+ * @return void
+ */
+static void watchBranchJitter(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Factory of the last element of each branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @return const gchar* queue2, or identity in queueless mode
+ */
+static const gchar *getQueueFactory(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Rebuild the branches with or without the queue threads
+ *
+ * Without the queues the encoders run in the threads of the upstream
+ * elements, and the muxer and udpsink in the thread that completes its
+ * input. No thread is created by the element. It is not a scheduler:
+ * GstCollectPads in matroskamux holds each pushing thread until its
+ * buffer is muxed, so one thread can't feed all the tracks.
+ *
+ * @param hthstreamsink The plugin instance, in the NULL state
+ * @param enable TRUE to build the branches without queues
+ * @return void
+ */
+static void setQueuelessMode(Gsththstreamsink *hthstreamsink, gboolean enable);
+
+/**
+ * @brief Drop the video frames that can't be encoded in time
+ *
+ * A slow encode must not hold the other branches: without the queues the
+ * muxer waits for the video track before it takes more audio.
+ *
+ * @param pad plugin_theora_enc sink pad
+ * @param info Probe info with the raw frame
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP for late frames
+ */
+static GstPadProbeReturn cb_videoDeadlineProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Add the rates since the previous stats read
+ *
+ * Adds video-fps and process-context-switch-rate (per second, every
+ * thread of the process, not only the ones of the element).
+ *
+ * @param hthstreamsink The plugin instance
+ * @param stats Structure to fill
  * @return void
  */
-static void setPluginSinkPads(Gsththstreamsink *hthstreamsink);
+static void appendRates(Gsththstreamsink *hthstreamsink, GstStructure *stats);
 
 /**
  * @brief set plugin's properties with new values
@@ -234,60 +679,382 @@ static void gst_hthstreamsink_set_property (GObject * object, guint prop_id, con
  */
 static void gst_hthstreamsink_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
 
-//==============================================================================
-
 /**
- * @brief GObject vmethod implementations
- * initialize the hthstreamsink class
+ * @brief Free the resources that are not owned by the bin
  *
+ * @param object The plugin instance
  */
-static void gst_hthstreamsink_class_init (GsththstreamsinkClass * klass){
-    
-    printf(WHITE "Bin-plugin  -- Serialtextsrc Class Init ---  \n" RESET);
-    
-    GObjectClass *gobject_class;
-    GstElementClass *gstelement_class;
-    
-    gobject_class = (GObjectClass *) klass;
-    gstelement_class = (GstElementClass *) klass;
-    
-    gobject_class->set_property = gst_hthstreamsink_set_property;
-    gobject_class->get_property = gst_hthstreamsink_get_property;
-    
-    /** Install properties*/
-    g_object_class_install_property (gobject_class, PROP_HOST,
-                                     g_param_spec_string ("host", "Host",
-                                                          "Address to send packets for" , NULL,
-                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
-    g_object_class_install_property (gobject_class, PROP_PORT,
-                                     g_param_spec_int ("port", "Port", "The port that receives the packets",
-                                                       0, G_MAXUINT16,
-                                                       0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
-    
-    gst_element_class_set_details_simple(gstelement_class,
-                                         "hthstreamsink",
-                                         "FIXME:Generic",
-                                         "FIXME:Generic Template Element",
-                                         "basultobd <<user@hostname.org>>");
-    
-    gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_bin_change_state);
-}
-
-//==============================================================================
+static void gst_hthstreamsink_finalize (GObject * object);
 
 /**
- * @brief initialize the new element
- *
+ * @brief Switch the text branch between sparse track and per-frame telemetry
  *
- * instantiate pads and add them to element
- * set pad calback functions
- * initialize instance structure
+ * In per-frame mode the text branch is only the identity element, without
+ * queue nor muxer pad. The text samples are only kept as the "last sample"
+ * and the encoded video frames carry it in their own data.
+ * =============================
+ * --- text ---> plugin_identity (last sample)
+ * plugin_theora_enc -> (record appended) -> plugin_video_queue -> matroskamux
+ * =============================
  *
- * @param hthstreamsink The plugin instance
+ * @param hthstreamsink The plugin instance, in the NULL or READY state
+ * @param enable TRUE for per-frame telemetry
  * @return void
  */
-static void gst_hthstreamsink_init (Gsththstreamsink *hthstreamsink) {
-    
+static void setFrameTelemetryMode(Gsththstreamsink *hthstreamsink, gboolean enable);
+
+/**
+ * @brief Put the per-frame telemetry probes and links on the elements of one branch
+ *
+ * Used when the mode is enabled and when the video or text branch is rebuilt.
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return void
+ */
+static void setBranchTelemetry(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Keep the last text sample and drop it from the text branch
+ *
+ * The events are dropped too, the identity src pad is not linked.
+ *
+ * @param pad plugin_identity sink pad
+ * @param info Probe info with the text buffer or event
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP
+ */
+static GstPadProbeReturn cb_textTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Attach the last text sample to each encoded video frame
+ *
+ * Appends a record to the frame data when the sample changed or the
+ * frame is a key frame.
+ *
+ * @param pad plugin_video_queue sink pad
+ * @param info Probe info with the encoded frame
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_videoTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Put the stream id header in front of each datagram
+ *
+ * The header is prepended as its own memory, udpsink sends both memories
+ * with one sendmsg() so the muxer output is not copied. It is added at
+ * the muxer output, so the datagrams lost by the impairment leave a gap
+ * in the numbers.
+ *
+ * @param pad plugin_matroska_mux src pad
+ * @param info Probe info with the muxer output
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_streamIdProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Put hthimpair between the muxer and udpsink, or take it out
+ *
+ * @param hthstreamsink The plugin instance, in the NULL state
+ * @param description Properties of hthimpair, NULL or empty for none
+ * @return void
+ */
+static void setImpairment(Gsththstreamsink *hthstreamsink, const gchar *description);
+
+/**
+ * @brief Factory of the first element of the video branch
+ *
+ * @param hthstreamsink The plugin instance
+ * @return const gchar* timeoverlay, or identity with the glyph overlay
+ */
+static const gchar *getOverlayFactory(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Rebuild the video branch with the timeoverlay element or the glyph overlay
+ *
+ * @param hthstreamsink The plugin instance, in the NULL state
+ * @param mode glyph, pango or meta
+ * @return void
+ */
+static void setTimeOverlay(Gsththstreamsink *hthstreamsink, const gchar *mode);
+
+/**
+ * @brief The branch takes encoded input, parsed and muxed without encoder
+ *
+ * @param hthstreamsink The plugin instance
+ * @param branch The branch
+ * @return gboolean TRUE when video-input or audio-input is not raw
+ */
+static gboolean isBranchPassthrough(Gsththstreamsink *hthstreamsink, HthStreamBranch branch);
+
+/**
+ * @brief Parser of an encoded input
+ *
+ * @param branch BRANCH_VIDEO or BRANCH_AUDIO
+ * @param input video-input or audio-input
+ * @return const gchar* Parser factory, NULL for raw or an unknown input
+ */
+static const gchar *getParserFactory(HthStreamBranch branch, const gchar *input);
+
+/**
+ * @brief Rebuild a branch with the encoder or with the parser of an encoded input
+ *
+ * @param hthstreamsink The plugin instance, in the NULL state
+ * @param branch BRANCH_VIDEO or BRANCH_AUDIO
+ * @param input raw or one of the inputs of encodedInputs
+ * @return void
+ */
+static void setBranchInput(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, const gchar *input);
+
+/**
+ * @brief Pass motion-gate, motion-threshold, motion-keepalive and skip-duplicates to the gate
+ *
+ * @param hthstreamsink The plugin instance
+ * @return void
+ */
+static void configureMotionGate(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Rebuild the audio branch with the encoder of a codec
+ *
+ * @param hthstreamsink The plugin instance, in the NULL state
+ * @param codec vorbis or opus
+ * @return void
+ */
+static void setAudioCodec(Gsththstreamsink *hthstreamsink, const gchar *codec);
+
+/**
+ * @brief Pass the opus-* properties to opusenc
+ *
+ * Does nothing with vorbisenc or an encoded audio input.
+ *
+ * @param hthstreamsink The plugin instance
+ * @return void
+ */
+static void configureAudioEncoder(Gsththstreamsink *hthstreamsink);
+
+/**
+ * @brief Attach the capture time of each raw frame as a GstHthCaptureMeta
+ *
+ * The capture time is the absolute time of the pipeline clock the frame
+ * was due at: base time plus the running time of its PTS. A receiver
+ * sharing the clock (the system monotonic clock, or a network clock)
+ * compares it with its own clock time for the end to end latency.
+ *
+ * The meta follows the frame through videorate and theoraenc, and
+ * cb_videoTelemetryProbe appends it in the frame record.
+ *
+ * @param pad src pad of the identity in front of the video branch
+ * @param info Probe info with the raw frame
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_captureTimeProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Count the datagrams sent and post the periodic encoder stats
+ *
+ * @param pad plugin_udp_sink sink pad
+ * @param info Probe info with the datagram
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK
+ */
+static GstPadProbeReturn cb_senderStatsProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief Add the videorate, send queue and socket counters to a structure
+ *
+ * Adds videorate-in, videorate-out, videorate-drops, videorate-duplicates,
+ * send-queue-buffers, send-queue-bytes and send-socket-queue.
+ *
+ * @param hthstreamsink The plugin instance
+ * @param structure Structure to fill
+ * @return void
+ */
+static void appendSenderStats(Gsththstreamsink *hthstreamsink, GstStructure *structure);
+
+//==============================================================================
+
+/**
+ * @brief GObject vmethod implementations
+ * initialize the hthstreamsink class
+ *
+ */
+static void gst_hthstreamsink_class_init (GsththstreamsinkClass * klass){
+    
+    printf(WHITE "Bin-plugin  -- Serialtextsrc Class Init ---  \n" RESET);
+    
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    GstBinClass *gstbin_class;
+    
+    gobject_class = (GObjectClass *) klass;
+    gstelement_class = (GstElementClass *) klass;
+    gstbin_class = (GstBinClass *) klass;
+    
+    gstbin_class->handle_message = gst_hthstreamsink_handle_message;
+    
+    gobject_class->set_property = gst_hthstreamsink_set_property;
+    gobject_class->get_property = gst_hthstreamsink_get_property;
+    gobject_class->finalize = gst_hthstreamsink_finalize;
+    
+    /** Install properties*/
+    g_object_class_install_property (gobject_class, PROP_HOST,
+                                     g_param_spec_string ("host", "Host",
+                                                          "Address to send packets for" , NULL,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_PORT,
+                                     g_param_spec_int ("port", "Port", "The port that receives the packets",
+                                                       0, G_MAXUINT16,
+                                                       0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_FRAME_TELEMETRY,
+                                     g_param_spec_boolean ("frame-telemetry", "Frame telemetry",
+                                                           "Carry the last serial text sample in the video frames instead of a sparse text track, no text queue nor track is used, video-input=raw only (NULL or READY state only)",
+                                                           DEFAULT_FRAME_TELEMETRY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STREAM_ID,
+                                     g_param_spec_uint ("stream-id", "Stream id",
+                                                        "Id put in a header in front of each datagram, for hthstreamsrc stream-id-header=true. 0 sends no header",
+                                                        0, G_MAXUINT32, DEFAULT_STREAM_ID,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_SHARED_TASK_POOL,
+                                     g_param_spec_boolean ("shared-task-pool", "Shared task pool",
+                                                           "Run the streaming tasks of the internal elements on the pool shared by all the hth elements of the process, one thread per core, grown to one per task when they outnumber the cores",
+                                                           DEFAULT_SHARED_TASK_POOL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_VIDEO_CPUS,
+                                     g_param_spec_string ("video-cpus", "Video CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the video threads: the source thread running the overlay, videorate and theoraenc (hth-video-enc) and the video queue thread (hth-video-tx)",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_AUDIO_CPUS,
+                                     g_param_spec_string ("audio-cpus", "Audio CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the audio threads: the capture thread running audioconvert and the Vorbis or Opus encoder (hth-audio-enc) and the audio queue thread (hth-audio-tx)",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_TEXT_CPUS,
+                                     g_param_spec_string ("text-cpus", "Text CPUs",
+                                                          "CPU list (e.g. \"0-1,4\") of the text threads: the serial source thread (hth-text-enc) and the text queue thread (hth-text-tx), which frame-telemetry removes",
+                                                          DEFAULT_CPUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RT_POLICY,
+                                     g_param_spec_string ("rt-policy", "Real-time policy",
+                                                          "Scheduling of the internal streaming threads: other, fifo or rr",
+                                                          DEFAULT_RT_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RT_PRIORITY,
+                                     g_param_spec_int ("rt-priority", "Real-time priority",
+                                                       "Priority of the internal streaming threads with rt-policy fifo or rr",
+                                                       1, 99, DEFAULT_RT_PRIORITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_QUEUELESS,
+                                     g_param_spec_boolean ("queueless", "Queueless",
+                                                           "Build the branches with identity instead of queue2: no queue thread, the encoders and the muxer run in the threads of the sources, which block each other in the muxer; not a single-thread scheduler (NULL state only)",
+                                                           DEFAULT_QUEUELESS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_VIDEO_DEADLINE,
+                                     g_param_spec_uint ("video-deadline", "Video deadline",
+                                                        "Drop the video frames that reach the encoder later than this many milliseconds after their running time, 0 never drops",
+                                                        0, G_MAXUINT, DEFAULT_VIDEO_DEADLINE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_MAX_MEMORY,
+                                     g_param_spec_uint64 ("max-memory", "Max memory",
+                                                          "Bytes the buffers of all the internal queues may hold together, video is dropped above 80%, audio above 95% and text only when full, also sets max-size-bytes of the queues; 0 for no limit",
+                                                          0, G_MAXUINT64, DEFAULT_MAX_MEMORY,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_LATENCY_TRACING,
+                                     g_param_spec_boolean ("latency-tracing", "Latency tracing",
+                                                           "Measure the time the buffers spend in every internal element, the muxer and the whole branch",
+                                                           DEFAULT_LATENCY_TRACING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_LATENCY_INTERVAL,
+                                     g_param_spec_uint ("latency-interval", "Latency interval",
+                                                        "Milliseconds between two hth-latency element messages while latency-tracing is on, 0 posts none",
+                                                        0, G_MAXUINT, DEFAULT_LATENCY_INTERVAL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_ENCODER_STATS_INTERVAL,
+                                     g_param_spec_uint ("encoder-stats-interval", "Encoder stats interval",
+                                                        "Milliseconds between two hth-encoder-stats element messages with the encoder and sender counters, 0 posts none",
+                                                        0, G_MAXUINT, DEFAULT_ENCODER_STATS_INTERVAL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_IMPAIRMENT,
+                                     g_param_spec_string ("impairment", "Impairment",
+                                                          "Properties of an hthimpair element put between the muxer and udpsink, e.g. \"loss=1 delay=40 seed=7\"",
+                                                          DEFAULT_IMPAIRMENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_TIME_OVERLAY,
+                                     g_param_spec_string ("time-overlay", "Time overlay",
+                                                          "How the PTS is drawn on the video frames: glyph copies the digits from a prerendered atlas into the luma plane, pango uses timeoverlay, meta sends the capture time (base time plus running time of the frame) in the frame-telemetry records instead and needs frame-telemetry=true to go to READY (NULL state only)",
+                                                          DEFAULT_TIME_OVERLAY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_MOTION_GATE,
+                                     g_param_spec_boolean ("motion-gate", "Motion gate",
+                                                           "Drop the video frames that did not change ahead of the encoder, a static scene is sent at one frame per motion-keepalive",
+                                                           DEFAULT_MOTION_GATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_MOTION_THRESHOLD,
+                                     g_param_spec_double ("motion-threshold", "Motion threshold",
+                                                          "Percent of the sampled luma cells that must change from the last frame encoded for a frame to be motion",
+                                                          0.0, 100.0, DEFAULT_MOTION_THRESHOLD,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_MOTION_KEEPALIVE,
+                                     g_param_spec_uint ("motion-keepalive", "Motion keepalive",
+                                                        "Milliseconds between two frames encoded while the scene is static or repeated, 0 encodes every frame",
+                                                        0, G_MAXUINT, DEFAULT_MOTION_KEEPALIVE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_SKIP_DUPLICATES,
+                                     g_param_spec_boolean ("skip-duplicates", "Skip duplicates",
+                                                           "Drop the frames videorate repeats to reach 30 fps instead of sending them as zero-byte Theora duplicates, the stream becomes variable frame rate; one per motion-keepalive is still encoded",
+                                                           DEFAULT_SKIP_DUPLICATES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_VIDEO_INPUT,
+                                     g_param_spec_string ("video-input", "Video input",
+                                                          "Format taken by video_sink: raw is encoded with theoraenc, theora, vp8 or h264 are parsed and muxed as they are, without overlay, scaling, rate nor encoder (NULL state only)",
+                                                          DEFAULT_VIDEO_INPUT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_AUDIO_INPUT,
+                                     g_param_spec_string ("audio-input", "Audio input",
+                                                          "Format taken by audio_sink: raw is encoded with vorbisenc, vorbis or opus are parsed and muxed as they are (NULL state only)",
+                                                          DEFAULT_AUDIO_INPUT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_AUDIO_CODEC,
+                                     g_param_spec_string ("audio-codec", "Audio codec",
+                                                          "Encoder of the raw audio: vorbis, or opus in restricted low delay mode (NULL state only)",
+                                                          DEFAULT_AUDIO_CODEC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_OPUS_FRAME_SIZE,
+                                     g_param_spec_double ("opus-frame-size", "Opus frame size",
+                                                          "Milliseconds of audio in each Opus packet: 2.5, 5, 10, 20, 40 or 60, other values are rounded down",
+                                                          2.5, 60.0, DEFAULT_OPUS_FRAME_SIZE,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_OPUS_BITRATE,
+                                     g_param_spec_uint ("opus-bitrate", "Opus bitrate",
+                                                        "Bits per second of the Opus stream",
+                                                        4000, 650000, DEFAULT_OPUS_BITRATE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_OPUS_INBAND_FEC,
+                                     g_param_spec_boolean ("opus-inband-fec", "Opus in-band FEC",
+                                                           "Each Opus packet carries a low bitrate copy of the previous one, the receiver rebuilds a single lost packet from it",
+                                                           DEFAULT_OPUS_INBAND_FEC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_OPUS_DTX,
+                                     g_param_spec_boolean ("opus-dtx", "Opus DTX",
+                                                           "Send one Opus packet every 400 ms during silence instead of one per frame",
+                                                           DEFAULT_OPUS_DTX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STATS,
+                                     g_param_spec_boxed ("stats", "Statistics",
+                                                         "Restarts and time-to-restore of the branches, shared pool and jitter, memory, latency, encoder, overlay, motion, sender, rate and impairment counters",
+                                                         GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    
+    gst_element_class_set_details_simple(gstelement_class,
+                                         "hthstreamsink",
+                                         "FIXME:Generic",
+                                         "FIXME:Generic Template Element",
+                                         "basultobd <<user@hostname.org>>");
+    
+    gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_bin_change_state);
+}
+
+//==============================================================================
+
+/**
+ * @brief initialize the new element
+ *
+ *
+ * instantiate pads and add them to element
+ * set pad calback functions
+ * initialize instance structure
+ *
+ * @param hthstreamsink The plugin instance
+ * @return void
+ */
+static void gst_hthstreamsink_init (Gsththstreamsink *hthstreamsink) {
+    
     printf(WHITE "Bin-plugin  -- Serialtextsrc Init ---  \n" RESET);
     
     /** Set plugin properties */
@@ -295,23 +1062,93 @@ static void gst_hthstreamsink_init (Gsththstreamsink *hthstreamsink) {
     printf(GREEN "Default host %s \n" RESET, hthstreamsink->host);
     hthstreamsink->port = DEFAULT_PORT;
     printf(GREEN "Default port %d \n" RESET, hthstreamsink->port);
+    hthstreamsink->frameTelemetry = DEFAULT_FRAME_TELEMETRY;
+    hthstreamsink->streamId = DEFAULT_STREAM_ID;
+    hthstreamsink->streamSequence = 0;
+    hthstreamsink->sharedTaskPool = DEFAULT_SHARED_TASK_POOL;
+    hthstreamsink->videoCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsink->audioCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsink->textCpus = g_strdup(DEFAULT_CPUS);
+    hthstreamsink->rtPolicy = g_strdup(DEFAULT_RT_POLICY);
+    hthstreamsink->rtPriority = DEFAULT_RT_PRIORITY;
+    hthstreamsink->queueless = DEFAULT_QUEUELESS;
+    hthstreamsink->videoDeadline = DEFAULT_VIDEO_DEADLINE;
+    hthstreamsink->memory = gst_hth_memory_new();
+    gst_hth_memory_set_limit(hthstreamsink->memory, DEFAULT_MAX_MEMORY);
+    hthstreamsink->latencyTracing = DEFAULT_LATENCY_TRACING;
+    hthstreamsink->latency = gst_hth_latency_new(GST_ELEMENT(hthstreamsink));
+    hthstreamsink->latencyInterval = DEFAULT_LATENCY_INTERVAL;
+    gst_hth_latency_set_interval(hthstreamsink->latency, DEFAULT_LATENCY_INTERVAL * GST_MSECOND);
+    hthstreamsink->encoderStatsInterval = DEFAULT_ENCODER_STATS_INTERVAL;
+    hthstreamsink->encoderStats = gst_hth_encoder_stats_new();
+    hthstreamsink->impairment = g_strdup(DEFAULT_IMPAIRMENT);
+    hthstreamsink->plugin_impairment = NULL;
+    hthstreamsink->timeOverlay = g_strdup(DEFAULT_TIME_OVERLAY);
+    hthstreamsink->overlay = gst_hth_overlay_new();
+    hthstreamsink->motionGate = DEFAULT_MOTION_GATE;
+    hthstreamsink->motionThreshold = DEFAULT_MOTION_THRESHOLD;
+    hthstreamsink->motionKeepalive = DEFAULT_MOTION_KEEPALIVE;
+    hthstreamsink->skipDuplicates = DEFAULT_SKIP_DUPLICATES;
+    hthstreamsink->videoInput = g_strdup(DEFAULT_VIDEO_INPUT);
+    hthstreamsink->audioInput = g_strdup(DEFAULT_AUDIO_INPUT);
+    hthstreamsink->audioCodec = g_strdup(DEFAULT_AUDIO_CODEC);
+    hthstreamsink->opusFrameSize = DEFAULT_OPUS_FRAME_SIZE;
+    hthstreamsink->opusBitrate = DEFAULT_OPUS_BITRATE;
+    hthstreamsink->opusInbandFec = DEFAULT_OPUS_INBAND_FEC;
+    hthstreamsink->opusDtx = DEFAULT_OPUS_DTX;
+    hthstreamsink->motion = gst_hth_motion_new();
+    configureMotionGate(hthstreamsink);
+    hthstreamsink->videoLateDrops = 0;
+    hthstreamsink->rateTime = 0;
+    
+    /** Frame telemetry */
+    g_mutex_init(&hthstreamsink->telemetryLock);
+    hthstreamsink->telemetryText = NULL;
+    hthstreamsink->telemetryTime = GST_CLOCK_TIME_NONE;
+    hthstreamsink->telemetryChanged = FALSE;
+    hthstreamsink->videoTelemetryProbeId = 0;
+    
+    /** Branches */
+    gst_hth_branch_init(&hthstreamsink->videoBranch, GST_ELEMENT(hthstreamsink), "video");
+    gst_hth_branch_init(&hthstreamsink->audioBranch, GST_ELEMENT(hthstreamsink), "audio");
+    gst_hth_branch_init(&hthstreamsink->textBranch, GST_ELEMENT(hthstreamsink), "text");
+    gst_hth_jitter_init(&hthstreamsink->videoJitter, "video");
+    gst_hth_jitter_init(&hthstreamsink->audioJitter, "audio");
+    gst_hth_jitter_init(&hthstreamsink->textJitter, "text");
+    hthstreamsink->videoMuxPad = NULL;
+    hthstreamsink->audioMuxPad = NULL;
+    hthstreamsink->textMuxPad = NULL;
     
     gboolean isVideoSinkPadActivated;
     gboolean isAudioSinkPadActivated;
     gboolean isTextSinkPadActivated;
+    gboolean isBuilt;
     
     /** Elements  */
     createElements(hthstreamsink);
-    verifyAllElementsCreated(hthstreamsink);
-    setElementsPropsValues(hthstreamsink);
+    isBuilt = verifyAllElementsCreated(hthstreamsink);
     
-    /** Bin */
-    addElementsToBin(hthstreamsink);
-    linkBinElements(hthstreamsink);
+    if (isBuilt) {
+        setElementsPropsValues(hthstreamsink);
+        
+        /** Bin */
+        addElementsToBin(hthstreamsink);
+        isBuilt = linkBinElements(hthstreamsink);
+    }
     
     /** Pads */
-    createPluginGhostPads(hthstreamsink);
-    setPluginSinkPads(hthstreamsink);
+    if (!createPluginGhostPads(hthstreamsink)) {
+        hthstreamsink->constructionFailed = TRUE;
+        return;
+    }
+    watchEncoderThreads(hthstreamsink);
+    if (isBuilt)
+        isBuilt = setPluginSinkPads(hthstreamsink);
+    if (isBuilt)
+        watchBranchJitter(hthstreamsink);
+    
+    /** Reported when the element goes to READY */
+    hthstreamsink->constructionFailed = !isBuilt;
     
     /** plugin sink pads */
     gst_element_add_pad (GST_ELEMENT (hthstreamsink), hthstreamsink->videoSinkPad);
@@ -343,428 +1180,2004 @@ static void gst_hthstreamsink_init (Gsththstreamsink *hthstreamsink) {
 
 //==============================================================================
 
-static void gst_hthstreamsink_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
-    
-    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (object);
+static void gst_hthstreamsink_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (object);
+    
+    switch (prop_id) {
+        case PROP_HOST:
+            
+            hthstreamsink->host = g_value_get_string (value);
+            g_object_set (hthstreamsink->plugin_udp_sink, "host",  hthstreamsink->host, NULL);
+            printf(GREEN "New host: %s \n" RESET , hthstreamsink->host);
+            break;
+        
+        case PROP_PORT:
+            
+            hthstreamsink->port = g_value_get_int(value);
+            g_object_set (hthstreamsink->plugin_udp_sink, "port", hthstreamsink->port, NULL);
+            printf(GREEN "New port: %d \n" RESET , hthstreamsink->port);
+            break;
+        
+        case PROP_FRAME_TELEMETRY:
+            
+            if (GST_STATE(hthstreamsink) > GST_STATE_READY) {
+                printf(RED "frame-telemetry can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            setFrameTelemetryMode(hthstreamsink, g_value_get_boolean(value));
+            printf(GREEN "New frame telemetry: %d \n" RESET , hthstreamsink->frameTelemetry);
+            break;
+        
+        case PROP_STREAM_ID:
+            
+            GST_OBJECT_LOCK(hthstreamsink);
+            hthstreamsink->streamId = g_value_get_uint(value);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            printf(GREEN "New stream id: %u \n" RESET , hthstreamsink->streamId);
+            break;
+        
+        case PROP_SHARED_TASK_POOL:
+            
+            /** The tasks are created when going to PAUSED */
+            if (GST_STATE(hthstreamsink) > GST_STATE_READY) {
+                printf(RED "shared-task-pool can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            hthstreamsink->sharedTaskPool = g_value_get_boolean(value);
+            printf(GREEN "New shared task pool: %d \n" RESET , hthstreamsink->sharedTaskPool);
+            break;
+        
+        case PROP_VIDEO_CPUS:
+            
+            setThreadString(hthstreamsink, &hthstreamsink->videoCpus, value);
+            printf(GREEN "New video CPUs: %s \n" RESET , hthstreamsink->videoCpus ? hthstreamsink->videoCpus : "all");
+            break;
+        
+        case PROP_AUDIO_CPUS:
+            
+            setThreadString(hthstreamsink, &hthstreamsink->audioCpus, value);
+            printf(GREEN "New audio CPUs: %s \n" RESET , hthstreamsink->audioCpus ? hthstreamsink->audioCpus : "all");
+            break;
+        
+        case PROP_TEXT_CPUS:
+            
+            setThreadString(hthstreamsink, &hthstreamsink->textCpus, value);
+            printf(GREEN "New text CPUs: %s \n" RESET , hthstreamsink->textCpus ? hthstreamsink->textCpus : "all");
+            break;
+        
+        case PROP_RT_POLICY:
+            
+            setThreadString(hthstreamsink, &hthstreamsink->rtPolicy, value);
+            printf(GREEN "New real-time policy: %s \n" RESET , hthstreamsink->rtPolicy);
+            break;
+        
+        case PROP_RT_PRIORITY:
+            
+            GST_OBJECT_LOCK(hthstreamsink);
+            hthstreamsink->rtPriority = g_value_get_int(value);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            printf(GREEN "New real-time priority: %d \n" RESET , hthstreamsink->rtPriority);
+            break;
+        
+        case PROP_QUEUELESS:
+            
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "queueless can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setQueuelessMode(hthstreamsink, g_value_get_boolean(value));
+            printf(GREEN "New queueless mode: %d \n" RESET , hthstreamsink->queueless);
+            break;
+        
+        case PROP_IMPAIRMENT:
+            
+            /** The muxer and udpsink are relinked */
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "impairment can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setImpairment(hthstreamsink, g_value_get_string(value));
+            break;
+        
+        case PROP_TIME_OVERLAY:
+            
+            /** The video branch is rebuilt */
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "time-overlay can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setTimeOverlay(hthstreamsink, g_value_get_string(value));
+            printf(GREEN "New time overlay: %s \n" RESET , hthstreamsink->timeOverlay);
+            break;
+    
+        case PROP_VIDEO_INPUT:
+    
+            /** The video branch is rebuilt */
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "video-input can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setBranchInput(hthstreamsink, BRANCH_VIDEO, g_value_get_string(value));
+            printf(GREEN "New video input: %s \n" RESET , hthstreamsink->videoInput);
+            break;
+    
+        case PROP_AUDIO_INPUT:
+    
+            /** The audio branch is rebuilt */
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "audio-input can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setBranchInput(hthstreamsink, BRANCH_AUDIO, g_value_get_string(value));
+            printf(GREEN "New audio input: %s \n" RESET , hthstreamsink->audioInput);
+            break;
+    
+        case PROP_AUDIO_CODEC:
+    
+            /** The audio branch is rebuilt */
+            if (GST_STATE(hthstreamsink) != GST_STATE_NULL) {
+                printf(RED "audio-codec can only be changed in the NULL state \n" RESET);
+                break;
+            }
+            setAudioCodec(hthstreamsink, g_value_get_string(value));
+            printf(GREEN "New audio codec: %s \n" RESET , hthstreamsink->audioCodec);
+            break;
+        
+        case PROP_VIDEO_DEADLINE:
+            
+            GST_OBJECT_LOCK(hthstreamsink);
+            hthstreamsink->videoDeadline = g_value_get_uint(value);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            printf(GREEN "New video deadline: %u ms \n" RESET , hthstreamsink->videoDeadline);
+            break;
+        
+        case PROP_MAX_MEMORY:
+            
+            gst_hth_memory_set_limit(hthstreamsink->memory, g_value_get_uint64(value));
+            printf(GREEN "New max memory: %" G_GUINT64_FORMAT " bytes \n" RESET , g_value_get_uint64(value));
+            break;
+        
+        case PROP_LATENCY_TRACING:
+            
+            setLatencyTracing(hthstreamsink, g_value_get_boolean(value));
+            printf(GREEN "New latency tracing: %d \n" RESET , hthstreamsink->latencyTracing);
+            break;
+        
+        case PROP_LATENCY_INTERVAL:
+            
+            hthstreamsink->latencyInterval = g_value_get_uint(value);
+            gst_hth_latency_set_interval(hthstreamsink->latency, hthstreamsink->latencyInterval * GST_MSECOND);
+            printf(GREEN "New latency interval: %u ms \n" RESET , hthstreamsink->latencyInterval);
+            break;
+        
+        case PROP_ENCODER_STATS_INTERVAL:
+            
+            GST_OBJECT_LOCK(hthstreamsink);
+            hthstreamsink->encoderStatsInterval = g_value_get_uint(value);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            printf(GREEN "New encoder stats interval: %u ms \n" RESET , hthstreamsink->encoderStatsInterval);
+            break;
+        
+        case PROP_MOTION_GATE:
+            
+            hthstreamsink->motionGate = g_value_get_boolean(value);
+            configureMotionGate(hthstreamsink);
+            printf(GREEN "New motion gate: %d \n" RESET , hthstreamsink->motionGate);
+            break;
+        
+        case PROP_MOTION_THRESHOLD:
+            
+            hthstreamsink->motionThreshold = g_value_get_double(value);
+            configureMotionGate(hthstreamsink);
+            printf(GREEN "New motion threshold: %.2f %% \n" RESET , hthstreamsink->motionThreshold);
+            break;
+        
+        case PROP_MOTION_KEEPALIVE:
+            
+            hthstreamsink->motionKeepalive = g_value_get_uint(value);
+            configureMotionGate(hthstreamsink);
+            printf(GREEN "New motion keepalive: %u ms \n" RESET , hthstreamsink->motionKeepalive);
+            break;
+        
+        case PROP_SKIP_DUPLICATES:
+            
+            hthstreamsink->skipDuplicates = g_value_get_boolean(value);
+            configureMotionGate(hthstreamsink);
+            printf(GREEN "New skip duplicates: %d \n" RESET , hthstreamsink->skipDuplicates);
+            break;
+    
+        case PROP_OPUS_FRAME_SIZE:
+    
+            hthstreamsink->opusFrameSize = g_value_get_double(value);
+            configureAudioEncoder(hthstreamsink);
+            printf(GREEN "New opus frame size: %.1f ms \n" RESET , hthstreamsink->opusFrameSize);
+            break;
+    
+        case PROP_OPUS_BITRATE:
+    
+            hthstreamsink->opusBitrate = g_value_get_uint(value);
+            configureAudioEncoder(hthstreamsink);
+            printf(GREEN "New opus bitrate: %u bps \n" RESET , hthstreamsink->opusBitrate);
+            break;
+    
+        case PROP_OPUS_INBAND_FEC:
+    
+            hthstreamsink->opusInbandFec = g_value_get_boolean(value);
+            configureAudioEncoder(hthstreamsink);
+            printf(GREEN "New opus in-band FEC: %d \n" RESET , hthstreamsink->opusInbandFec);
+            break;
+    
+        case PROP_OPUS_DTX:
+    
+            hthstreamsink->opusDtx = g_value_get_boolean(value);
+            configureAudioEncoder(hthstreamsink);
+            printf(GREEN "New opus DTX: %d \n" RESET , hthstreamsink->opusDtx);
+            break;
+        
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static void gst_hthstreamsink_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (object);
+    
+    switch (prop_id) {
+        case PROP_HOST:
+            g_value_set_string (value, hthstreamsink->host);
+            break;
+        case PROP_PORT:
+            g_value_set_int (value, hthstreamsink->port);
+            break;
+        case PROP_FRAME_TELEMETRY:
+            g_value_set_boolean (value, hthstreamsink->frameTelemetry);
+            break;
+        case PROP_STREAM_ID:
+            g_value_set_uint (value, hthstreamsink->streamId);
+            break;
+        case PROP_SHARED_TASK_POOL:
+            g_value_set_boolean (value, hthstreamsink->sharedTaskPool);
+            break;
+        case PROP_VIDEO_CPUS:
+            GST_OBJECT_LOCK(hthstreamsink);
+            g_value_set_string (value, hthstreamsink->videoCpus);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            break;
+        case PROP_AUDIO_CPUS:
+            GST_OBJECT_LOCK(hthstreamsink);
+            g_value_set_string (value, hthstreamsink->audioCpus);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            break;
+        case PROP_TEXT_CPUS:
+            GST_OBJECT_LOCK(hthstreamsink);
+            g_value_set_string (value, hthstreamsink->textCpus);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            break;
+        case PROP_RT_POLICY:
+            GST_OBJECT_LOCK(hthstreamsink);
+            g_value_set_string (value, hthstreamsink->rtPolicy);
+            GST_OBJECT_UNLOCK(hthstreamsink);
+            break;
+        case PROP_RT_PRIORITY:
+            g_value_set_int (value, hthstreamsink->rtPriority);
+            break;
+        case PROP_QUEUELESS:
+            g_value_set_boolean (value, hthstreamsink->queueless);
+            break;
+        case PROP_VIDEO_DEADLINE:
+            g_value_set_uint (value, hthstreamsink->videoDeadline);
+            break;
+        case PROP_MAX_MEMORY:
+            g_value_set_uint64 (value, gst_hth_memory_get_limit(hthstreamsink->memory));
+            break;
+        case PROP_LATENCY_TRACING:
+            g_value_set_boolean (value, hthstreamsink->latencyTracing);
+            break;
+        case PROP_LATENCY_INTERVAL:
+            g_value_set_uint (value, hthstreamsink->latencyInterval);
+            break;
+        case PROP_ENCODER_STATS_INTERVAL:
+            g_value_set_uint (value, hthstreamsink->encoderStatsInterval);
+            break;
+        case PROP_IMPAIRMENT:
+            g_value_set_string (value, hthstreamsink->impairment);
+            break;
+        case PROP_TIME_OVERLAY:
+            g_value_set_string (value, hthstreamsink->timeOverlay);
+            break;
+        case PROP_MOTION_GATE:
+            g_value_set_boolean (value, hthstreamsink->motionGate);
+            break;
+        case PROP_MOTION_THRESHOLD:
+            g_value_set_double (value, hthstreamsink->motionThreshold);
+            break;
+        case PROP_MOTION_KEEPALIVE:
+            g_value_set_uint (value, hthstreamsink->motionKeepalive);
+            break;
+        case PROP_SKIP_DUPLICATES:
+            g_value_set_boolean (value, hthstreamsink->skipDuplicates);
+            break;
+        case PROP_VIDEO_INPUT:
+            g_value_set_string (value, hthstreamsink->videoInput);
+            break;
+        case PROP_AUDIO_INPUT:
+            g_value_set_string (value, hthstreamsink->audioInput);
+            break;
+        case PROP_AUDIO_CODEC:
+            g_value_set_string (value, hthstreamsink->audioCodec);
+            break;
+        case PROP_OPUS_FRAME_SIZE:
+            g_value_set_double (value, hthstreamsink->opusFrameSize);
+            break;
+        case PROP_OPUS_BITRATE:
+            g_value_set_uint (value, hthstreamsink->opusBitrate);
+            break;
+        case PROP_OPUS_INBAND_FEC:
+            g_value_set_boolean (value, hthstreamsink->opusInbandFec);
+            break;
+        case PROP_OPUS_DTX:
+            g_value_set_boolean (value, hthstreamsink->opusDtx);
+            break;
+        case PROP_STATS:
+            g_value_take_boxed (value, createStatsStructure(hthstreamsink));
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static void gst_hthstreamsink_finalize (GObject * object){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (object);
+    
+    g_free(hthstreamsink->telemetryText);
+    g_mutex_clear(&hthstreamsink->telemetryLock);
+    
+    g_free(hthstreamsink->videoCpus);
+    g_free(hthstreamsink->audioCpus);
+    g_free(hthstreamsink->textCpus);
+    g_free(hthstreamsink->rtPolicy);
+    g_free(hthstreamsink->impairment);
+    g_free(hthstreamsink->timeOverlay);
+    g_free(hthstreamsink->videoInput);
+    g_free(hthstreamsink->audioInput);
+    g_free(hthstreamsink->audioCodec);
+    gst_hth_jitter_clear(&hthstreamsink->videoJitter);
+    gst_hth_jitter_clear(&hthstreamsink->audioJitter);
+    gst_hth_jitter_clear(&hthstreamsink->textJitter);
+    gst_hth_memory_unref(hthstreamsink->memory);
+    gst_hth_latency_free(hthstreamsink->latency);
+    gst_hth_encoder_stats_free(hthstreamsink->encoderStats);
+    gst_hth_overlay_free(hthstreamsink->overlay);
+    gst_hth_motion_free(hthstreamsink->motion);
+    
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+//==============================================================================
+
+static void createElements(Gsththstreamsink *hthstreamsink) {
+    
+    /**
+     * Create all the internal elements
+    */
+    
+    createBranchElements(hthstreamsink, BRANCH_VIDEO);
+    createBranchElements(hthstreamsink, BRANCH_AUDIO);
+    createBranchElements(hthstreamsink, BRANCH_TEXT);
+    
+    /** mux */
+    hthstreamsink->plugin_matroska_mux = gst_element_factory_make("matroskamux", "muxer");
+    
+    /** udp sender*/
+    hthstreamsink->plugin_udp_sink = gst_element_factory_make("udpsink", "udp-sender");
+}
+
+//==============================================================================
+
+static void createBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch) {
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            if (isBranchPassthrough(hthstreamsink, BRANCH_VIDEO)) {
+                hthstreamsink->plugin_video_parse = gst_element_factory_make(getParserFactory(BRANCH_VIDEO, hthstreamsink->videoInput), "video-parse");
+                hthstreamsink->plugin_video_queue = gst_element_factory_make(getQueueFactory(hthstreamsink), "video-queue");
+                break;
+            }
+            hthstreamsink->plugin_time_overlay = gst_element_factory_make (getOverlayFactory(hthstreamsink), "time-overlay");
+            hthstreamsink->plugin_caps_filter = gst_element_factory_make("capsfilter", "filter-cap");
+            hthstreamsink->plugin_video_rate = gst_element_factory_make("videorate", "audio-rate");
+            hthstreamsink->plugin_theora_enc = gst_element_factory_make("theoraenc", "video-enc");
+            hthstreamsink->plugin_video_queue = gst_element_factory_make(getQueueFactory(hthstreamsink), "video-queue");
+            break;
+        
+        case BRANCH_AUDIO:
+            if (isBranchPassthrough(hthstreamsink, BRANCH_AUDIO)) {
+                hthstreamsink->plugin_audio_parse = gst_element_factory_make(getParserFactory(BRANCH_AUDIO, hthstreamsink->audioInput), "audio-parse");
+                hthstreamsink->plugin_audio_queue = gst_element_factory_make(getQueueFactory(hthstreamsink), "audio-queue");
+                break;
+            }
+            hthstreamsink->plugin_audio_convert = gst_element_factory_make("audioconvert", "audio-convert");
+            hthstreamsink->plugin_audio_enc = gst_element_factory_make(strcmp(hthstreamsink->audioCodec, AUDIO_CODEC_OPUS) == 0 ? "opusenc" : "vorbisenc",
+                                                                       "audio-encoder");
+            hthstreamsink->plugin_audio_queue = gst_element_factory_make(getQueueFactory(hthstreamsink), "audio-queue");
+            break;
+        
+        case BRANCH_TEXT:
+            hthstreamsink->plugin_identity = gst_element_factory_make("identity", "text-filter");
+            if (!hthstreamsink->frameTelemetry)
+                hthstreamsink->plugin_text_queue = gst_element_factory_make(getQueueFactory(hthstreamsink), "text-queue");
+            break;
+        
+        default:
+            break;
+    }
+    
+    GST_OBJECT_UNLOCK(hthstreamsink);
+}
+
+//==============================================================================
+
+static gboolean verifyAllElementsCreated(Gsththstreamsink *hthstreamsink){
+    
+    /**
+     * Verify that all the internal plugins are created properly
+     */
+    
+    gboolean notAllElementCreated; /**< Boolean that stores the function return values*/
+    
+    notAllElementCreated = !verifyBranchElementsCreated(hthstreamsink, BRANCH_VIDEO)
+        || !verifyBranchElementsCreated(hthstreamsink, BRANCH_AUDIO)
+        || !verifyBranchElementsCreated(hthstreamsink, BRANCH_TEXT)
+        || !hthstreamsink->plugin_matroska_mux
+        || !hthstreamsink->plugin_udp_sink;
+    
+    if (notAllElementCreated) {
+        printf (RED "One element could not be created.\n" RESET);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean verifyBranchElementsCreated(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    guint i;
+    
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+        if (*elements[i] == NULL) {
+            printf (RED "One element of the %s branch could not be created.\n" RESET, getBranchState(hthstreamsink, branch)->name);
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void setElementsPropsValues(Gsththstreamsink *hthstreamsink){
+    
+    GstPad *muxSrcPad;
+    GstPad *udpSinkPad;
+    
+    setBranchPropsValues(hthstreamsink, BRANCH_VIDEO);
+    setBranchPropsValues(hthstreamsink, BRANCH_AUDIO);
+    setBranchPropsValues(hthstreamsink, BRANCH_TEXT);
+    
+    g_object_set (hthstreamsink->plugin_udp_sink, "host", hthstreamsink->host, NULL);
+    g_object_set (hthstreamsink->plugin_udp_sink, "port", hthstreamsink->port, NULL);
+    
+    /** Does nothing while stream-id is 0, ahead of the impairment */
+    muxSrcPad = gst_element_get_static_pad (hthstreamsink->plugin_matroska_mux, "src");
+    gst_pad_add_probe(muxSrcPad, GST_PAD_PROBE_TYPE_BUFFER, cb_streamIdProbe, hthstreamsink, NULL);
+    gst_object_unref(muxSrcPad);
+    
+    /** After the stream id probe, the header counts in the bytes sent */
+    udpSinkPad = gst_element_get_static_pad (hthstreamsink->plugin_udp_sink, "sink");
+    gst_pad_add_probe(udpSinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_senderStatsProbe, hthstreamsink, NULL);
+    gst_object_unref(udpSinkPad);
+    
+}
+
+//==============================================================================
+
+static void setBranchPropsValues(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstCaps *caps;
+    GstPad *encoderSinkPad;
+    GstPad *overlaySrcPad;
+    
+    watchBranchMemory(hthstreamsink, branch);
+    
+    if (branch == BRANCH_AUDIO)
+        configureAudioEncoder(hthstreamsink);
+    
+    /** An encoded input has no frame to scale, gate nor encode */
+    if (branch != BRANCH_VIDEO || isBranchPassthrough(hthstreamsink, BRANCH_VIDEO))
+        return;
+    
+    /**
+     * Configure the streaming capabilities filter
+     */
+    caps = gst_caps_new_simple("video/x-raw",
+                               "width", G_TYPE_INT, 640,
+                               "height", G_TYPE_INT, 480,
+                               NULL);
+    
+    g_object_set(G_OBJECT (hthstreamsink->plugin_caps_filter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+    
+    /** The frames videorate repeats carry GST_BUFFER_FLAG_GAP, they become zero-byte duplicate packets */
+    g_object_set(G_OBJECT (hthstreamsink->plugin_theora_enc), "dup-on-gap", TRUE, NULL);
+    
+    /** First probe of the encoder, the static frames it drops are neither counted nor traced */
+    gst_hth_motion_ignore_time_corner(hthstreamsink->motion, strcmp(hthstreamsink->timeOverlay, TIME_OVERLAY_META) != 0);
+    gst_hth_motion_watch_encoder(hthstreamsink->motion, hthstreamsink->plugin_theora_enc);
+    gst_hth_encoder_stats_watch_encoder(hthstreamsink->encoderStats, hthstreamsink->plugin_theora_enc);
+    
+    /** The identity in front of the branch only carries the glyph overlay or capture time probe */
+    overlaySrcPad = gst_element_get_static_pad(hthstreamsink->plugin_time_overlay, "src");
+    if (strcmp(hthstreamsink->timeOverlay, TIME_OVERLAY_GLYPH) == 0)
+        gst_hth_overlay_watch_pad(hthstreamsink->overlay, overlaySrcPad);
+    else if (strcmp(hthstreamsink->timeOverlay, TIME_OVERLAY_META) == 0)
+        gst_pad_add_probe(overlaySrcPad, GST_PAD_PROBE_TYPE_BUFFER, cb_captureTimeProbe, hthstreamsink, NULL);
+    gst_object_unref(overlaySrcPad);
+    
+    /** Does nothing while video-deadline is 0 */
+    encoderSinkPad = gst_element_get_static_pad(hthstreamsink->plugin_theora_enc, "sink");
+    gst_pad_add_probe(encoderSinkPad, GST_PAD_PROBE_TYPE_BUFFER, cb_videoDeadlineProbe, hthstreamsink, NULL);
+    gst_object_unref(encoderSinkPad);
+}
+
+//==============================================================================
+
+static void watchBranchMemory(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            gst_hth_memory_watch_queue(hthstreamsink->memory, hthstreamsink->plugin_video_queue, GST_HTH_MEMORY_VIDEO);
+            break;
+        case BRANCH_AUDIO:
+            gst_hth_memory_watch_queue(hthstreamsink->memory, hthstreamsink->plugin_audio_queue, GST_HTH_MEMORY_AUDIO);
+            break;
+        case BRANCH_TEXT:
+            gst_hth_memory_watch_queue(hthstreamsink->memory, hthstreamsink->plugin_text_queue, GST_HTH_MEMORY_TEXT);
+            break;
+        default:
+            break;
+    }
+}
+
+//==============================================================================
+
+static void setLatencyTracing(Gsththstreamsink *hthstreamsink, gboolean enable){
+    
+    HthStreamBranch branch;
+    
+    if (hthstreamsink->latencyTracing == enable)
+        return;
+    
+    hthstreamsink->latencyTracing = enable;
+    
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
+    
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        if (enable)
+            traceBranchLatency(hthstreamsink, branch);
+        else
+            untraceBranchLatency(hthstreamsink, branch);
+    }
+}
+
+//==============================================================================
+
+static void traceBranchLatency(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    const gchar *branchName = getBranchState(hthstreamsink, branch)->name;
+    GstPad *entryPad;
+    GstPad *exitPad;
+    GstPad *muxSrcPad;
+    guint elementsCount;
+    guint i;
+    gchar *name;
+    
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+        
+        /** timeoverlay takes the frames on video_sink, identity of the glyph overlay on sink */
+        entryPad = gst_element_get_static_pad(*elements[i], "sink");
+        if (entryPad == NULL)
+            entryPad = gst_element_get_static_pad(*elements[i], "video_sink");
+        exitPad = gst_element_get_static_pad(*elements[i], "src");
+        
+        /** The queue is the last element, identity in queueless mode */
+        if (i + 1 == elementsCount)
+            name = g_strdup_printf("%s-queue", branchName);
+        else
+            name = g_strdup_printf("%s-%s", branchName, GST_OBJECT_NAME(gst_element_get_factory(*elements[i])));
+        
+        gst_hth_latency_add_stage(hthstreamsink->latency, name, entryPad, exitPad, FALSE);
+        
+        g_free(name);
+        if (entryPad != NULL)
+            gst_object_unref(entryPad);
+        if (exitPad != NULL)
+            gst_object_unref(exitPad);
+    }
+    
+    /** The text branch of frame-telemetry ends in the identity */
+    if (*getBranchMuxPad(hthstreamsink, branch) == NULL)
+        return;
+
+    muxSrcPad = gst_element_get_static_pad(hthstreamsink->plugin_matroska_mux, "src");
+
+    name = g_strdup_printf("%s-mux", branchName);
+    gst_hth_latency_add_stage(hthstreamsink->latency, name, *getBranchMuxPad(hthstreamsink, branch), muxSrcPad, FALSE);
+    g_free(name);
+    
+    name = g_strdup_printf("%s-total", branchName);
+    gst_hth_latency_add_stage(hthstreamsink->latency, name, getBranchGhostPad(hthstreamsink, branch), muxSrcPad, FALSE);
+    g_free(name);
+    
+    gst_object_unref(muxSrcPad);
+}
+
+//==============================================================================
+
+static void untraceBranchLatency(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    gchar *prefix = g_strdup_printf("%s-", getBranchState(hthstreamsink, branch)->name);
+    
+    gst_hth_latency_detach_stages(hthstreamsink->latency, prefix);
+    g_free(prefix);
+}
+
+//==============================================================================
+
+static void addElementsToBin(Gsththstreamsink *hthstreamsink){
+    
+    /**
+    * Add elements to the bin filter
+    */
+    
+    addBranchElementsToBin(hthstreamsink, BRANCH_VIDEO);
+    addBranchElementsToBin(hthstreamsink, BRANCH_AUDIO);
+    addBranchElementsToBin(hthstreamsink, BRANCH_TEXT);
+    
+    gst_bin_add_many(GST_BIN(hthstreamsink) ,
+                     GST_ELEMENT(hthstreamsink->plugin_matroska_mux),
+                     GST_ELEMENT(hthstreamsink->plugin_udp_sink),
+                     NULL);
+}
+
+//==============================================================================
+
+static void addBranchElementsToBin(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    guint i;
+    
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    for (i = 0; i < elementsCount; i++)
+        gst_bin_add(GST_BIN(hthstreamsink), *elements[i]);
+}
+
+//==============================================================================
+
+static gboolean linkBinElements(Gsththstreamsink *hthstreamsink){
+    
+    /**
+    *
+    * Link the audio elements and
+    * video elements respectively
+    *
+    */
+    
+    gboolean link_ok; /**< Boolean that stores the function return values*/
+    
+    link_ok = linkBranchElements(hthstreamsink, BRANCH_VIDEO)
+        && linkBranchElements(hthstreamsink, BRANCH_AUDIO)
+        && linkBranchElements(hthstreamsink, BRANCH_TEXT);
+    if (!link_ok)
+        return FALSE;
+    
+    /** link matroska mux and udp sink*/
+    link_ok = gst_element_link(hthstreamsink->plugin_matroska_mux, hthstreamsink->plugin_udp_sink);
+    if (!link_ok){
+        printf(RED "UDP sink fail linking pads with matroska muxer" RESET);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean linkBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstHthBranch *branchState = getBranchState(hthstreamsink, branch);
+    GstPad **muxPad = getBranchMuxPad(hthstreamsink, branch);
+    GstPad *srcPad;
+    guint elementsCount;
+    guint i;
+    gboolean link_ok; /**< Boolean that stores the function return values*/
+    GstPadLinkReturn padLink_ok; /**< Stores the function return values with a specific format*/
+    
+    /** Branch elements linking */
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    for (i = 0; i + 1 < elementsCount; i++) {
+        link_ok = gst_element_link(*elements[i], *elements[i + 1]);
+        if (!link_ok){
+            printf(RED "%s stream elements linking fail" RESET, branchState->name);
+            return FALSE;
+        }
+    }
+    
+    /** The samples leave with the video frames, the muxer must not wait for a text track */
+    if (branch == BRANCH_TEXT && hthstreamsink->frameTelemetry) {
+        if (*muxPad != NULL) {
+            gst_element_release_request_pad(hthstreamsink->plugin_matroska_mux, *muxPad);
+            gst_object_unref(*muxPad);
+            *muxPad = NULL;
+        }
+        return TRUE;
+    }
+
+    /**
+     * The muxer request pads are kept when a branch is rebuilt,
+     * matroskamux doesn't accept new pads once the header is written
+     */
+    if (*muxPad == NULL)
+        *muxPad = gst_element_get_request_pad(hthstreamsink->plugin_matroska_mux, getBranchMuxPadTemplate(branch));
+    
+    /** link the branch queue with muxer*/
+    srcPad = gst_element_get_static_pad(*elements[elementsCount - 1], "src");
+    padLink_ok = *muxPad != NULL ? gst_pad_link(srcPad, *muxPad) : GST_PAD_LINK_REFUSED;
+    gst_object_unref(srcPad);
+    
+    if (padLink_ok != GST_PAD_LINK_OK){
+        printf(RED "New %s sink request pad linking fails" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean createPluginGhostPads(Gsththstreamsink *hthstreamsink){
+    
+    /**
+     * Create sink ghost pads
+     */
+    
+    hthstreamsink->videoSinkPad = gst_ghost_pad_new_no_target_from_template ("video_sink",
+                                                                            gst_static_pad_template_get (&sink_factory));
+    if (!hthstreamsink->videoSinkPad) {
+        printf(RED "filter videoSinkPad ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    hthstreamsink->audioSinkPad = gst_ghost_pad_new_no_target_from_template ("audio_sink",
+                                                                            gst_static_pad_template_get (&sink_factory));
+    if (!hthstreamsink->audioSinkPad) {
+        printf(RED "filter audioSinkPad ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    hthstreamsink->textSinkPad = gst_ghost_pad_new_no_target_from_template ("text_sink",
+                                                                           gst_static_pad_template_get (&sink_factory));
+    if (!hthstreamsink->textSinkPad) {
+        printf(RED "filter textSinkPad ghost pad no created from template \n" RESET);
+        return FALSE;
+    }
+    
+    /** Failures of one branch don't reach the upstream elements */
+    gst_hth_branch_isolate_ghost_pad(&hthstreamsink->videoBranch, hthstreamsink->videoSinkPad);
+    gst_hth_branch_isolate_ghost_pad(&hthstreamsink->audioBranch, hthstreamsink->audioSinkPad);
+    gst_hth_branch_isolate_ghost_pad(&hthstreamsink->textBranch, hthstreamsink->textSinkPad);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static gboolean setPluginSinkPads(Gsththstreamsink *hthstreamsink){
+    
+    /**
+     * Link the ghost pads with the last element of the audio and video flow respectively
+     */
+    
+    return setBranchSinkPad(hthstreamsink, BRANCH_VIDEO)
+        && setBranchSinkPad(hthstreamsink, BRANCH_AUDIO)
+        && setBranchSinkPad(hthstreamsink, BRANCH_TEXT);
+}
+
+//==============================================================================
+
+static gboolean setBranchSinkPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstHthBranch *branchState = getBranchState(hthstreamsink, branch);
+    GstPad *ghostPad = getBranchGhostPad(hthstreamsink, branch);
+    gboolean setGhostPad_ok; /**< Boolean that stores the function return values*/
+    GstPad *elementSinkPad;
+    
+    getBranchElements(hthstreamsink, branch, elements);
+    
+    /** timeoverlay has a video_sink and a text_sink pad */
+    elementSinkPad = gst_element_get_static_pad (*elements[0], "sink");
+    if (elementSinkPad == NULL)
+        elementSinkPad = gst_element_get_static_pad (*elements[0], "video_sink");
+    if (elementSinkPad == NULL) {
+        printf(RED "Fail on get %s sink pad of element \n" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)ghostPad, elementSinkPad);
+    gst_object_unref(elementSinkPad);
+    if(!setGhostPad_ok){
+        printf(RED "%s ghost pad could not be linked with element sink pad \n" RESET, branchState->name);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static guint getBranchElements(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, GstElement **elements[MAX_BRANCH_ELEMENTS]){
+    
+    guint elementsCount = 0;
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            if (isBranchPassthrough(hthstreamsink, BRANCH_VIDEO)) {
+                elements[elementsCount++] = &hthstreamsink->plugin_video_parse;
+                elements[elementsCount++] = &hthstreamsink->plugin_video_queue;
+                break;
+            }
+            elements[elementsCount++] = &hthstreamsink->plugin_time_overlay;
+            elements[elementsCount++] = &hthstreamsink->plugin_caps_filter;
+            elements[elementsCount++] = &hthstreamsink->plugin_video_rate;
+            elements[elementsCount++] = &hthstreamsink->plugin_theora_enc;
+            elements[elementsCount++] = &hthstreamsink->plugin_video_queue;
+            break;
+        
+        case BRANCH_AUDIO:
+            if (isBranchPassthrough(hthstreamsink, BRANCH_AUDIO)) {
+                elements[elementsCount++] = &hthstreamsink->plugin_audio_parse;
+                elements[elementsCount++] = &hthstreamsink->plugin_audio_queue;
+                break;
+            }
+            elements[elementsCount++] = &hthstreamsink->plugin_audio_convert;
+            elements[elementsCount++] = &hthstreamsink->plugin_audio_enc;
+            elements[elementsCount++] = &hthstreamsink->plugin_audio_queue;
+            break;
+        
+        case BRANCH_TEXT:
+            elements[elementsCount++] = &hthstreamsink->plugin_identity;
+            if (!hthstreamsink->frameTelemetry)
+                elements[elementsCount++] = &hthstreamsink->plugin_text_queue;
+            break;
+        
+        default:
+            break;
+    }
+    
+    return elementsCount;
+}
+
+//==============================================================================
+
+static GstHthBranch *getBranchState(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return &hthstreamsink->videoBranch;
+        case BRANCH_AUDIO:
+            return &hthstreamsink->audioBranch;
+        default:
+            return &hthstreamsink->textBranch;
+    }
+}
+
+//==============================================================================
+
+static GstPad *getBranchGhostPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return hthstreamsink->videoSinkPad;
+        case BRANCH_AUDIO:
+            return hthstreamsink->audioSinkPad;
+        default:
+            return hthstreamsink->textSinkPad;
+    }
+}
+
+//==============================================================================
+
+static GstPad **getBranchMuxPad(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return &hthstreamsink->videoMuxPad;
+        case BRANCH_AUDIO:
+            return &hthstreamsink->audioMuxPad;
+        default:
+            return &hthstreamsink->textMuxPad;
+    }
+}
+
+//==============================================================================
+
+static const gchar *getBranchMuxPadTemplate(HthStreamBranch branch){
+    
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return "video_%u";
+        case BRANCH_AUDIO:
+            return "audio_%u";
+        default:
+            return "subtitle_%u";
+    }
+}
+
+//==============================================================================
+
+static HthStreamBranch findElementBranch(Gsththstreamsink *hthstreamsink, GstObject *object){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    HthStreamBranch branch;
+    guint elementsCount;
+    guint i;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        elementsCount = getBranchElements(hthstreamsink, branch, elements);
+        for (i = 0; i < elementsCount; i++) {
+            if (*elements[i] != NULL && object == GST_OBJECT(*elements[i])) {
+                GST_OBJECT_UNLOCK(hthstreamsink);
+                return branch;
+            }
+        }
+    }
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    return BRANCH_NONE;
+}
+
+//==============================================================================
+
+static void gst_hthstreamsink_handle_message (GstBin *bin, GstMessage *message){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (bin);
+    HthStreamBranch branch;
+    GstHthBranchAction action;
+    GError *error;
+    gchar *debug;
+    
+    /** Before the task of the child starts, the message is still forwarded */
+    if (hthstreamsink->sharedTaskPool)
+        gst_hth_task_pool_handle_message(message);
+    
+    /** Posted by the streaming thread itself, before its loop */
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_STREAM_STATUS)
+        setupStreamingThread(hthstreamsink, message);
+    
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_ERROR) {
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    /** Errors of the muxer or udpsink stop the whole element */
+    branch = findElementBranch(hthstreamsink, GST_MESSAGE_SRC(message));
+    if (branch == BRANCH_NONE) {
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    action = gst_hth_branch_fail(getBranchState(hthstreamsink, branch));
+    if (action == GST_HTH_BRANCH_GIVE_UP) {
+        printf(RED "%s branch keeps failing, giving up \n" RESET, getBranchState(hthstreamsink, branch)->name);
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    if (action == GST_HTH_BRANCH_REBUILD) {
+        
+        gst_message_parse_error(message, &error, &debug);
+        printf(RED "%s branch failed: %s, rebuilding \n" RESET, getBranchState(hthstreamsink, branch)->name, error->message);
+        
+        /** The application still gets to know about the failure */
+        gst_element_post_message(GST_ELEMENT(hthstreamsink),
+                                 gst_message_new_warning(GST_OBJECT(hthstreamsink), error, debug));
+        g_error_free(error);
+        g_free(debug);
+        
+        gst_element_call_async(GST_ELEMENT(hthstreamsink), cb_rebuildBranch, GINT_TO_POINTER(branch), NULL);
+    }
+    
+    gst_message_unref(message);
+}
+
+//==============================================================================
+
+static void cb_rebuildBranch(GstElement *element, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (element);
+    HthStreamBranch branch = (HthStreamBranch) GPOINTER_TO_INT(user_data);
+    GstHthBranch *branchState = getBranchState(hthstreamsink, branch);
+    
+    printf(YELLOW "Rebuilding the %s branch \n" RESET, branchState->name);
+    
+    if (!buildBranch(hthstreamsink, branch)) {
+        GST_ELEMENT_ERROR (hthstreamsink, CORE, FAILED, ("The %s branch could not be rebuilt", branchState->name), (NULL));
+        return;
+    }
+    
+    syncBranchStates(hthstreamsink, branch);
+    
+    /** The data flows again, the restore ends with the first buffer reaching the muxer, or the branch with frame-telemetry */
+    gst_hth_branch_rebuilt(branchState, *getBranchMuxPad(hthstreamsink, branch) != NULL ? *getBranchMuxPad(hthstreamsink, branch)
+                                                                                         : getBranchGhostPad(hthstreamsink, branch));
+}
+
+//==============================================================================
+
+static void teardownBranch(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstElement *element;
+    guint elementsCount;
+    guint i;
+    
+    untraceBranchLatency(hthstreamsink, branch);
+    
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    for (i = 0; i < elementsCount; i++) {
+        
+        GST_OBJECT_LOCK(hthstreamsink);
+        element = *elements[i];
+        *elements[i] = NULL;
+        GST_OBJECT_UNLOCK(hthstreamsink);
+        
+        if (element == NULL)
+            continue;
+        
+        /** Removing the element unlinks it from the muxer pad and the ghost pad */
+        gst_element_set_state(element, GST_STATE_NULL);
+        if (GST_OBJECT_PARENT(element) != NULL)
+            gst_bin_remove(GST_BIN(hthstreamsink), element);
+        else
+            gst_object_unref(element);
+    }
+}
+
+//==============================================================================
+
+static void syncBranchStates(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    guint elementsCount;
+    
+    /** Downstream first, so no element pushes into one that is not running */
+    elementsCount = getBranchElements(hthstreamsink, branch, elements);
+    while (elementsCount > 0) {
+        elementsCount--;
+        gst_element_sync_state_with_parent(*elements[elementsCount]);
+    }
+}
+
+//==============================================================================
+
+static GstStructure *createStatsStructure(Gsththstreamsink *hthstreamsink){
+    
+    GstStructure *stats = gst_structure_new_empty("hthstreamsink-stats");
+    
+    gst_hth_branch_append_stats(&hthstreamsink->videoBranch, stats);
+    gst_hth_branch_append_stats(&hthstreamsink->audioBranch, stats);
+    gst_hth_branch_append_stats(&hthstreamsink->textBranch, stats);
+    gst_hth_task_pool_append_stats(stats);
+    gst_hth_jitter_append_stats(&hthstreamsink->videoJitter, stats);
+    gst_hth_jitter_append_stats(&hthstreamsink->audioJitter, stats);
+    gst_hth_jitter_append_stats(&hthstreamsink->textJitter, stats);
+    gst_hth_memory_append_stats(hthstreamsink->memory, stats);
+    gst_hth_latency_append_stats(hthstreamsink->latency, stats);
+    gst_hth_encoder_stats_append(hthstreamsink->encoderStats, stats);
+    gst_hth_overlay_append_stats(hthstreamsink->overlay, stats);
+    gst_hth_motion_append_stats(hthstreamsink->motion, stats);
+    appendSenderStats(hthstreamsink, stats);
+    appendRates(hthstreamsink, stats);
+    
+    if (hthstreamsink->plugin_impairment != NULL)
+        gst_hth_impairment_append_stats(hthstreamsink->plugin_impairment, stats);
+    
+    return stats;
+}
+
+//==============================================================================
+
+static void setFrameTelemetryMode(Gsththstreamsink *hthstreamsink, gboolean enable){
+
+    GstPad *videoQueueSinkPad;
+
+    if (hthstreamsink->frameTelemetry == enable)
+        return;
+
+    hthstreamsink->frameTelemetry = enable;
+
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
+
+    /** The text branch loses or gets back its queue and its muxer pad */
+    if (!buildBranch(hthstreamsink, BRANCH_TEXT)) {
+        printf(RED "The text branch could not be rebuilt \n" RESET);
+        hthstreamsink->constructionFailed = TRUE;
+        return;
+    }
+    syncBranchStates(hthstreamsink, BRANCH_TEXT);
+
+    if (enable) {
+        setBranchTelemetry(hthstreamsink, BRANCH_VIDEO);
+        return;
+    }
+
+    videoQueueSinkPad = gst_element_get_static_pad(hthstreamsink->plugin_video_queue, "sink");
+    gst_pad_remove_probe(videoQueueSinkPad, hthstreamsink->videoTelemetryProbeId);
+    hthstreamsink->videoTelemetryProbeId = 0;
+    gst_object_unref(videoQueueSinkPad);
+
+    /** A new muxer pad */
+    gst_hth_jitter_watch_pad(&hthstreamsink->textJitter, hthstreamsink->textMuxPad);
+}
+
+//==============================================================================
+
+static void setBranchTelemetry(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
+
+    GstPad *identitySinkPad;
+    GstPad *videoQueueSinkPad;
+
+    if (!hthstreamsink->frameTelemetry)
+        return;
+
+    if (branch == BRANCH_VIDEO) {
+
+        videoQueueSinkPad = gst_element_get_static_pad(hthstreamsink->plugin_video_queue, "sink");
+        hthstreamsink->videoTelemetryProbeId = gst_pad_add_probe(videoQueueSinkPad, GST_PAD_PROBE_TYPE_BUFFER,
+                                                                 cb_videoTelemetryProbe, hthstreamsink, NULL);
+        gst_object_unref(videoQueueSinkPad);
+
+    } else if (branch == BRANCH_TEXT) {
+
+        /** Nothing goes past the identity, its src pad is not linked */
+        identitySinkPad = gst_element_get_static_pad(hthstreamsink->plugin_identity, "sink");
+        gst_pad_add_probe(identitySinkPad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                          cb_textTelemetryProbe, hthstreamsink, NULL);
+        gst_object_unref(identitySinkPad);
+    }
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_textTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstBuffer *buffer;
+    GstMapInfo map;
+    gchar *text;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM)
+        return GST_PAD_PROBE_DROP;
+
+    buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ))
+        return GST_PAD_PROBE_DROP;
+
+    /** serialtextsrc buffers are not always NUL terminated */
+    text = g_strndup((const gchar*)map.data, map.size);
+    gst_buffer_unmap(buffer, &map);
+
+    g_mutex_lock(&hthstreamsink->telemetryLock);
+    if (g_strcmp0(text, hthstreamsink->telemetryText) != 0) {
+        g_free(hthstreamsink->telemetryText);
+        hthstreamsink->telemetryText = text;
+        hthstreamsink->telemetryChanged = TRUE;
+        text = NULL;
+    }
+    hthstreamsink->telemetryTime = GST_BUFFER_PTS(buffer);
+    g_mutex_unlock(&hthstreamsink->telemetryLock);
+
+    g_free(text);
+
+    return GST_PAD_PROBE_DROP;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_videoTelemetryProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstHthTelemetryMeta *telemetryMeta = NULL;
+    GstHthCaptureMeta *captureMeta;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gchar *text;
+    GstClockTime sampleTime;
+    GstClockTime captureTime = GST_CLOCK_TIME_NONE;
+    gboolean changed;
+
+    /** The stream headers go in the codec private data of the track, they must stay as they are */
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_HEADER))
+        return GST_PAD_PROBE_OK;
+    
+    /** A duplicate frame of dup-on-gap must stay empty to be decoded as one, the next frame carries the record */
+    if (gst_buffer_get_size(buffer) == 0)
+        return GST_PAD_PROBE_OK;
+
+    /** Set by cb_captureTimeProbe with time-overlay=meta */
+    captureMeta = gst_buffer_get_hth_capture_meta(buffer);
+    if (captureMeta != NULL)
+        captureTime = captureMeta->captureTime;
+
+    g_mutex_lock(&hthstreamsink->telemetryLock);
+    if (hthstreamsink->telemetryText == NULL && !GST_CLOCK_TIME_IS_VALID(captureTime)) {
+        g_mutex_unlock(&hthstreamsink->telemetryLock);
+        return GST_PAD_PROBE_OK;
+    }
+    text = g_strdup(hthstreamsink->telemetryText);
+    sampleTime = hthstreamsink->telemetryTime;
+    changed = hthstreamsink->telemetryChanged;
+    hthstreamsink->telemetryChanged = FALSE;
+    g_mutex_unlock(&hthstreamsink->telemetryLock);
+
+    buffer = gst_buffer_make_writable(buffer);
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    if (text != NULL)
+        telemetryMeta = gst_buffer_add_hth_telemetry_meta(buffer, text, sampleTime);
+
+    /**
+     * matroskamux drops the buffer metas, so the sample is appended to the
+     * frame data. The receiver keeps the last record, so only changes and
+     * key frames (for late joiners) need one, unless every frame has its
+     * own capture time.
+     */
+    if (changed || GST_CLOCK_TIME_IS_VALID(captureTime) || !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+        gst_hth_frame_record_append(buffer, telemetryMeta, captureTime);
+
+    g_free(text);
+
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstStateChangeReturn gst_bin_change_state (GstElement *element, GstStateChange trans)
+{
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (element);
+    GstStateChangeReturn ret;
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_NULL_TO_READY:
+            printf(BLUE "GST_STATE_CHANGE_NULL_TO_READY\n" RESET);
+            if (hthstreamsink->constructionFailed) {
+                GST_ELEMENT_ERROR (hthstreamsink, CORE, FAILED, ("Internal elements could not be created or linked"), (NULL));
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            /** The capture time travels in the frame records, turning frame-telemetry on would remove the text track */
+            if (strcmp(hthstreamsink->timeOverlay, TIME_OVERLAY_META) == 0 && !hthstreamsink->frameTelemetry) {
+                GST_ELEMENT_ERROR (hthstreamsink, CORE, NEGOTIATION, ("time-overlay=meta needs frame-telemetry=true"), (NULL));
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            /** The records are appended to the frames, only theoraenc output is known to be decoded with them */
+            if (hthstreamsink->frameTelemetry && isBranchPassthrough(hthstreamsink, BRANCH_VIDEO)) {
+                GST_ELEMENT_ERROR (hthstreamsink, CORE, NEGOTIATION, ("frame-telemetry=true needs video-input=raw, not %s",
+                                   hthstreamsink->videoInput), (NULL));
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            break;
+        
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            printf(YELLOW "GST_STATE_CHANGE_READY_TO_PAUSED\n" RESET);
+            break;
+        
+        case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+            printf(GREEN "GST_STATE_CHANGE_PAUSED_TO_PLAYING\n" RESET);
+            break;
+        
+        case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+            printf(GREEN "GST_STATE_CHANGE_PLAYING_TO_PAUSED\n" RESET);
+        
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            printf(YELLOW "GST_STATE_CHANGE_PAUSED_TO_READY\n" RESET);
+            break;
+        
+        case GST_STATE_CHANGE_READY_TO_NULL:
+            printf(BLUE "GST_STATE_CHANGE_READY_TO_NULL\n" RESET);
+            break;
+        
+        default:
+            break;
+    }
+    
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            
+            /** The streaming threads are stopped, the next stream starts without sample */
+            g_mutex_lock(&hthstreamsink->telemetryLock);
+            g_free(hthstreamsink->telemetryText);
+            hthstreamsink->telemetryText = NULL;
+            hthstreamsink->telemetryChanged = FALSE;
+            g_mutex_unlock(&hthstreamsink->telemetryLock);
+            break;
+        
+        default:
+            break;
+    }
+    
+    return ret;
+}
+
+
+//==============================================================================
+
+/**
+ *
+ * @brief entry point to initialize the plug-in
+ *
+ * initialize the plug-in itself
+ * register the element factories and other features
+ */
+static gboolean hthstreamsink_init (GstPlugin * hthstreamsink){
+    
+    printf(WHITE "Bin-plugin  -- Serialtextsrc --- Init plugin function \n" RESET);
+    
+    /** Debug category for fltering log messages
+    * exchange the string 'Template hthstreamsink' with your description
+    */
+    
+    GST_DEBUG_CATEGORY_INIT (gst_hthstreamsink_debug, "hthstreamsink",0, "Template hthstreamsink");
+    
+    return gst_element_register (hthstreamsink, "hthstreamsink", GST_RANK_NONE, GST_TYPE_HTHSTREAMSINK);
+}
+
+//==============================================================================
+
+/* PACKAGE: this is usually set by autotools depending on some _INIT macro
+ * in configure.ac and then written into and defined in config.h, but we can
+ * just set it ourselves here in case someone doesn't use autotools to
+ * compile this code. GST_PLUGIN_DEFINE needs PACKAGE to be defined.
+ */
+#ifndef PACKAGE
+#define PACKAGE "myfirsththstreamsink"
+#endif
+
+/* gstreamer looks for this structure to register hthstreamsinks
+ *
+ * exchange the string 'Template hthstreamsink' with your hthstreamsink description
+ */
+GST_PLUGIN_DEFINE (
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    hthstreamsink,
+"Template hthstreamsink",
+hthstreamsink_init,
+VERSION,
+"LGPL",
+"GStreamer",
+"http://gstreamer.net/"
+)
+
+//==============================================================================
+
+static GstPadProbeReturn cb_streamIdProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstBuffer *buffer;
+    guint streamId;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    streamId = hthstreamsink->streamId;
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    if (streamId == 0)
+        return GST_PAD_PROBE_OK;
+    
+    /** Only the buffer is copied, the memories of the muxer are shared */
+    buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+    gst_buffer_prepend_memory(buffer, gst_hth_stream_id_header_new(streamId, hthstreamsink->streamSequence++));
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_senderStatsProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstStructure *message;
+    GstClockTime interval;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    interval = hthstreamsink->encoderStatsInterval * GST_MSECOND;
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    if (!gst_hth_encoder_stats_count_datagram(hthstreamsink->encoderStats, gst_buffer_get_size(buffer), interval))
+        return GST_PAD_PROBE_OK;
+    
+    message = gst_structure_new_empty(HTH_ENCODER_STATS_MESSAGE);
+    gst_hth_encoder_stats_append(hthstreamsink->encoderStats, message);
+    gst_hth_motion_append_stats(hthstreamsink->motion, message);
+    appendSenderStats(hthstreamsink, message);
+    gst_element_post_message(GST_ELEMENT(hthstreamsink), gst_message_new_element(GST_OBJECT(hthstreamsink), message));
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+static void appendSenderStats(Gsththstreamsink *hthstreamsink, GstStructure *structure){
+    
+    GstElement **elements[MAX_BRANCH_ELEMENTS];
+    GstElement *videoRate;
+    GstElement *queue;
+    GObject *socket = NULL;
+    HthStreamBranch branch;
+    guint64 rateIn = 0, rateOut = 0, rateDrops = 0, rateDuplicates = 0;
+    guint64 queueBuffers = 0, queueBytes = 0;
+    guint levelBuffers, levelBytes;
+    guint elementsCount;
+    gint socketQueue = 0;
+    gint fd = -1;
+    
+    /** The elements may be replaced by a rebuild meanwhile */
+    GST_OBJECT_LOCK(hthstreamsink);
+    videoRate = hthstreamsink->plugin_video_rate ? gst_object_ref(hthstreamsink->plugin_video_rate) : NULL;
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    if (videoRate != NULL) {
+        g_object_get(videoRate, "in", &rateIn, "out", &rateOut, "drop", &rateDrops, "duplicate", &rateDuplicates, NULL);
+        gst_object_unref(videoRate);
+    }
     
-    switch (prop_id) {
-        case PROP_HOST:
-            
-            hthstreamsink->host = g_value_get_string (value);
-            g_object_set (hthstreamsink->plugin_udp_sink, "host",  hthstreamsink->host, NULL);
-            printf(GREEN "New host: %s \n" RESET , hthstreamsink->host);
-            break;
+    /** The queue is the last element of each branch, identity in queueless mode has no level */
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
         
-        case PROP_PORT:
-            
-            hthstreamsink->port = g_value_get_int(value);
-            g_object_set (hthstreamsink->plugin_udp_sink, "port", hthstreamsink->port, NULL);
-            printf(GREEN "New port: %d \n" RESET , hthstreamsink->port);
-            break;
+        GST_OBJECT_LOCK(hthstreamsink);
+        elementsCount = getBranchElements(hthstreamsink, branch, elements);
+        queue = *elements[elementsCount - 1] ? gst_object_ref(*elements[elementsCount - 1]) : NULL;
+        GST_OBJECT_UNLOCK(hthstreamsink);
         
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
+        if (queue == NULL)
+            continue;
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(queue), "current-level-buffers") != NULL) {
+            g_object_get(queue, "current-level-buffers", &levelBuffers, "current-level-bytes", &levelBytes, NULL);
+            queueBuffers += levelBuffers;
+            queueBytes += levelBytes;
+        }
+        gst_object_unref(queue);
     }
+    
+    /** Bytes the kernel did not send yet */
+    g_object_get(hthstreamsink->plugin_udp_sink, "used-socket", &socket, NULL);
+    if (socket != NULL) {
+        g_object_get(socket, "fd", &fd, NULL);
+        if (fd < 0 || ioctl(fd, SIOCOUTQ, &socketQueue) < 0)
+            socketQueue = 0;
+        g_object_unref(socket);
+    }
+    
+    gst_structure_set(structure,
+                      "videorate-in", G_TYPE_UINT64, rateIn,
+                      "videorate-out", G_TYPE_UINT64, rateOut,
+                      "videorate-drops", G_TYPE_UINT64, rateDrops,
+                      "videorate-duplicates", G_TYPE_UINT64, rateDuplicates,
+                      "send-queue-buffers", G_TYPE_UINT64, queueBuffers,
+                      "send-queue-bytes", G_TYPE_UINT64, queueBytes,
+                      "send-socket-queue", G_TYPE_UINT, (guint) socketQueue,
+                      NULL);
 }
 
 //==============================================================================
 
-static void gst_hthstreamsink_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
+static void setThreadString(Gsththstreamsink *hthstreamsink, gchar **field, const GValue *value){
     
-    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK (object);
-    
-    switch (prop_id) {
-        case PROP_HOST:
-            g_value_set_string (value, hthstreamsink->host);
-            break;
-        case PROP_PORT:
-            g_value_set_int (value, hthstreamsink->port);
-            break;
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
-    }
+    /** Applied when the next streaming thread starts */
+    GST_OBJECT_LOCK(hthstreamsink);
+    g_free(*field);
+    *field = g_value_dup_string(value);
+    GST_OBJECT_UNLOCK(hthstreamsink);
 }
 
 //==============================================================================
 
-static void createElements(Gsththstreamsink *hthstreamsink) {
+static void setupStreamingThread(Gsththstreamsink *hthstreamsink, GstMessage *message){
     
-    /**
-     * Create all the internal elements
-    */
+    GstStreamStatusType type;
+    GstElement *owner;
+    HthStreamBranch branch;
+    
+    gst_message_parse_stream_status(message, &type, &owner);
+    if (type != GST_STREAM_STATUS_TYPE_ENTER || owner == NULL)
+        return;
     
-    /** video */
-    hthstreamsink->plugin_time_overlay = gst_element_factory_make ("timeoverlay", "time-overlay");
-    hthstreamsink->plugin_caps_filter = gst_element_factory_make("capsfilter", "filter-cap");
-    hthstreamsink->plugin_video_rate = gst_element_factory_make("videorate", "audio-rate");
-    hthstreamsink->plugin_theora_enc = gst_element_factory_make("theoraenc", "video-enc");
+    /** The queue threads push into the muxer and udpsink */
+    branch = findElementBranch(hthstreamsink, GST_OBJECT(owner));
+    if (branch != BRANCH_NONE)
+        setupBranchThread(hthstreamsink, branch, "tx");
+}
+
+//==============================================================================
+
+static void setupBranchThread(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, const gchar *role){
     
-    /** audio */
-    hthstreamsink->plugin_audio_convert = gst_element_factory_make("audioconvert", "audio-convert");
-    hthstreamsink->plugin_vorbis_enc = gst_element_factory_make("vorbisenc", "audio-encoder");
+    gchar **field;
+    gchar *name;
+    gchar *cpus;
+    gchar *policy;
+    gint priority;
     
-    /** text */
-    hthstreamsink->plugin_identity = gst_element_factory_make("identity", "text-filter");
+    switch (branch) {
+        case BRANCH_VIDEO:
+            field = &hthstreamsink->videoCpus;
+            break;
+        case BRANCH_AUDIO:
+            field = &hthstreamsink->audioCpus;
+            break;
+        default:
+            field = &hthstreamsink->textCpus;
+            break;
+    }
     
-    /** queues */
-    hthstreamsink->plugin_video_queue = gst_element_factory_make("queue2", "video-queue");
-    hthstreamsink->plugin_audio_queue = gst_element_factory_make("queue2", "audio-queue");
-    hthstreamsink->plugin_text_queue = gst_element_factory_make("queue2", "text-queue");
+    GST_OBJECT_LOCK(hthstreamsink);
+    cpus = g_strdup(*field);
+    policy = g_strdup(hthstreamsink->rtPolicy);
+    priority = hthstreamsink->rtPriority;
+    GST_OBJECT_UNLOCK(hthstreamsink);
     
-    /** mux */
-    hthstreamsink->plugin_matroska_mux = gst_element_factory_make("matroskamux", "muxer");
+    name = g_strdup_printf("hth-%s-%s", getBranchState(hthstreamsink, branch)->name, role);
+    gst_hth_thread_setup(name, cpus, policy, priority);
     
-    /** udp sender*/
-    hthstreamsink->plugin_udp_sink = gst_element_factory_make("udpsink", "udp-sender");
+    g_free(name);
+    g_free(cpus);
+    g_free(policy);
 }
 
 //==============================================================================
 
-static void verifyAllElementsCreated(Gsththstreamsink *hthstreamsink){
+static void watchEncoderThreads(Gsththstreamsink *hthstreamsink){
     
-    /**
-     * Verify that all the internal plugins are created properly
-     */
+    HthStreamBranch branch;
     
-    gboolean notAllElementCreated; /**< Boolean that stores the function return values*/
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++)
+        gst_pad_add_probe(getBranchGhostPad(hthstreamsink, branch), GST_PAD_PROBE_TYPE_BUFFER,
+                          cb_encoderThreadProbe, hthstreamsink, NULL);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_encoderThreadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    HthStreamBranch branch;
+    GThread **thread;
+    gboolean isNew;
+    
+    if (pad == hthstreamsink->videoSinkPad) {
+        branch = BRANCH_VIDEO;
+        thread = &hthstreamsink->videoEncThread;
+    } else if (pad == hthstreamsink->audioSinkPad) {
+        branch = BRANCH_AUDIO;
+        thread = &hthstreamsink->audioEncThread;
+    } else {
+        branch = BRANCH_TEXT;
+        thread = &hthstreamsink->textEncThread;
+    }
     
-    notAllElementCreated = !hthstreamsink->plugin_time_overlay
-        || !hthstreamsink->plugin_caps_filter
-        || !hthstreamsink->plugin_video_rate
-        || !hthstreamsink->plugin_video_rate
-        || !hthstreamsink->plugin_theora_enc
-        || !hthstreamsink->plugin_audio_convert
-        || !hthstreamsink->plugin_vorbis_enc
-        || !hthstreamsink->plugin_identity
-        || !hthstreamsink->plugin_audio_queue
-        || !hthstreamsink->plugin_video_queue
-        || !hthstreamsink->plugin_text_queue
-        || !hthstreamsink->plugin_matroska_mux
-        || !hthstreamsink->plugin_udp_sink;
+    /** Once per thread, the upstream element may restart its task with a new one */
+    GST_OBJECT_LOCK(hthstreamsink);
+    isNew = *thread != g_thread_self();
+    *thread = g_thread_self();
+    GST_OBJECT_UNLOCK(hthstreamsink);
     
-    if (notAllElementCreated) {
-        printf (RED "One element could not be created.\n" RESET);
-        exit(EXIT_ELEMENT_CREATION_FAILURE);
-    }
+    if (isNew)
+        setupBranchThread(hthstreamsink, branch, "enc");
+    
+    return GST_PAD_PROBE_OK;
 }
 
 //==============================================================================
 
-static void setElementsPropsValues(Gsththstreamsink *hthstreamsink){
-    
-    GstCaps *caps;
+static void watchBranchJitter(Gsththstreamsink *hthstreamsink){
     
-    /**
-     * Configure the streaming capabilities filter
-     */
-    caps = gst_caps_new_simple("video/x-raw",
-                               "width", G_TYPE_INT, 640,
-                               "height", G_TYPE_INT, 480,
-                               NULL);
+    /** The muxer request pads, fed by the queue threads */
+    gst_hth_jitter_watch_pad(&hthstreamsink->videoJitter, hthstreamsink->videoMuxPad);
+    gst_hth_jitter_watch_pad(&hthstreamsink->audioJitter, hthstreamsink->audioMuxPad);
+    if (hthstreamsink->textMuxPad != NULL)
+        gst_hth_jitter_watch_pad(&hthstreamsink->textJitter, hthstreamsink->textMuxPad);
+}
+
+//==============================================================================
+
+static gboolean buildBranch(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
     
-    g_object_set(G_OBJECT (hthstreamsink->plugin_caps_filter), "caps", caps, NULL);
+    teardownBranch(hthstreamsink, branch);
     
-    g_object_set (hthstreamsink->plugin_udp_sink, "host", hthstreamsink->host, NULL);
-    g_object_set (hthstreamsink->plugin_udp_sink, "port", hthstreamsink->port, NULL);
+    createBranchElements(hthstreamsink, branch);
+    if (!verifyBranchElementsCreated(hthstreamsink, branch)) {
+        teardownBranch(hthstreamsink, branch);
+        return FALSE;
+    }
+    setBranchPropsValues(hthstreamsink, branch);
+    addBranchElementsToBin(hthstreamsink, branch);
+    if (!linkBranchElements(hthstreamsink, branch) || !setBranchSinkPad(hthstreamsink, branch)) {
+        teardownBranch(hthstreamsink, branch);
+        return FALSE;
+    }
+    setBranchTelemetry(hthstreamsink, branch);
+    if (hthstreamsink->latencyTracing)
+        traceBranchLatency(hthstreamsink, branch);
     
+    return TRUE;
 }
 
 //==============================================================================
 
-static void addElementsToBin(Gsththstreamsink *hthstreamsink){
-    
-    /**
-    * Add elements to the bin filter
-    */
+static const gchar *getQueueFactory(Gsththstreamsink *hthstreamsink){
     
-    gst_bin_add_many(GST_BIN(hthstreamsink) ,
-                     GST_ELEMENT(hthstreamsink->plugin_time_overlay),
-                     GST_ELEMENT(hthstreamsink->plugin_caps_filter),
-                     GST_ELEMENT(hthstreamsink->plugin_video_rate),
-                     GST_ELEMENT(hthstreamsink->plugin_theora_enc),
-                     GST_ELEMENT(hthstreamsink->plugin_audio_convert),
-                     GST_ELEMENT(hthstreamsink->plugin_vorbis_enc),
-                     GST_ELEMENT(hthstreamsink->plugin_identity),
-                     GST_ELEMENT(hthstreamsink->plugin_audio_queue),
-                     GST_ELEMENT(hthstreamsink->plugin_video_queue),
-                     GST_ELEMENT(hthstreamsink->plugin_text_queue),
-                     GST_ELEMENT(hthstreamsink->plugin_matroska_mux),
-                     GST_ELEMENT(hthstreamsink->plugin_udp_sink),
-                     NULL);
+    /** identity keeps the element slots and the links of the queue */
+    return hthstreamsink->queueless ? "identity" : "queue2";
 }
 
 //==============================================================================
 
-static void linkBinElements(Gsththstreamsink *hthstreamsink){
+static void setQueuelessMode(Gsththstreamsink *hthstreamsink, gboolean enable){
     
-    /**
-    *
-    * Link the audio elements and
-    * video elements respectively
-    *
-    */
+    HthStreamBranch branch;
     
-    GstPad *sink_videoPad;
-    GstPad *src_videoPad;
+    if (hthstreamsink->queueless == enable)
+        return;
     
-    GstPad *sink_audioPad;
-    GstPad *src_audioPad;
+    hthstreamsink->queueless = enable;
     
-    GstPad *sink_textPad;
-    GstPad *src_textPad;
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
     
-    gboolean link_ok; /**< Boolean that stores the function return values*/
-    GstPadLinkReturn audioPadLink_ok; /**< Stores the function return values with a specific format*/
-    GstPadLinkReturn videoPadLink_ok; /**< Stores the function return values with a specific format*/
-    GstPadLinkReturn textPadLink_ok; /**< Stores the function return values with a specific format*/
-    
-    /** Video elements linking */
-    link_ok = gst_element_link_many(hthstreamsink->plugin_time_overlay,
-                                    hthstreamsink->plugin_caps_filter,
-                                    hthstreamsink->plugin_video_rate,
-                                    hthstreamsink->plugin_theora_enc,
-                                    hthstreamsink->plugin_video_queue,
-                                    NULL);
-    if (!link_ok){
-        printf(RED "Video stream elements linking fail" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
+    for (branch = BRANCH_VIDEO; branch < BRANCH_COUNT; branch++) {
+        if (!buildBranch(hthstreamsink, branch)) {
+            printf(RED "The %s branch could not be rebuilt \n" RESET, getBranchState(hthstreamsink, branch)->name);
+            hthstreamsink->constructionFailed = TRUE;
+        }
     }
+}
 
-//    gst_element_link_pads(hthstreamsink->plugin_time_overlay, "src", hthstreamsink->plugin_caps_filter, "sink");
-//    gst_element_link_pads(hthstreamsink->plugin_caps_filter, "src", hthstreamsink->plugin_video_rate, "sink");
-//    gst_element_link_pads(hthstreamsink->plugin_video_rate, "src", hthstreamsink->plugin_theora_enc, "sink");
-//    gst_element_link_pads(hthstreamsink->plugin_theora_enc, "src", hthstreamsink->plugin_video_queue, "sink");
-    
-    /** link the video queue with muxer*/
-    src_videoPad = gst_element_get_static_pad(hthstreamsink->plugin_video_queue, "src");
-    sink_videoPad = gst_element_get_request_pad(hthstreamsink->plugin_matroska_mux, "video_%u");
-    videoPadLink_ok = gst_pad_link(src_videoPad, sink_videoPad);
-    
-    if (videoPadLink_ok != GST_PAD_LINK_OK){
-        printf(RED "New video sink request pad linking fails" RESET);
-        exit(EXIT_PADS_LINKING_FAILURE);
+//==============================================================================
+
+static GstPadProbeReturn cb_videoDeadlineProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime deadline;
+    GstClockTime runningTime;
+    GstClockTime now;
+    GstClock *clock;
+    GstEvent *segmentEvent;
+    const GstSegment *segment;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    deadline = hthstreamsink->videoDeadline * GST_MSECOND;
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    if (deadline == 0 || !GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_PAD_PROBE_OK;
+    
+    clock = gst_element_get_clock(GST_ELEMENT(hthstreamsink));
+    if (clock == NULL)
+        return GST_PAD_PROBE_OK;
+    now = gst_clock_get_time(clock) - gst_element_get_base_time(GST_ELEMENT(hthstreamsink));
+    gst_object_unref(clock);
+    
+    segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (segmentEvent == NULL)
+        return GST_PAD_PROBE_OK;
+    gst_event_parse_segment(segmentEvent, &segment);
+    runningTime = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    gst_event_unref(segmentEvent);
+    
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime) || now <= runningTime + deadline)
+        return GST_PAD_PROBE_OK;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    hthstreamsink->videoLateDrops++;
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    return GST_PAD_PROBE_DROP;
+}
+
+//==============================================================================
+
+static void appendRates(Gsththstreamsink *hthstreamsink, GstStructure *stats){
+    
+    gint64 now = g_get_monotonic_time();
+    guint64 videoBuffers = gst_hth_jitter_get_buffers(&hthstreamsink->videoJitter);
+    guint64 switches = gst_hth_task_pool_get_context_switches();
+    gdouble fps = 0.0;
+    gdouble switchRate = 0.0;
+    gdouble elapsed;
+    guint64 lateDrops;
+    
+    GST_OBJECT_LOCK(hthstreamsink);
+    
+    if (hthstreamsink->rateTime > 0 && now > hthstreamsink->rateTime) {
+        elapsed = (gdouble) (now - hthstreamsink->rateTime) / G_USEC_PER_SEC;
+        fps = (videoBuffers - hthstreamsink->rateVideoBuffers) / elapsed;
+        switchRate = (switches - hthstreamsink->rateSwitches) / elapsed;
     }
+    hthstreamsink->rateTime = now;
+    hthstreamsink->rateVideoBuffers = videoBuffers;
+    hthstreamsink->rateSwitches = switches;
+    lateDrops = hthstreamsink->videoLateDrops;
+    
+    GST_OBJECT_UNLOCK(hthstreamsink);
+    
+    gst_structure_set(stats,
+                      "queueless", G_TYPE_BOOLEAN, hthstreamsink->queueless,
+                      "video-fps", G_TYPE_DOUBLE, fps,
+                      "process-context-switch-rate", G_TYPE_DOUBLE, switchRate,
+                      "video-late-drops", G_TYPE_UINT64, lateDrops,
+                      NULL);
+}
+
+//==============================================================================
+
+static void setImpairment(Gsththstreamsink *hthstreamsink, const gchar *description){
     
-    /** Audio elements linking */
-    link_ok = gst_element_link_many(hthstreamsink->plugin_audio_convert,
-                                    hthstreamsink->plugin_vorbis_enc,
-                                    hthstreamsink->plugin_audio_queue,
-                                    NULL);
-    if (!link_ok){
-        printf(RED "Audio stream elements linking fail" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
+    if (hthstreamsink->plugin_impairment != NULL) {
+        gst_hth_impairment_remove(GST_BIN(hthstreamsink), hthstreamsink->plugin_impairment,
+                                  hthstreamsink->plugin_matroska_mux, hthstreamsink->plugin_udp_sink);
+        hthstreamsink->plugin_impairment = NULL;
     }
-
-//    gst_element_link_pads(hthstreamsink->plugin_audio_convert, "src", hthstreamsink->plugin_vorbis_enc, "sink");
-//    gst_element_link_pads(hthstreamsink->plugin_vorbis_enc, "src", hthstreamsink->plugin_audio_queue, "sink");
     
-    /** link the audio queue with muxer*/
-    src_audioPad = gst_element_get_static_pad(hthstreamsink->plugin_audio_queue, "src");
-    sink_audioPad = gst_element_get_request_pad(hthstreamsink->plugin_matroska_mux, "audio_%u");
-    audioPadLink_ok = gst_pad_link(src_audioPad, sink_audioPad);
+    g_free(hthstreamsink->impairment);
+    hthstreamsink->impairment = NULL;
     
-    if (audioPadLink_ok != GST_PAD_LINK_OK){
-        printf(RED "New audio sink request pad linking fails" RESET);
-        exit(EXIT_PADS_LINKING_FAILURE);
-    }
+    if (description == NULL || *description == '\0' || hthstreamsink->constructionFailed)
+        return;
     
-    /** Text elements linking */
-    link_ok = gst_element_link_many(hthstreamsink->plugin_identity,
-                                    hthstreamsink->plugin_text_queue,
-                                    NULL);
-    if (!link_ok){
-        printf(RED "Text stream elements linking fail" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
-    }
+    hthstreamsink->plugin_impairment = gst_hth_impairment_insert(GST_BIN(hthstreamsink), hthstreamsink->plugin_matroska_mux,
+                                                                 hthstreamsink->plugin_udp_sink, description);
+    if (hthstreamsink->plugin_impairment != NULL)
+        hthstreamsink->impairment = g_strdup(description);
+}
+
+//==============================================================================
 
-//    gst_element_link_pads(hthstreamsink->plugin_audio_convert, "src", hthstreamsink->plugin_vorbis_enc, "sink");
-//    gst_element_link_pads(hthstreamsink->plugin_vorbis_enc, "src", hthstreamsink->plugin_audio_queue, "sink");
+static const gchar *getOverlayFactory(Gsththstreamsink *hthstreamsink){
     
-    /** link the audio queue with muxer*/
-    src_textPad = gst_element_get_static_pad(hthstreamsink->plugin_text_queue, "src");
-    sink_textPad = gst_element_get_request_pad(hthstreamsink->plugin_matroska_mux, "subtitle_%u");
-    textPadLink_ok = gst_pad_link(src_textPad, sink_textPad);
+    /** identity keeps the element slot and the links of timeoverlay */
+    return strcmp(hthstreamsink->timeOverlay, TIME_OVERLAY_PANGO) == 0 ? "timeoverlay" : "identity";
+}
+
+//==============================================================================
+
+static void setTimeOverlay(Gsththstreamsink *hthstreamsink, const gchar *mode){
     
-    if (textPadLink_ok != GST_PAD_LINK_OK){
-        printf(RED "New text sink request pad linking fails" RESET);
-        exit(EXIT_PADS_LINKING_FAILURE);
+    if (mode == NULL || (strcmp(mode, TIME_OVERLAY_GLYPH) != 0 && strcmp(mode, TIME_OVERLAY_PANGO) != 0
+                         && strcmp(mode, TIME_OVERLAY_META) != 0)) {
+        printf(RED "Unknown time overlay %s, glyph, pango or meta \n" RESET, mode ? mode : "(null)");
+        return;
     }
     
-    /** link matroska mux and udp sink*/
-    link_ok = gst_element_link(hthstreamsink->plugin_matroska_mux, hthstreamsink->plugin_udp_sink);
-    if (!link_ok){
-        printf(RED "UDP sink fail linking pads with matroska muxer" RESET);
-        exit(EXIT_ELEMENT_LINKING_FAILURE);
-    }
+    if (strcmp(hthstreamsink->timeOverlay, mode) == 0)
+        return;
     
+    g_free(hthstreamsink->timeOverlay);
+    hthstreamsink->timeOverlay = g_strdup(mode);
     
+    /** The capture time is only sent in the frame records, the NULL to READY change checks it */
+    if (strcmp(mode, TIME_OVERLAY_META) == 0 && !hthstreamsink->frameTelemetry)
+        printf(YELLOW "time-overlay=meta needs frame-telemetry=true, the element won't go to READY without it \n" RESET);
+    
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
+    
+    if (!buildBranch(hthstreamsink, BRANCH_VIDEO)) {
+        printf(RED "The video branch could not be rebuilt \n" RESET);
+        hthstreamsink->constructionFailed = TRUE;
+    }
 }
 
 //==============================================================================
 
-static void createPluginGhostPads(Gsththstreamsink *hthstreamsink){
-    
-    /**
-     * Create sink ghost pads
-     */
+static gboolean isBranchPassthrough(Gsththstreamsink *hthstreamsink, HthStreamBranch branch){
     
-    hthstreamsink->videoSinkPad = gst_ghost_pad_new_no_target_from_template ("video_sink",
-                                                                            gst_static_pad_template_get (&sink_factory));
-    if (!hthstreamsink->videoSinkPad) {
-        printf(RED "filter videoSinkPad ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
+    switch (branch) {
+        case BRANCH_VIDEO:
+            return strcmp(hthstreamsink->videoInput, INPUT_RAW) != 0;
+        case BRANCH_AUDIO:
+            return strcmp(hthstreamsink->audioInput, INPUT_RAW) != 0;
+        default:
+            return FALSE;
     }
+}
+
+//==============================================================================
+
+static const gchar *getParserFactory(HthStreamBranch branch, const gchar *input){
     
-    hthstreamsink->audioSinkPad = gst_ghost_pad_new_no_target_from_template ("audio_sink",
-                                                                            gst_static_pad_template_get (&sink_factory));
-    if (!hthstreamsink->audioSinkPad) {
-        printf(RED "filter audioSinkPad ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
-    }
+    guint i;
     
-    hthstreamsink->textSinkPad = gst_ghost_pad_new_no_target_from_template ("text_sink",
-                                                                           gst_static_pad_template_get (&sink_factory));
-    if (!hthstreamsink->textSinkPad) {
-        printf(RED "filter textSinkPad ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
+    for (i = 0; encodedInputs[i].input != NULL; i++) {
+        if (encodedInputs[i].branch == branch && strcmp(encodedInputs[i].input, input) == 0)
+            return encodedInputs[i].factory;
     }
     
+    return NULL;
 }
 
 //==============================================================================
 
-static void setPluginSinkPads(Gsththstreamsink *hthstreamsink){
-    
-    /**
-     * Link the ghost pads with the last element of the audio and video flow respectively
-     */
+static void setBranchInput(Gsththstreamsink *hthstreamsink, HthStreamBranch branch, const gchar *input){
     
-    gboolean setGhostPad_ok; /**< Boolean that stores the function return values*/
+    gchar **field = branch == BRANCH_VIDEO ? &hthstreamsink->videoInput : &hthstreamsink->audioInput;
     
-    GstPad *videoSinkPad1 = gst_element_get_static_pad (hthstreamsink->plugin_time_overlay, "video_sink");
-    if (videoSinkPad1 == NULL) {
-        printf(RED "Fail on get video sink pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
+    if (input == NULL || (strcmp(input, INPUT_RAW) != 0 && getParserFactory(branch, input) == NULL)) {
+        printf(RED "Unknown %s input %s, raw, %s \n" RESET, getBranchState(hthstreamsink, branch)->name,
+               input ? input : "(null)", branch == BRANCH_VIDEO ? "theora, vp8 or h264" : "vorbis or opus");
+        return;
     }
     
-    GstPad *audioSinkPad1 = gst_element_get_static_pad (hthstreamsink->plugin_audio_convert, "sink");
-    if(audioSinkPad1 == NULL ){// || audioSrcPad1 == NULL){
-        printf(RED "Fail on get audio sink pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
-    }
+    if (strcmp(*field, input) == 0)
+        return;
     
-    GstPad *textSinkPad1 = gst_element_get_static_pad (hthstreamsink->plugin_identity, "sink");
-    if(textSinkPad1 == NULL ){// || audioSrcPad1 == NULL){
-        printf(RED "Fail on get text sink pad of element \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
-    }
+    /** The elements of the current input, getBranchElements() gives the slots of the new one afterwards */
+    teardownBranch(hthstreamsink, branch);
     
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsink->videoSinkPad, videoSinkPad1);
-    if(!setGhostPad_ok){
-        printf(RED "video ghost pad could not be linked with element sink pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
-    }
+    g_free(*field);
+    *field = g_strdup(input);
     
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsink->audioSinkPad, audioSinkPad1);
-    if(!setGhostPad_ok){
-        printf(RED "audio ghost pad could not be linked with element sink pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
-    }
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
     
-    setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)hthstreamsink->textSinkPad, textSinkPad1);
-    if(!setGhostPad_ok){
-        printf(RED "text ghost pad could not be linked with element sink pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
+    if (!buildBranch(hthstreamsink, branch)) {
+        printf(RED "The %s branch could not be rebuilt \n" RESET, getBranchState(hthstreamsink, branch)->name);
+        hthstreamsink->constructionFailed = TRUE;
     }
+}
+
+//==============================================================================
+
+static void configureMotionGate(Gsththstreamsink *hthstreamsink){
     
+    /** The gate applies the values from the next frame, in any state */
+    gst_hth_motion_configure(hthstreamsink->motion, hthstreamsink->motionGate,
+                             hthstreamsink->motionThreshold, hthstreamsink->motionKeepalive * GST_MSECOND);
+    gst_hth_motion_skip_duplicates(hthstreamsink->motion, hthstreamsink->skipDuplicates);
 }
 
 //==============================================================================
 
-static GstStateChangeReturn gst_bin_change_state (GstElement *element, GstStateChange trans)
-{
-    //GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+static void setAudioCodec(Gsththstreamsink *hthstreamsink, const gchar *codec){
     
-    switch (trans)
-    {
-        case GST_STATE_CHANGE_NULL_TO_READY:
-            printf(BLUE "GST_STATE_CHANGE_NULL_TO_READY\n" RESET);
-            break;
-        
-        case GST_STATE_CHANGE_READY_TO_PAUSED:
-            printf(YELLOW "GST_STATE_CHANGE_READY_TO_PAUSED\n" RESET);
-            break;
-        
-        case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
-            printf(GREEN "GST_STATE_CHANGE_PAUSED_TO_PLAYING\n" RESET);
-            break;
-        
-        case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
-            printf(GREEN "GST_STATE_CHANGE_PLAYING_TO_PAUSED\n" RESET);
-        
-        case GST_STATE_CHANGE_PAUSED_TO_READY:
-            printf(YELLOW "GST_STATE_CHANGE_PAUSED_TO_READY\n" RESET);
-            break;
-        
-        case GST_STATE_CHANGE_READY_TO_NULL:
-            printf(BLUE "GST_STATE_CHANGE_READY_TO_NULL\n" RESET);
-            break;
-        
-        default:
-            break;
+    if (codec == NULL || (strcmp(codec, AUDIO_CODEC_VORBIS) != 0 && strcmp(codec, AUDIO_CODEC_OPUS) != 0)) {
+        printf(RED "Unknown audio codec %s, vorbis or opus \n" RESET, codec ? codec : "(null)");
+        return;
     }
     
-    return GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+    if (strcmp(hthstreamsink->audioCodec, codec) == 0)
+        return;
+    
+    g_free(hthstreamsink->audioCodec);
+    hthstreamsink->audioCodec = g_strdup(codec);
+    
+    /** The elements are missing, the element won't go to READY */
+    if (hthstreamsink->constructionFailed)
+        return;
+    
+    if (!buildBranch(hthstreamsink, BRANCH_AUDIO)) {
+        printf(RED "The audio branch could not be rebuilt \n" RESET);
+        hthstreamsink->constructionFailed = TRUE;
+    }
 }
 
-
 //==============================================================================
 
-/**
- *
- * @brief entry point to initialize the plug-in
- *
- * initialize the plug-in itself
- * register the element factories and other features
- */
-static gboolean hthstreamsink_init (GstPlugin * hthstreamsink){
+static void configureAudioEncoder(Gsththstreamsink *hthstreamsink){
     
-    printf(WHITE "Bin-plugin  -- Serialtextsrc --- Init plugin function \n" RESET);
+    GstElement *encoder = NULL;
+    gint frameSize = (gint) opusFrameSizes[0];
+    guint i;
     
-    /** Debug category for fltering log messages
-    * exchange the string 'Template hthstreamsink' with your description
-    */
+    GST_OBJECT_LOCK(hthstreamsink);
+    if (hthstreamsink->plugin_audio_enc != NULL && !isBranchPassthrough(hthstreamsink, BRANCH_AUDIO)
+        && strcmp(hthstreamsink->audioCodec, AUDIO_CODEC_OPUS) == 0)
+        encoder = gst_object_ref(hthstreamsink->plugin_audio_enc);
+    GST_OBJECT_UNLOCK(hthstreamsink);
     
-    GST_DEBUG_CATEGORY_INIT (gst_hthstreamsink_debug, "hthstreamsink",0, "Template hthstreamsink");
+    if (encoder == NULL)
+        return;
     
-    return gst_element_register (hthstreamsink, "hthstreamsink", GST_RANK_NONE, GST_TYPE_HTHSTREAMSINK);
+    /** The largest frame that does not exceed opus-frame-size */
+    for (i = 0; i < G_N_ELEMENTS(opusFrameSizes); i++) {
+        if (opusFrameSizes[i] <= hthstreamsink->opusFrameSize)
+            frameSize = (gint) opusFrameSizes[i];
+    }
+    
+    /** restricted-lowdelay leaves out the SILK layer and its lookahead, about 2.5 ms of delay on top of the frame */
+    gst_util_set_object_arg(G_OBJECT(encoder), "audio-type", "restricted-lowdelay");
+    g_object_set(G_OBJECT(encoder),
+                 "frame-size", frameSize,
+                 "bitrate", (gint) hthstreamsink->opusBitrate,
+                 "inband-fec", hthstreamsink->opusInbandFec,
+                 "packet-loss-percentage", hthstreamsink->opusInbandFec ? OPUS_FEC_LOSS_PERCENTAGE : 0,
+                 "dtx", hthstreamsink->opusDtx,
+                 NULL);
+    
+    gst_object_unref(encoder);
 }
 
 //==============================================================================
 
-/* PACKAGE: this is usually set by autotools depending on some _INIT macro
- * in configure.ac and then written into and defined in config.h, but we can
- * just set it ourselves here in case someone doesn't use autotools to
- * compile this code. GST_PLUGIN_DEFINE needs PACKAGE to be defined.
- */
-#ifndef PACKAGE
-#define PACKAGE "myfirsththstreamsink"
-#endif
-
-/* gstreamer looks for this structure to register hthstreamsinks
- *
- * exchange the string 'Template hthstreamsink' with your hthstreamsink description
- */
-GST_PLUGIN_DEFINE (
-    GST_VERSION_MAJOR,
-    GST_VERSION_MINOR,
-    hthstreamsink,
-"Template hthstreamsink",
-hthstreamsink_init,
-VERSION,
-"LGPL",
-"GStreamer",
-"http://gstreamer.net/"
-)
+static GstPadProbeReturn cb_captureTimeProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    Gsththstreamsink *hthstreamsink = GST_HTHSTREAMSINK(user_data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime runningTime;
+    GstClockTime baseTime;
+    GstEvent *segmentEvent;
+    const GstSegment *segment;
+    
+    if (!GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_PAD_PROBE_OK;
+    
+    segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (segmentEvent == NULL)
+        return GST_PAD_PROBE_OK;
+    gst_event_parse_segment(segmentEvent, &segment);
+    runningTime = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    gst_event_unref(segmentEvent);
+    
+    /** The base time is only known once the pipeline has a clock */
+    baseTime = gst_element_get_base_time(GST_ELEMENT(hthstreamsink));
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime) || !GST_CLOCK_TIME_IS_VALID(baseTime))
+        return GST_PAD_PROBE_OK;
+    
+    /** A shared frame only costs a copy of the buffer struct, the memory is kept */
+    buffer = gst_buffer_make_writable(buffer);
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    gst_buffer_add_hth_capture_meta(buffer, baseTime + runningTime);
+    
+    return GST_PAD_PROBE_OK;
+}
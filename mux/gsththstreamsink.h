@@ -49,6 +49,14 @@
 #include <gst/gst.h>
 #include <glib.h>
 
+#include "gsththbranch.h"
+#include "gsthththread.h"
+#include "gsththmemory.h"
+#include "gsththlatency.h"
+#include "gsththencoderstats.h"
+#include "gsththoverlay.h"
+#include "gsththmotion.h"
+
 G_BEGIN_DECLS
 
 /* #defines don't like whitespacey bits */
@@ -73,16 +81,18 @@ struct _Gsththstreamsink{
     GstBin parent; /**< Parent struct. This element defines the plugin type */
     
     /** Video stream */
-    GstElement *plugin_time_overlay; /**< This element add the stream time in the video window */
+    GstElement *plugin_time_overlay; /**< This element add the stream time in the video window, identity with the glyph overlay */
     GstElement *plugin_caps_filter;  /**< This element that works between plugins
     									* Modifies the stream original capabilities like the weight or width */
     GstElement *plugin_video_rate;   /**  takes an incoming stream of timestamped video frames
     									* It will produce a perfect stream that matches the source pad's framerate */
     GstElement *plugin_theora_enc;   /** This element encodes raw video into a Theora stream */
+    GstElement *plugin_video_parse;  /** Parser of the encoded video input, replaces the four elements above */
     
     /** Audio stream */
     GstElement *plugin_audio_convert; /** This element converts raw audio buffers between various possible formats */
-    GstElement *plugin_vorbis_enc;    /** This element encodes raw float audio into a Vorbis stream */
+    GstElement *plugin_audio_enc;     /** This element encodes raw audio into a Vorbis or Opus stream */
+    GstElement *plugin_audio_parse;   /** Parser of the encoded audio input, replaces the two elements above */
     
     /** Text stream */
     GstElement *plugin_identity; /** This element is used only for watch the text stream */
@@ -91,7 +101,7 @@ struct _Gsththstreamsink{
     GstElement *plugin_video_queue; /** Tis element will create a new thread on the source pad to
                                     * decouple the processing on sink and source pad*/
     GstElement *plugin_audio_queue;
-    GstElement *plugin_text_queue;
+    GstElement *plugin_text_queue; /**< NULL with frame-telemetry */
     
     /** sink pad's */
     GstPad *videoSinkPad; /**< video stream input pad */
@@ -100,6 +110,9 @@ struct _Gsththstreamsink{
     
     /** Muxer */
     GstElement *plugin_matroska_mux; /** This element muxes different input streams into a Matroska file */
+    GstPad *videoMuxPad; /**< Muxer request pads, kept when a branch is rebuilt */
+    GstPad *audioMuxPad;
+    GstPad *textMuxPad;
     
     /** Plugin transport */
     GstElement *plugin_udp_sink; /**< Plugin that ends UDP packets to the network */
@@ -110,6 +123,86 @@ struct _Gsththstreamsink{
     /** Destination port */
     gint port;
     
+    /** Stream id header, 0 for none */
+    guint streamId;
+    guint32 streamSequence; /**< Number of the next datagram, only touched by the muxer thread */
+    
+    /** Impairment */
+    gchar *impairment; /**< Properties of hthimpair, NULL for none */
+    GstElement *plugin_impairment; /**< hthimpair between the muxer and udpsink, NULL for none */
+    
+    /** Time overlay */
+    gchar *timeOverlay; /**< glyph, pango or meta */
+    GstHthOverlay *overlay; /**< Glyph atlas and counters of the glyph overlay */
+    
+    /** Motion gate */
+    gboolean motionGate; /**< Static frames dropped ahead of the encoder */
+    gdouble motionThreshold; /**< Percent of the luma cells that must change */
+    guint motionKeepalive; /**< Milliseconds between two frames of a static scene */
+    gboolean skipDuplicates; /**< Frames repeated by videorate dropped ahead of the encoder */
+    GstHthMotion *motion; /**< Luma grids and counters of the gate */
+    
+    /** Encoded inputs */
+    gchar *videoInput; /**< raw, theora, vp8 or h264 */
+    gchar *audioInput; /**< raw, vorbis or opus */
+    
+    /** Audio encoder */
+    gchar *audioCodec; /**< vorbis or opus, encoder of the raw audio input */
+    gdouble opusFrameSize; /**< Milliseconds of audio in each Opus packet */
+    guint opusBitrate; /**< Bits per second of opusenc */
+    gboolean opusInbandFec; /**< Packets carry the FEC data of the previous one */
+    gboolean opusDtx; /**< Discontinuous transmission during silence */
+    
+    /** Shared task pool */
+    gboolean sharedTaskPool; /**< The streaming tasks of the children run on the shared pool */
+    
+    /** Streaming threads */
+    gchar *videoCpus; /**< CPU list of the video thread, NULL for all */
+    gchar *audioCpus; /**< CPU list of the audio thread, NULL for all */
+    gchar *textCpus; /**< CPU list of the text thread, NULL for all */
+    gchar *rtPolicy; /**< other, fifo or rr */
+    gint rtPriority; /**< Priority with fifo or rr */
+    GThread *videoEncThread; /**< Last thread set up as hth-video-enc, only compared */
+    GThread *audioEncThread; /**< Last thread set up as hth-audio-enc */
+    GThread *textEncThread; /**< Last thread set up as hth-text-enc */
+    GstHthJitter videoJitter; /**< Jitter of the buffers leaving each branch */
+    GstHthJitter audioJitter;
+    GstHthJitter textJitter;
+    
+    /** Queueless mode */
+    gboolean queueless; /**< Branches built with identity instead of queue2, so without queue threads */
+    guint videoDeadline; /**< Lateness in ms before a frame is dropped ahead of the encoder, 0 for never */
+    guint64 videoLateDrops; /**< Frames dropped by the deadline */
+    gint64 rateTime; /**< Monotonic time of the previous stats read, in us */
+    guint64 rateVideoBuffers; /**< Video buffers at the previous stats read */
+    guint64 rateSwitches; /**< Context switches at the previous stats read */
+    
+    /** Memory budget */
+    GstHthMemory *memory; /**< max-memory and the bytes charged by the queues */
+    
+    /** Latency tracing */
+    gboolean latencyTracing; /**< Probes installed on the stages */
+    guint latencyInterval; /**< Milliseconds between two hth-latency messages */
+    GstHthLatency *latency; /**< Residency histograms of the stages */
+    
+    /** Encoder stats */
+    guint encoderStatsInterval; /**< Milliseconds between two hth-encoder-stats messages */
+    GstHthEncoderStats *encoderStats; /**< Counters of theoraenc and of the datagrams sent */
+    
+    /** Frame telemetry */
+    gboolean frameTelemetry; /**< Send the serial text in the video frames instead of a sparse track */
+    gulong videoTelemetryProbeId; /**< Probe that attaches the sample to each encoded frame */
+    GMutex telemetryLock; /**< Protects the last telemetry sample */
+    gchar *telemetryText; /**< Last telemetry sample */
+    GstClockTime telemetryTime; /**< Running time of the last telemetry sample */
+    gboolean telemetryChanged; /**< The sample changed since the last record sent */
+    
+    /** Branch rebuild */
+    gboolean constructionFailed; /**< Internal elements missing, the element fails to go to READY */
+    GstHthBranch videoBranch; /**< Restart bookkeeping of each branch */
+    GstHthBranch audioBranch;
+    GstHthBranch textBranch;
+    
 };
 
 /**
@@ -0,0 +1,640 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+/**
+ * SECTION:element-hthprobe
+ *
+ * Passthrough element measuring the buffer rate, the byte rate, the
+ * inter-arrival jitter, the lateness of the PTS against the clock and the
+ * buffer sizes. The buffers are not copied nor touched, and nothing is
+ * allocated per buffer.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 hthstreamsrc name=demux demux.video_src ! hthprobe interval=1000 ! xvimagesink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** -- Includes -- */
+
+/** probe plugin header */
+#include "gsththprobe.h" /**< For all elements of the plugin */
+
+/** gstreamer header file */
+#include <gst/gst.h> /**< For all gstreamer functions */
+
+/** stdio header file */
+#include <stdio.h> /**< For printf() */
+
+/** histogram header */
+#include "gsththhistogram.h" /**< For the log-linear histograms */
+
+/**
+ * @brief Colors for printed messages
+ *
+ */
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state, playing state or close state*/
+#define YELLOW  "\033[1m\033[33m"   /** Pause state  */
+#define BLUE    "\033[1m\033[34m"   /** Ready state */
+#define WHITE   "\033[1m\033[37m"   /** Normal text of functions*/
+
+GST_DEBUG_CATEGORY_STATIC (gst_hthprobe_debug);
+#define GST_CAT_DEFAULT gst_hthprobe_debug
+
+//==============================================================================
+
+/**
+ * Parameters
+ */
+
+#define DEFAULT_INTERVAL            1000 /**< Milliseconds between two hth-probe messages */
+#define PROBE_MESSAGE               "hth-probe" /**< Name of the periodic element message */
+
+enum{
+    PROP_0,
+    PROP_INTERVAL,
+    PROP_STATS
+};
+
+//==============================================================================
+
+/**
+ * @brief The capabilities of the inputs and outputs.
+ *
+ * Any stream, the element does not look into the buffers
+ *
+ */
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+                                                                     GST_PAD_SINK,
+                                                                     GST_PAD_ALWAYS,
+                                                                     GST_STATIC_CAPS_ANY
+);
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+                                                                    GST_PAD_SRC,
+                                                                    GST_PAD_ALWAYS,
+                                                                    GST_STATIC_CAPS_ANY
+);
+
+//==============================================================================
+
+#define gst_hthprobe_parent_class parent_class
+G_DEFINE_TYPE (Gsththprobe, gst_hthprobe, GST_TYPE_ELEMENT);
+
+//==============================================================================
+
+/**
+ * @brief Set plugin's properties with new values
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value new property value
+ * @param pspec
+ */
+static void gst_hthprobe_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+
+/**
+ * @brief Obtain the values of the plugin's properties
+ *
+ * @param object
+ * @param prop_id property id
+ * @param value
+ * @param pspec
+ */
+static void gst_hthprobe_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
+
+/**
+ * @brief Start the measures again when going to PAUSED
+ *
+ * @param element The plugin instance
+ * @param trans The state transition
+ * @return GstStateChangeReturn
+ */
+static GstStateChangeReturn gst_hthprobe_change_state (GstElement *element, GstStateChange trans);
+
+/**
+ * @brief Measure a buffer and push it unchanged
+ *
+ * @param pad Sink pad
+ * @param parent The plugin instance
+ * @param buffer The buffer
+ * @return GstFlowReturn Return of the push
+ */
+static GstFlowReturn gst_hthprobe_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer);
+
+/**
+ * @brief Keep the segment of the buffers, forget the arrivals on a flush
+ *
+ * @param pad Sink pad
+ * @param parent The plugin instance
+ * @param event The event
+ * @return gboolean Event handled
+ */
+static gboolean gst_hthprobe_sink_event (GstPad *pad, GstObject *parent, GstEvent *event);
+
+/**
+ * @brief Count a buffer in the total and the window
+ *
+ * @param hthprobe The plugin instance, locked
+ * @param buffer The buffer
+ * @param now Monotonic time, in ns
+ * @return void
+ */
+static void measureBuffer(Gsththprobe *hthprobe, GstBuffer *buffer, GstClockTime now);
+
+/**
+ * @brief How far the running time of the clock is past the running time of a PTS
+ *
+ * @param hthprobe The plugin instance, locked
+ * @param pts PTS of the buffer
+ * @param lateness Filled with the lateness in ns, negative when early
+ * @return gboolean FALSE without clock, PTS or time segment
+ */
+static gboolean getLateness(Gsththprobe *hthprobe, GstClockTime pts, GstClockTimeDiff *lateness);
+
+/**
+ * @brief Forget the measures of a period
+ *
+ * @param counters The counters
+ * @return void
+ */
+static void resetCounters(HthProbeCounters *counters);
+
+/**
+ * @brief Forget all the measures and the previous arrival
+ *
+ * @param hthprobe The plugin instance, locked
+ * @return void
+ */
+static void resetMeasures(Gsththprobe *hthprobe);
+
+/**
+ * @brief Add the counters and the histograms of a period to a structure
+ *
+ * @param counters The counters
+ * @param structure Structure to fill
+ * @return void
+ */
+static void appendCounters(HthProbeCounters *counters, GstStructure *structure);
+
+/**
+ * @brief Build the hth-probe message of the window and start a new one
+ *
+ * @param hthprobe The plugin instance, locked
+ * @param now Monotonic time, in ns
+ * @return GstMessage* The message, posted by the caller once unlocked
+ */
+static GstMessage *createWindowMessage(Gsththprobe *hthprobe, GstClockTime now);
+
+/**
+ * @brief Build the stats structure
+ *
+ * @param hthprobe The plugin instance
+ * @return GstStructure* hthprobe-stats structure
+ */
+static GstStructure *createStatsStructure(Gsththprobe *hthprobe);
+
+//==============================================================================
+
+/**
+ * @brief GObject vmethod implementations
+ * initialize the hthprobe class
+ *
+ */
+static void gst_hthprobe_class_init (GsththprobeClass * klass){
+    
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    
+    gobject_class = (GObjectClass *) klass;
+    gstelement_class = (GstElementClass *) klass;
+    
+    gobject_class->set_property = gst_hthprobe_set_property;
+    gobject_class->get_property = gst_hthprobe_get_property;
+    gstelement_class->change_state = gst_hthprobe_change_state;
+    
+    /** Install properties */
+    g_object_class_install_property (gobject_class, PROP_INTERVAL,
+                                     g_param_spec_uint ("interval", "Interval",
+                                                        "Milliseconds between two hth-probe element messages with the measures of the period, 0 posts none",
+                                                        0, G_MAXUINT, DEFAULT_INTERVAL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STATS,
+                                     g_param_spec_boxed ("stats", "Statistics",
+                                                         "Buffers, bytes, rates since the previous read and histograms of the inter-arrival, jitter, lateness and size since PAUSED",
+                                                         GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    
+    gst_element_class_set_details_simple(gstelement_class,
+                                         "hthprobe",
+                                         "Generic",
+                                         "Measures the rate, jitter, lateness and size of the buffers going through",
+                                         "basultobd <<basultobd@gmail.com>>");
+    
+    gst_element_class_add_pad_template (gstelement_class,
+                                        gst_static_pad_template_get (&src_factory));
+    gst_element_class_add_pad_template (gstelement_class,
+                                        gst_static_pad_template_get (&sink_factory));
+}
+
+//==============================================================================
+
+static void gst_hthprobe_init (Gsththprobe *hthprobe){
+    
+    hthprobe->sinkPad = gst_pad_new_from_static_template (&sink_factory, "sink");
+    gst_pad_set_chain_function (hthprobe->sinkPad, GST_DEBUG_FUNCPTR(gst_hthprobe_chain));
+    gst_pad_set_event_function (hthprobe->sinkPad, GST_DEBUG_FUNCPTR(gst_hthprobe_sink_event));
+    GST_PAD_SET_PROXY_CAPS (hthprobe->sinkPad);
+    GST_PAD_SET_PROXY_ALLOCATION (hthprobe->sinkPad);
+    GST_PAD_SET_PROXY_SCHEDULING (hthprobe->sinkPad);
+    gst_element_add_pad (GST_ELEMENT (hthprobe), hthprobe->sinkPad);
+    
+    hthprobe->srcPad = gst_pad_new_from_static_template (&src_factory, "src");
+    GST_PAD_SET_PROXY_CAPS (hthprobe->srcPad);
+    GST_PAD_SET_PROXY_SCHEDULING (hthprobe->srcPad);
+    gst_element_add_pad (GST_ELEMENT (hthprobe), hthprobe->srcPad);
+    
+    hthprobe->interval = DEFAULT_INTERVAL;
+    gst_segment_init(&hthprobe->segment, GST_FORMAT_UNDEFINED);
+    resetMeasures(hthprobe);
+}
+
+//==============================================================================
+
+static void gst_hthprobe_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec){
+    
+    Gsththprobe *hthprobe = GST_HTHPROBE (object);
+    
+    switch (prop_id) {
+        
+        case PROP_INTERVAL:
+            
+            GST_OBJECT_LOCK(hthprobe);
+            hthprobe->interval = g_value_get_uint(value);
+            GST_OBJECT_UNLOCK(hthprobe);
+            printf(GREEN "New probe interval: %u ms \n" RESET , hthprobe->interval);
+            break;
+        
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static void gst_hthprobe_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec){
+    
+    Gsththprobe *hthprobe = GST_HTHPROBE (object);
+    
+    switch (prop_id) {
+        case PROP_INTERVAL:
+            g_value_set_uint (value, hthprobe->interval);
+            break;
+        case PROP_STATS:
+            g_value_take_boxed (value, createStatsStructure(hthprobe));
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+//==============================================================================
+
+static GstStateChangeReturn gst_hthprobe_change_state (GstElement *element, GstStateChange trans){
+    
+    Gsththprobe *hthprobe = GST_HTHPROBE (element);
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            GST_OBJECT_LOCK(hthprobe);
+            gst_segment_init(&hthprobe->segment, GST_FORMAT_UNDEFINED);
+            resetMeasures(hthprobe);
+            GST_OBJECT_UNLOCK(hthprobe);
+            break;
+        
+        default:
+            break;
+    }
+    
+    return GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+}
+
+//==============================================================================
+
+static GstFlowReturn gst_hthprobe_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer){
+    
+    Gsththprobe *hthprobe = GST_HTHPROBE (parent);
+    GstMessage *message = NULL;
+    GstClockTime now;
+    
+    now = gst_util_get_timestamp();
+    
+    GST_OBJECT_LOCK(hthprobe);
+    measureBuffer(hthprobe, buffer, now);
+    if (hthprobe->interval > 0 && now - hthprobe->windowStart >= hthprobe->interval * GST_MSECOND)
+        message = createWindowMessage(hthprobe, now);
+    GST_OBJECT_UNLOCK(hthprobe);
+    
+    if (message != NULL)
+        gst_element_post_message(GST_ELEMENT(hthprobe), message);
+    
+    /** Pushed as it came, the element only reads the metadata */
+    return gst_pad_push(hthprobe->srcPad, buffer);
+}
+
+//==============================================================================
+
+static gboolean gst_hthprobe_sink_event (GstPad *pad, GstObject *parent, GstEvent *event){
+    
+    Gsththprobe *hthprobe = GST_HTHPROBE (parent);
+    
+    switch (GST_EVENT_TYPE (event)) {
+        
+        case GST_EVENT_SEGMENT:
+            GST_OBJECT_LOCK(hthprobe);
+            gst_event_copy_segment(event, &hthprobe->segment);
+            GST_OBJECT_UNLOCK(hthprobe);
+            break;
+        
+        case GST_EVENT_FLUSH_STOP:
+            /** The next buffer does not follow the previous one */
+            GST_OBJECT_LOCK(hthprobe);
+            gst_segment_init(&hthprobe->segment, GST_FORMAT_UNDEFINED);
+            hthprobe->lastArrival = GST_CLOCK_TIME_NONE;
+            hthprobe->lastInterarrival = GST_CLOCK_TIME_NONE;
+            GST_OBJECT_UNLOCK(hthprobe);
+            break;
+        
+        default:
+            break;
+    }
+    
+    return gst_pad_event_default(pad, parent, event);
+}
+
+//==============================================================================
+
+static void measureBuffer(Gsththprobe *hthprobe, GstBuffer *buffer, GstClockTime now){
+    
+    GstClockTime interarrival;
+    GstClockTimeDiff lateness;
+    GstClockTimeDiff variation;
+    gsize size;
+    
+    size = gst_buffer_get_size(buffer);
+    
+    hthprobe->total.buffers++;
+    hthprobe->total.bytes += size;
+    hthprobe->window.buffers++;
+    hthprobe->window.bytes += size;
+    gst_hth_histogram_record(&hthprobe->total.size, size);
+    gst_hth_histogram_record(&hthprobe->window.size, size);
+    
+    if (GST_CLOCK_TIME_IS_VALID(hthprobe->lastArrival)) {
+        
+        interarrival = now - hthprobe->lastArrival;
+        gst_hth_histogram_record(&hthprobe->total.interarrival, interarrival);
+        gst_hth_histogram_record(&hthprobe->window.interarrival, interarrival);
+        
+        if (GST_CLOCK_TIME_IS_VALID(hthprobe->lastInterarrival)) {
+            variation = ABS(GST_CLOCK_DIFF(hthprobe->lastInterarrival, interarrival));
+            gst_hth_histogram_record(&hthprobe->total.jitter, variation);
+            gst_hth_histogram_record(&hthprobe->window.jitter, variation);
+            hthprobe->smoothedJitter += (variation - hthprobe->smoothedJitter) / 16.0;
+        }
+        hthprobe->lastInterarrival = interarrival;
+    }
+    hthprobe->lastArrival = now;
+    
+    if (!getLateness(hthprobe, GST_BUFFER_PTS(buffer), &lateness))
+        return;
+    
+    if (lateness < 0) {
+        hthprobe->total.earlyBuffers++;
+        hthprobe->window.earlyBuffers++;
+        return;
+    }
+    gst_hth_histogram_record(&hthprobe->total.lateness, lateness);
+    gst_hth_histogram_record(&hthprobe->window.lateness, lateness);
+}
+
+//==============================================================================
+
+static gboolean getLateness(Gsththprobe *hthprobe, GstClockTime pts, GstClockTimeDiff *lateness){
+    
+    GstClock *clock;
+    GstClockTime runningTime;
+    GstClockTime clockTime;
+    
+    /** The running time of the clock only moves in PLAYING */
+    clock = GST_ELEMENT_CLOCK(hthprobe);
+    if (clock == NULL || GST_STATE(hthprobe) != GST_STATE_PLAYING || !GST_CLOCK_TIME_IS_VALID(pts)
+        || hthprobe->segment.format != GST_FORMAT_TIME)
+        return FALSE;
+    
+    runningTime = gst_segment_to_running_time(&hthprobe->segment, GST_FORMAT_TIME, pts);
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime))
+        return FALSE;
+    
+    clockTime = gst_clock_get_time(clock);
+    *lateness = GST_CLOCK_DIFF(runningTime, clockTime - GST_ELEMENT_CAST(hthprobe)->base_time);
+    
+    return TRUE;
+}
+
+//==============================================================================
+
+static void resetCounters(HthProbeCounters *counters){
+    
+    counters->buffers = 0;
+    counters->bytes = 0;
+    counters->earlyBuffers = 0;
+    gst_hth_histogram_reset(&counters->interarrival);
+    gst_hth_histogram_reset(&counters->jitter);
+    gst_hth_histogram_reset(&counters->lateness);
+    gst_hth_histogram_reset(&counters->size);
+}
+
+//==============================================================================
+
+static void resetMeasures(Gsththprobe *hthprobe){
+    
+    GstClockTime now = gst_util_get_timestamp();
+    
+    hthprobe->lastArrival = GST_CLOCK_TIME_NONE;
+    hthprobe->lastInterarrival = GST_CLOCK_TIME_NONE;
+    hthprobe->smoothedJitter = 0.0;
+    resetCounters(&hthprobe->total);
+    resetCounters(&hthprobe->window);
+    hthprobe->windowStart = now;
+    hthprobe->rateTime = now;
+    hthprobe->rateBuffers = 0;
+    hthprobe->rateBytes = 0;
+}
+
+//==============================================================================
+
+static void appendCounters(HthProbeCounters *counters, GstStructure *structure){
+    
+    gst_structure_set(structure,
+                      "buffers", G_TYPE_UINT64, counters->buffers,
+                      "bytes", G_TYPE_UINT64, counters->bytes,
+                      "early-buffers", G_TYPE_UINT64, counters->earlyBuffers,
+                      NULL);
+    gst_hth_histogram_append_stats(&counters->interarrival, structure, "interarrival");
+    gst_hth_histogram_append_stats(&counters->jitter, structure, "jitter");
+    gst_hth_histogram_append_stats(&counters->lateness, structure, "lateness");
+    gst_hth_histogram_append_stats(&counters->size, structure, "size");
+}
+
+//==============================================================================
+
+static GstMessage *createWindowMessage(Gsththprobe *hthprobe, GstClockTime now){
+    
+    GstStructure *structure;
+    gdouble elapsed;
+    
+    elapsed = (gdouble) (now - hthprobe->windowStart) / GST_SECOND;
+    
+    structure = gst_structure_new(PROBE_MESSAGE,
+                                  "buffer-rate", G_TYPE_DOUBLE, hthprobe->window.buffers / elapsed,
+                                  "byte-rate", G_TYPE_DOUBLE, hthprobe->window.bytes / elapsed,
+                                  "smoothed-jitter", G_TYPE_UINT64, (guint64) hthprobe->smoothedJitter,
+                                  NULL);
+    appendCounters(&hthprobe->window, structure);
+    
+    resetCounters(&hthprobe->window);
+    hthprobe->windowStart = now;
+    
+    return gst_message_new_element(GST_OBJECT(hthprobe), structure);
+}
+
+//==============================================================================
+
+static GstStructure *createStatsStructure(Gsththprobe *hthprobe){
+    
+    GstStructure *stats = gst_structure_new_empty("hthprobe-stats");
+    GstClockTime now = gst_util_get_timestamp();
+    gdouble bufferRate = 0.0;
+    gdouble byteRate = 0.0;
+    gdouble elapsed;
+    
+    GST_OBJECT_LOCK(hthprobe);
+    
+    if (now > hthprobe->rateTime) {
+        elapsed = (gdouble) (now - hthprobe->rateTime) / GST_SECOND;
+        bufferRate = (hthprobe->total.buffers - hthprobe->rateBuffers) / elapsed;
+        byteRate = (hthprobe->total.bytes - hthprobe->rateBytes) / elapsed;
+    }
+    hthprobe->rateTime = now;
+    hthprobe->rateBuffers = hthprobe->total.buffers;
+    hthprobe->rateBytes = hthprobe->total.bytes;
+    
+    gst_structure_set(stats,
+                      "buffer-rate", G_TYPE_DOUBLE, bufferRate,
+                      "byte-rate", G_TYPE_DOUBLE, byteRate,
+                      "smoothed-jitter", G_TYPE_UINT64, (guint64) hthprobe->smoothedJitter,
+                      NULL);
+    appendCounters(&hthprobe->total, stats);
+    
+    GST_OBJECT_UNLOCK(hthprobe);
+    
+    return stats;
+}
+
+//==============================================================================
+
+/**
+ *
+ * @brief entry point to initialize the plug-in
+ *
+ * initialize the plug-in itself
+ * register the element factories and other features
+ */
+static gboolean hthprobe_init (GstPlugin * hthprobe){
+    
+    printf(WHITE "Plugin  -- hthprobe --- Init plugin function \n" RESET);
+    
+    /** Debug category for fltering log messages */
+    GST_DEBUG_CATEGORY_INIT (gst_hthprobe_debug, "hthprobe", 0, "Buffer measures");
+    
+    return gst_element_register (hthprobe, "hthprobe", GST_RANK_NONE, GST_TYPE_HTHPROBE);
+}
+
+//==============================================================================
+
+/* PACKAGE: this is usually set by autotools depending on some _INIT macro
+ * in configure.ac and then written into and defined in config.h, but we can
+ * just set it ourselves here in case someone doesn't use autotools to
+ * compile this code. GST_PLUGIN_DEFINE needs PACKAGE to be defined.
+ */
+#ifndef PACKAGE
+#define PACKAGE "myfirsththprobe"
+#endif
+
+/* gstreamer looks for this structure to register plugins
+ *
+ * exchange the string 'Template hthprobe' with your plugin description
+ */
+GST_PLUGIN_DEFINE (
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    hthprobe,
+    "Buffer rate, jitter, lateness and size measures",
+    hthprobe_init,
+    VERSION,
+    "LGPL",
+    "GStreamer",
+    "http://gstreamer.net/"
+)
@@ -0,0 +1,126 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+#ifndef __GST_HTHPROBE_H__
+#define __GST_HTHPROBE_H__
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "gsththhistogram.h"
+
+G_BEGIN_DECLS
+
+/* #defines don't like whitespacey bits */
+#define GST_TYPE_HTHPROBE (gst_hthprobe_get_type())
+#define GST_HTHPROBE(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HTHPROBE,Gsththprobe))
+#define GST_HTHPROBE_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_HTHPROBE,GsththprobeClass))
+#define GST_IS_HTHPROBE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HTHPROBE))
+#define GST_IS_HTHPROBE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_HTHPROBE))
+
+/**
+ * @struct HthProbeCounters
+ *
+ * @brief Measures of the buffers seen during a period
+ *
+ */
+typedef struct {
+    guint64 buffers; /**< Buffers that went through */
+    guint64 bytes; /**< Bytes of the buffers */
+    guint64 earlyBuffers; /**< Buffers whose running time is still ahead of the clock */
+    GstHthHistogram interarrival; /**< ns between two buffers */
+    GstHthHistogram jitter; /**< ns of variation between two consecutive inter-arrival times */
+    GstHthHistogram lateness; /**< ns the running time of the clock is past the PTS */
+    GstHthHistogram size; /**< Bytes of each buffer */
+} HthProbeCounters;
+
+/**
+ * @struct Gsththprobe
+ *
+ * @brief Passthrough element measuring the buffers that go through it
+ *
+ */
+
+typedef struct _Gsththprobe      Gsththprobe;
+
+struct _Gsththprobe{
+    
+    GstElement parent; /**< Parent struct. This element defines the plugin type */
+    
+    GstPad *sinkPad; /**< Buffers in */
+    GstPad *srcPad; /**< The same buffers out */
+    
+    /** Measures, protected by the object lock */
+    guint interval; /**< Milliseconds between two hth-probe messages, 0 for none */
+    GstSegment segment; /**< Last segment, for the running time of the PTS */
+    GstClockTime lastArrival; /**< Monotonic time of the previous buffer, in ns */
+    GstClockTime lastInterarrival; /**< Time between the two previous buffers, in ns */
+    gdouble smoothedJitter; /**< Inter-arrival jitter smoothed as in RFC 3550, in ns */
+    HthProbeCounters total; /**< Since the element went to PAUSED */
+    HthProbeCounters window; /**< Since the previous hth-probe message */
+    GstClockTime windowStart; /**< Monotonic time the window started, in ns */
+    GstClockTime rateTime; /**< Monotonic time of the previous stats read, in ns */
+    guint64 rateBuffers; /**< Buffers at the previous stats read */
+    guint64 rateBytes; /**< Bytes at the previous stats read */
+    
+};
+
+/**
+ * @struct GsththprobeClass
+ *
+ * @brief Generic struct that defines the plugin class.
+ *
+ */
+
+typedef struct _GsththprobeClass GsththprobeClass;
+
+struct _GsththprobeClass {
+    GstElementClass parent_class; /**< Parent plugin class */
+};
+
+GType gst_hthprobe_get_type (void);
+G_END_DECLS
+
+#endif /* __GST_HTHPROBE_H__ */
@@ -4,32 +4,60 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 ADT_SerialPortStruct* dummyStruct;
 
-void ADT_initSerialPort(ADT_SerialPortStruct *serialPortInfo)
+// Returns 0 when the port is open, -1 if the device can't be opened (the caller retries)
+int ADT_initSerialPort(ADT_SerialPortStruct *serialPortInfo)
 {
-	serialPortInfo->buffer = (unsigned char*)malloc(sizeof(char)*BUFFERSIZE);
-	//dummyStruct = serialPortInfo;
-	strcpy((char*)serialPortInfo->buffer, "DEFAULT MESSAGE");
+	ADT_closeSerialPort(serialPortInfo);
+	if (serialPortInfo->buffer == NULL)
+	{
+		serialPortInfo->buffer = (unsigned char*)malloc(sizeof(char)*BUFFERSIZE);
+		//dummyStruct = serialPortInfo;
+		strcpy((char*)serialPortInfo->buffer, "DEFAULT MESSAGE");
+		serialPortInfo->bufferLength = strlen("DEFAULT MESSAGE");
+	}
+	serialPortInfo->lineLength = 0;
 	// printf("%s\n",serialPortInfo->deviceName );
 	if ((serialPortInfo->fileDescriptor = open(serialPortInfo->deviceName, O_RDWR | O_NONBLOCK | O_NOCTTY ) ) < 0)
 	{
 		printf("could not open: %s \n",serialPortInfo->deviceName);
-		exit(1);
+		return -1;
 	}
 	else
 	{
 		fcntl(serialPortInfo->fileDescriptor, F_SETFL, 0);
 		serialPortInfo->channel = g_io_channel_unix_new (serialPortInfo->fileDescriptor);
-		g_io_add_watch(serialPortInfo->channel, G_IO_IN, &ttycallback, serialPortInfo);
+		serialPortInfo->watchId = g_io_add_watch(serialPortInfo->channel, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL, &ttycallback, serialPortInfo);
 		ADT_config(serialPortInfo);
+		serialPortInfo->isOpen = 1;
 		printf("port %s is now open\n", serialPortInfo->deviceName);
 	}
+	return 0;
 } 	
 
 //------------------------------------------------------------------------------
 
+void ADT_closeSerialPort(ADT_SerialPortStruct *serialPortInfo)
+{
+	if (!serialPortInfo->isOpen)
+		return;
+
+	if (serialPortInfo->watchId != 0)
+		g_source_remove(serialPortInfo->watchId);
+	serialPortInfo->watchId = 0;
+	g_io_channel_unref(serialPortInfo->channel);
+	serialPortInfo->channel = NULL;
+	close(serialPortInfo->fileDescriptor);
+	serialPortInfo->fileDescriptor = -1;
+	serialPortInfo->lineLength = 0;
+	serialPortInfo->isOpen = 0;
+}
+
+//------------------------------------------------------------------------------
+
 // End of the stream
 void eos_event_handler(int dummy) {
     printf("The user finish the stream!\n");
@@ -43,10 +71,50 @@ void eos_event_handler(int dummy) {
 
 gboolean ttycallback(GIOChannel *source, GIOCondition condition, void *data)
 {
+	ADT_SerialPortStruct *serialPortInfo = (ADT_SerialPortStruct*)data;
+	char chunk[BUFFERSIZE];
+	ssize_t chunkLength;
+	ssize_t i;
+
 	//printf("ttycallback\n");
-	//printf("%s\n", ((ADT_SerialPortStruct*)data)->deviceName);
-	((ADT_SerialPortStruct*)data)->bufferLength=read(((ADT_SerialPortStruct*)data)->fileDescriptor,((ADT_SerialPortStruct*)data)->buffer, BUFFERSIZE);
-    //onGetData(((ADT_SerialPortStruct*)data)->bufferLength, ((ADT_SerialPortStruct*)data)->buffer);
+	chunkLength = read(serialPortInfo->fileDescriptor, chunk, BUFFERSIZE - 1);
+
+	// A hangup reads 0 bytes or fails with EIO/ENXIO/ENODEV
+	if ((chunkLength < 0 && errno != EAGAIN && errno != EINTR)
+		|| (chunkLength == 0 && (condition & (G_IO_HUP | G_IO_ERR | G_IO_NVAL))))
+	{
+		printf("port %s was lost\n", serialPortInfo->deviceName);
+		// The watch is removed by returning FALSE
+		serialPortInfo->watchId = 0;
+		ADT_closeSerialPort(serialPortInfo);
+		if (serialPortInfo->onDisconnect != NULL)
+			serialPortInfo->onDisconnect(serialPortInfo->userData);
+		return FALSE;
+	}
+	if (chunkLength <= 0)
+		return 1;
+
+	// The raw chunk is what the need-data path sends, as it was read
+	memcpy(serialPortInfo->buffer, chunk, chunkLength);
+	serialPortInfo->buffer[chunkLength] = '\0';
+	serialPortInfo->bufferLength = chunkLength;
+
+	// Frame the stream in messages, the devices end each one with \n or \r\n
+	for (i = 0; i < chunkLength; i++)
+	{
+		if (chunk[i] != '\n' && chunk[i] != '\r')
+			serialPortInfo->line[serialPortInfo->lineLength++] = chunk[i];
+
+		if ((chunk[i] == '\n' || chunk[i] == '\r' || serialPortInfo->lineLength == BUFFERSIZE - 1)
+			&& serialPortInfo->lineLength > 0)
+		{
+			serialPortInfo->line[serialPortInfo->lineLength] = '\0';
+			if (serialPortInfo->onData != NULL)
+				serialPortInfo->onData(serialPortInfo->line, serialPortInfo->lineLength, serialPortInfo->userData);
+			serialPortInfo->lineLength = 0;
+		}
+	}
+	//onGetData(serialPortInfo->bufferLength, serialPortInfo->buffer);
 	return 1;
 }
 
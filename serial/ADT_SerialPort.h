@@ -11,6 +11,12 @@
 
 typedef struct _ADT_SerialPort	ADT_SerialPortStruct;
 
+// Called for each complete message (line) read from the port
+typedef void (*ADT_DataCallback)(const char *message, unsigned int length, void *userData);
+
+// Called when the device disappears (unplugged adapter, closed pty), the port is already closed
+typedef void (*ADT_DisconnectCallback)(void *userData);
+
 struct _ADT_SerialPort
 {
 	const char* deviceName;
@@ -18,12 +24,20 @@ struct _ADT_SerialPort
 	int speed;
 	int fileDescriptor;
 	GIOChannel* channel;
-	unsigned char* buffer;
+	unsigned char* buffer;	// last raw chunk read, not framed
 	unsigned int bufferLength;
 	GMainLoop* mainLoop;
+	char line[BUFFERSIZE];	// message being received
+	unsigned int lineLength;
+	ADT_DataCallback onData;	// optional, called from the main context
+	ADT_DisconnectCallback onDisconnect;	// optional, called from the main context
+	void *userData;
+	int isOpen;
+	guint watchId;
 };
 
-void ADT_initSerialPort(ADT_SerialPortStruct *serialPortInfo);
+int ADT_initSerialPort(ADT_SerialPortStruct *serialPortInfo);
+void ADT_closeSerialPort(ADT_SerialPortStruct *serialPortInfo);
 int ADT_config(ADT_SerialPortStruct *serialPortInfo);
 void eos_event_handler(int dummy);
 gboolean ttycallback(GIOChannel *source, GIOCondition condition, void *data);
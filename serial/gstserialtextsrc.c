@@ -63,6 +63,7 @@
 
 #include "gstserialtextsrc.h"
 #include "ADT_SerialPort.h" //own library
+#include "gsththbranch.h"
 #include <gst/gst.h>
 #include <stdio.h>
 #include <gst/app/gstappsrc.h>
@@ -83,19 +84,6 @@ GST_DEBUG_CATEGORY_STATIC (gst_serialtextsrc_debug);
 //==============================================================================
 
 
-/**
- * Exit error flags
- */
-
-#define EXIT_ELEMENT_CREATION_FAILURE  -1 /**< Creation elements failure flag */
-#define EXIT_ELEMENT_LINKING_FAILURE   -2 /**< Linking elements failure flag */
-#define EXIT_PADS_LINKING_FAILURE      -3 /**< Pads elements failure flag */
-#define EXIT_GHOSTPAD_CREATION_FAILURE -4 /**< Ghost pads elements failure flag */
-#define EXIT_GET_PAD_FAILURE           -5 /**< Get static pad failure flag */
-#define EXIT_SET_GHOSTH_PAD_FAILURE    -6 /**< Set ghosth pad failure flag */
-
-//==============================================================================
-
 /**
  * Parameters
  */
@@ -103,10 +91,17 @@ GST_DEBUG_CATEGORY_STATIC (gst_serialtextsrc_debug);
 #define DEFAULT_DEVICE                   ((const char *)"/dev/pts/19") /**< ADT Serial port reader default device */
 #define DEFAULT_SPEED                    9600 /**< ADT Serial port reader default speed */
 #define DEFAULT_SETTINGS                 ((const char *)"8n1") /**< ADT Serial port reader default settings */
+#define DEFAULT_DEDUP                    FALSE /**< Every message is pushed */
+#define DEFAULT_KEEPALIVE                1000 /**< Milliseconds between repetitions of an unchanged message */
+#define RECONNECT_MIN_INTERVAL           100 /**< First reopen attempt after the device is lost, ms */
+#define RECONNECT_MAX_INTERVAL           5000 /**< Reopen backoff limit, ms */
 
 enum{
     PROP_0,
-    PROP_DEVICE
+    PROP_DEVICE,
+    PROP_DEDUP,
+    PROP_KEEPALIVE,
+    PROP_STATS
 };
 
 //==============================================================================
@@ -144,9 +139,9 @@ static void createElements(Gstserialtextsrc *serialTextSrc);
  * @brief verify if all elements were cretated
  *
  * @param mediaDemux The plugin instance
- * @return void
+ * @return gboolean FALSE if appsrc is missing
  */
-static void verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc);
+static gboolean verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc);
 
 /**
  * @brief Set some elements properties like udpsrc port
@@ -168,9 +163,9 @@ static void addElementsToBin(Gstserialtextsrc *serialTextSrc);
  * @brief Creates the audio and video ghost pads from src template
  *
  * @param mediaDemux
- * @return void
+ * @return gboolean FALSE if the pad could not be created
  */
-static void createPluginGhostPads(Gstserialtextsrc *serialTextSrc);
+static gboolean createPluginGhostPads(Gstserialtextsrc *serialTextSrc);
 
 /**
  * @brief set plugin ghost pads with the las video and audio plugin
@@ -183,9 +178,9 @@ static void createPluginGhostPads(Gstserialtextsrc *serialTextSrc);
  *
  *
  * @param mediaDemux The plugin instance
- * @return void
+ * @return gboolean FALSE if the ghost pad target could not be set
  */
-static void setPluginSrcPads(Gstserialtextsrc *serialTextSrc);
+static gboolean setPluginSrcPads(Gstserialtextsrc *serialTextSrc);
 
 /**
  * @brief appsrc callback that ask for data
@@ -203,6 +198,187 @@ static void cb_need_data (GstElement *appsrc, guint unused_size, gpointer serial
  */
 static gboolean feed_buffer(gpointer serialTextsrc);
 
+/**
+ * @brief serial port callback called for each message read
+ *
+ * Pushes the message unless the deduplication is enabled
+ * and it is the same as the last one pushed
+ *
+ * @param message The message, without the line ending
+ * @param length Message length
+ * @param serialTextsrc The plugin instance
+ */
+static void cb_serialData(const char *message, unsigned int length, void *serialTextsrc);
+
+/**
+ * @brief serial port callback called when the device disappears
+ *
+ * @param serialTextsrc The plugin instance
+ */
+static void cb_serialDisconnect(void *serialTextsrc);
+
+/**
+ * @brief reopen timeout, doubles the interval after each failure
+ *
+ * @param serialTextsrc The plugin instance
+ * @return gboolean G_SOURCE_REMOVE, the next attempt is a new source
+ */
+static gboolean cb_reconnect(gpointer serialTextsrc);
+
+/**
+ * @brief open the serial port, or start an outage if it can't be opened
+ *
+ * @param serialTextSrc The plugin instance
+ * @return void
+ */
+static void openSerialPort(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief mark the device as lost, report it and schedule the reopen
+ *
+ * @param serialTextSrc The plugin instance
+ * @return void
+ */
+static void startOutage(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief post a serialtextsrc-outage element message
+ *
+ * @param serialTextSrc The plugin instance
+ * @param duration Outage duration, 0 when the device was just lost
+ * @return void
+ */
+static void postOutageMessage(Gstserialtextsrc *serialTextSrc, GstClockTime duration);
+
+/**
+ * @brief push an empty GAP flagged buffer, turned into a GAP event by cb_gapProbe
+ *
+ * @param serialTextSrc The plugin instance
+ * @param pts Start of the gap, GST_CLOCK_TIME_NONE to let appsrc timestamp it
+ * @param duration Length of the gap
+ * @return GstFlowReturn appsrc push-buffer return
+ */
+static GstFlowReturn pushGapBuffer(Gstserialtextsrc *serialTextSrc, GstClockTime pts, GstClockTime duration);
+
+/**
+ * @brief replace the GAP buffers of appsrc with GAP events
+ *
+ * appsrc can't push events, so the gap is queued as a buffer and
+ * converted in the appsrc streaming thread.
+ *
+ * @param pad appsrc src pad
+ * @param info Probe info with the buffer
+ * @param user_data The plugin instance
+ * @return GstPadProbeReturn GST_PAD_PROBE_DROP for the GAP buffers
+ */
+static GstPadProbeReturn cb_gapProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+/**
+ * @brief keepalive tick, repeats the last message and arms the next tick
+ *
+ * @param serialTextsrc The plugin instance
+ * @return gboolean G_SOURCE_REMOVE, the next tick is a new source
+ */
+static gboolean cb_keepalive(gpointer serialTextsrc);
+
+/**
+ * @brief arm the timeout of the next keepalive tick
+ *
+ * The ticks are counted from the start of the schedule, so a late
+ * dispatch does not push the following ones back.
+ *
+ * @param serialTextSrc The plugin instance
+ * @return void
+ */
+static void scheduleKeepalive(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief monotonic time of the next keepalive tick
+ *
+ * @param serialTextSrc The plugin instance
+ * @return gint64 Time in us
+ */
+static gint64 getNextKeepalive(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief push a text buffer that lasts until the next keepalive tick
+ *
+ * @param serialTextSrc The plugin instance
+ * @param text The message
+ * @return GstFlowReturn appsrc push-buffer return
+ */
+static GstFlowReturn pushTextBuffer(Gstserialtextsrc *serialTextSrc, const gchar *text);
+
+/**
+ * @brief configure appsrc as a live source timestamping the messages on arrival in deduplication mode
+ *
+ * @param serialTextSrc The plugin instance
+ * @return void
+ */
+static void setDedupMode(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief build the stats structure
+ *
+ * @param serialTextSrc The plugin instance
+ * @return GstStructure* serialtextsrc-stats structure
+ */
+static GstStructure *createStatsStructure(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief push a buffer into appsrc
+ *
+ * appsrc is replaced when it fails, the buffers are dropped until
+ * the new one is running.
+ *
+ * @param serialTextSrc The plugin instance
+ * @param buffer Buffer to push, the ownership is taken
+ * @return GstFlowReturn appsrc push-buffer return
+ */
+static GstFlowReturn pushAppSrcBuffer(Gstserialtextsrc *serialTextSrc, GstBuffer *buffer);
+
+/**
+ * @brief Replace appsrc after an error instead of stopping the element
+ *
+ * @param bin The plugin instance
+ * @param message Message posted by appsrc
+ */
+static void gst_serialtextsrc_handle_message (GstBin *bin, GstMessage *message);
+
+/**
+ * @brief Replace a failed appsrc with a new one
+ *
+ * Runs from gst_element_call_async(), not from a streaming thread.
+ *
+ * @param element The plugin instance
+ * @param user_data unused
+ */
+static void cb_rebuildBranch(GstElement *element, gpointer user_data);
+
+/**
+ * @brief Stop appsrc and remove it from the bin
+ *
+ * @param serialTextSrc The plugin instance
+ * @return void
+ */
+static void teardownBranch(Gstserialtextsrc *serialTextSrc);
+
+/**
+ * @brief start and stop the keepalive timeout
+ *
+ * @param element The plugin instance
+ * @param trans The state transition
+ * @return GstStateChangeReturn
+ */
+static GstStateChangeReturn gst_serialtextsrc_change_state (GstElement *element, GstStateChange trans);
+
+/**
+ * @brief Free the resources that are not owned by the bin
+ *
+ * @param object The plugin instance
+ */
+static void gst_serialtextsrc_finalize (GObject * object);
+
 /**
  * @brief set plugin's properties with new values
  *
@@ -235,12 +411,18 @@ static void gst_serialtextsrc_class_init (GstserialtextsrcClass * klass) {
     
     GObjectClass *gobject_class;
     GstElementClass *gstelement_class;
+    GstBinClass *gstbin_class;
     
     gobject_class = (GObjectClass *) klass;
     gstelement_class = (GstElementClass *) klass;
+    gstbin_class = (GstBinClass *) klass;
+    
+    gstbin_class->handle_message = gst_serialtextsrc_handle_message;
     
     gobject_class->set_property = gst_serialtextsrc_set_property;
     gobject_class->get_property = gst_serialtextsrc_get_property;
+    gobject_class->finalize = gst_serialtextsrc_finalize;
+    gstelement_class->change_state = gst_serialtextsrc_change_state;
     
     gst_element_class_set_details_simple(gstelement_class,
                                          "serialtextsrc",
@@ -253,6 +435,19 @@ static void gst_serialtextsrc_class_init (GstserialtextsrcClass * klass) {
                                      g_param_spec_string ("device", "Device Name",
                                                           "Device of /dev to open" , NULL,
                                                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DEDUP,
+                                     g_param_spec_boolean ("dedup", "Deduplication",
+                                                           "Suppress the messages identical to the last one, they are repeated only every keepalive ms",
+                                                           DEFAULT_DEDUP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_KEEPALIVE,
+                                     g_param_spec_uint ("keepalive", "Keepalive",
+                                                        "Milliseconds between repetitions of an unchanged message in dedup mode",
+                                                        10, G_MAXUINT, DEFAULT_KEEPALIVE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STATS,
+                                     g_param_spec_boxed ("stats", "Statistics",
+                                                         "Message, deduplication, device outage and appsrc restart counters",
+                                                         GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
     
     gst_element_class_add_pad_template (gstelement_class,
                                         gst_static_pad_template_get (&src_factory));
@@ -270,8 +465,12 @@ static void gst_serialtextsrc_set_property (GObject * object, guint prop_id, con
     switch (prop_id) {
         case PROP_DEVICE:
             
-            strcpy(serialtextsrc->device,g_value_get_string (value));
-            char* token = strtok(g_value_get_string (value), ",");
+            g_strlcpy(serialtextsrc->device, g_value_get_string (value), sizeof(serialtextsrc->device));
+            
+            /** The tokens must outlive the value, they are used again to reopen the device */
+            g_free(serialtextsrc->deviceArgs);
+            serialtextsrc->deviceArgs = g_value_dup_string (value);
+            char* token = strtok(serialtextsrc->deviceArgs, ",");
             int propertyNumber = 1;
             int number;
             while (token != NULL)
@@ -293,9 +492,30 @@ static void gst_serialtextsrc_set_property (GObject * object, guint prop_id, con
                 token = strtok (NULL,",");
             }
             
-            ADT_initSerialPort(&serialtextsrc->serialPortStruct);
+            openSerialPort(serialtextsrc);
             
             break;
+        
+        case PROP_DEDUP:
+            
+            if (GST_STATE(serialtextsrc) > GST_STATE_READY) {
+                printf(RED "dedup can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            serialtextsrc->dedup = g_value_get_boolean(value);
+            printf(GREEN "New dedup: %d \n" RESET , serialtextsrc->dedup);
+            setDedupMode(serialtextsrc);
+            break;
+        
+        case PROP_KEEPALIVE:
+            
+            if (GST_STATE(serialtextsrc) > GST_STATE_READY) {
+                printf(RED "keepalive can only be changed in NULL or READY state \n" RESET);
+                break;
+            }
+            serialtextsrc->keepalive = g_value_get_uint(value);
+            printf(GREEN "New keepalive: %u ms \n" RESET , serialtextsrc->keepalive);
+            break;
             
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -313,6 +533,15 @@ static void gst_serialtextsrc_get_property (GObject * object, guint prop_id, GVa
         case PROP_DEVICE:
             g_value_set_string (value, serialtextsrc->device);
             break;
+        case PROP_DEDUP:
+            g_value_set_boolean (value, serialtextsrc->dedup);
+            break;
+        case PROP_KEEPALIVE:
+            g_value_set_uint (value, serialtextsrc->keepalive);
+            break;
+        case PROP_STATS:
+            g_value_take_boxed (value, createStatsStructure(serialtextsrc));
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -346,18 +575,36 @@ static void gst_serialtextsrc_init (Gstserialtextsrc * serialTextSrc)
     printf(GREEN "Default speed %d \n" RESET, serialTextSrc->serialPortStruct.speed);
     serialTextSrc->serialPortStruct.settings = g_strdup(DEFAULT_SETTINGS);
     printf(GREEN "Default speed %s \n" RESET, serialTextSrc->serialPortStruct.settings);
+    serialTextSrc->serialPortStruct.onData = cb_serialData;
+    serialTextSrc->serialPortStruct.onDisconnect = cb_serialDisconnect;
+    serialTextSrc->serialPortStruct.userData = serialTextSrc;
+    serialTextSrc->serialPortStruct.fileDescriptor = -1;
+    serialTextSrc->dedup = DEFAULT_DEDUP;
+    serialTextSrc->keepalive = DEFAULT_KEEPALIVE;
+    gst_hth_branch_init(&serialTextSrc->textBranch, GST_ELEMENT(serialTextSrc), "text");
+    
+    gboolean isBuilt;
     
     /** Elements  */
     createElements(serialTextSrc);
-    verifyAllElementsCreated(serialTextSrc);
-    setElementsPropsValues(serialTextSrc);
-    
-    /** Bin */
-    addElementsToBin(serialTextSrc);
+    isBuilt = verifyAllElementsCreated(serialTextSrc);
+    if (isBuilt) {
+        setElementsPropsValues(serialTextSrc);
+        
+        /** Bin */
+        addElementsToBin(serialTextSrc);
+    }
     
     /** Pads */
-    createPluginGhostPads(serialTextSrc);
-    setPluginSrcPads(serialTextSrc);
+    if (!createPluginGhostPads(serialTextSrc)) {
+        serialTextSrc->constructionFailed = TRUE;
+        return;
+    }
+    if (isBuilt)
+        isBuilt = setPluginSrcPads(serialTextSrc);
+    
+    /** Reported when the element goes to READY */
+    serialTextSrc->constructionFailed = !isBuilt;
     
     /** plugin src pads */
     gst_element_add_pad (GST_ELEMENT (serialTextSrc), serialTextSrc->dataSrcPad);
@@ -377,6 +624,22 @@ static void gst_serialtextsrc_init (Gstserialtextsrc * serialTextSrc)
 
 //==============================================================================
 
+static void gst_serialtextsrc_finalize (GObject * object){
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC (object);
+    
+    if (serialTextSrc->reconnectSourceId != 0)
+        g_source_remove(serialTextSrc->reconnectSourceId);
+    ADT_closeSerialPort(&serialTextSrc->serialPortStruct);
+    
+    g_free(serialTextSrc->lastText);
+    g_free(serialTextSrc->deviceArgs);
+    
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+//==============================================================================
+
 static void createElements(Gstserialtextsrc *serialTextSrc) {
     
     /**
@@ -384,16 +647,19 @@ static void createElements(Gstserialtextsrc *serialTextSrc) {
      */
     
     /** udp src*/
+    GST_OBJECT_LOCK(serialTextSrc);
     serialTextSrc->plugin_app_src = gst_element_factory_make("appsrc", "text-src");
+    GST_OBJECT_UNLOCK(serialTextSrc);
     
-    g_signal_connect (serialTextSrc->plugin_app_src, "need-data", G_CALLBACK (cb_need_data), serialTextSrc);
+    if (serialTextSrc->plugin_app_src != NULL)
+        g_signal_connect (serialTextSrc->plugin_app_src, "need-data", G_CALLBACK (cb_need_data), serialTextSrc);
     
 }
 
 
 //==============================================================================
 
-static void verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc){
+static gboolean verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc){
     
     /**
      * Verify that all the internal plugins are created properly
@@ -401,9 +667,10 @@ static void verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc){
     
     if(!serialTextSrc->plugin_app_src){
         printf (RED "Appsrc could not be created\n" RESET);
-        exit(EXIT_ELEMENT_CREATION_FAILURE);
+        return FALSE;
     }
     
+    return TRUE;
 }
 
 
@@ -411,6 +678,8 @@ static void verifyAllElementsCreated(Gstserialtextsrc *serialTextSrc){
 
 static void setElementsPropsValues(Gstserialtextsrc *serialTextSrc){
     
+    GstCaps *caps;
+    
     /**
      * Configure the streaming capabilities mediademux
      */
@@ -420,12 +689,13 @@ static void setElementsPropsValues(Gstserialtextsrc *serialTextSrc){
                   "format", GST_FORMAT_TIME,
                   NULL);
     
-    g_object_set (G_OBJECT (serialTextSrc->plugin_app_src), "caps",
-                  gst_caps_new_simple ("text/x-raw",
-                                       "format", G_TYPE_STRING, "utf8",
-                                       NULL),
-                  NULL);
+    caps = gst_caps_new_simple ("text/x-raw",
+                                "format", G_TYPE_STRING, "utf8",
+                                NULL);
+    g_object_set (G_OBJECT (serialTextSrc->plugin_app_src), "caps", caps, NULL);
+    gst_caps_unref(caps);
     
+    setDedupMode(serialTextSrc);
 }
 
 //==============================================================================
@@ -445,7 +715,7 @@ static void addElementsToBin(Gstserialtextsrc *serialTextSrc){
 
 
 
-static void createPluginGhostPads(Gstserialtextsrc *serialTextSrc){
+static gboolean createPluginGhostPads(Gstserialtextsrc *serialTextSrc){
     
     /**
      * Create src ghost pads
@@ -455,15 +725,15 @@ static void createPluginGhostPads(Gstserialtextsrc *serialTextSrc){
                                                                          gst_static_pad_template_get (&src_factory));
     if (!serialTextSrc->dataSrcPad) {
         printf(RED "serial data src ghost pad no created from template \n" RESET);
-        exit(EXIT_GHOSTPAD_CREATION_FAILURE);
+        return FALSE;
     }
     
-    
+    return TRUE;
 }
 
 //==============================================================================
 
-static void setPluginSrcPads(Gstserialtextsrc *serialTextSrc){
+static gboolean setPluginSrcPads(Gstserialtextsrc *serialTextSrc){
     
     /**
      * Link the ghost pads with the last element of the audio and video flow respectively
@@ -475,16 +745,21 @@ static void setPluginSrcPads(Gstserialtextsrc *serialTextSrc){
     GstPad *dataSrcPad1 = gst_element_get_static_pad (serialTextSrc->plugin_app_src, "src");
     if (dataSrcPad1 == NULL) {
         printf(RED "Fail on get appsrc src pad \n" RESET);
-        exit(EXIT_GET_PAD_FAILURE);
+        return FALSE;
     }
     
     /** Set ghost pads with the elements src pads*/
     setGhostPad_ok = gst_ghost_pad_set_target ((GstGhostPad*)serialTextSrc->dataSrcPad, dataSrcPad1);
     if(!setGhostPad_ok){
         printf(RED "Text ghost pad could not be linked with appsrc pad \n" RESET);
-        exit(EXIT_SET_GHOSTH_PAD_FAILURE);
+        gst_object_unref(dataSrcPad1);
+        return FALSE;
     }
     
+    gst_pad_add_probe(dataSrcPad1, GST_PAD_PROBE_TYPE_BUFFER, cb_gapProbe, serialTextSrc, NULL);
+    gst_object_unref(dataSrcPad1);
+    
+    return TRUE;
 }
 
 //==============================================================================
@@ -492,6 +767,11 @@ static void setPluginSrcPads(Gstserialtextsrc *serialTextSrc){
 static void cb_need_data (GstElement *appsrc, guint unused_size, gpointer serialTextsrc)
 {
     //printf("cb_need_data\n");
+    
+    /** In dedup mode the messages are pushed when they arrive */
+    if (((Gstserialtextsrc*)serialTextsrc)->dedup)
+        return;
+    
     feed_buffer(serialTextsrc);
 }
 
@@ -505,8 +785,15 @@ static gboolean feed_buffer(gpointer serialTextsrc) {
     //char *str;
     int size = 32;
     
+    /** No text while the device is lost, downstream gets a GAP instead */
+    if (((Gstserialtextsrc*)serialTextsrc)->deviceLost) {
+        ret = pushGapBuffer((Gstserialtextsrc*)serialTextsrc, timestamp, gst_util_uint64_scale_int (1, GST_SECOND, 2));
+        timestamp += gst_util_uint64_scale_int (1, GST_SECOND, 2);
+        return ret == GST_FLOW_OK;
+    }
+    
     //printf("%s\n", ((Gstserialtextsrc*)serialTextsrc)->serialPortStruct->buffer);
-    strcpy(((Gstserialtextsrc*)serialTextsrc)->buff, (char*)((Gstserialtextsrc*)serialTextsrc)->serialPortStruct.buffer);
+    g_strlcpy(((Gstserialtextsrc*)serialTextsrc)->buff, (char*)((Gstserialtextsrc*)serialTextsrc)->serialPortStruct.buffer, MAX_BUFFER_SIZE);
     buffer = gst_buffer_new_wrapped_full( 0, (gpointer)(((Gstserialtextsrc*)serialTextsrc)->buff), MAX_BUFFER_SIZE,
                                           0, size, NULL, NULL);
 
@@ -517,7 +804,7 @@ static gboolean feed_buffer(gpointer serialTextsrc) {
     GST_BUFFER_DURATION (buffer) = gst_util_uint64_scale_int (1, GST_SECOND, 2);
 
     timestamp += GST_BUFFER_DURATION (buffer);
-    g_signal_emit_by_name ((GstAppSrc*)((Gstserialtextsrc*)serialTextsrc)->plugin_app_src, "push-buffer", buffer, &ret);
+    ret = pushAppSrcBuffer((Gstserialtextsrc*)serialTextsrc, buffer);
     
     if (ret != GST_FLOW_OK)
     {
@@ -531,6 +818,431 @@ static gboolean feed_buffer(gpointer serialTextsrc) {
 
 //==============================================================================
 
+static void cb_serialData(const char *message, unsigned int length, void *serialTextsrc) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC(serialTextsrc);
+    gboolean isDuplicate;
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    serialTextSrc->messagesReceived++;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    if (!serialTextSrc->dedup || GST_STATE(serialTextSrc) < GST_STATE_PAUSED)
+        return;
+    
+    isDuplicate = serialTextSrc->lastText != NULL && strcmp(serialTextSrc->lastText, message) == 0;
+    if (isDuplicate) {
+        GST_OBJECT_LOCK(serialTextSrc);
+        serialTextSrc->duplicatesSuppressed++;
+        GST_OBJECT_UNLOCK(serialTextSrc);
+        return;
+    }
+    
+    g_free(serialTextSrc->lastText);
+    serialTextSrc->lastText = g_strndup(message, length);
+    pushTextBuffer(serialTextSrc, serialTextSrc->lastText);
+}
+
+//==============================================================================
+
+static gboolean cb_keepalive(gpointer serialTextsrc) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC(serialTextsrc);
+    
+    serialTextSrc->keepaliveTicks++;
+    
+    /** Every tick repeats the message, the buffers of the new ones only last until the tick */
+    if (serialTextSrc->deviceLost) {
+        pushGapBuffer(serialTextSrc, GST_CLOCK_TIME_NONE, serialTextSrc->keepalive * GST_MSECOND);
+    } else if (serialTextSrc->lastText != NULL
+               && pushTextBuffer(serialTextSrc, serialTextSrc->lastText) == GST_FLOW_OK) {
+        GST_OBJECT_LOCK(serialTextSrc);
+        serialTextSrc->keepalivesSent++;
+        GST_OBJECT_UNLOCK(serialTextSrc);
+    }
+    
+    scheduleKeepalive(serialTextSrc);
+    
+    return G_SOURCE_REMOVE;
+}
+
+//==============================================================================
+
+static void scheduleKeepalive(Gstserialtextsrc *serialTextSrc) {
+    
+    gint64 delay = getNextKeepalive(serialTextSrc) - g_get_monotonic_time();
+    
+    /** Behind schedule, the tick is due now */
+    serialTextSrc->keepaliveSourceId = g_timeout_add(delay > 0 ? delay / 1000 : 0, cb_keepalive, serialTextSrc);
+}
+
+//==============================================================================
+
+static gint64 getNextKeepalive(Gstserialtextsrc *serialTextSrc) {
+    
+    return serialTextSrc->keepaliveStart + (gint64) (serialTextSrc->keepaliveTicks + 1) * serialTextSrc->keepalive * 1000;
+}
+
+//==============================================================================
+
+static GstFlowReturn pushTextBuffer(Gstserialtextsrc *serialTextSrc, const gchar *text) {
+    
+    GstBuffer *buffer;
+    GstFlowReturn ret;
+    gsize size = strlen(text);
+    gint64 untilTick = getNextKeepalive(serialTextSrc) - g_get_monotonic_time();
+    
+    /** appsrc sets the PTS (do-timestamp), the text lasts until the next keepalive tick */
+    buffer = gst_buffer_new_wrapped(g_strndup(text, size), size);
+    GST_BUFFER_DURATION (buffer) = untilTick > 0 ? untilTick * GST_USECOND : 0;
+    
+    ret = pushAppSrcBuffer(serialTextSrc, buffer);
+    
+    if (ret == GST_FLOW_OK) {
+        GST_OBJECT_LOCK(serialTextSrc);
+        serialTextSrc->buffersPushed++;
+        GST_OBJECT_UNLOCK(serialTextSrc);
+    }
+    
+    return ret;
+}
+
+//==============================================================================
+
+static void cb_serialDisconnect(void *serialTextsrc) {
+    
+    startOutage(GST_SERIALTEXTSRC(serialTextsrc));
+}
+
+//==============================================================================
+
+static gboolean cb_reconnect(gpointer serialTextsrc) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC(serialTextsrc);
+    GstClockTime duration;
+    
+    serialTextSrc->reconnectSourceId = 0;
+    
+    if (ADT_initSerialPort(&serialTextSrc->serialPortStruct) < 0) {
+        serialTextSrc->reconnectInterval = MIN(serialTextSrc->reconnectInterval * 2, RECONNECT_MAX_INTERVAL);
+        serialTextSrc->reconnectSourceId = g_timeout_add(serialTextSrc->reconnectInterval, cb_reconnect, serialTextSrc);
+        return G_SOURCE_REMOVE;
+    }
+    
+    duration = (g_get_monotonic_time() - serialTextSrc->outageStart) * GST_USECOND;
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    serialTextSrc->deviceLost = FALSE;
+    serialTextSrc->lastOutageDuration = duration;
+    serialTextSrc->totalOutageDuration += duration;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    printf(GREEN "Serial device %s restored after %" GST_TIME_FORMAT " \n" RESET,
+           serialTextSrc->serialPortStruct.deviceName, GST_TIME_ARGS(duration));
+    postOutageMessage(serialTextSrc, duration);
+    
+    return G_SOURCE_REMOVE;
+}
+
+//==============================================================================
+
+static void openSerialPort(Gstserialtextsrc *serialTextSrc) {
+    
+    if (serialTextSrc->reconnectSourceId != 0) {
+        g_source_remove(serialTextSrc->reconnectSourceId);
+        serialTextSrc->reconnectSourceId = 0;
+    }
+    
+    if (ADT_initSerialPort(&serialTextSrc->serialPortStruct) == 0) {
+        GST_OBJECT_LOCK(serialTextSrc);
+        serialTextSrc->deviceLost = FALSE;
+        GST_OBJECT_UNLOCK(serialTextSrc);
+        return;
+    }
+    
+    /** A device that is not plugged yet is handled as an outage */
+    startOutage(serialTextSrc);
+}
+
+//==============================================================================
+
+static void startOutage(Gstserialtextsrc *serialTextSrc) {
+    
+    printf(RED "Serial device %s lost, retrying \n" RESET, serialTextSrc->serialPortStruct.deviceName);
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    serialTextSrc->deviceLost = TRUE;
+    serialTextSrc->outages++;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    serialTextSrc->outageStart = g_get_monotonic_time();
+    
+    /** The first message after the outage is always pushed */
+    g_free(serialTextSrc->lastText);
+    serialTextSrc->lastText = NULL;
+    
+    postOutageMessage(serialTextSrc, 0);
+    
+    serialTextSrc->reconnectInterval = RECONNECT_MIN_INTERVAL;
+    serialTextSrc->reconnectSourceId = g_timeout_add(serialTextSrc->reconnectInterval, cb_reconnect, serialTextSrc);
+}
+
+//==============================================================================
+
+static void postOutageMessage(Gstserialtextsrc *serialTextSrc, GstClockTime duration) {
+    
+    GstStructure *outage;
+    
+    outage = gst_structure_new ("serialtextsrc-outage",
+                                "device", G_TYPE_STRING, serialTextSrc->serialPortStruct.deviceName,
+                                "connected", G_TYPE_BOOLEAN, !serialTextSrc->deviceLost,
+                                "duration", G_TYPE_UINT64, duration,
+                                NULL);
+    
+    gst_element_post_message (GST_ELEMENT (serialTextSrc),
+                              gst_message_new_element (GST_OBJECT (serialTextSrc), outage));
+}
+
+//==============================================================================
+
+static GstFlowReturn pushGapBuffer(Gstserialtextsrc *serialTextSrc, GstClockTime pts, GstClockTime duration) {
+    
+    GstBuffer *buffer;
+    
+    buffer = gst_buffer_new();
+    GST_BUFFER_PTS (buffer) = pts;
+    GST_BUFFER_DURATION (buffer) = duration;
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+    
+    return pushAppSrcBuffer(serialTextSrc, buffer);
+}
+
+//==============================================================================
+
+static GstPadProbeReturn cb_gapProbe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC(user_data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    
+    if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP) || gst_buffer_get_size(buffer) != 0)
+        return GST_PAD_PROBE_OK;
+    
+    gst_pad_push_event(pad, gst_event_new_gap(GST_BUFFER_PTS (buffer), GST_BUFFER_DURATION (buffer)));
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    serialTextSrc->gapsSent++;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    return GST_PAD_PROBE_DROP;
+}
+
+//==============================================================================
+
+static void setDedupMode(Gstserialtextsrc *serialTextSrc) {
+    
+    if (serialTextSrc->plugin_app_src == NULL)
+        return;
+    
+    /** The need-data path generates its own timestamps */
+    g_object_set (G_OBJECT (serialTextSrc->plugin_app_src),
+                  "is-live", serialTextSrc->dedup,
+                  "do-timestamp", serialTextSrc->dedup,
+                  NULL);
+}
+
+//==============================================================================
+
+static GstStructure *createStatsStructure(Gstserialtextsrc *serialTextSrc) {
+    
+    GstStructure *stats;
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    stats = gst_structure_new ("serialtextsrc-stats",
+                               "messages-received", G_TYPE_UINT64, serialTextSrc->messagesReceived,
+                               "buffers-pushed", G_TYPE_UINT64, serialTextSrc->buffersPushed,
+                               "duplicates-suppressed", G_TYPE_UINT64, serialTextSrc->duplicatesSuppressed,
+                               "keepalives-sent", G_TYPE_UINT64, serialTextSrc->keepalivesSent,
+                               "device-connected", G_TYPE_BOOLEAN, serialTextSrc->serialPortStruct.isOpen && !serialTextSrc->deviceLost,
+                               "outages", G_TYPE_UINT64, serialTextSrc->outages,
+                               "gaps-sent", G_TYPE_UINT64, serialTextSrc->gapsSent,
+                               "last-outage-duration", G_TYPE_UINT64, serialTextSrc->lastOutageDuration,
+                               "total-outage-duration", G_TYPE_UINT64, serialTextSrc->totalOutageDuration,
+                               NULL);
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    gst_hth_branch_append_stats(&serialTextSrc->textBranch, stats);
+    
+    return stats;
+}
+
+//==============================================================================
+
+static GstFlowReturn pushAppSrcBuffer(Gstserialtextsrc *serialTextSrc, GstBuffer *buffer) {
+    
+    GstElement *appSrc;
+    GstFlowReturn ret;
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    appSrc = serialTextSrc->plugin_app_src ? gst_object_ref(serialTextSrc->plugin_app_src) : NULL;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    /** appsrc is being rebuilt */
+    if (appSrc == NULL) {
+        gst_buffer_unref(buffer);
+        return GST_FLOW_FLUSHING;
+    }
+    
+    g_signal_emit_by_name (appSrc, "push-buffer", buffer, &ret);
+    gst_buffer_unref(buffer);
+    gst_object_unref(appSrc);
+    
+    return ret;
+}
+
+//==============================================================================
+
+static void gst_serialtextsrc_handle_message (GstBin *bin, GstMessage *message) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC (bin);
+    GstHthBranchAction action;
+    GError *error;
+    gchar *debug;
+    
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_ERROR) {
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    action = gst_hth_branch_fail(&serialTextSrc->textBranch);
+    if (action == GST_HTH_BRANCH_GIVE_UP) {
+        printf(RED "appsrc keeps failing, giving up \n" RESET);
+        GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+        return;
+    }
+    
+    if (action == GST_HTH_BRANCH_REBUILD) {
+        
+        gst_message_parse_error(message, &error, &debug);
+        printf(RED "appsrc failed: %s, rebuilding \n" RESET, error->message);
+        
+        /** The application still gets to know about the failure */
+        gst_element_post_message(GST_ELEMENT(serialTextSrc),
+                                 gst_message_new_warning(GST_OBJECT(serialTextSrc), error, debug));
+        g_error_free(error);
+        g_free(debug);
+        
+        gst_element_call_async(GST_ELEMENT(serialTextSrc), cb_rebuildBranch, NULL, NULL);
+    }
+    
+    gst_message_unref(message);
+}
+
+//==============================================================================
+
+static void cb_rebuildBranch(GstElement *element, gpointer user_data) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC (element);
+    GstPad *appSrcPad;
+    
+    printf(YELLOW "Rebuilding appsrc \n" RESET);
+    
+    teardownBranch(serialTextSrc);
+    
+    createElements(serialTextSrc);
+    if (!verifyAllElementsCreated(serialTextSrc)) {
+        GST_ELEMENT_ERROR (serialTextSrc, CORE, FAILED, ("appsrc could not be rebuilt"), (NULL));
+        return;
+    }
+    setElementsPropsValues(serialTextSrc);
+    addElementsToBin(serialTextSrc);
+    if (!setPluginSrcPads(serialTextSrc)) {
+        teardownBranch(serialTextSrc);
+        GST_ELEMENT_ERROR (serialTextSrc, CORE, FAILED, ("appsrc could not be rebuilt"), (NULL));
+        return;
+    }
+    
+    gst_element_sync_state_with_parent(serialTextSrc->plugin_app_src);
+    
+    /** The restore ends with the first buffer leaving the element */
+    appSrcPad = gst_element_get_static_pad (serialTextSrc->plugin_app_src, "src");
+    gst_hth_branch_rebuilt(&serialTextSrc->textBranch, appSrcPad);
+    gst_object_unref(appSrcPad);
+}
+
+//==============================================================================
+
+static void teardownBranch(Gstserialtextsrc *serialTextSrc) {
+    
+    GstElement *appSrc;
+    
+    GST_OBJECT_LOCK(serialTextSrc);
+    appSrc = serialTextSrc->plugin_app_src;
+    serialTextSrc->plugin_app_src = NULL;
+    GST_OBJECT_UNLOCK(serialTextSrc);
+    
+    if (appSrc == NULL)
+        return;
+    
+    gst_element_set_state(appSrc, GST_STATE_NULL);
+    if (GST_OBJECT_PARENT(appSrc) != NULL)
+        gst_bin_remove(GST_BIN(serialTextSrc), appSrc);
+    else
+        gst_object_unref(appSrc);
+}
+
+//==============================================================================
+
+static GstStateChangeReturn gst_serialtextsrc_change_state (GstElement *element, GstStateChange trans) {
+    
+    Gstserialtextsrc *serialTextSrc = GST_SERIALTEXTSRC (element);
+    GstStateChangeReturn ret;
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_NULL_TO_READY:
+            if (serialTextSrc->constructionFailed) {
+                GST_ELEMENT_ERROR (serialTextSrc, CORE, FAILED, ("appsrc could not be created"), (NULL));
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            break;
+        
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            if (serialTextSrc->dedup) {
+                serialTextSrc->keepaliveStart = g_get_monotonic_time();
+                serialTextSrc->keepaliveTicks = 0;
+                scheduleKeepalive(serialTextSrc);
+            }
+            break;
+        
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            if (serialTextSrc->keepaliveSourceId != 0) {
+                g_source_remove(serialTextSrc->keepaliveSourceId);
+                serialTextSrc->keepaliveSourceId = 0;
+            }
+            break;
+        
+        default:
+            break;
+    }
+    
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, trans);
+    
+    switch (trans)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            g_free(serialTextSrc->lastText);
+            serialTextSrc->lastText = NULL;
+            break;
+        
+        default:
+            break;
+    }
+    
+    return ret;
+}
+
+//==============================================================================
+
 
 
 /**
@@ -48,6 +48,7 @@
 
 #include <gst/gst.h>
 #include "ADT_SerialPort.h"
+#include "gsththbranch.h"
 
 G_BEGIN_DECLS
 
@@ -70,7 +71,9 @@ struct _Gstserialtextsrc
     GstPad *dataSrcPad;
     
     /** Internal element */
-    GstElement *plugin_app_src;
+    GstElement *plugin_app_src; /**< Replaced when it fails, protected by the object lock */
+    GstHthBranch textBranch; /**< Restart bookkeeping of appsrc */
+    gboolean constructionFailed; /**< appsrc missing, the element fails to go to READY */
     
     /**
      * Contains all the required for read
@@ -83,7 +86,31 @@ struct _Gstserialtextsrc
     
     /** Destination host */
     gchar device[30];
-
+    gchar *deviceArgs; /**< Copy of the device property, ADT_SerialPortStruct points into it */
+    
+    /** Device recovery */
+    gboolean deviceLost; /**< The device disappeared and is not open again yet */
+    gint64 outageStart; /**< Monotonic time the device was lost, in us */
+    guint reconnectSourceId; /**< Reconnect timeout source */
+    guint reconnectInterval; /**< Current reconnect backoff in ms */
+    
+    /** Deduplication */
+    gboolean dedup; /**< Only push the messages that differ from the last one */
+    guint keepalive; /**< Milliseconds between repetitions of an unchanged message */
+    guint keepaliveSourceId; /**< Keepalive timeout source */
+    gchar *lastText; /**< Last message pushed */
+    gint64 keepaliveStart; /**< Monotonic time the keepalive schedule started, in us */
+    guint64 keepaliveTicks; /**< Keepalive ticks since the start of the schedule */
+    
+    /** Stats, protected by the object lock */
+    guint64 messagesReceived; /**< Messages read from the serial port */
+    guint64 buffersPushed; /**< Buffers pushed downstream, keepalives included */
+    guint64 duplicatesSuppressed; /**< Messages not pushed because they repeat the last one */
+    guint64 keepalivesSent; /**< Repetitions of the last message pushed as keepalive */
+    guint64 gapsSent; /**< GAP events pushed while the device was lost */
+    guint64 outages; /**< Times the device was lost */
+    GstClockTime lastOutageDuration; /**< Duration of the last finished outage */
+    GstClockTime totalOutageDuration; /**< Duration of all the finished outages */
     
 };
 
@@ -0,0 +1,521 @@
+/**
+ * serialloadgen - serial text load generator for serialtextsrc
+ *
+ * Creates a pty pair and writes messages to it at a fixed rate, so
+ * serialtextsrc can be tested without serial hardware. Each message
+ * carries a sequence number and the send time in microseconds of
+ * CLOCK_MONOTONIC (the clock of g_get_monotonic_time()), which lets the
+ * receiving side measure loss and serial to mux latency:
+ *
+ *     HTH <sequence> <send time us> <padding>\n
+ *
+ * A capture written with --record can be re-emitted with its original
+ * timing with --replay. Capture lines are "<offset us>\t<message>".
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+
+#define RESET   "\033[0m"
+#define RED     "\033[1m\033[31m"   /** Error state */
+#define GREEN   "\033[1m\033[32m"   /** Success state */
+#define YELLOW  "\033[1m\033[33m"   /** Warnings */
+#define WHITE   "\033[1m\033[37m"   /** Normal text */
+
+#define DEFAULT_RATE            10 /**< Messages per second */
+#define DEFAULT_SIZE            32 /**< Bytes per message, line ending included */
+#define DEFAULT_BURST           1 /**< Messages written back to back on each tick */
+#define MIN_RATE                1
+#define MAX_RATE                100000
+#define MAX_MESSAGE_SIZE        4096
+#define REPORT_INTERVAL_US      1000000 /**< Stats are printed every second */
+
+#define EXIT_USAGE_FAILURE      -1 /**< Wrong command line */
+#define EXIT_PTY_FAILURE        -2 /**< The pty pair could not be created */
+#define EXIT_FILE_FAILURE       -3 /**< Capture or device could not be opened */
+
+//==============================================================================
+
+/**
+ * @struct LoadGenStats
+ *
+ * @brief Counters printed while the generator runs
+ *
+ */
+typedef struct {
+    unsigned long long sent; /**< Messages written completely */
+    unsigned long long bytes; /**< Bytes written */
+    unsigned long long dropped; /**< Messages not written because the pty buffer was full */
+    unsigned long long late; /**< Ticks that started after their deadline */
+} LoadGenStats;
+
+static volatile sig_atomic_t running = 1;
+
+//==============================================================================
+
+/**
+ * @brief Stop the main loops on SIGINT/SIGTERM
+ *
+ * @param signum Signal number
+ */
+static void onSignal(int signum);
+
+/**
+ * @brief Current CLOCK_MONOTONIC time in microseconds
+ *
+ * @return long long Time in microseconds
+ */
+static long long monotonicUs(void);
+
+/**
+ * @brief Sleep until an absolute CLOCK_MONOTONIC time
+ *
+ * @param deadlineUs Time in microseconds
+ */
+static void sleepUntil(long long deadlineUs);
+
+/**
+ * @brief Create a raw, non blocking pty pair and print the slave name
+ *
+ * @param linkPath Optional symlink to the slave, NULL for none
+ * @return int Master file descriptor
+ */
+static int openPty(const char *linkPath);
+
+/**
+ * @brief Wait until serialtextsrc opens the pty slave
+ *
+ * The master reports POLLHUP while nobody has the slave open,
+ * the messages written meanwhile would be lost.
+ *
+ * @param fd Master file descriptor
+ */
+static void waitForReader(int fd);
+
+/**
+ * @brief Write one message, counting it as dropped if the pty is full
+ *
+ * @param fd Master file descriptor
+ * @param message The message
+ * @param length Message length
+ * @param stats Counters
+ */
+static void writeMessage(int fd, const char *message, size_t length, LoadGenStats *stats);
+
+/**
+ * @brief Print the counters of the last interval
+ *
+ * @param stats Counters
+ * @param previous Counters at the previous report, updated
+ * @param elapsedUs Interval length
+ */
+static void printStats(const LoadGenStats *stats, LoadGenStats *previous, long long elapsedUs);
+
+/**
+ * @brief Generate sequenced messages at a fixed rate
+ *
+ * @return int Exit code
+ */
+static int runGenerator(int fd, unsigned int rate, unsigned int size, unsigned int burst,
+                        unsigned long long count, unsigned int duration);
+
+/**
+ * @brief Re-emit a capture with its original timing
+ *
+ * @return int Exit code
+ */
+static int runReplay(int fd, const char *capturePath, int loop);
+
+/**
+ * @brief Write the messages read from a device to a capture
+ *
+ * @return int Exit code
+ */
+static int runRecord(const char *devicePath, const char *capturePath, unsigned int duration);
+
+/**
+ * @brief Print the command line help
+ *
+ * @param program argv[0]
+ */
+static void printUsage(const char *program);
+
+//==============================================================================
+
+static void onSignal(int signum) {
+
+    (void)signum;
+    running = 0;
+}
+
+//==============================================================================
+
+static long long monotonicUs(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+//==============================================================================
+
+static void sleepUntil(long long deadlineUs) {
+
+    struct timespec deadline;
+
+    deadline.tv_sec = deadlineUs / 1000000LL;
+    deadline.tv_nsec = (deadlineUs % 1000000LL) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR && running)
+        ;
+}
+
+//==============================================================================
+
+static int openPty(const char *linkPath) {
+
+    struct termios settings;
+    const char *slaveName;
+    int fd;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0 || (slaveName = ptsname(fd)) == NULL) {
+        printf(RED "Could not create the pty pair: %s \n" RESET, strerror(errno));
+        exit(EXIT_PTY_FAILURE);
+    }
+
+    /** No echo nor line processing, the bytes reach serialtextsrc unchanged */
+    if (tcgetattr(fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        tcsetattr(fd, TCSANOW, &settings);
+    }
+
+    if (linkPath != NULL) {
+        unlink(linkPath);
+        if (symlink(slaveName, linkPath) < 0)
+            printf(YELLOW "Could not link %s: %s \n" RESET, linkPath, strerror(errno));
+    }
+
+    printf(GREEN "Serial device: %s%s%s \n" RESET, linkPath != NULL ? linkPath : slaveName,
+           linkPath != NULL ? " -> " : "", linkPath != NULL ? slaveName : "");
+    fflush(stdout);
+
+    return fd;
+}
+
+//==============================================================================
+
+static void waitForReader(int fd) {
+
+    struct pollfd master = { fd, POLLOUT, 0 };
+
+    printf(WHITE "Waiting for the device to be opened \n" RESET);
+    fflush(stdout);
+
+    while (running && poll(&master, 1, 100) >= 0 && (master.revents & POLLHUP))
+        usleep(10000);
+}
+
+//==============================================================================
+
+static void writeMessage(int fd, const char *message, size_t length, LoadGenStats *stats) {
+
+    ssize_t written = write(fd, message, length);
+
+    if (written == (ssize_t)length) {
+        stats->sent++;
+        stats->bytes += written;
+        return;
+    }
+
+    /** A partial write still counts as a lost message for the receiver */
+    if (written > 0)
+        stats->bytes += written;
+    stats->dropped++;
+}
+
+//==============================================================================
+
+static void printStats(const LoadGenStats *stats, LoadGenStats *previous, long long elapsedUs) {
+
+    double seconds = elapsedUs / 1000000.0;
+
+    printf(WHITE "sent %llu (%.0f msg/s, %.0f B/s) dropped %llu late ticks %llu \n" RESET,
+           stats->sent,
+           (stats->sent - previous->sent) / seconds,
+           (stats->bytes - previous->bytes) / seconds,
+           stats->dropped, stats->late);
+    fflush(stdout);
+
+    *previous = *stats;
+}
+
+//==============================================================================
+
+static int runGenerator(int fd, unsigned int rate, unsigned int size, unsigned int burst,
+                        unsigned long long count, unsigned int duration) {
+
+    LoadGenStats stats = {0}, reported = {0};
+    char message[MAX_MESSAGE_SIZE + 64];
+    unsigned long long sequence = 0;
+    unsigned long long tick = 0;
+    long long startUs, nextTickUs, lastReportUs, nowUs;
+    unsigned int i;
+    int length;
+
+    startUs = monotonicUs();
+    nextTickUs = startUs;
+    lastReportUs = startUs;
+
+    while (running && (count == 0 || sequence < count)) {
+
+        nowUs = monotonicUs();
+        if (duration > 0 && nowUs - startUs >= duration * 1000000LL)
+            break;
+
+        for (i = 0; i < burst && (count == 0 || sequence < count); i++) {
+            length = snprintf(message, sizeof(message), "HTH %llu %lld ", sequence, monotonicUs());
+
+            /** Pad up to the requested size, the line ending included */
+            while ((unsigned int)length < size - 1 && length < MAX_MESSAGE_SIZE - 1)
+                message[length++] = 'x';
+            message[length++] = '\n';
+
+            writeMessage(fd, message, length, &stats);
+            sequence++;
+        }
+
+        if (nowUs - lastReportUs >= REPORT_INTERVAL_US) {
+            printStats(&stats, &reported, nowUs - lastReportUs);
+            lastReportUs = nowUs;
+        }
+
+        /** From the start every time, a rounded interval would drift the rate */
+        tick++;
+        nextTickUs = startUs + (long long)(tick * 1000000ULL * burst / rate);
+        if (monotonicUs() > nextTickUs)
+            stats.late++;
+        else
+            sleepUntil(nextTickUs);
+    }
+
+    printStats(&stats, &reported, monotonicUs() - lastReportUs);
+
+    return EXIT_SUCCESS;
+}
+
+//==============================================================================
+
+static int runReplay(int fd, const char *capturePath, int loop) {
+
+    LoadGenStats stats = {0}, reported = {0};
+    char line[MAX_MESSAGE_SIZE + 64];
+    char *message;
+    long long offsetUs, startUs, lastReportUs, nowUs;
+    size_t length;
+    FILE *capture;
+
+    capture = fopen(capturePath, "r");
+    if (capture == NULL) {
+        printf(RED "Could not open %s: %s \n" RESET, capturePath, strerror(errno));
+        return EXIT_FILE_FAILURE;
+    }
+
+    startUs = monotonicUs();
+    lastReportUs = startUs;
+
+    while (running) {
+
+        if (fgets(line, sizeof(line), capture) == NULL) {
+            if (!loop)
+                break;
+            rewind(capture);
+            startUs = monotonicUs();
+            continue;
+        }
+
+        offsetUs = strtoll(line, &message, 10);
+        if (*message != '\t') {
+            printf(YELLOW "Skipping malformed capture line \n" RESET);
+            continue;
+        }
+        message++;
+        length = strlen(message);
+
+        sleepUntil(startUs + offsetUs);
+        writeMessage(fd, message, length, &stats);
+
+        nowUs = monotonicUs();
+        if (nowUs - lastReportUs >= REPORT_INTERVAL_US) {
+            printStats(&stats, &reported, nowUs - lastReportUs);
+            lastReportUs = nowUs;
+        }
+    }
+
+    printStats(&stats, &reported, monotonicUs() - lastReportUs);
+    fclose(capture);
+
+    return EXIT_SUCCESS;
+}
+
+//==============================================================================
+
+static int runRecord(const char *devicePath, const char *capturePath, unsigned int duration) {
+
+    char chunk[MAX_MESSAGE_SIZE];
+    char line[MAX_MESSAGE_SIZE];
+    size_t lineLength = 0;
+    unsigned long long messages = 0;
+    long long startUs, lineStartUs = 0;
+    struct pollfd device;
+    FILE *capture;
+    ssize_t chunkLength, i;
+
+    device.fd = open(devicePath, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (device.fd < 0) {
+        printf(RED "Could not open %s: %s \n" RESET, devicePath, strerror(errno));
+        return EXIT_FILE_FAILURE;
+    }
+    device.events = POLLIN;
+
+    capture = fopen(capturePath, "w");
+    if (capture == NULL) {
+        printf(RED "Could not open %s: %s \n" RESET, capturePath, strerror(errno));
+        close(device.fd);
+        return EXIT_FILE_FAILURE;
+    }
+
+    startUs = monotonicUs();
+
+    while (running && (duration == 0 || monotonicUs() - startUs < duration * 1000000LL)) {
+
+        if (poll(&device, 1, 100) <= 0)
+            continue;
+
+        chunkLength = read(device.fd, chunk, sizeof(chunk));
+        if (chunkLength <= 0)
+            continue;
+
+        /** The message time is the arrival of its first byte */
+        for (i = 0; i < chunkLength; i++) {
+            if (lineLength == 0)
+                lineStartUs = monotonicUs() - startUs;
+            if (lineLength < sizeof(line) - 1)
+                line[lineLength++] = chunk[i];
+            if (chunk[i] == '\n') {
+                fprintf(capture, "%lld\t%.*s", lineStartUs, (int)lineLength, line);
+                lineLength = 0;
+                messages++;
+            }
+        }
+    }
+
+    printf(GREEN "Recorded %llu messages in %s \n" RESET, messages, capturePath);
+    fclose(capture);
+    close(device.fd);
+
+    return EXIT_SUCCESS;
+}
+
+//==============================================================================
+
+static void printUsage(const char *program) {
+
+    printf("Usage: %s [OPTION]...\n"
+           "Write serial text messages to a new pty for serialtextsrc.\n"
+           "\n"
+           "  -r, --rate=HZ          messages per second, %d to %d (default %d)\n"
+           "  -s, --size=BYTES       message size with the line ending (default %d)\n"
+           "  -b, --burst=N          messages written back to back per tick (default %d)\n"
+           "  -n, --count=N          stop after N messages (default unlimited)\n"
+           "  -d, --duration=SECONDS stop after SECONDS (default unlimited)\n"
+           "  -l, --link=PATH        symlink PATH to the pty slave\n"
+           "  -p, --replay=FILE      re-emit a capture with its original timing\n"
+           "  -o, --loop             restart the capture when it ends\n"
+           "  -w, --record=FILE      write the messages read from --device to FILE\n"
+           "  -D, --device=PATH      device read by --record\n"
+           "  -h, --help             show this help\n",
+           program, MIN_RATE, MAX_RATE, DEFAULT_RATE, DEFAULT_SIZE, DEFAULT_BURST);
+}
+
+//==============================================================================
+
+int main(int argc, char *argv[]) {
+
+    static const struct option options[] = {
+        { "rate", required_argument, NULL, 'r' },
+        { "size", required_argument, NULL, 's' },
+        { "burst", required_argument, NULL, 'b' },
+        { "count", required_argument, NULL, 'n' },
+        { "duration", required_argument, NULL, 'd' },
+        { "link", required_argument, NULL, 'l' },
+        { "replay", required_argument, NULL, 'p' },
+        { "loop", no_argument, NULL, 'o' },
+        { "record", required_argument, NULL, 'w' },
+        { "device", required_argument, NULL, 'D' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    unsigned int rate = DEFAULT_RATE, size = DEFAULT_SIZE, burst = DEFAULT_BURST, duration = 0;
+    unsigned long long count = 0;
+    const char *linkPath = NULL, *replayPath = NULL, *recordPath = NULL, *devicePath = NULL;
+    int loop = 0, option, fd, ret;
+    struct sigaction action;
+
+    while ((option = getopt_long(argc, argv, "r:s:b:n:d:l:p:ow:D:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'r': rate = strtoul(optarg, NULL, 10); break;
+            case 's': size = strtoul(optarg, NULL, 10); break;
+            case 'b': burst = strtoul(optarg, NULL, 10); break;
+            case 'n': count = strtoull(optarg, NULL, 10); break;
+            case 'd': duration = strtoul(optarg, NULL, 10); break;
+            case 'l': linkPath = optarg; break;
+            case 'p': replayPath = optarg; break;
+            case 'o': loop = 1; break;
+            case 'w': recordPath = optarg; break;
+            case 'D': devicePath = optarg; break;
+            case 'h': printUsage(argv[0]); return EXIT_SUCCESS;
+            default: printUsage(argv[0]); return EXIT_USAGE_FAILURE;
+        }
+    }
+
+    if (rate < MIN_RATE || rate > MAX_RATE || size < 2 || size > MAX_MESSAGE_SIZE || burst == 0
+        || (recordPath != NULL && devicePath == NULL) || (recordPath != NULL && replayPath != NULL)) {
+        printUsage(argv[0]);
+        return EXIT_USAGE_FAILURE;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (recordPath != NULL)
+        return runRecord(devicePath, recordPath, duration);
+
+    fd = openPty(linkPath);
+    waitForReader(fd);
+
+    if (replayPath != NULL)
+        ret = runReplay(fd, replayPath, loop);
+    else
+        ret = runGenerator(fd, rate, size, burst, count, duration);
+
+    if (linkPath != NULL)
+        unlink(linkPath);
+    close(fd);
+
+    return ret;
+}
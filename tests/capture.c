@@ -0,0 +1,287 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the datagram capture files (demux/gsththcapture.c)
+ *
+ * Every test writes its capture in a temporary file, read back with the
+ * reader hthstreamsrc uses for replay-location.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+
+#include <arpa/inet.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gsththcapture.h"
+
+//==============================================================================
+
+/**
+ * @brief Create an empty temporary file
+ *
+ * @return gchar* Path of the file, to free
+ */
+static gchar *createTempFile (void){
+    
+    gchar *path = NULL;
+    gint fd;
+    
+    fd = g_file_open_tmp ("hthcapture-XXXXXX", &path, NULL);
+    fail_unless (fd >= 0);
+    close (fd);
+    
+    return path;
+}
+
+//==============================================================================
+
+/**
+ * @brief Fill a datagram with a pattern of its index
+ *
+ * @param data The datagram
+ * @param size Datagram size
+ * @param index Index of the datagram in the capture
+ */
+static void fillDatagram (guint8 *data, gsize size, guint index){
+    
+    gsize i;
+    
+    for (i = 0; i < size; i++)
+        data[i] = (guint8) (i * 7 + index);
+}
+
+//==============================================================================
+
+/**
+ * @brief Set an IPv4 sender
+ *
+ * @param from Address to fill
+ * @param address Dotted address
+ * @param port Port in host order
+ */
+static void setSender (struct sockaddr_in *from, const gchar *address, guint16 port){
+    
+    memset (from, 0, sizeof (*from));
+    from->sin_family = AF_INET;
+    from->sin_port = htons (port);
+    fail_unless (inet_pton (AF_INET, address, &from->sin_addr) == 1);
+}
+
+//==============================================================================
+
+GST_START_TEST (test_capture_round_trip)
+{
+    const gsize sizes[] = { 1400, 0, HTH_CAPTURE_MAX_DATAGRAM, 12 };
+    gchar *path = createTempFile ();
+    struct sockaddr_in senders[G_N_ELEMENTS (sizes)];
+    struct sockaddr_in from;
+    GstHthCaptureReader *reader;
+    GstHthCapture *capture;
+    GstClockTime previous = 0;
+    GstClockTime arrival;
+    guint8 *expected = g_malloc (HTH_CAPTURE_MAX_DATAGRAM);
+    guint8 *data = g_malloc (HTH_CAPTURE_MAX_DATAGRAM);
+    gsize size;
+    guint i;
+    
+    setSender (&senders[0], "192.168.1.20", 5000);
+    setSender (&senders[1], "10.0.0.1", 6000);
+    memset (&senders[2], 0, sizeof (senders[2]));
+    setSender (&senders[3], "127.0.0.1", 65535);
+    
+    capture = gst_hth_capture_open (path);
+    fail_unless (capture != NULL);
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+        fillDatagram (expected, sizes[i], i);
+        /** The third sender is unknown, as with udpsrc */
+        gst_hth_capture_write (capture, i == 2 ? NULL : &senders[i], expected, sizes[i]);
+    }
+    gst_hth_capture_close (capture);
+    
+    reader = gst_hth_capture_reader_open (path);
+    fail_unless (reader != NULL);
+    
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    
+        fail_unless (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size), "datagram %u missing", i);
+    
+        /** The times start at the first datagram and never go back */
+        if (i == 0)
+            fail_unless_equals_uint64 (arrival, 0);
+        fail_unless (arrival >= previous);
+        previous = arrival;
+    
+        fail_unless_equals_int (from.sin_family, AF_INET);
+        fail_unless_equals_uint64 (from.sin_addr.s_addr, senders[i].sin_addr.s_addr);
+        fail_unless_equals_int (from.sin_port, senders[i].sin_port);
+    
+        fail_unless_equals_uint64 (size, sizes[i]);
+        fillDatagram (expected, sizes[i], i);
+        fail_unless (memcmp (data, expected, size) == 0, "datagram %u differs", i);
+    }
+    
+    fail_if (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size));
+    gst_hth_capture_reader_close (reader);
+    
+    g_unlink (path);
+    g_free (path);
+    g_free (expected);
+    g_free (data);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_capture_stats_and_limit)
+{
+    gchar *path = createTempFile ();
+    GstHthCaptureReader *reader;
+    GstHthCapture *capture;
+    GstStructure *stats;
+    struct sockaddr_in from;
+    GstClockTime arrival;
+    guint8 *data = g_malloc0 (HTH_CAPTURE_MAX_DATAGRAM + 100);
+    gsize size;
+    guint64 value;
+    
+    capture = gst_hth_capture_open (path);
+    gst_hth_capture_write (capture, NULL, data, 100);
+    
+    /** The length field is 16 bits, a larger datagram is cut */
+    gst_hth_capture_write (capture, NULL, data, HTH_CAPTURE_MAX_DATAGRAM + 100);
+    
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_capture_append_stats (capture, stats);
+    fail_unless (gst_structure_get_uint64 (stats, "capture-datagrams", &value));
+    fail_unless_equals_uint64 (value, 2);
+    fail_unless (gst_structure_get_uint64 (stats, "capture-bytes", &value));
+    fail_unless_equals_uint64 (value, 100 + HTH_CAPTURE_MAX_DATAGRAM);
+    gst_structure_free (stats);
+    gst_hth_capture_close (capture);
+    
+    reader = gst_hth_capture_reader_open (path);
+    fail_unless (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size));
+    fail_unless_equals_uint64 (size, 100);
+    fail_unless (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size));
+    fail_unless_equals_uint64 (size, HTH_CAPTURE_MAX_DATAGRAM);
+    fail_unless_equals_uint64 (from.sin_addr.s_addr, 0);
+    gst_hth_capture_reader_close (reader);
+    
+    g_unlink (path);
+    g_free (path);
+    g_free (data);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_capture_truncated)
+{
+    gchar *path = createTempFile ();
+    GstHthCaptureReader *reader;
+    GstHthCapture *capture;
+    struct sockaddr_in from;
+    GstClockTime arrival;
+    guint8 *data = g_malloc0 (HTH_CAPTURE_MAX_DATAGRAM);
+    gsize size;
+    
+    capture = gst_hth_capture_open (path);
+    gst_hth_capture_write (capture, NULL, data, 500);
+    gst_hth_capture_write (capture, NULL, data, 500);
+    gst_hth_capture_close (capture);
+    
+    /** Cut in the middle of the last datagram, as a capture killed while it was written */
+    fail_unless (truncate (path, strlen (HTH_CAPTURE_MAGIC) + 2 * HTH_CAPTURE_RECORD_SIZE + 500 + 200) == 0);
+    
+    reader = gst_hth_capture_reader_open (path);
+    fail_unless (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size));
+    fail_if (gst_hth_capture_reader_next (reader, &arrival, &from, data, &size));
+    gst_hth_capture_reader_close (reader);
+    
+    g_unlink (path);
+    g_free (path);
+    g_free (data);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_capture_not_a_capture)
+{
+    gchar *path = createTempFile ();
+    
+    /** Missing file */
+    fail_unless (gst_hth_capture_reader_open ("/nonexistent/hth.hthcap") == NULL);
+    
+    /** An empty file, then an other file format */
+    fail_unless (gst_hth_capture_reader_open (path) == NULL);
+    fail_unless (g_file_set_contents (path, "\x1A\x45\xDF\xA3 matroska", -1, NULL));
+    fail_unless (gst_hth_capture_reader_open (path) == NULL);
+    
+    g_unlink (path);
+    g_free (path);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *capture_suite (void){
+    
+    Suite *s = suite_create ("capture");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_capture_round_trip);
+    tcase_add_test (tc, test_capture_stats_and_limit);
+    tcase_add_test (tc, test_capture_truncated);
+    tcase_add_test (tc, test_capture_not_a_capture);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (capture);
@@ -0,0 +1,228 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of GstHthHistogram (common/gsththhistogram.c)
+ *
+ * The values below 2 << HTH_HISTOGRAM_SUB_BITS have a bucket of their
+ * own, the larger ones are kept to 1 / (1 << HTH_HISTOGRAM_SUB_BITS) of
+ * their value, rounded down.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsththhistogram.h"
+
+#define SUB_BUCKETS (1 << HTH_HISTOGRAM_SUB_BITS) /**< Buckets per power of two */
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_empty)
+{
+    GstHthHistogram histogram;
+    GstStructure *stats;
+    guint64 value;
+    
+    gst_hth_histogram_reset (&histogram);
+    
+    fail_unless_equals_uint64 (histogram.samples, 0);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 50.0), 0);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 99.0), 0);
+    
+    /** No sample reads as 0, not as G_MAXUINT64 */
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_histogram_append_stats (&histogram, stats, "empty");
+    fail_unless (gst_structure_get_uint64 (stats, "empty-min", &value));
+    fail_unless_equals_uint64 (value, 0);
+    fail_unless (gst_structure_get_uint64 (stats, "empty-mean", &value));
+    fail_unless_equals_uint64 (value, 0);
+    gst_structure_free (stats);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_small_values_exact)
+{
+    GstHthHistogram histogram;
+    guint64 value;
+    
+    gst_hth_histogram_reset (&histogram);
+    for (value = 0; value < 2 * SUB_BUCKETS; value++)
+        gst_hth_histogram_record (&histogram, value);
+    
+    fail_unless_equals_uint64 (histogram.samples, 2 * SUB_BUCKETS);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 0.0), 0);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 50.0), SUB_BUCKETS - 1);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 100.0), 2 * SUB_BUCKETS - 1);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_bucket_precision)
+{
+    GstHthHistogram histogram;
+    guint64 value;
+    guint64 bucket;
+    
+    /** Between a 0 and a larger value, the median falls in the bucket of the value itself */
+    for (value = 2 * SUB_BUCKETS; value < G_MAXUINT64 / 3; value = value * 3 + 1) {
+    
+        gst_hth_histogram_reset (&histogram);
+        gst_hth_histogram_record (&histogram, 0);
+        gst_hth_histogram_record (&histogram, value);
+        gst_hth_histogram_record (&histogram, value);
+        gst_hth_histogram_record (&histogram, G_MAXUINT64);
+    
+        bucket = gst_hth_histogram_get_percentile (&histogram, 50.0);
+        fail_unless (bucket <= value, "%" G_GUINT64_FORMAT " reported as %" G_GUINT64_FORMAT, value, bucket);
+        fail_unless (value - bucket <= value / SUB_BUCKETS,
+                     "%" G_GUINT64_FORMAT " reported as %" G_GUINT64_FORMAT, value, bucket);
+    }
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_percentiles)
+{
+    GstHthHistogram histogram;
+    guint64 p50;
+    guint64 p95;
+    guint64 p99;
+    guint64 value;
+    
+    gst_hth_histogram_reset (&histogram);
+    for (value = 1; value <= 1000; value++)
+        gst_hth_histogram_record (&histogram, value * GST_MSECOND);
+    
+    p50 = gst_hth_histogram_get_percentile (&histogram, 50.0);
+    p95 = gst_hth_histogram_get_percentile (&histogram, 95.0);
+    p99 = gst_hth_histogram_get_percentile (&histogram, 99.0);
+    
+    fail_unless (p50 <= p95 && p95 <= p99 && p99 <= histogram.max);
+    fail_unless (p50 <= 500 * GST_MSECOND && p50 >= 500 * GST_MSECOND - 500 * GST_MSECOND / SUB_BUCKETS);
+    fail_unless (p99 <= 990 * GST_MSECOND && p99 >= 990 * GST_MSECOND - 990 * GST_MSECOND / SUB_BUCKETS);
+    fail_unless_equals_uint64 (histogram.min, GST_MSECOND);
+    fail_unless_equals_uint64 (histogram.max, 1000 * GST_MSECOND);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_extremes)
+{
+    GstHthHistogram histogram;
+    guint64 top;
+    
+    /** The last bucket holds G_MAXUINT64 without going past the array */
+    gst_hth_histogram_reset (&histogram);
+    gst_hth_histogram_record (&histogram, G_MAXUINT64);
+    gst_hth_histogram_record (&histogram, G_MAXUINT64 - 1);
+    
+    top = gst_hth_histogram_get_percentile (&histogram, 100.0);
+    fail_unless_equals_uint64 (histogram.max, G_MAXUINT64);
+    fail_unless (top >= G_MAXUINT64 - G_MAXUINT64 / SUB_BUCKETS);
+    fail_unless_equals_uint64 (histogram.counts[HTH_HISTOGRAM_BUCKETS - 1], 2);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_histogram_stats_fields)
+{
+    GstHthHistogram histogram;
+    GstStructure *stats;
+    guint64 value;
+    
+    gst_hth_histogram_reset (&histogram);
+    gst_hth_histogram_record (&histogram, 10);
+    gst_hth_histogram_record (&histogram, 20);
+    gst_hth_histogram_record (&histogram, 30);
+    
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_histogram_append_stats (&histogram, stats, "video-latency");
+    
+    fail_unless (gst_structure_get_uint64 (stats, "video-latency-p50", &value));
+    fail_unless_equals_uint64 (value, 20);
+    fail_unless (gst_structure_get_uint64 (stats, "video-latency-min", &value));
+    fail_unless_equals_uint64 (value, 10);
+    fail_unless (gst_structure_get_uint64 (stats, "video-latency-max", &value));
+    fail_unless_equals_uint64 (value, 30);
+    fail_unless (gst_structure_get_uint64 (stats, "video-latency-mean", &value));
+    fail_unless_equals_uint64 (value, 20);
+    fail_unless (gst_structure_has_field (stats, "video-latency-p95"));
+    fail_unless (gst_structure_has_field (stats, "video-latency-p99"));
+    fail_unless (gst_structure_has_field (stats, "video-latency-p999"));
+    
+    /** reset starts a new window */
+    gst_hth_histogram_reset (&histogram);
+    fail_unless_equals_uint64 (histogram.samples, 0);
+    fail_unless_equals_uint64 (gst_hth_histogram_get_percentile (&histogram, 50.0), 0);
+    
+    gst_structure_free (stats);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *histogram_suite (void){
+    
+    Suite *s = suite_create ("histogram");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_histogram_empty);
+    tcase_add_test (tc, test_histogram_small_values_exact);
+    tcase_add_test (tc, test_histogram_bucket_precision);
+    tcase_add_test (tc, test_histogram_percentiles);
+    tcase_add_test (tc, test_histogram_extremes);
+    tcase_add_test (tc, test_histogram_stats_fields);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (histogram);
@@ -0,0 +1,239 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the decisions of hthimpair (impair/gsththimpair.c)
+ *
+ * Without delay, jitter nor bandwidth the element pushes from its sink
+ * pad, so the datagrams that come out only depend on the seed and on the
+ * loss, burst and duplicate draws.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "gsththimpair.h"
+
+#define DATAGRAMS 1000 /**< Datagrams pushed by each run */
+
+//==============================================================================
+
+/**
+ * @brief Push numbered datagrams through an hthimpair
+ *
+ * @param seed Seed of the element
+ * @param loss Percent lost in the good state
+ * @param burstEnter Percent chance to enter a burst, 0 for none
+ * @param duplicate Percent sent twice
+ * @param stats Returns the stats of the element, may be NULL
+ * @return GArray* Numbers of the datagrams that came out, in order
+ */
+static GArray *runImpairment (guint seed, gdouble loss, gdouble burstEnter, gdouble duplicate, GstStructure **stats){
+    
+    GArray *numbers = g_array_new (FALSE, FALSE, sizeof (guint64));
+    GstElement *impair;
+    GstHarness *h;
+    GstBuffer *buffer;
+    guint64 number;
+    
+    /** The seed is applied on the way to PAUSED, the harness starts the element */
+    impair = gst_element_factory_make ("hthimpair", NULL);
+    fail_unless (impair != NULL);
+    g_object_set (impair, "seed", seed, "loss", loss, "burst-enter", burstEnter, "burst-exit", 25.0,
+                  "burst-loss", 80.0, "duplicate", duplicate, NULL);
+    
+    h = gst_harness_new_with_element (impair, "sink", "src");
+    gst_harness_set_src_caps_str (h, "application/x-matroska");
+    
+    for (number = 0; number < DATAGRAMS; number++) {
+        buffer = gst_harness_create_buffer (h, 100);
+        GST_BUFFER_OFFSET (buffer) = number;
+        fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+    }
+    
+    while ((buffer = gst_harness_try_pull (h)) != NULL) {
+        number = GST_BUFFER_OFFSET (buffer);
+        g_array_append_val (numbers, number);
+        gst_buffer_unref (buffer);
+    }
+    
+    if (stats != NULL)
+        g_object_get (impair, "stats", stats, NULL);
+    
+    gst_harness_teardown (h);
+    gst_object_unref (impair);
+    
+    return numbers;
+}
+
+//==============================================================================
+
+/**
+ * @brief Compare the output of two runs
+ *
+ * @param a First run
+ * @param b Second run
+ * @return gboolean TRUE if the same datagrams came out in the same order
+ */
+static gboolean isSameOutput (GArray *a, GArray *b){
+    
+    return a->len == b->len && memcmp (a->data, b->data, a->len * sizeof (guint64)) == 0;
+}
+
+//==============================================================================
+
+GST_START_TEST (test_impairment_same_seed)
+{
+    GstStructure *firstStats;
+    GstStructure *secondStats;
+    GArray *first;
+    GArray *second;
+    guint64 lost;
+    guint64 duplicates;
+    
+    first = runImpairment (7, 20.0, 0.0, 5.0, &firstStats);
+    second = runImpairment (7, 20.0, 0.0, 5.0, &secondStats);
+    
+    fail_unless (isSameOutput (first, second));
+    fail_unless (gst_structure_is_equal (firstStats, secondStats));
+    
+    /** About the configured rates */
+    fail_unless (gst_structure_get_uint64 (firstStats, "loss-drops", &lost));
+    fail_unless (gst_structure_get_uint64 (firstStats, "duplicates", &duplicates));
+    fail_unless (lost > DATAGRAMS / 10 && lost < DATAGRAMS * 3 / 10, "%" G_GUINT64_FORMAT " lost", lost);
+    fail_unless (duplicates > 0 && duplicates < DATAGRAMS / 10, "%" G_GUINT64_FORMAT " duplicates", duplicates);
+    fail_unless_equals_uint64 (first->len, DATAGRAMS - lost + duplicates);
+    
+    gst_structure_free (firstStats);
+    gst_structure_free (secondStats);
+    g_array_unref (first);
+    g_array_unref (second);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_impairment_other_seed)
+{
+    GArray *first;
+    GArray *second;
+    
+    first = runImpairment (7, 20.0, 0.0, 5.0, NULL);
+    second = runImpairment (8, 20.0, 0.0, 5.0, NULL);
+    
+    fail_if (isSameOutput (first, second));
+    
+    g_array_unref (first);
+    g_array_unref (second);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_impairment_bursts)
+{
+    GstStructure *firstStats;
+    GstStructure *secondStats;
+    GArray *first;
+    GArray *second;
+    guint64 bursts;
+    guint64 burstDrops;
+    
+    /** The Gilbert-Elliott state is part of the sequence too */
+    first = runImpairment (42, 0.0, 2.0, 0.0, &firstStats);
+    second = runImpairment (42, 0.0, 2.0, 0.0, &secondStats);
+    
+    fail_unless (isSameOutput (first, second));
+    fail_unless (gst_structure_is_equal (firstStats, secondStats));
+    
+    fail_unless (gst_structure_get_uint64 (firstStats, "bursts", &bursts));
+    fail_unless (gst_structure_get_uint64 (firstStats, "burst-drops", &burstDrops));
+    fail_unless (bursts > 0);
+    fail_unless_equals_uint64 (first->len, DATAGRAMS - burstDrops);
+    
+    gst_structure_free (firstStats);
+    gst_structure_free (secondStats);
+    g_array_unref (first);
+    g_array_unref (second);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_impairment_order_kept)
+{
+    GArray *numbers;
+    guint i;
+    
+    /** Loss and duplicates never reorder, the duplicate follows its datagram */
+    numbers = runImpairment (3, 10.0, 0.0, 10.0, NULL);
+    for (i = 1; i < numbers->len; i++)
+        fail_unless (g_array_index (numbers, guint64, i) >= g_array_index (numbers, guint64, i - 1));
+    
+    g_array_unref (numbers);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *hthimpair_suite (void){
+    
+    Suite *s = suite_create ("hthimpair");
+    TCase *tc = tcase_create ("general");
+    
+    /** The element is built in the test, no plugin to load */
+    gst_element_register (NULL, "hthimpair", GST_RANK_NONE, GST_TYPE_HTHIMPAIR);
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_impairment_same_seed);
+    tcase_add_test (tc, test_impairment_other_seed);
+    tcase_add_test (tc, test_impairment_bursts);
+    tcase_add_test (tc, test_impairment_order_kept);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (hthimpair);
@@ -0,0 +1,292 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the priority drops of the shared memory budget
+ * (common/gsththmemory.c)
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsththmemory.h"
+
+#define BUFFER_SIZE     100 /**< Bytes of each pushed buffer */
+#define MEMORY_LIMIT    1000 /**< Budget of the tests, ten buffers */
+
+/**
+ * @struct MemoryQueue
+ * @brief A watched queue whose src pad holds the buffers
+ */
+typedef struct {
+    GstHarness *harness; /**< Pushes into the queue */
+    GstPad *srcPad; /**< Src pad of the queue */
+    gulong blockId; /**< Probe holding the buffers inside the queue */
+} MemoryQueue;
+
+//==============================================================================
+
+/**
+ * @brief Hold the buffers leaving a queue, they stay counted by the budget
+ *
+ * @param pad Src pad of the queue
+ * @param info Probe info with the buffer
+ * @param user_data Unused
+ * @return GstPadProbeReturn GST_PAD_PROBE_OK once the probe is removed
+ */
+static GstPadProbeReturn cb_blockProbe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data){
+    
+    return GST_PAD_PROBE_OK;
+}
+
+//==============================================================================
+
+/**
+ * @brief Create a queue in a harness, watched by the budget
+ *
+ * @param queue Filled with the harness and the blocking probe
+ * @param memory The budget
+ * @param priority Drop order of the queue
+ * @return void
+ */
+static void createQueue (MemoryQueue *queue, GstHthMemory *memory, GstHthMemoryPriority priority){
+    
+    GstElement *element = gst_element_factory_make ("queue", NULL);
+    
+    fail_unless (element != NULL);
+    g_object_set (element, "max-size-buffers", 0, "max-size-time", G_GUINT64_CONSTANT (0), NULL);
+    
+    queue->harness = gst_harness_new_with_element (element, "sink", "src");
+    
+    /** Added before the budget probes so the buffers stay counted */
+    queue->srcPad = gst_element_get_static_pad (element, "src");
+    queue->blockId = gst_pad_add_probe (queue->srcPad, GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER,
+                                        cb_blockProbe, NULL, NULL);
+    
+    gst_hth_memory_watch_queue (memory, element, priority);
+    gst_object_unref (element);
+    
+    gst_harness_set_src_caps_str (queue->harness, "application/x-hth");
+}
+
+//==============================================================================
+
+/**
+ * @brief Release the held buffers and free the harness
+ *
+ * @param queue Queue of createQueue()
+ * @return void
+ */
+static void freeQueue (MemoryQueue *queue){
+    
+    gst_pad_remove_probe (queue->srcPad, queue->blockId);
+    gst_object_unref (queue->srcPad);
+    gst_harness_teardown (queue->harness);
+}
+
+//==============================================================================
+
+/**
+ * @brief Push buffers of BUFFER_SIZE bytes, dropped ones included
+ *
+ * @param queue Queue of createQueue()
+ * @param count Buffers pushed
+ * @param delta The buffers are delta units
+ * @return void
+ */
+static void pushBuffers (MemoryQueue *queue, guint count, gboolean delta){
+    
+    GstBuffer *buffer;
+    guint i;
+    
+    for (i = 0; i < count; i++) {
+        buffer = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+        if (delta)
+            GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+        fail_unless_equals_int (gst_harness_push (queue->harness, buffer), GST_FLOW_OK);
+    }
+}
+
+//==============================================================================
+
+/**
+ * @brief Read one counter of the budget
+ *
+ * @param memory The budget
+ * @param name Field of gst_hth_memory_append_stats()
+ * @return guint64 The counter
+ */
+static guint64 getStat (GstHthMemory *memory, const gchar *name){
+    
+    GstStructure *stats = gst_structure_new_empty ("stats");
+    guint64 value = 0;
+    
+    gst_hth_memory_append_stats (memory, stats);
+    fail_unless (gst_structure_get_uint64 (stats, name, &value));
+    gst_structure_free (stats);
+    
+    return value;
+}
+
+//==============================================================================
+
+GST_START_TEST (test_memory_video_dropped_first)
+{
+    GstHthMemory *memory = gst_hth_memory_new ();
+    MemoryQueue video, audio, text;
+    
+    gst_hth_memory_set_limit (memory, MEMORY_LIMIT);
+    createQueue (&video, memory, GST_HTH_MEMORY_VIDEO);
+    createQueue (&audio, memory, GST_HTH_MEMORY_AUDIO);
+    createQueue (&text, memory, GST_HTH_MEMORY_TEXT);
+    
+    /** The video alone stops at its level, the rest of the budget is left */
+    pushBuffers (&video, 10, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-used"), MEMORY_LIMIT / 100 * HTH_MEMORY_VIDEO_LEVEL);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-drops"), 2);
+    
+    /** The audio uses what the video left, up to its own level */
+    pushBuffers (&audio, 3, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "audio-memory-used"), BUFFER_SIZE);
+    fail_unless_equals_uint64 (getStat (memory, "audio-memory-drops"), 2);
+    
+    /** The text gets the last bytes */
+    pushBuffers (&text, 2, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "text-memory-used"), BUFFER_SIZE);
+    fail_unless_equals_uint64 (getStat (memory, "text-memory-drops"), 1);
+    
+    /** Never over the budget */
+    fail_unless_equals_uint64 (getStat (memory, "memory-used"), MEMORY_LIMIT);
+    fail_unless_equals_uint64 (getStat (memory, "memory-peak"), MEMORY_LIMIT);
+    
+    freeQueue (&video);
+    freeQueue (&audio);
+    freeQueue (&text);
+    gst_hth_memory_unref (memory);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_memory_shared_by_one_kind)
+{
+    GstHthMemory *memory = gst_hth_memory_new ();
+    MemoryQueue audio;
+    
+    /** Without video the audio gets its whole level, not a fixed share */
+    gst_hth_memory_set_limit (memory, MEMORY_LIMIT);
+    createQueue (&audio, memory, GST_HTH_MEMORY_AUDIO);
+    
+    pushBuffers (&audio, 10, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "audio-memory-used"), 9 * BUFFER_SIZE);
+    fail_unless_equals_uint64 (getStat (memory, "audio-memory-drops"), 1);
+    
+    freeQueue (&audio);
+    gst_hth_memory_unref (memory);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_memory_video_waits_keyframe)
+{
+    GstHthMemory *memory = gst_hth_memory_new ();
+    MemoryQueue video;
+    
+    gst_hth_memory_set_limit (memory, MEMORY_LIMIT);
+    createQueue (&video, memory, GST_HTH_MEMORY_VIDEO);
+    
+    pushBuffers (&video, 9, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-drops"), 1);
+    
+    /** Room again, but the deltas after a drop are dropped until a keyframe */
+    gst_hth_memory_set_limit (memory, 2 * MEMORY_LIMIT);
+    pushBuffers (&video, 3, TRUE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-drops"), 4);
+    
+    pushBuffers (&video, 1, FALSE);
+    pushBuffers (&video, 1, TRUE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-drops"), 4);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-used"), 10 * BUFFER_SIZE);
+    
+    freeQueue (&video);
+    gst_hth_memory_unref (memory);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_memory_no_limit)
+{
+    GstHthMemory *memory = gst_hth_memory_new ();
+    MemoryQueue video;
+    
+    createQueue (&video, memory, GST_HTH_MEMORY_VIDEO);
+    
+    pushBuffers (&video, 20, FALSE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-used"), 20 * BUFFER_SIZE);
+    fail_unless_equals_uint64 (getStat (memory, "video-memory-drops"), 0);
+    
+    freeQueue (&video);
+    gst_hth_memory_unref (memory);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *memory_suite (void){
+    
+    Suite *s = suite_create ("memory");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_memory_video_dropped_first);
+    tcase_add_test (tc, test_memory_shared_by_one_kind);
+    tcase_add_test (tc, test_memory_video_waits_keyframe);
+    tcase_add_test (tc, test_memory_no_limit);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (memory);
@@ -0,0 +1,394 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the motion gate (mux/gsththmotion.c)
+ *
+ * The gate watches an identity in a harness, as it watches the video
+ * encoder of hthstreamsink: a frame the gate drops never reaches the
+ * harness sink.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "gsththmotion.h"
+
+#define WIDTH       320
+#define HEIGHT      180
+#define FRAME_CAPS  "video/x-raw,format=GRAY8,width=320,height=180,framerate=30/1"
+#define HD_WIDTH    1920 /**< 30x30 pixels per cell */
+#define HD_HEIGHT   1080
+#define HD_CAPS     "video/x-raw,format=GRAY8,width=1920,height=1080,framerate=30/1"
+#define FRAME_TIME  (GST_SECOND / 30) /**< PTS step of the frames */
+#define THRESHOLD   5.0 /**< Percent of the cells, 115 of the 64x36 grid */
+
+//==============================================================================
+
+/**
+ * @brief Create a harness whose identity is watched by the gate
+ *
+ * @param motion The gate, configured by the test
+ * @param caps Caps of the frames
+ * @return GstHarness* The harness with its caps set
+ */
+static GstHarness *createHarness (GstHthMotion *motion, const gchar *caps){
+    
+    GstHarness *h = gst_harness_new ("identity");
+    
+    gst_hth_motion_watch_encoder (motion, h->element);
+    gst_harness_set_src_caps_str (h, caps);
+    
+    return h;
+}
+
+//==============================================================================
+
+/**
+ * @brief Create a uniform GRAY8 frame
+ *
+ * @param h The harness
+ * @param size Pixels of the frame, the lines have no padding
+ * @param luma Value of every pixel
+ * @param pts Time of the frame
+ * @return GstBuffer* The frame
+ */
+static GstBuffer *createSizedFrame (GstHarness *h, gsize size, guint8 luma, GstClockTime pts){
+    
+    GstBuffer *frame = gst_harness_create_buffer (h, size);
+    
+    gst_buffer_memset (frame, 0, luma, size);
+    GST_BUFFER_PTS (frame) = pts;
+    GST_BUFFER_DURATION (frame) = FRAME_TIME;
+    
+    return frame;
+}
+
+//==============================================================================
+
+/**
+ * @brief Create a uniform 320x180 frame
+ *
+ * @param h The harness
+ * @param luma Value of every pixel
+ * @param pts Time of the frame
+ * @return GstBuffer* The frame
+ */
+static GstBuffer *createFrame (GstHarness *h, guint8 luma, GstClockTime pts){
+    
+    return createSizedFrame (h, WIDTH * HEIGHT, luma, pts);
+}
+
+//==============================================================================
+
+/**
+ * @brief Paint a rectangle of a frame
+ *
+ * @param frame Frame of createSizedFrame()
+ * @param stride Pixels of a line
+ * @param x Left column
+ * @param y Top line
+ * @param width Columns painted
+ * @param height Lines painted
+ * @param luma Value of the pixels
+ * @return void
+ */
+static void paintRectangle (GstBuffer *frame, guint stride, guint x, guint y, guint width, guint height, guint8 luma){
+    
+    GstMapInfo map;
+    guint line;
+    
+    fail_unless (gst_buffer_map (frame, &map, GST_MAP_WRITE));
+    for (line = y; line < y + height; line++)
+        memset (map.data + line * stride + x, luma, width);
+    gst_buffer_unmap (frame, &map);
+}
+
+//==============================================================================
+
+/**
+ * @brief Read a counter of the gate
+ *
+ * @param motion The gate
+ * @param name Field of gst_hth_motion_append_stats()
+ * @return guint64 Its value
+ */
+static guint64 getCounter (GstHthMotion *motion, const gchar *name){
+    
+    GstStructure *stats = gst_structure_new_empty ("stats");
+    guint64 value = 0;
+    
+    gst_hth_motion_append_stats (motion, stats);
+    fail_unless (gst_structure_get_uint64 (stats, name, &value));
+    gst_structure_free (stats);
+    
+    return value;
+}
+
+//==============================================================================
+
+GST_START_TEST (test_motion_static_scene)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    guint i;
+    
+    gst_hth_motion_configure (motion, TRUE, THRESHOLD, GST_SECOND);
+    h = createHarness (motion, FRAME_CAPS);
+    
+    /** The first frame, then one keepalive a second later */
+    for (i = 0; i <= 30; i++)
+        fail_unless_equals_int (gst_harness_push (h, createFrame (h, 0x40, i * FRAME_TIME)), GST_FLOW_OK);
+    
+    fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+    frame = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (frame), 0);
+    gst_buffer_unref (frame);
+    frame = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (frame), 30 * FRAME_TIME);
+    gst_buffer_unref (frame);
+    
+    fail_unless_equals_uint64 (getCounter (motion, "motion-frames"), 31);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-skipped"), 29);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-keepalives"), 1);
+    
+    /** Each frame skipped would have cost the keepalive seen leaving the identity */
+    fail_unless_equals_uint64 (getCounter (motion, "motion-bytes-saved"), 29 * WIDTH * HEIGHT);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_motion_change)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    
+    gst_hth_motion_configure (motion, TRUE, THRESHOLD, GST_SECOND);
+    h = createHarness (motion, FRAME_CAPS);
+    
+    gst_harness_push (h, createFrame (h, 0x40, 0));
+    
+    /** A 20x20 square is about 16 cells, below the threshold */
+    frame = createFrame (h, 0x40, FRAME_TIME);
+    paintRectangle (frame, WIDTH, 160, 90, 20, 20, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 1);
+    
+    /** Half of the picture goes through before the keepalive */
+    frame = createFrame (h, 0x40, 2 * FRAME_TIME);
+    paintRectangle (frame, WIDTH, 0, 90, WIDTH, 90, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+    
+    /** Compared with the last frame let through, not with the first one */
+    frame = createFrame (h, 0x40, 3 * FRAME_TIME);
+    paintRectangle (frame, WIDTH, 0, 90, WIDTH, 90, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+    
+    fail_unless_equals_uint64 (getCounter (motion, "motion-skipped"), 2);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-keepalives"), 0);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_motion_time_corner)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    
+    gst_hth_motion_configure (motion, TRUE, THRESHOLD, GST_SECOND);
+    h = createHarness (motion, FRAME_CAPS);
+    
+    /** The 24x5 cells of the corner are 5.2 % of the grid, above the threshold */
+    gst_harness_push (h, createFrame (h, 0x40, 0));
+    frame = createFrame (h, 0x40, FRAME_TIME);
+    paintRectangle (frame, WIDTH, 0, 0, 120, 25, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+    
+    /** Left out, the time drawn there is no motion */
+    gst_hth_motion_ignore_time_corner (motion, TRUE);
+    gst_harness_push (h, createFrame (h, 0x40, 2 * FRAME_TIME));
+    frame = createFrame (h, 0x40, 3 * FRAME_TIME);
+    paintRectangle (frame, WIDTH, 0, 0, 120, 25, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 3);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_motion_duplicates)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    guint i;
+    
+    /** Gate off, only the frames repeated by videorate are dropped */
+    gst_hth_motion_configure (motion, FALSE, THRESHOLD, GST_SECOND);
+    gst_hth_motion_skip_duplicates (motion, TRUE);
+    h = createHarness (motion, FRAME_CAPS);
+    
+    gst_harness_push (h, createFrame (h, 0x40, 0));
+    for (i = 1; i <= 30; i++) {
+        frame = createFrame (h, 0x40, i * FRAME_TIME);
+        GST_BUFFER_FLAG_SET (frame, GST_BUFFER_FLAG_GAP);
+        gst_harness_push (h, frame);
+    }
+    
+    /** A frame that is no repeat always goes through */
+    gst_harness_push (h, createFrame (h, 0x40, 31 * FRAME_TIME));
+    
+    fail_unless_equals_int (gst_harness_buffers_received (h), 3);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-duplicates"), 29);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-keepalives"), 1);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-skipped"), 0);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_motion_disabled)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    guint i;
+    
+    h = createHarness (motion, FRAME_CAPS);
+    
+    for (i = 0; i < 10; i++) {
+        frame = createFrame (h, 0x40, i * FRAME_TIME);
+        GST_BUFFER_FLAG_SET (frame, GST_BUFFER_FLAG_GAP);
+        gst_harness_push (h, frame);
+    }
+    
+    fail_unless_equals_int (gst_harness_buffers_received (h), 10);
+    fail_unless_equals_uint64 (getCounter (motion, "motion-frames"), 0);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_motion_small_object)
+{
+    GstHthMotion *motion = gst_hth_motion_new ();
+    GstHarness *h;
+    GstBuffer *frame;
+    guint i;
+    
+    /** One cell of the 64x36 grid is enough */
+    gst_hth_motion_configure (motion, TRUE, 0.04, GST_SECOND);
+    h = createHarness (motion, HD_CAPS);
+    
+    gst_harness_push (h, createSizedFrame (h, HD_WIDTH * HD_HEIGHT, 0x40, 0));
+    
+    /**
+     * A 12x12 square moving two cells a frame, in the top left part of
+     * each cell: it never covers the centre pixels, only the mean of the
+     * whole cell sees it
+     */
+    for (i = 1; i <= 10; i++) {
+        frame = createSizedFrame (h, HD_WIDTH * HD_HEIGHT, 0x40, i * FRAME_TIME);
+        paintRectangle (frame, HD_WIDTH, 300 + 60 * i, 300, 12, 12, 0xc0);
+        gst_harness_push (h, frame);
+        fail_unless_equals_int (gst_harness_buffers_received (h), i + 1);
+    }
+    
+    /** Then it stops */
+    frame = createSizedFrame (h, HD_WIDTH * HD_HEIGHT, 0x40, 11 * FRAME_TIME);
+    paintRectangle (frame, HD_WIDTH, 900, 300, 12, 12, 0xc0);
+    gst_harness_push (h, frame);
+    fail_unless_equals_int (gst_harness_buffers_received (h), 11);
+    
+    fail_unless_equals_uint64 (getCounter (motion, "motion-skipped"), 1);
+    
+    gst_harness_teardown (h);
+    gst_hth_motion_free (motion);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *motion_suite (void){
+    
+    Suite *s = suite_create ("motion");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_motion_static_scene);
+    tcase_add_test (tc, test_motion_change);
+    tcase_add_test (tc, test_motion_time_corner);
+    tcase_add_test (tc, test_motion_duplicates);
+    tcase_add_test (tc, test_motion_disabled);
+    tcase_add_test (tc, test_motion_small_object);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (motion);
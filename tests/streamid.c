@@ -0,0 +1,207 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the stream id header and of the sequence loss accounting
+ * (common/gsththstreamid.c)
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsththstreamid.h"
+
+//==============================================================================
+
+GST_START_TEST (test_stream_id_header_round_trip)
+{
+    GstMemory *header;
+    GstMapInfo map;
+    guint32 streamId = 0;
+    guint32 sequence = 0;
+    
+    header = gst_hth_stream_id_header_new (0xDEADBEEF, 42);
+    fail_unless (gst_memory_map (header, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, HTH_STREAM_ID_HEADER_SIZE);
+    
+    fail_unless (gst_hth_stream_id_parse (map.data, map.size, &streamId, &sequence));
+    fail_unless_equals_uint64 (streamId, 0xDEADBEEF);
+    fail_unless_equals_uint64 (sequence, 42);
+    
+    /** The sequence number is optional */
+    streamId = 0;
+    fail_unless (gst_hth_stream_id_parse (map.data, map.size, &streamId, NULL));
+    fail_unless_equals_uint64 (streamId, 0xDEADBEEF);
+    
+    /** Truncated header */
+    fail_if (gst_hth_stream_id_parse (map.data, HTH_STREAM_ID_HEADER_SIZE - 1, &streamId, &sequence));
+    
+    gst_memory_unmap (header, &map);
+    gst_memory_unref (header);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_stream_id_parse_no_header)
+{
+    /** A Matroska datagram from a sender without the header */
+    const guint8 datagram[HTH_STREAM_ID_HEADER_SIZE] = { 0x1A, 0x45, 0xDF, 0xA3, 0, 0, 0, 0, 0, 0, 0, 0 };
+    guint32 streamId = 7;
+    guint32 sequence = 7;
+    
+    fail_if (gst_hth_stream_id_parse (datagram, sizeof (datagram), &streamId, &sequence));
+    fail_unless_equals_uint64 (streamId, 7);
+    fail_unless_equals_uint64 (sequence, 7);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_sequence_in_order)
+{
+    GstHthSequence sequence = { 0, };
+    guint32 number;
+    
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 0);
+    
+    /** The first datagram seen is the start, whatever its number */
+    for (number = 1000; number < 1100; number++)
+        gst_hth_sequence_update (&sequence, number);
+    
+    fail_unless_equals_uint64 (sequence.received, 100);
+    fail_unless_equals_uint64 (sequence.reordered, 0);
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 0);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_sequence_loss)
+{
+    GstHthSequence sequence = { 0, };
+    guint32 number;
+    
+    /** One in ten lost, the first and last ones arrive */
+    for (number = 0; number <= 100; number++) {
+        if (number % 10 != 5)
+            gst_hth_sequence_update (&sequence, number);
+    }
+    
+    fail_unless_equals_uint64 (sequence.received, 91);
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 10);
+    fail_unless_equals_uint64 (sequence.reordered, 0);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_sequence_late_and_repeated)
+{
+    GstHthSequence sequence = { 0, };
+    
+    gst_hth_sequence_update (&sequence, 0);
+    gst_hth_sequence_update (&sequence, 1);
+    gst_hth_sequence_update (&sequence, 3);
+    gst_hth_sequence_update (&sequence, 4);
+    
+    /** Missing until it arrives */
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 1);
+    
+    gst_hth_sequence_update (&sequence, 2);
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 0);
+    fail_unless_equals_uint64 (sequence.reordered, 1);
+    
+    /** A repeated datagram counts as reordered, never as negative loss */
+    gst_hth_sequence_update (&sequence, 4);
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 0);
+    fail_unless_equals_uint64 (sequence.reordered, 2);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_sequence_wrap)
+{
+    GstHthSequence sequence = { 0, };
+    guint32 number = G_MAXUINT32 - 4;
+    guint i;
+    
+    /** 20 numbers across the 32 bits wrap, the 3rd after the wrap is lost */
+    for (i = 0; i < 20; i++, number++) {
+        if (number != 2)
+            gst_hth_sequence_update (&sequence, number);
+    }
+    
+    fail_unless_equals_uint64 (sequence.highest - sequence.first, 19);
+    fail_unless_equals_uint64 (sequence.received, 19);
+    fail_unless_equals_uint64 (sequence.reordered, 0);
+    fail_unless_equals_uint64 (gst_hth_sequence_get_lost (&sequence), 1);
+    
+    /** A datagram from before the wrap is late, not 4 billion ahead */
+    gst_hth_sequence_update (&sequence, G_MAXUINT32);
+    fail_unless_equals_uint64 (sequence.reordered, 1);
+    fail_unless_equals_uint64 (sequence.highest - sequence.first, 19);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *streamid_suite (void){
+    
+    Suite *s = suite_create ("streamid");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_stream_id_header_round_trip);
+    tcase_add_test (tc, test_stream_id_parse_no_header);
+    tcase_add_test (tc, test_sequence_in_order);
+    tcase_add_test (tc, test_sequence_loss);
+    tcase_add_test (tc, test_sequence_late_and_repeated);
+    tcase_add_test (tc, test_sequence_wrap);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (streamid);
@@ -0,0 +1,210 @@
+/*********************************************************************************
+ * GStreamer                                                                     *
+ * Copyright (C) 2005 Thomas Vander Stichele <thomas@apestaart.org>
+ * Copyright (C) 2005 Ronald S. Bultje <rbultje@ronald.bitfreak.net>             *
+ * Copyright (C) 2017 basultobd <<basultobd@gmail.com>>
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),    *
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,      *
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:          *
+ *
+ * The above copyright notice and this permission notice shall be included in    *
+ * all copies or substantial portions of the Software.
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER           *
+ * DEALINGS IN THE SOFTWARE.
+ *                                                                               *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in                *
+ * which case the following provisions apply instead of the ones
+ * mentioned above:                                                              *
+ *
+ * This library is free software; you can redistribute it and/or                 *
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either                  *
+ * version 2 of the License, or (at your option) any later version.
+ *                                                                               *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.                              *
+ *
+ * You should have received a copy of the GNU Library General Public             *
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,                  *
+ * Boston, MA 02111-1307, USA.
+**********************************************************************************/
+
+/**
+ * Unit tests of the shared task pool (common/gsththtaskpool.c)
+ *
+ * The tasks are put on the pool with the STREAM_STATUS message a bin
+ * hands to gst_hth_task_pool_handle_message().
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsththtaskpool.h"
+
+#define PROGRESS_TIMEOUT (5 * G_USEC_PER_SEC) /**< Time given to every task to run */
+
+/**
+ * @struct CountingTask
+ * @brief A streaming task that counts its iterations
+ */
+typedef struct {
+    GstTask *task;
+    GRecMutex lock;
+    gint iterations; /**< Atomic */
+} CountingTask;
+
+//==============================================================================
+
+/**
+ * @brief One iteration of a task, like the loop of a queue
+ *
+ * @param user_data The CountingTask
+ * @return void
+ */
+static void cb_countIteration (gpointer user_data){
+    
+    CountingTask *counting = (CountingTask*) user_data;
+    
+    g_atomic_int_inc (&counting->iterations);
+    g_usleep (1000);
+}
+
+//==============================================================================
+
+/**
+ * @brief Create a task and put it on the shared pool
+ *
+ * @param counting Task to fill
+ * @param owner Element posting the stream status
+ * @return void
+ */
+static void createPoolTask (CountingTask *counting, GstElement *owner){
+    
+    GstMessage *message;
+    GValue value = G_VALUE_INIT;
+    
+    g_rec_mutex_init (&counting->lock);
+    counting->iterations = 0;
+    counting->task = gst_task_new (cb_countIteration, counting, NULL);
+    gst_task_set_lock (counting->task, &counting->lock);
+    
+    message = gst_message_new_stream_status (GST_OBJECT (owner), GST_STREAM_STATUS_TYPE_CREATE, owner);
+    g_value_init (&value, GST_TYPE_TASK);
+    g_value_set_object (&value, counting->task);
+    gst_message_set_stream_status_object (message, &value);
+    g_value_unset (&value);
+    
+    fail_unless (gst_hth_task_pool_handle_message (message));
+    gst_message_unref (message);
+}
+
+//==============================================================================
+
+GST_START_TEST (test_task_pool_more_tasks_than_cores)
+{
+    guint count = 2 * g_get_num_processors () + 1;
+    CountingTask *tasks = g_new0 (CountingTask, count);
+    GstElement *owner = gst_object_ref_sink (gst_bin_new ("owner"));
+    GstStructure *stats;
+    gint64 deadline;
+    guint started;
+    guint grows;
+    guint i;
+    
+    for (i = 0; i < count; i++) {
+        createPoolTask (&tasks[i], owner);
+        fail_unless (gst_task_start (tasks[i].task));
+    }
+    
+    /** A task that never got a thread would stay at 0 */
+    deadline = g_get_monotonic_time () + PROGRESS_TIMEOUT;
+    do {
+        g_usleep (10000);
+        for (started = 0, i = 0; i < count; i++)
+            started += g_atomic_int_get (&tasks[i].iterations) > 0;
+    } while (started < count && g_get_monotonic_time () < deadline);
+    
+    fail_unless_equals_int (started, count);
+    
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_task_pool_append_stats (stats);
+    fail_unless (gst_structure_get_uint (stats, "shared-pool-grows", &grows));
+    fail_unless (grows > 0);
+    gst_structure_free (stats);
+    
+    for (i = 0; i < count; i++) {
+        fail_unless (gst_task_join (tasks[i].task));
+        gst_object_unref (tasks[i].task);
+        g_rec_mutex_clear (&tasks[i].lock);
+    }
+    
+    gst_object_unref (owner);
+    g_free (tasks);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+GST_START_TEST (test_task_pool_threads_reused)
+{
+    CountingTask counting;
+    GstElement *owner = gst_object_ref_sink (gst_bin_new ("owner"));
+    GstStructure *stats;
+    guint before;
+    guint after;
+    guint i;
+    
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_task_pool_append_stats (stats);
+    fail_unless (gst_structure_get_uint (stats, "shared-pool-grows", &before));
+    gst_structure_free (stats);
+    
+    /** One task at a time never makes the pool grow */
+    for (i = 0; i < 10; i++) {
+        createPoolTask (&counting, owner);
+        fail_unless (gst_task_start (counting.task));
+        while (g_atomic_int_get (&counting.iterations) == 0)
+            g_usleep (1000);
+        fail_unless (gst_task_join (counting.task));
+        gst_object_unref (counting.task);
+        g_rec_mutex_clear (&counting.lock);
+    }
+    
+    stats = gst_structure_new_empty ("stats");
+    gst_hth_task_pool_append_stats (stats);
+    fail_unless (gst_structure_get_uint (stats, "shared-pool-grows", &after));
+    gst_structure_free (stats);
+    
+    fail_unless_equals_int (after, before);
+    gst_object_unref (owner);
+}
+GST_END_TEST;
+
+//==============================================================================
+
+static Suite *taskpool_suite (void){
+    
+    Suite *s = suite_create ("taskpool");
+    TCase *tc = tcase_create ("general");
+    
+    suite_add_tcase (s, tc);
+    tcase_add_test (tc, test_task_pool_more_tasks_than_cores);
+    tcase_add_test (tc, test_task_pool_threads_reused);
+    
+    return s;
+}
+
+GST_CHECK_MAIN (taskpool);